@@ -17,6 +17,7 @@
 
 #include "buffer_pool.h"
 
+#include <algorithm>
 #include <cstddef>
 
 #include "common/logging.h"
@@ -54,16 +55,21 @@ BufferAllocation BufferBlock::allocate(const uint32_t allocate_size)
 {
 	assert(allocate_size > 0 && "Allocation size must be greater than zero");
 
-	auto aligned_offset = (offset + alignment - 1) & ~(alignment - 1);
+	VkDeviceSize current_offset = offset.load(std::memory_order_relaxed);
+	VkDeviceSize aligned_offset;
 
-	if (aligned_offset + allocate_size > buffer.get_size())
+	// Move the current offset, only retried if another thread allocated from the block meanwhile
+	do
 	{
-		// No more space available from the underlying buffer, return empty allocation
-		return BufferAllocation{};
-	}
+		aligned_offset = (current_offset + alignment - 1) & ~(alignment - 1);
+
+		if (aligned_offset + allocate_size > buffer.get_size())
+		{
+			// No more space available from the underlying buffer, return empty allocation
+			return BufferAllocation{};
+		}
+	} while (!offset.compare_exchange_weak(current_offset, aligned_offset + allocate_size, std::memory_order_relaxed));
 
-	// Move the current offset and return an allocation
-	offset = aligned_offset + allocate_size;
 	return BufferAllocation{buffer, allocate_size, aligned_offset};
 }
 
@@ -72,9 +78,14 @@ VkDeviceSize BufferBlock::get_size() const
 	return buffer.get_size();
 }
 
+VkDeviceSize BufferBlock::get_used_size() const
+{
+	return offset.load(std::memory_order_relaxed);
+}
+
 void BufferBlock::reset()
 {
-	offset = 0;
+	offset.store(0, std::memory_order_relaxed);
 }
 
 BufferPool::BufferPool(Device &device, VkDeviceSize block_size, VkBufferUsageFlags usage, VmaMemoryUsage memory_usage) :
@@ -87,6 +98,12 @@ BufferPool::BufferPool(Device &device, VkDeviceSize block_size, VkBufferUsageFla
 
 BufferBlock &BufferPool::request_buffer_block(const VkDeviceSize minimum_size, bool minimal)
 {
+	if (!minimal && (active_buffer_block_count > 0 || minimum_size > block_size))
+	{
+		// The frame does not fit in a single block, or an allocation does not fit in any
+		grow_block_size = true;
+	}
+
 	// Find the first block in the range of the inactive blocks
 	// which can fit the minimum size
 	auto it = std::upper_bound(buffer_blocks.begin() + active_buffer_block_count, buffer_blocks.end(), minimum_size,
@@ -94,31 +111,89 @@ BufferBlock &BufferPool::request_buffer_block(const VkDeviceSize minimum_size, b
 
 	if (it != buffer_blocks.end())
 	{
-		// Recycle inactive block
-		active_buffer_block_count++;
-		return *it->get();
+		// Recycle inactive block, moving it at the end of the active range
+		// keeps the remaining inactive blocks sorted by size
+		std::rotate(buffer_blocks.begin() + active_buffer_block_count, it, it + 1);
+
+		return *buffer_blocks[active_buffer_block_count++];
 	}
 
 	LOGD("Building #{} buffer block ({})", buffer_blocks.size(), usage);
 
 	VkDeviceSize new_block_size = minimal ? minimum_size : std::max(block_size, minimum_size);
 
-	// Create a new block, store and return it
-	buffer_blocks.emplace_back(std::make_unique<BufferBlock>(device, new_block_size, usage, memory_usage));
+	// Create a new block, and insert it at the end of the active range
+	auto block = buffer_blocks.insert(buffer_blocks.begin() + active_buffer_block_count,
+	                                  std::make_unique<BufferBlock>(device, new_block_size, usage, memory_usage));
 
-	auto &block = buffer_blocks[active_buffer_block_count++];
+	active_buffer_block_count++;
 
-	return *block.get();
+	return *block->get();
 }
 
-void BufferPool::reset()
+bool BufferPool::reset()
 {
+	VkDeviceSize used_size = get_used_size();
+
+	size_t block_count = buffer_blocks.size();
+
 	for (auto &buffer_block : buffer_blocks)
 	{
 		buffer_block->reset();
 	}
 
+	if (grow_block_size && block_size < MAX_BLOCK_SIZE)
+	{
+		// Grow the blocks to the high-water mark of this frame
+		VkDeviceSize new_block_size = block_size;
+		while (new_block_size < used_size && new_block_size < MAX_BLOCK_SIZE)
+		{
+			new_block_size *= 2;
+		}
+
+		if (new_block_size != block_size)
+		{
+			LOGD("Growing buffer pool blocks ({}) from {} KB to {} KB", usage, block_size / 1024, new_block_size / 1024);
+
+			block_size = new_block_size;
+
+			// Release the blocks which would only be used once the larger block is full
+			buffer_blocks.erase(std::remove_if(buffer_blocks.begin(), buffer_blocks.end(),
+			                                   [this](const std::unique_ptr<BufferBlock> &block) { return block->get_size() < block_size; }),
+			                    buffer_blocks.end());
+		}
+	}
+
+	// Keep the blocks sorted by size, so the smallest fitting block is recycled first
+	std::sort(buffer_blocks.begin(), buffer_blocks.end(),
+	          [](const std::unique_ptr<BufferBlock> &a, const std::unique_ptr<BufferBlock> &b) { return a->get_size() < b->get_size(); });
+
 	active_buffer_block_count = 0;
+	grow_block_size           = false;
+
+	return buffer_blocks.size() != block_count;
+}
+
+VkDeviceSize BufferPool::get_block_size() const
+{
+	return block_size;
+}
+
+VkDeviceSize BufferPool::get_used_size() const
+{
+	VkDeviceSize used_size = 0;
+
+	for (uint32_t i = 0; i < active_buffer_block_count; ++i)
+	{
+		used_size += buffer_blocks[i]->get_used_size();
+	}
+
+	return used_size;
+}
+
+uint32_t BufferPool::get_active_block_count() const
+{
+	return active_buffer_block_count;
 }
 
 BufferAllocation::BufferAllocation(core::Buffer &buffer, VkDeviceSize size, VkDeviceSize offset) :
@@ -129,12 +204,17 @@ BufferAllocation::BufferAllocation(core::Buffer &buffer, VkDeviceSize size, VkDe
 }
 
 void BufferAllocation::update(const std::vector<uint8_t> &data, uint32_t offset)
+{
+	update(data.data(), data.size(), offset);
+}
+
+void BufferAllocation::update(const uint8_t *data, size_t data_size, uint32_t offset)
 {
 	assert(buffer && "Invalid buffer pointer");
 
-	if (offset + data.size() <= size)
+	if (offset + data_size <= size)
 	{
-		buffer->update(data, to_u32(base_offset) + offset);
+		buffer->update(data, data_size, to_u32(base_offset) + offset);
 	}
 	else
 	{
@@ -142,6 +222,21 @@ void BufferAllocation::update(const std::vector<uint8_t> &data, uint32_t offset)
 	}
 }
 
+uint8_t *BufferAllocation::map(size_t map_size, uint32_t offset)
+{
+	assert(buffer && "Invalid buffer pointer");
+	assert(offset + map_size <= size && "Buffer allocation map out of range");
+
+	return buffer->map() + base_offset + offset;
+}
+
+void BufferAllocation::flush()
+{
+	assert(buffer && "Invalid buffer pointer");
+
+	buffer->flush(base_offset, size);
+}
+
 bool BufferAllocation::empty() const
 {
 	return size == 0 || buffer == nullptr;
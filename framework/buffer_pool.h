@@ -17,6 +17,10 @@
 
 #pragma once
 
+#include <atomic>
+#include <new>
+#include <type_traits>
+
 #include "common/helpers.h"
 #include "core/buffer.h"
 
@@ -45,12 +49,60 @@ class BufferAllocation
 
 	void update(const std::vector<uint8_t> &data, uint32_t offset = 0);
 
+	/**
+	 * @brief Copies byte data into the allocation
+	 * @param data The data to copy from
+	 * @param size The amount of bytes to copy
+	 * @param offset The offset from the start of the allocation
+	 */
+	void update(const uint8_t *data, size_t size, uint32_t offset = 0);
+
+	/**
+	 * @brief Copies an array of values into the allocation, without an intermediate copy
+	 */
+	template <class T>
+	void update(const T *values, size_t count, uint32_t offset = 0)
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "Buffer allocations can only hold trivially copyable data");
+		update(reinterpret_cast<const uint8_t *>(values), count * sizeof(T), offset);
+	}
+
+	/**
+	 * @brief Copies a value into the allocation, without an intermediate copy
+	 */
 	template <class T>
 	void update(const T &value, uint32_t offset = 0)
 	{
-		update(to_bytes(value), offset);
+		update(reinterpret_cast<const uint8_t *>(&value), sizeof(T), offset);
+	}
+
+	/**
+	 * @brief Maps a range of the allocation, so that the caller can write into it directly
+	 *        The written range must be flushed before the GPU reads it
+	 * @param size The amount of bytes that will be written
+	 * @param offset The offset from the start of the allocation
+	 * @return Pointer to the mapped range
+	 */
+	uint8_t *map(size_t size, uint32_t offset = 0);
+
+	/**
+	 * @brief Constructs a value directly in the mapped memory of the allocation
+	 *        The allocation must be flushed before the GPU reads it
+	 * @param args Arguments forwarded to the constructor of the value
+	 * @return The constructed value
+	 */
+	template <class T, class... Args>
+	T &emplace(Args &&... args)
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "Buffer allocations can only hold trivially copyable data");
+		return *new (map(sizeof(T))) T(std::forward<Args>(args)...);
 	}
 
+	/**
+	 * @brief Flushes the allocation range of the buffer, if its memory is not HOST_COHERENT
+	 */
+	void flush();
+
 	bool empty() const;
 
 	VkDeviceSize get_size() const;
@@ -69,6 +121,9 @@ class BufferAllocation
 
 /**
  * @brief Helper class which handles multiple allocation from the same underlying Vulkan buffer.
+ *
+ * Allocations bump an atomic offset, so a block may be shared by multiple threads.
+ * A block used by a single thread never contends on the offset.
  */
 class BufferBlock
 {
@@ -82,6 +137,11 @@ class BufferBlock
 
 	VkDeviceSize get_size() const;
 
+	/**
+	 * @return The size allocated from the block since the last reset, including alignment padding
+	 */
+	VkDeviceSize get_used_size() const;
+
 	void reset();
 
   private:
@@ -91,7 +151,7 @@ class BufferBlock
 	VkDeviceSize alignment{0};
 
 	// Current offset, it increases on every allocation
-	VkDeviceSize offset{0};
+	std::atomic<VkDeviceSize> offset{0};
 };
 
 /**
@@ -107,6 +167,10 @@ class BufferBlock
  * overwritten. The minimum allocation size is 256 kb, if you ask for more you get a dedicated
  * buffer allocation.
  *
+ * If a frame needed more than one block, or an allocation larger than a block, the block size
+ * grows to the next power of two of the size used in that frame, so the following frames fit in
+ * a single block. Blocks smaller than the new block size are released.
+ *
  * We re-use descriptor sets: we only need one for the corresponding buffer infos (and we only
  * have one VkBuffer per BufferBlock), then it is bound and we use dynamic offsets.
  */
@@ -117,7 +181,23 @@ class BufferPool
 
 	BufferBlock &request_buffer_block(VkDeviceSize minimum_size, bool minimal = false);
 
-	void reset();
+	/**
+	 * @brief Returns the blocks, and grows the block size if the blocks were not large enough
+	 * @return True if smaller blocks were released, invalidating the descriptor sets referencing their buffers
+	 */
+	bool reset();
+
+	VkDeviceSize get_block_size() const;
+
+	/**
+	 * @return The size allocated from the active blocks since the last reset
+	 */
+	VkDeviceSize get_used_size() const;
+
+	uint32_t get_active_block_count() const;
+
+	/// Largest size a block can grow to
+	static constexpr VkDeviceSize MAX_BLOCK_SIZE = 64 * 1024 * 1024;
 
   private:
 	Device &device;
@@ -134,5 +214,8 @@ class BufferPool
 
 	/// Numbers of active blocks from the start of buffer_blocks
 	uint32_t active_buffer_block_count{0};
+
+	/// Whether the blocks were too small for the current frame
+	bool grow_block_size{false};
 };
 }        // namespace vkb
@@ -214,4 +214,57 @@ inline std::vector<uint8_t> to_bytes(const T &value)
 	                            reinterpret_cast<const uint8_t *>(&value) + sizeof(T)};
 }
 
+/**
+ * @brief Sorts elements by their 64-bit key member, with a stable least significant digit radix sort.
+ *        Each pass sorts one byte of the keys, and the bytes shared by all the keys are skipped.
+ * @param elements Elements to sort, each with an uint64_t key member
+ * @param scratch Storage for the intermediate passes, kept by the caller to reuse it across sorts
+ */
+template <class T>
+inline void radix_sort(std::vector<T> &elements, std::vector<T> &scratch)
+{
+	if (elements.size() < 2)
+	{
+		return;
+	}
+
+	// Count the digits of all the passes at once
+	std::array<std::array<size_t, 256>, sizeof(uint64_t)> histograms{};
+	for (auto &element : elements)
+	{
+		for (size_t pass = 0; pass < sizeof(uint64_t); ++pass)
+		{
+			histograms[pass][(element.key >> (8 * pass)) & 0xFF]++;
+		}
+	}
+
+	scratch.resize(elements.size());
+
+	for (size_t pass = 0; pass < sizeof(uint64_t); ++pass)
+	{
+		auto &histogram = histograms[pass];
+
+		if (histogram[(elements.front().key >> (8 * pass)) & 0xFF] == elements.size())
+		{
+			continue;
+		}
+
+		// Turn the counts into the offsets of the buckets
+		size_t offset = 0;
+		for (auto &count : histogram)
+		{
+			size_t bucket_size = count;
+			count              = offset;
+			offset += bucket_size;
+		}
+
+		for (auto &element : elements)
+		{
+			scratch[histogram[(element.key >> (8 * pass)) & 0xFF]++] = element;
+		}
+
+		elements.swap(scratch);
+	}
+}
+
 }        // namespace vkb
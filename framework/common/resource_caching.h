@@ -448,6 +448,10 @@ struct hash<vkb::RenderTarget>
 			vkb::hash_combine(result, view.get_image().get_handle());
 		}
 
+		// Framebuffers are sized to the extent, which may be smaller than the images
+		vkb::hash_combine(result, render_target.get_extent().width);
+		vkb::hash_combine(result, render_target.get_extent().height);
+
 		return result;
 	}
 };
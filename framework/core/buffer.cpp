@@ -132,9 +132,9 @@ void Buffer::unmap()
 	}
 }
 
-void Buffer::flush() const
+void Buffer::flush(VkDeviceSize offset, VkDeviceSize size) const
 {
-	vmaFlushAllocation(device->get_memory_allocator(), allocation, 0, size);
+	vmaFlushAllocation(device->get_memory_allocator(), allocation, offset, size);
 }
 
 void Buffer::update(const std::vector<uint8_t> &data, size_t offset)
@@ -157,6 +157,8 @@ void Buffer::update(void *data, size_t size, size_t offset)
 
 void Buffer::update(const uint8_t *data, const size_t size, const size_t offset)
 {
+	assert(offset + size <= this->size && "Buffer update out of range");
+
 	if (persistent)
 	{
 		std::copy(data, data + size, mapped_data + offset);
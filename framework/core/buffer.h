@@ -90,8 +90,10 @@ class Buffer : public VulkanResource<VkBuffer, VK_OBJECT_TYPE_BUFFER, const Devi
 
 	/**
 	 * @brief Flushes memory if it is HOST_VISIBLE and not HOST_COHERENT
+	 * @param offset The offset of the range to flush
+	 * @param size The size of the range to flush, the whole buffer by default
 	 */
-	void flush() const;
+	void flush(VkDeviceSize offset = 0, VkDeviceSize size = VK_WHOLE_SIZE) const;
 
 	/**
 	 * @brief Maps vulkan memory if it isn't already mapped to an host visible address
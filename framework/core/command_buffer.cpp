@@ -124,6 +124,13 @@ VkResult CommandBuffer::begin(VkCommandBufferUsageFlags flags, const RenderPass
 		inheritance.subpass     = subpass_index;
 
 		begin_info.pInheritanceInfo = &inheritance;
+
+		// Update pipeline state for the inherited subpass
+		pipeline_state.set_subpass_index(subpass_index);
+
+		auto blend_state = pipeline_state.get_color_blend_state();
+		blend_state.attachments.resize(current_render_pass.render_pass->get_color_output_count(subpass_index));
+		pipeline_state.set_color_blend_state(blend_state);
 	}
 
 	return vkBeginCommandBuffer(get_handle(), &begin_info);
@@ -204,7 +211,7 @@ void CommandBuffer::begin_render_pass(const RenderTarget &render_target, const R
 	pipeline_state.set_color_blend_state(blend_state);
 }
 
-void CommandBuffer::next_subpass()
+void CommandBuffer::next_subpass(VkSubpassContents contents)
 {
 	// Increment subpass index
 	pipeline_state.set_subpass_index(pipeline_state.get_subpass_index() + 1);
@@ -221,7 +228,7 @@ void CommandBuffer::next_subpass()
 	// Clear stored push constants
 	stored_push_constants.clear();
 
-	vkCmdNextSubpass(get_handle(), VK_SUBPASS_CONTENTS_INLINE);
+	vkCmdNextSubpass(get_handle(), contents);
 }
 
 void CommandBuffer::execute_commands(CommandBuffer &secondary_command_buffer)
@@ -309,6 +316,38 @@ void CommandBuffer::bind_lighting(LightingState &lighting_state, uint32_t set, u
 	set_specialization_constant(2, to_u32(lighting_state.spot_lights.size()));
 }
 
+void CommandBuffer::inherit_binding_state(const CommandBuffer &command_buffer)
+{
+	for (auto &resource_set_it : command_buffer.resource_binding_state.get_resource_sets())
+	{
+		for (auto &binding_it : resource_set_it.second.get_resource_bindings())
+		{
+			for (auto &element_it : binding_it.second)
+			{
+				const ResourceInfo &resource_info = element_it.second;
+
+				if (resource_info.buffer != nullptr)
+				{
+					resource_binding_state.bind_buffer(*resource_info.buffer, resource_info.offset, resource_info.range, resource_set_it.first, binding_it.first, element_it.first);
+				}
+				else if (resource_info.image_view != nullptr && resource_info.sampler != nullptr)
+				{
+					resource_binding_state.bind_image(*resource_info.image_view, *resource_info.sampler, resource_set_it.first, binding_it.first, element_it.first);
+				}
+				else if (resource_info.image_view != nullptr)
+				{
+					resource_binding_state.bind_image(*resource_info.image_view, resource_set_it.first, binding_it.first, element_it.first);
+				}
+			}
+		}
+	}
+
+	for (auto &constant_it : command_buffer.pipeline_state.get_specialization_constant_state().get_specialization_constant_state())
+	{
+		pipeline_state.set_specialization_constant(constant_it.first, constant_it.second);
+	}
+}
+
 void CommandBuffer::set_viewport_state(const ViewportState &state_info)
 {
 	pipeline_state.set_viewport_state(state_info);
@@ -395,6 +434,13 @@ void CommandBuffer::draw_indexed_indirect(const core::Buffer &buffer, VkDeviceSi
 	vkCmdDrawIndexedIndirect(get_handle(), buffer.get_handle(), offset, draw_count, stride);
 }
 
+void CommandBuffer::draw_mesh_tasks(uint32_t group_count_x, uint32_t group_count_y, uint32_t group_count_z)
+{
+	flush(VK_PIPELINE_BIND_POINT_GRAPHICS);
+
+	vkCmdDrawMeshTasksEXT(get_handle(), group_count_x, group_count_y, group_count_z);
+}
+
 void CommandBuffer::dispatch(uint32_t group_count_x, uint32_t group_count_y, uint32_t group_count_z)
 {
 	flush(VK_PIPELINE_BIND_POINT_COMPUTE);
@@ -455,7 +501,9 @@ void CommandBuffer::copy_image_to_buffer(const core::Image &image, VkImageLayout
 	                       buffer.get_handle(), to_u32(regions.size()), regions.data());
 }
 
-void CommandBuffer::image_memory_barrier(const core::ImageView &image_view, const ImageMemoryBarrier &memory_barrier) const
+namespace
+{
+VkImageMemoryBarrier get_image_memory_barrier(const core::ImageView &image_view, const ImageMemoryBarrier &memory_barrier)
 {
 	// Adjust barrier's subresource range for depth images
 	auto subresource_range = image_view.get_subresource_range();
@@ -479,6 +527,14 @@ void CommandBuffer::image_memory_barrier(const core::ImageView &image_view, cons
 	image_memory_barrier.srcQueueFamilyIndex = memory_barrier.old_queue_family;
 	image_memory_barrier.dstQueueFamilyIndex = memory_barrier.new_queue_family;
 
+	return image_memory_barrier;
+}
+}        // namespace
+
+void CommandBuffer::image_memory_barrier(const core::ImageView &image_view, const ImageMemoryBarrier &memory_barrier) const
+{
+	VkImageMemoryBarrier image_memory_barrier = get_image_memory_barrier(image_view, memory_barrier);
+
 	VkPipelineStageFlags src_stage_mask = memory_barrier.src_stage_mask;
 	VkPipelineStageFlags dst_stage_mask = memory_barrier.dst_stage_mask;
 
@@ -493,14 +549,50 @@ void CommandBuffer::image_memory_barrier(const core::ImageView &image_view, cons
 	    &image_memory_barrier);
 }
 
+void CommandBuffer::image_memory_barriers(const std::vector<const core::ImageView *> &image_views, const std::vector<ImageMemoryBarrier> &memory_barriers) const
+{
+	assert(image_views.size() == memory_barriers.size() && "Expected one image view per image memory barrier");
+
+	if (memory_barriers.empty())
+	{
+		return;
+	}
+
+	std::vector<VkImageMemoryBarrier> image_memory_barriers;
+	image_memory_barriers.reserve(memory_barriers.size());
+
+	VkPipelineStageFlags src_stage_mask = 0;
+	VkPipelineStageFlags dst_stage_mask = 0;
+
+	for (size_t i = 0; i < memory_barriers.size(); ++i)
+	{
+		image_memory_barriers.push_back(get_image_memory_barrier(*image_views[i], memory_barriers[i]));
+
+		src_stage_mask |= memory_barriers[i].src_stage_mask;
+		dst_stage_mask |= memory_barriers[i].dst_stage_mask;
+	}
+
+	vkCmdPipelineBarrier(
+	    get_handle(),
+	    src_stage_mask,
+	    dst_stage_mask,
+	    0,
+	    0, nullptr,
+	    0, nullptr,
+	    to_u32(image_memory_barriers.size()),
+	    image_memory_barriers.data());
+}
+
 void CommandBuffer::buffer_memory_barrier(const core::Buffer &buffer, VkDeviceSize offset, VkDeviceSize size, const BufferMemoryBarrier &memory_barrier)
 {
 	VkBufferMemoryBarrier buffer_memory_barrier{VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER};
-	buffer_memory_barrier.srcAccessMask = memory_barrier.src_access_mask;
-	buffer_memory_barrier.dstAccessMask = memory_barrier.dst_access_mask;
-	buffer_memory_barrier.buffer        = buffer.get_handle();
-	buffer_memory_barrier.offset        = offset;
-	buffer_memory_barrier.size          = size;
+	buffer_memory_barrier.srcAccessMask       = memory_barrier.src_access_mask;
+	buffer_memory_barrier.dstAccessMask       = memory_barrier.dst_access_mask;
+	buffer_memory_barrier.srcQueueFamilyIndex = memory_barrier.old_queue_family;
+	buffer_memory_barrier.dstQueueFamilyIndex = memory_barrier.new_queue_family;
+	buffer_memory_barrier.buffer              = buffer.get_handle();
+	buffer_memory_barrier.offset              = offset;
+	buffer_memory_barrier.size                = size;
 
 	VkPipelineStageFlags src_stage_mask = memory_barrier.src_stage_mask;
 	VkPipelineStageFlags dst_stage_mask = memory_barrier.dst_stage_mask;
@@ -815,6 +907,11 @@ VkResult CommandBuffer::reset(ResetMode reset_mode)
 	return result;
 }
 
+const CommandBuffer::ResetMode CommandBuffer::get_reset_mode() const
+{
+	return command_pool.get_reset_mode();
+}
+
 RenderPass &CommandBuffer::get_render_pass(const vkb::RenderTarget &render_target, const std::vector<LoadStoreInfo> &load_store_infos, const std::vector<std::unique_ptr<Subpass>> &subpasses)
 {
 	// Create render pass
@@ -125,7 +125,7 @@ class CommandBuffer : public core::VulkanResource<VkCommandBuffer, VK_OBJECT_TYP
 
 	void begin_render_pass(const RenderTarget &render_target, const RenderPass &render_pass, const Framebuffer &framebuffer, const std::vector<VkClearValue> &clear_values, VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE);
 
-	void next_subpass();
+	void next_subpass(VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE);
 
 	void execute_commands(CommandBuffer &secondary_command_buffer);
 
@@ -149,9 +149,9 @@ class CommandBuffer : public core::VulkanResource<VkCommandBuffer, VK_OBJECT_TYP
 	template <typename T>
 	void push_constants(const T &value)
 	{
-		auto data = to_bytes(value);
+		auto data = reinterpret_cast<const uint8_t *>(&value);
 
-		uint32_t size = to_u32(stored_push_constants.size() + data.size());
+		uint32_t size = to_u32(stored_push_constants.size() + sizeof(T));
 
 		if (size > max_push_constants_size)
 		{
@@ -159,7 +159,8 @@ class CommandBuffer : public core::VulkanResource<VkCommandBuffer, VK_OBJECT_TYP
 			throw std::runtime_error("Cannot overflow push constant limit");
 		}
 
-		stored_push_constants.insert(stored_push_constants.end(), data.begin(), data.end());
+		// The storage keeps its capacity across frames, so this does not allocate once warmed up
+		stored_push_constants.insert(stored_push_constants.end(), data, data + sizeof(T));
 	}
 
 	void bind_buffer(const core::Buffer &buffer, VkDeviceSize offset, VkDeviceSize range, uint32_t set, uint32_t binding, uint32_t array_element);
@@ -176,6 +177,13 @@ class CommandBuffer : public core::VulkanResource<VkCommandBuffer, VK_OBJECT_TYP
 
 	void bind_lighting(LightingState &lighting_state, uint32_t set, uint32_t binding);
 
+	/**
+	 * @brief Binds the resources and specialization constants currently bound on another command buffer,
+	 *        so that a secondary command buffer can continue the draws recorded by its primary
+	 * @param command_buffer Command buffer to inherit the binding state from
+	 */
+	void inherit_binding_state(const CommandBuffer &command_buffer);
+
 	void set_viewport_state(const ViewportState &state_info);
 
 	void set_vertex_input_state(const VertexInputState &state_info);
@@ -208,6 +216,11 @@ class CommandBuffer : public core::VulkanResource<VkCommandBuffer, VK_OBJECT_TYP
 
 	void draw_indexed_indirect(const core::Buffer &buffer, VkDeviceSize offset, uint32_t draw_count, uint32_t stride);
 
+	/**
+	 * @brief Records a draw with task and mesh shaders, requires the VK_EXT_mesh_shader extension
+	 */
+	void draw_mesh_tasks(uint32_t group_count_x, uint32_t group_count_y, uint32_t group_count_z);
+
 	void dispatch(uint32_t group_count_x, uint32_t group_count_y, uint32_t group_count_z);
 
 	void dispatch_indirect(const core::Buffer &buffer, VkDeviceSize offset);
@@ -228,6 +241,12 @@ class CommandBuffer : public core::VulkanResource<VkCommandBuffer, VK_OBJECT_TYP
 
 	void image_memory_barrier(const core::ImageView &image_view, const ImageMemoryBarrier &memory_barrier) const;
 
+	/**
+	 * @brief Records the image memory barriers of several image views as a single pipeline barrier,
+	 *        from the union of their source stages to the union of their destination stages
+	 */
+	void image_memory_barriers(const std::vector<const core::ImageView *> &image_views, const std::vector<ImageMemoryBarrier> &memory_barriers) const;
+
 	void buffer_memory_barrier(const core::Buffer &buffer, VkDeviceSize offset, VkDeviceSize size, const BufferMemoryBarrier &memory_barrier);
 
 	const State get_state() const;
@@ -248,6 +267,16 @@ class CommandBuffer : public core::VulkanResource<VkCommandBuffer, VK_OBJECT_TYP
 	 */
 	VkResult reset(ResetMode reset_mode);
 
+	/**
+	 * @return The reset mode of the pool the command buffer was allocated from
+	 */
+	const ResetMode get_reset_mode() const;
+
+	/**
+	 * @return The render pass and framebuffer the command buffer is recording into
+	 */
+	const RenderPassBinding &get_current_render_pass() const;
+
 	RenderPass &get_render_pass(const vkb::RenderTarget &render_target, const std::vector<LoadStoreInfo> &load_store_infos, const std::vector<std::unique_ptr<Subpass>> &subpasses);
 
 	const VkCommandBufferLevel level;
@@ -277,8 +306,6 @@ class CommandBuffer : public core::VulkanResource<VkCommandBuffer, VK_OBJECT_TYP
 
 	std::unordered_map<uint32_t, DescriptorSetLayout *> descriptor_set_layout_binding_state;
 
-	const RenderPassBinding &get_current_render_pass() const;
-
 	const uint32_t get_current_subpass_index() const;
 
 	/**
@@ -117,10 +117,29 @@ Device::Device(PhysicalDevice &                       gpu,
 		}
 	}
 
+	// Timeline semaphores order the work the render context submits on several queues
+	if (is_extension_supported(VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME) &&
+	    gpu.get_instance().is_enabled(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME))
+	{
+		auto &timeline_semaphore_features = gpu.request_extension_features<VkPhysicalDeviceTimelineSemaphoreFeaturesKHR>(VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES_KHR);
+
+		if (timeline_semaphore_features.timelineSemaphore)
+		{
+			enabled_extensions.push_back(VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME);
+			LOGI("Timeline semaphores enabled");
+		}
+	}
+
 	// Check that extensions are supported before trying to create the device
 	std::vector<const char *> unsupported_extensions{};
 	for (auto &extension : requested_extensions)
 	{
+		// The framework may have enabled it already
+		if (is_enabled(extension.first))
+		{
+			continue;
+		}
+
 		if (is_extension_supported(extension.first))
 		{
 			enabled_extensions.emplace_back(extension.first);
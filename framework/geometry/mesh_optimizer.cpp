@@ -0,0 +1,524 @@
+/* Copyright (c) 2023, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "mesh_optimizer.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <unordered_map>
+
+namespace vkb
+{
+namespace
+{
+// Scoring of the vertex cache optimization, from Tom Forsyth's linear-speed vertex cache optimisation
+constexpr size_t VERTEX_CACHE_SIZE = 32;
+
+constexpr float CACHE_DECAY_POWER = 1.5f;
+
+constexpr float LAST_TRIANGLE_SCORE = 0.75f;
+
+constexpr float VALENCE_BOOST_SCALE = 2.0f;
+
+constexpr float VALENCE_BOOST_POWER = 0.5f;
+
+// FIFO cache simulated to find the clusters of the overdraw optimization
+constexpr uint32_t OVERDRAW_CACHE_SIZE = 16;
+
+// Finest grid of the simplification, in cells along the largest axis of the mesh
+constexpr uint32_t MAX_GRID_SIZE = 1024;
+
+float get_vertex_score(int cache_position, uint32_t remaining_triangle_count)
+{
+	// Vertices without triangles left to draw are never picked
+	if (remaining_triangle_count == 0)
+	{
+		return -1.0f;
+	}
+
+	float score = 0.0f;
+
+	if (cache_position >= 0)
+	{
+		// The vertices of the last triangle get a fixed score, so that strips are not favoured
+		if (cache_position < 3)
+		{
+			score = LAST_TRIANGLE_SCORE;
+		}
+		else
+		{
+			score = std::pow(1.0f - static_cast<float>(cache_position - 3) / (VERTEX_CACHE_SIZE - 3), CACHE_DECAY_POWER);
+		}
+	}
+
+	// Vertices with few triangles left are drawn first, so that they leave the cache for good
+	return score + VALENCE_BOOST_SCALE * std::pow(static_cast<float>(remaining_triangle_count), -VALENCE_BOOST_POWER);
+}
+
+/**
+ * @brief Symmetric matrix of the sum of squared distances to a set of planes
+ */
+struct Quadric
+{
+	float xx, xy, xz, xw, yy, yz, yw, zz, zw, ww;
+
+	void add(const Quadric &other)
+	{
+		xx += other.xx;
+		xy += other.xy;
+		xz += other.xz;
+		xw += other.xw;
+		yy += other.yy;
+		yz += other.yz;
+		yw += other.yw;
+		zz += other.zz;
+		zw += other.zw;
+		ww += other.ww;
+	}
+
+	void add_plane(const glm::vec3 &normal, float distance, float weight)
+	{
+		xx += weight * normal.x * normal.x;
+		xy += weight * normal.x * normal.y;
+		xz += weight * normal.x * normal.z;
+		xw += weight * normal.x * distance;
+		yy += weight * normal.y * normal.y;
+		yz += weight * normal.y * normal.z;
+		yw += weight * normal.y * distance;
+		zz += weight * normal.z * normal.z;
+		zw += weight * normal.z * distance;
+		ww += weight * distance * distance;
+	}
+
+	float get_error(const glm::vec3 &p) const
+	{
+		return p.x * (xx * p.x + 2.0f * (xy * p.y + xz * p.z + xw)) +
+		       p.y * (yy * p.y + 2.0f * (yz * p.z + yw)) +
+		       p.z * (zz * p.z + 2.0f * zw) +
+		       ww;
+	}
+};
+}        // namespace
+
+void optimize_vertex_cache(std::vector<uint32_t> &indices, size_t vertex_count)
+{
+	size_t triangle_count = indices.size() / 3;
+	if (triangle_count == 0)
+	{
+		return;
+	}
+
+	// Triangles using each vertex, the first remaining_triangle_counts of them are not drawn yet
+	std::vector<uint32_t> triangle_offsets(vertex_count + 1, 0);
+	for (auto index : indices)
+	{
+		triangle_offsets[index + 1]++;
+	}
+	std::partial_sum(triangle_offsets.begin(), triangle_offsets.end(), triangle_offsets.begin());
+
+	std::vector<uint32_t> vertex_triangles(indices.size());
+	std::vector<uint32_t> remaining_triangle_counts(vertex_count, 0);
+	for (size_t i = 0; i < triangle_count * 3; ++i)
+	{
+		uint32_t vertex = indices[i];
+		vertex_triangles[triangle_offsets[vertex] + remaining_triangle_counts[vertex]++] = static_cast<uint32_t>(i / 3);
+	}
+
+	std::vector<int>   cache_positions(vertex_count, -1);
+	std::vector<float> vertex_scores(vertex_count);
+	for (size_t vertex = 0; vertex < vertex_count; ++vertex)
+	{
+		vertex_scores[vertex] = get_vertex_score(-1, remaining_triangle_counts[vertex]);
+	}
+
+	std::vector<float> triangle_scores(triangle_count);
+	for (size_t triangle = 0; triangle < triangle_count; ++triangle)
+	{
+		triangle_scores[triangle] = vertex_scores[indices[triangle * 3]] + vertex_scores[indices[triangle * 3 + 1]] + vertex_scores[indices[triangle * 3 + 2]];
+	}
+
+	std::vector<uint8_t>  drawn(triangle_count, 0);
+	std::vector<uint32_t> result;
+	result.reserve(triangle_count * 3);
+
+	std::vector<uint32_t> cache;
+	std::vector<uint32_t> new_cache;
+	cache.reserve(VERTEX_CACHE_SIZE + 3);
+	new_cache.reserve(VERTEX_CACHE_SIZE + 3);
+
+	size_t  next_undrawn_triangle = 0;
+	int64_t best_triangle         = std::max_element(triangle_scores.begin(), triangle_scores.end()) - triangle_scores.begin();
+
+	for (size_t i = 0; i < triangle_count; ++i)
+	{
+		// Without candidate in the cache, continue with the next triangle in the original order
+		if (best_triangle < 0)
+		{
+			while (drawn[next_undrawn_triangle])
+			{
+				next_undrawn_triangle++;
+			}
+			best_triangle = static_cast<int64_t>(next_undrawn_triangle);
+		}
+
+		const uint32_t *triangle_indices = &indices[best_triangle * 3];
+
+		drawn[best_triangle] = 1;
+		result.insert(result.end(), triangle_indices, triangle_indices + 3);
+
+		// Remove the triangle from the triangles left to draw with its vertices
+		new_cache.clear();
+		for (size_t j = 0; j < 3; ++j)
+		{
+			uint32_t vertex    = triangle_indices[j];
+			auto     first     = vertex_triangles.begin() + triangle_offsets[vertex];
+			auto     last      = first + remaining_triangle_counts[vertex];
+			auto     triangle  = std::find(first, last, static_cast<uint32_t>(best_triangle));
+			*triangle          = *(last - 1);
+			remaining_triangle_counts[vertex]--;
+
+			if (std::find(new_cache.begin(), new_cache.end(), vertex) == new_cache.end())
+			{
+				new_cache.push_back(vertex);
+			}
+		}
+
+		// The vertices of the triangle move to the front of the cache
+		for (auto vertex : cache)
+		{
+			if (std::find(new_cache.begin(), new_cache.end(), vertex) == new_cache.end())
+			{
+				new_cache.push_back(vertex);
+			}
+		}
+
+		// Update the scores of the vertices which moved in or out of the cache, and of their triangles
+		for (size_t j = 0; j < new_cache.size(); ++j)
+		{
+			uint32_t vertex = new_cache[j];
+
+			cache_positions[vertex] = j < VERTEX_CACHE_SIZE ? static_cast<int>(j) : -1;
+
+			float score = get_vertex_score(cache_positions[vertex], remaining_triangle_counts[vertex]);
+			float delta = score - vertex_scores[vertex];
+
+			vertex_scores[vertex] = score;
+
+			for (uint32_t k = 0; k < remaining_triangle_counts[vertex]; ++k)
+			{
+				triangle_scores[vertex_triangles[triangle_offsets[vertex] + k]] += delta;
+			}
+		}
+
+		// Pick the best triangle using a vertex in the cache
+		best_triangle    = -1;
+		float best_score = -1.0f;
+
+		new_cache.resize(std::min(new_cache.size(), VERTEX_CACHE_SIZE));
+		for (auto vertex : new_cache)
+		{
+			for (uint32_t k = 0; k < remaining_triangle_counts[vertex]; ++k)
+			{
+				uint32_t triangle = vertex_triangles[triangle_offsets[vertex] + k];
+				if (triangle_scores[triangle] > best_score)
+				{
+					best_triangle = triangle;
+					best_score    = triangle_scores[triangle];
+				}
+			}
+		}
+
+		cache.swap(new_cache);
+	}
+
+	// Keep any trailing indices of an incomplete triangle
+	result.insert(result.end(), indices.begin() + triangle_count * 3, indices.end());
+
+	indices.swap(result);
+}
+
+void optimize_overdraw(std::vector<uint32_t> &indices, const std::vector<glm::vec3> &positions)
+{
+	size_t triangle_count = indices.size() / 3;
+	if (triangle_count < 2)
+	{
+		return;
+	}
+
+	// A new cluster starts at each triangle whose three vertices miss the cache
+	std::vector<size_t>   cluster_starts{0};
+	std::vector<uint32_t> cache_timestamps(positions.size(), 0);
+	uint32_t              timestamp = OVERDRAW_CACHE_SIZE + 1;
+
+	for (size_t triangle = 0; triangle < triangle_count; ++triangle)
+	{
+		uint32_t miss_count = 0;
+		for (size_t j = 0; j < 3; ++j)
+		{
+			uint32_t vertex = indices[triangle * 3 + j];
+			if (timestamp - cache_timestamps[vertex] > OVERDRAW_CACHE_SIZE)
+			{
+				cache_timestamps[vertex] = timestamp++;
+				miss_count++;
+			}
+		}
+
+		if (miss_count == 3 && triangle > 0)
+		{
+			cluster_starts.push_back(triangle);
+		}
+	}
+	cluster_starts.push_back(triangle_count);
+
+	size_t cluster_count = cluster_starts.size() - 1;
+	if (cluster_count < 2)
+	{
+		return;
+	}
+
+	// Area weighted centroid and normal of each cluster
+	std::vector<glm::vec3> cluster_centroids(cluster_count, glm::vec3(0.0f));
+	std::vector<glm::vec3> cluster_normals(cluster_count, glm::vec3(0.0f));
+
+	glm::vec3 mesh_centroid{0.0f};
+	float     mesh_area{0.0f};
+
+	for (size_t cluster = 0; cluster < cluster_count; ++cluster)
+	{
+		float cluster_area = 0.0f;
+
+		for (size_t triangle = cluster_starts[cluster]; triangle < cluster_starts[cluster + 1]; ++triangle)
+		{
+			const auto &p0 = positions[indices[triangle * 3]];
+			const auto &p1 = positions[indices[triangle * 3 + 1]];
+			const auto &p2 = positions[indices[triangle * 3 + 2]];
+
+			glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+			float     area   = glm::length(normal);
+
+			cluster_centroids[cluster] += (p0 + p1 + p2) * (area / 3.0f);
+			cluster_normals[cluster] += normal;
+			cluster_area += area;
+		}
+
+		mesh_centroid += cluster_centroids[cluster];
+		mesh_area += cluster_area;
+
+		if (cluster_area > 0.0f)
+		{
+			cluster_centroids[cluster] /= cluster_area;
+		}
+	}
+
+	if (mesh_area > 0.0f)
+	{
+		mesh_centroid /= mesh_area;
+	}
+
+	// Clusters on the outside of the mesh facing outwards are the most likely to occlude the others
+	std::vector<float> sort_keys(cluster_count);
+	for (size_t cluster = 0; cluster < cluster_count; ++cluster)
+	{
+		float normal_length = glm::length(cluster_normals[cluster]);
+
+		sort_keys[cluster] = normal_length > 0.0f ? glm::dot(cluster_centroids[cluster] - mesh_centroid, cluster_normals[cluster] / normal_length) : 0.0f;
+	}
+
+	std::vector<size_t> cluster_order(cluster_count);
+	std::iota(cluster_order.begin(), cluster_order.end(), 0);
+	std::stable_sort(cluster_order.begin(), cluster_order.end(), [&sort_keys](size_t a, size_t b) { return sort_keys[a] > sort_keys[b]; });
+
+	std::vector<uint32_t> result;
+	result.reserve(indices.size());
+
+	for (auto cluster : cluster_order)
+	{
+		result.insert(result.end(), indices.begin() + cluster_starts[cluster] * 3, indices.begin() + cluster_starts[cluster + 1] * 3);
+	}
+
+	result.insert(result.end(), indices.begin() + triangle_count * 3, indices.end());
+
+	indices.swap(result);
+}
+
+std::vector<uint32_t> simplify_mesh(const std::vector<uint32_t> &indices, const std::vector<glm::vec3> &positions, size_t target_index_count, float &error)
+{
+	error = 0.0f;
+
+	size_t triangle_count = indices.size() / 3;
+	if (indices.size() <= target_index_count || triangle_count == 0)
+	{
+		return indices;
+	}
+
+	// Vertices referenced by the triangles, and their bounds
+	std::vector<uint32_t> vertices;
+	std::vector<uint8_t>  referenced(positions.size(), 0);
+
+	glm::vec3 min{std::numeric_limits<float>::max()};
+	glm::vec3 max{std::numeric_limits<float>::lowest()};
+
+	for (size_t i = 0; i < triangle_count * 3; ++i)
+	{
+		uint32_t vertex = indices[i];
+		if (!referenced[vertex])
+		{
+			referenced[vertex] = 1;
+			vertices.push_back(vertex);
+
+			min = glm::min(min, positions[vertex]);
+			max = glm::max(max, positions[vertex]);
+		}
+	}
+
+	float extent = std::max(std::max(max.x - min.x, max.y - min.y), max.z - min.z);
+	if (extent <= 0.0f)
+	{
+		return indices;
+	}
+
+	// Quadric of the planes of the triangles around each vertex, weighted by the triangle areas
+	std::vector<Quadric> vertex_quadrics(positions.size(), Quadric{});
+	for (size_t triangle = 0; triangle < triangle_count; ++triangle)
+	{
+		const auto &p0 = positions[indices[triangle * 3]];
+		const auto &p1 = positions[indices[triangle * 3 + 1]];
+		const auto &p2 = positions[indices[triangle * 3 + 2]];
+
+		glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+		float     length = glm::length(normal);
+		if (length == 0.0f)
+		{
+			continue;
+		}
+
+		normal /= length;
+
+		Quadric quadric{};
+		quadric.add_plane(normal, -glm::dot(normal, p0), 0.5f * length);
+
+		for (size_t j = 0; j < 3; ++j)
+		{
+			vertex_quadrics[indices[triangle * 3 + j]].add(quadric);
+		}
+	}
+
+	std::vector<uint32_t>                  vertex_cells(positions.size());
+	std::vector<Quadric>                   cell_quadrics;
+	std::vector<uint32_t>                  cell_vertices;
+	std::vector<float>                     cell_errors;
+	std::unordered_map<uint64_t, uint32_t> cell_indices;
+
+	auto cluster = [&](uint32_t grid_size, std::vector<uint32_t> &result) {
+		float cell_size = extent / grid_size;
+
+		cell_indices.clear();
+		cell_quadrics.clear();
+
+		for (auto vertex : vertices)
+		{
+			glm::vec3 cell = glm::min(glm::floor((positions[vertex] - min) / cell_size), glm::vec3(static_cast<float>(grid_size - 1)));
+
+			uint64_t key = static_cast<uint64_t>(cell.x) + grid_size * (static_cast<uint64_t>(cell.y) + grid_size * static_cast<uint64_t>(cell.z));
+
+			auto it = cell_indices.emplace(key, static_cast<uint32_t>(cell_indices.size())).first;
+			if (it->second == cell_quadrics.size())
+			{
+				cell_quadrics.push_back(Quadric{});
+			}
+
+			vertex_cells[vertex] = it->second;
+			cell_quadrics[it->second].add(vertex_quadrics[vertex]);
+		}
+
+		// Each cell collapses to its vertex closest to the planes of all the triangles of the cell
+		cell_vertices.assign(cell_quadrics.size(), 0);
+		cell_errors.assign(cell_quadrics.size(), std::numeric_limits<float>::max());
+
+		for (auto vertex : vertices)
+		{
+			uint32_t cell  = vertex_cells[vertex];
+			float    error = cell_quadrics[cell].get_error(positions[vertex]);
+			if (error < cell_errors[cell])
+			{
+				cell_errors[cell]   = error;
+				cell_vertices[cell] = vertex;
+			}
+		}
+
+		// Keep the triangles whose vertices fall in different cells, once each
+		std::vector<std::array<uint32_t, 3>> triangles;
+		for (size_t triangle = 0; triangle < triangle_count; ++triangle)
+		{
+			std::array<uint32_t, 3> collapsed{cell_vertices[vertex_cells[indices[triangle * 3]]],
+			                                  cell_vertices[vertex_cells[indices[triangle * 3 + 1]]],
+			                                  cell_vertices[vertex_cells[indices[triangle * 3 + 2]]]};
+
+			if (collapsed[0] == collapsed[1] || collapsed[1] == collapsed[2] || collapsed[0] == collapsed[2])
+			{
+				continue;
+			}
+
+			// Start with the smallest index, which keeps the winding
+			std::rotate(collapsed.begin(), std::min_element(collapsed.begin(), collapsed.end()), collapsed.end());
+			triangles.push_back(collapsed);
+		}
+
+		std::sort(triangles.begin(), triangles.end());
+		triangles.erase(std::unique(triangles.begin(), triangles.end()), triangles.end());
+
+		result.clear();
+		for (auto &triangle : triangles)
+		{
+			result.insert(result.end(), triangle.begin(), triangle.end());
+		}
+	};
+
+	// Find the finest grid which simplifies the mesh enough, a single cell collapses all the triangles
+	std::vector<uint32_t> result;
+	std::vector<uint32_t> candidate;
+
+	uint32_t low_grid_size  = 1;
+	uint32_t high_grid_size = MAX_GRID_SIZE;
+
+	cluster(low_grid_size, result);
+
+	while (low_grid_size < high_grid_size)
+	{
+		uint32_t grid_size = (low_grid_size + high_grid_size + 1) / 2;
+
+		cluster(grid_size, candidate);
+
+		if (candidate.size() <= target_index_count)
+		{
+			low_grid_size = grid_size;
+			result.swap(candidate);
+		}
+		else
+		{
+			high_grid_size = grid_size - 1;
+		}
+	}
+
+	error = std::sqrt(3.0f) * extent / low_grid_size;
+
+	return result;
+}
+}        // namespace vkb
@@ -0,0 +1,62 @@
+/* Copyright (c) 2023, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "common/error.h"
+
+VKBP_DISABLE_WARNINGS()
+#include "common/glm_common.h"
+VKBP_ENABLE_WARNINGS()
+
+namespace vkb
+{
+/**
+ * @brief Reorders the triangles of a triangle list so that consecutive triangles reuse the vertices left
+ *        in the post-transform vertex cache. Triangles are picked greedily, scored by the cache position
+ *        of their vertices and by the number of triangles left to draw with each vertex.
+ * @param indices Indices of the triangle list, reordered in place
+ * @param vertex_count Number of vertices referenced by the indices
+ */
+void optimize_vertex_cache(std::vector<uint32_t> &indices, size_t vertex_count);
+
+/**
+ * @brief Reorders the clusters of triangles of a triangle list optimized for the vertex cache, so that the
+ *        clusters facing away from the center of the mesh are drawn first and occlude the others.
+ *        A cluster starts at each triangle whose three vertices miss the vertex cache, so the vertex
+ *        cache efficiency is mostly preserved.
+ * @param indices Indices of the triangle list, reordered in place
+ * @param positions Positions of the vertices
+ */
+void optimize_overdraw(std::vector<uint32_t> &indices, const std::vector<glm::vec3> &positions);
+
+/**
+ * @brief Simplifies a triangle list by clustering its vertices on a regular grid. Each cell is collapsed
+ *        to the vertex of the cell closest to the planes of the triangles of the cell, so the simplified
+ *        triangles reference the same vertices as the original ones.
+ *        The finest grid producing at most the target number of indices is used.
+ * @param indices Indices of the triangle list
+ * @param positions Positions of the vertices
+ * @param target_index_count Maximum number of indices of the simplified triangle list
+ * @param error Set to the largest distance a vertex may have moved by, the diagonal of a grid cell
+ * @return The indices of the simplified triangle list
+ */
+std::vector<uint32_t> simplify_mesh(const std::vector<uint32_t> &indices, const std::vector<glm::vec3> &positions, size_t target_index_count, float &error);
+}        // namespace vkb
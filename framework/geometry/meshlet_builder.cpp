@@ -0,0 +1,301 @@
+/* Copyright (c) 2023, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "meshlet_builder.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <sstream>
+
+#include "common/helpers.h"
+#include "common/logging.h"
+#include "geometry/mesh_optimizer.h"
+#include "platform/filesystem.h"
+
+namespace vkb
+{
+namespace
+{
+// Identifies meshlet cache files, and their layout version
+constexpr uint32_t MESHLET_CACHE_MAGIC = 0x4d534c54;
+
+constexpr uint32_t MESHLET_CACHE_VERSION = 1;
+
+// Meshlets whose normals spread further than this from their axis are never culled by their cone
+constexpr float MIN_NORMAL_CONE_COSINE = 0.1f;
+
+/**
+ * @brief 64-bit FNV-1a hash of a range of bytes
+ */
+uint64_t hash_bytes(uint64_t hash, const void *data, size_t size)
+{
+	auto bytes = static_cast<const uint8_t *>(data);
+
+	for (size_t i = 0; i < size; ++i)
+	{
+		hash = (hash ^ bytes[i]) * 0x100000001b3ull;
+	}
+
+	return hash;
+}
+
+/**
+ * @brief Computes the bounding sphere and the normal cone of a meshlet from its vertices and triangles
+ */
+void compute_meshlet_bounds(Meshlet &meshlet, const MeshletData &data, const std::vector<glm::vec3> &positions)
+{
+	glm::vec3 min{std::numeric_limits<float>::max()};
+	glm::vec3 max{std::numeric_limits<float>::lowest()};
+
+	for (uint32_t i = 0; i < meshlet.vertex_count; ++i)
+	{
+		const auto &position = positions[data.vertices[meshlet.vertex_offset + i]];
+
+		min = glm::min(min, position);
+		max = glm::max(max, position);
+	}
+
+	glm::vec3 center = (min + max) * 0.5f;
+	float     radius = 0.0f;
+
+	for (uint32_t i = 0; i < meshlet.vertex_count; ++i)
+	{
+		radius = std::max(radius, glm::length(positions[data.vertices[meshlet.vertex_offset + i]] - center));
+	}
+
+	meshlet.bounding_sphere = glm::vec4(center, radius);
+
+	std::vector<glm::vec3> normals;
+	normals.reserve(meshlet.triangle_count);
+
+	glm::vec3 axis{0.0f};
+
+	for (uint32_t i = 0; i < meshlet.triangle_count; ++i)
+	{
+		uint32_t triangle = data.triangles[meshlet.triangle_offset + i];
+
+		const auto &a = positions[data.vertices[meshlet.vertex_offset + (triangle & 0xff)]];
+		const auto &b = positions[data.vertices[meshlet.vertex_offset + ((triangle >> 8) & 0xff)]];
+		const auto &c = positions[data.vertices[meshlet.vertex_offset + ((triangle >> 16) & 0xff)]];
+
+		glm::vec3 normal = glm::cross(b - a, c - a);
+
+		float length = glm::length(normal);
+		if (length > 0.0f)
+		{
+			normals.push_back(normal / length);
+			axis += normals.back();
+		}
+	}
+
+	// Degenerate meshlets and meshlets whose triangles face too many directions are never culled
+	meshlet.normal_cone = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);
+
+	float axis_length = glm::length(axis);
+	if (normals.empty() || axis_length == 0.0f)
+	{
+		return;
+	}
+
+	axis /= axis_length;
+
+	float min_cosine = 1.0f;
+	for (const auto &normal : normals)
+	{
+		min_cosine = std::min(min_cosine, glm::dot(normal, axis));
+	}
+
+	if (min_cosine < MIN_NORMAL_CONE_COSINE)
+	{
+		return;
+	}
+
+	// All the triangles face away from the viewer when the view direction is within this angle of the axis
+	meshlet.normal_cone = glm::vec4(axis, std::sqrt(1.0f - min_cosine * min_cosine));
+}
+
+bool read_meshlet_cache(const std::string &filename, uint64_t key, MeshletData &data)
+{
+	std::vector<uint8_t> file_data;
+
+	try
+	{
+		file_data = fs::read_temp(filename);
+	}
+	catch (std::runtime_error &)
+	{
+		return false;
+	}
+
+	std::istringstream is{std::string{file_data.begin(), file_data.end()}};
+
+	uint32_t magic    = 0;
+	uint32_t version  = 0;
+	uint64_t file_key = 0;
+	read(is, magic, version, file_key);
+
+	if (!is || magic != MESHLET_CACHE_MAGIC || version != MESHLET_CACHE_VERSION || file_key != key)
+	{
+		return false;
+	}
+
+	size_t meshlet_count  = 0;
+	size_t vertex_count   = 0;
+	size_t triangle_count = 0;
+	read(is, meshlet_count, vertex_count, triangle_count);
+
+	// Sizes are checked against the file size before allocating, in case the file was truncated
+	size_t expected_size = static_cast<size_t>(is.tellg()) + meshlet_count * sizeof(Meshlet) + (vertex_count + triangle_count) * sizeof(uint32_t);
+	if (!is || expected_size != file_data.size())
+	{
+		return false;
+	}
+
+	data.meshlets.resize(meshlet_count);
+	data.vertices.resize(vertex_count);
+	data.triangles.resize(triangle_count);
+
+	is.read(reinterpret_cast<char *>(data.meshlets.data()), meshlet_count * sizeof(Meshlet));
+	is.read(reinterpret_cast<char *>(data.vertices.data()), vertex_count * sizeof(uint32_t));
+	is.read(reinterpret_cast<char *>(data.triangles.data()), triangle_count * sizeof(uint32_t));
+
+	return static_cast<bool>(is);
+}
+
+void write_meshlet_cache(const std::string &filename, uint64_t key, const MeshletData &data)
+{
+	std::ostringstream os;
+
+	write(os, MESHLET_CACHE_MAGIC, MESHLET_CACHE_VERSION, key);
+	write(os, data.meshlets.size(), data.vertices.size(), data.triangles.size());
+
+	os.write(reinterpret_cast<const char *>(data.meshlets.data()), data.meshlets.size() * sizeof(Meshlet));
+	os.write(reinterpret_cast<const char *>(data.vertices.data()), data.vertices.size() * sizeof(uint32_t));
+	os.write(reinterpret_cast<const char *>(data.triangles.data()), data.triangles.size() * sizeof(uint32_t));
+
+	auto file_data = os.str();
+
+	try
+	{
+		fs::write_temp(std::vector<uint8_t>{file_data.begin(), file_data.end()}, filename);
+	}
+	catch (std::runtime_error &ex)
+	{
+		LOGW("Failed to write meshlet cache: {}", ex.what());
+	}
+}
+}        // namespace
+
+MeshletData build_meshlets(const std::vector<uint32_t> &triangle_indices, const std::vector<glm::vec3> &positions, uint32_t max_vertex_count, uint32_t max_triangle_count)
+{
+	assert(max_vertex_count >= 3 && max_vertex_count <= 256 && "Meshlet vertices are indexed with 8 bits");
+	assert(max_triangle_count >= 1 && "Meshlets must hold at least one triangle");
+
+	std::vector<uint32_t> indices = triangle_indices;
+	optimize_vertex_cache(indices, positions.size());
+
+	MeshletData data;
+
+	// Index of each mesh vertex in the current meshlet, if it was added to it
+	std::vector<uint32_t> meshlet_vertex_indices(positions.size(), ~0u);
+
+	Meshlet meshlet{};
+
+	auto finish_meshlet = [&]() {
+		if (meshlet.triangle_count == 0)
+		{
+			return;
+		}
+
+		compute_meshlet_bounds(meshlet, data, positions);
+
+		for (uint32_t i = 0; i < meshlet.vertex_count; ++i)
+		{
+			meshlet_vertex_indices[data.vertices[meshlet.vertex_offset + i]] = ~0u;
+		}
+
+		data.meshlets.push_back(meshlet);
+
+		meshlet                 = Meshlet{};
+		meshlet.vertex_offset   = static_cast<uint32_t>(data.vertices.size());
+		meshlet.triangle_offset = static_cast<uint32_t>(data.triangles.size());
+	};
+
+	for (size_t i = 0; i + 2 < indices.size(); i += 3)
+	{
+		uint32_t new_vertex_count = 0;
+		for (size_t j = 0; j < 3; ++j)
+		{
+			if (meshlet_vertex_indices[indices[i + j]] == ~0u)
+			{
+				new_vertex_count++;
+			}
+		}
+
+		if (meshlet.vertex_count + new_vertex_count > max_vertex_count || meshlet.triangle_count == max_triangle_count)
+		{
+			finish_meshlet();
+		}
+
+		uint32_t triangle = 0;
+		for (size_t j = 0; j < 3; ++j)
+		{
+			uint32_t &meshlet_vertex_index = meshlet_vertex_indices[indices[i + j]];
+			if (meshlet_vertex_index == ~0u)
+			{
+				meshlet_vertex_index = meshlet.vertex_count++;
+				data.vertices.push_back(indices[i + j]);
+			}
+
+			triangle |= meshlet_vertex_index << (8 * j);
+		}
+
+		data.triangles.push_back(triangle);
+		meshlet.triangle_count++;
+	}
+
+	finish_meshlet();
+
+	return data;
+}
+
+MeshletData build_cached_meshlets(const std::vector<uint32_t> &indices, const std::vector<glm::vec3> &positions, uint32_t max_vertex_count, uint32_t max_triangle_count)
+{
+	uint64_t key = 0xcbf29ce484222325ull;
+	key          = hash_bytes(key, indices.data(), indices.size() * sizeof(uint32_t));
+	key          = hash_bytes(key, positions.data(), positions.size() * sizeof(glm::vec3));
+	key          = hash_bytes(key, &max_vertex_count, sizeof(max_vertex_count));
+	key          = hash_bytes(key, &max_triangle_count, sizeof(max_triangle_count));
+
+	std::stringstream filename;
+	filename << "meshlets_" << std::hex << key << ".bin";
+
+	MeshletData data;
+
+	if (read_meshlet_cache(filename.str(), key, data))
+	{
+		return data;
+	}
+
+	data = build_meshlets(indices, positions, max_vertex_count, max_triangle_count);
+
+	write_meshlet_cache(filename.str(), key, data);
+
+	return data;
+}
+}        // namespace vkb
@@ -0,0 +1,88 @@
+/* Copyright (c) 2023, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "common/error.h"
+
+VKBP_DISABLE_WARNINGS()
+#include "common/glm_common.h"
+VKBP_ENABLE_WARNINGS()
+
+namespace vkb
+{
+/**
+ * @brief A small group of triangles of a mesh, drawn by one mesh shader workgroup
+ *
+ *        Laid out as read by the meshlet shaders.
+ */
+struct alignas(16) Meshlet
+{
+	// xyz: center of the bounding sphere of the meshlet in model space, w: radius
+	glm::vec4 bounding_sphere;
+
+	// xyz: axis of the cone containing the normals of the triangles, w: sine of the angle between the cone and
+	// the plane orthogonal to its axis, or 1 if the triangles cannot be back-facing all at once
+	glm::vec4 normal_cone;
+
+	// First vertex of the meshlet in the meshlet vertices
+	uint32_t vertex_offset;
+
+	// First triangle of the meshlet in the meshlet triangles
+	uint32_t triangle_offset;
+
+	uint32_t vertex_count;
+
+	uint32_t triangle_count;
+};
+
+/**
+ * @brief The meshlets of a triangle list
+ */
+struct MeshletData
+{
+	std::vector<Meshlet> meshlets;
+
+	// Index of each meshlet vertex in the vertices of the mesh
+	std::vector<uint32_t> vertices;
+
+	// Meshlet triangles, with the three indices of each triangle in the meshlet vertices packed in the low 24 bits
+	std::vector<uint32_t> triangles;
+};
+
+/**
+ * @brief Partitions a triangle list into meshlets. The triangles are reordered for the vertex cache, so that
+ *        consecutive triangles share most of their vertices, then added to the current meshlet in order
+ *        until it runs out of vertices or triangles.
+ * @param indices Indices of the triangle list
+ * @param positions Positions of the vertices
+ * @param max_vertex_count Maximum number of vertices of a meshlet, at most 256
+ * @param max_triangle_count Maximum number of triangles of a meshlet
+ */
+MeshletData build_meshlets(const std::vector<uint32_t> &indices, const std::vector<glm::vec3> &positions, uint32_t max_vertex_count, uint32_t max_triangle_count);
+
+/**
+ * @brief Builds the meshlets of a triangle list like build_meshlets, or loads them from a cache file in
+ *        temporary storage written when they were last built for the same triangle list
+ * @return The meshlets of the triangle list
+ */
+MeshletData build_cached_meshlets(const std::vector<uint32_t> &indices, const std::vector<glm::vec3> &positions, uint32_t max_vertex_count, uint32_t max_triangle_count);
+}        // namespace vkb
@@ -19,6 +19,7 @@
 #define TINYGLTF_IMPLEMENTATION
 #include "gltf_loader.h"
 
+#include <algorithm>
 #include <limits>
 #include <queue>
 
@@ -35,6 +36,7 @@ VKBP_ENABLE_WARNINGS()
 #include "common/vk_common.h"
 #include "core/device.h"
 #include "core/image.h"
+#include "geometry/mesh_optimizer.h"
 #include "platform/filesystem.h"
 #include "scene_graph/components/camera.h"
 #include "scene_graph/components/image.h"
@@ -44,6 +46,7 @@ VKBP_ENABLE_WARNINGS()
 #include "scene_graph/components/pbr_material.h"
 #include "scene_graph/components/perspective_camera.h"
 #include "scene_graph/components/sampler.h"
+#include "scene_graph/components/skin.h"
 #include "scene_graph/components/sub_mesh.h"
 #include "scene_graph/components/texture.h"
 #include "scene_graph/components/transform.h"
@@ -51,7 +54,7 @@ VKBP_ENABLE_WARNINGS()
 #include "scene_graph/scene.h"
 #include "scene_graph/scripts/animation.h"
 
-#include <ctpl_stl.h>
+#include "job_system.h"
 
 namespace vkb
 {
@@ -334,6 +337,44 @@ inline void upload_image_to_gpu(CommandBuffer &command_buffer, core::Buffer &sta
 	}
 }
 
+/**
+ * @brief Waits for jobs when going out of scope, so that they never outlive the data they write to
+ */
+class JobsGuard
+{
+  public:
+	JobsGuard(JobSystem *job_system, const std::vector<JobSystem::JobHandle> &jobs) :
+	    job_system{job_system},
+	    jobs{jobs}
+	{
+	}
+
+	~JobsGuard()
+	{
+		if (!job_system)
+		{
+			return;
+		}
+
+		for (auto &job : jobs)
+		{
+			try
+			{
+				job_system->wait(job);
+			}
+			catch (...)
+			{
+				// Failed jobs were already reported by the wait which unwound the scope, if any
+			}
+		}
+	}
+
+  private:
+	JobSystem *job_system;
+
+	const std::vector<JobSystem::JobHandle> &jobs;
+};
+
 static inline bool texture_needs_srgb_colorspace(const std::string &name)
 {
 	// The gltf spec states that the base and emissive textures MUST be encoded with the sRGB
@@ -353,9 +394,15 @@ static inline bool texture_needs_srgb_colorspace(const std::string &name)
 std::unordered_map<std::string, bool> GLTFLoader::supported_extensions = {
     {KHR_LIGHTS_PUNCTUAL_EXTENSION, false}};
 
-GLTFLoader::GLTFLoader(Device const &device) :
-    device{device}
+GLTFLoader::GLTFLoader(Device const &device, JobSystem *job_system) :
+    device{device},
+    job_system{job_system}
+{
+}
+
+void GLTFLoader::set_mesh_lod_count(uint32_t lod_count)
 {
+	mesh_lod_count = lod_count;
 }
 
 std::unique_ptr<sg::Scene> GLTFLoader::read_scene_from_file(const std::string &file_name, int scene_index)
@@ -496,28 +543,29 @@ sg::Scene GLTFLoader::load_scene(int scene_index)
 	timer.start();
 
 	// Load images
-	auto thread_count = std::thread::hardware_concurrency();
-	thread_count      = thread_count == 0 ? 1 : thread_count;
-	ctpl::thread_pool thread_pool(thread_count);
-
 	auto image_count = to_u32(model.images.size());
 
-	std::vector<std::future<std::unique_ptr<sg::Image>>> image_component_futures;
-	for (size_t image_index = 0; image_index < image_count; image_index++)
-	{
-		auto fut = thread_pool.push(
-		    [this, image_index](size_t) {
-			    auto image = parse_image(model.images[image_index]);
+	std::vector<std::unique_ptr<sg::Image>> image_components(image_count);
 
-			    LOGI("Loaded gltf image #{} ({})", image_index, model.images[image_index].uri.c_str());
+	auto load_image = [this, &image_components](size_t image_index) {
+		image_components[image_index] = parse_image(model.images[image_index]);
 
-			    return image;
-		    });
+		LOGI("Loaded gltf image #{} ({})", image_index, model.images[image_index].uri.c_str());
+	};
 
-		image_component_futures.push_back(std::move(fut));
+	std::vector<JobSystem::JobHandle> image_jobs;
+	if (job_system)
+	{
+		for (size_t image_index = 0; image_index < image_count; image_index++)
+		{
+			image_jobs.push_back(job_system->submit([&load_image, image_index](uint32_t) { load_image(image_index); }));
+		}
 	}
 
-	std::vector<std::unique_ptr<sg::Image>> image_components;
+	// The jobs write to the image components, they must complete before these are released on any exit
+	JobsGuard image_jobs_guard{job_system, image_jobs};
+
+	auto thread_count = job_system ? job_system->get_thread_count() : 1;
 
 	// Upload images to GPU. We do this in batches of 64MB of data to avoid needing
 	// double the amount of memory (all the images and all the corresponding buffers).
@@ -537,7 +585,14 @@ sg::Scene GLTFLoader::load_scene(int scene_index)
 		while (image_index < image_count && batch_size < 64 * 1024 * 1024)
 		{
 			// Wait for this image to complete loading, then stage for upload
-			image_components.push_back(image_component_futures[image_index].get());
+			if (job_system)
+			{
+				job_system->wait(image_jobs[image_index]);
+			}
+			else
+			{
+				load_image(image_index);
+			}
 
 			auto &image = image_components[image_index];
 
@@ -669,6 +724,9 @@ sg::Scene GLTFLoader::load_scene(int scene_index)
 	{
 		auto mesh = parse_mesh(gltf_mesh);
 
+		// Default weights of the morph targets
+		mesh->set_morph_weights(std::vector<float>(gltf_mesh.weights.begin(), gltf_mesh.weights.end()));
+
 		for (size_t i_primitive = 0; i_primitive < gltf_mesh.primitives.size(); i_primitive++)
 		{
 			const auto &gltf_primitive = gltf_mesh.primitives[i_primitive];
@@ -686,11 +744,26 @@ sg::Scene GLTFLoader::load_scene(int scene_index)
 				if (attrib_name == "position")
 				{
 					assert(attribute.second < model.accessors.size());
-					submesh->vertices_count = to_u32(model.accessors[attribute.second].count);
+					auto &accessor = model.accessors[attribute.second];
+
+					submesh->vertices_count = to_u32(accessor.count);
+
+					// glTF requires min and max values for position accessors
+					if (accessor.minValues.size() == 3 && accessor.maxValues.size() == 3)
+					{
+						mesh->update_bounds({glm::vec3(accessor.minValues[0], accessor.minValues[1], accessor.minValues[2]),
+						                     glm::vec3(accessor.maxValues[0], accessor.maxValues[1], accessor.maxValues[2])});
+					}
 				}
 
 				VkBufferUsageFlags buffer_usage_flags = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
 
+				// The GPU skinning reads the vertices to deform in a compute shader
+				if (attrib_name == "position" || attrib_name == "normal" || attrib_name == "joints_0" || attrib_name == "weights_0")
+				{
+					buffer_usage_flags |= VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+				}
+
 #ifdef ENABLE_RAYTRACING_SCENE_GRAPH
 				if (attrib_name == "position")
 				{
@@ -718,6 +791,13 @@ sg::Scene GLTFLoader::load_scene(int scene_index)
 				LOGI("Loaded gltf mesh '{}', primitive #{}: '{}' vertex buffer with stride '{}' and format '{}'", gltf_mesh.name, i_primitive, attrib_name, attrib.stride, vkb::to_string(attrib.format));
 			}
 
+			if (!gltf_primitive.targets.empty())
+			{
+				load_morph_targets(*submesh, gltf_primitive);
+
+				LOGI("Loaded gltf mesh '{}', primitive #{}: {} morph targets", gltf_mesh.name, i_primitive, submesh->morph_target_count);
+			}
+
 			if (gltf_primitive.indices >= 0)
 			{
 				submesh->vertex_indices = to_u32(get_attribute_size(&model, gltf_primitive.indices));
@@ -744,6 +824,12 @@ sg::Scene GLTFLoader::load_scene(int scene_index)
 						break;
 				}
 
+				// Only triangle lists can be simplified, the default mode
+				if (mesh_lod_count > 0 && (gltf_primitive.mode == -1 || gltf_primitive.mode == TINYGLTF_MODE_TRIANGLES))
+				{
+					build_lods(*submesh, gltf_primitive, index_data);
+				}
+
 				VkBufferUsageFlags index_buffer_usage_flags = VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
 
 #ifdef ENABLE_RAYTRACING_SCENE_GRAPH
@@ -831,7 +917,7 @@ sg::Scene GLTFLoader::load_scene(int scene_index)
 
 		if (auto extension = get_extension(gltf_node.extensions, KHR_LIGHTS_PUNCTUAL_EXTENSION))
 		{
-			auto lights      = scene.get_components<sg::Light>();
+			auto &lights     = scene.get_component_view<sg::Light>();
 			int  light_index = extension->Get("light").Get<int>();
 			assert(light_index < lights.size());
 			auto light = lights[light_index];
@@ -844,6 +930,46 @@ sg::Scene GLTFLoader::load_scene(int scene_index)
 		nodes.push_back(std::move(node));
 	}
 
+	// Load skins, once all of their joint nodes exist
+	std::vector<sg::Skin *> skins;
+
+	for (auto &gltf_skin : model.skins)
+	{
+		auto skin = std::make_unique<sg::Skin>(gltf_skin.name);
+
+		std::vector<uint8_t> inverse_bind_data;
+		if (gltf_skin.inverseBindMatrices >= 0)
+		{
+			inverse_bind_data = get_attribute_data(&model, gltf_skin.inverseBindMatrices);
+		}
+
+		for (size_t joint_index = 0; joint_index < gltf_skin.joints.size(); ++joint_index)
+		{
+			// Inverse bind matrices default to identity
+			glm::mat4 inverse_bind_matrix{1.0f};
+			if ((joint_index + 1) * sizeof(glm::mat4) <= inverse_bind_data.size())
+			{
+				inverse_bind_matrix = glm::make_mat4(reinterpret_cast<const float *>(inverse_bind_data.data()) + joint_index * 16);
+			}
+
+			assert(gltf_skin.joints[joint_index] < nodes.size());
+			skin->add_joint(*nodes[gltf_skin.joints[joint_index]], inverse_bind_matrix);
+		}
+
+		skins.push_back(skin.get());
+		scene.add_component(std::move(skin));
+	}
+
+	for (size_t node_index = 0; node_index < model.nodes.size(); ++node_index)
+	{
+		int skin_index = model.nodes[node_index].skin;
+		if (skin_index >= 0)
+		{
+			assert(skin_index < skins.size());
+			nodes[node_index]->set_component(*skins[skin_index]);
+		}
+	}
+
 	std::vector<std::unique_ptr<sg::Animation>> animations;
 
 	// Load animations
@@ -851,7 +977,11 @@ sg::Scene GLTFLoader::load_scene(int scene_index)
 	{
 		auto &gltf_animation = model.animations[animation_index];
 
-		std::vector<sg::AnimationSampler> samplers;
+		auto animation = std::make_unique<sg::Animation>(gltf_animation.name);
+
+		// Samplers are shared by the channels, their keyframe times give the duration of the animation
+		std::vector<uint32_t>  sampler_indices(gltf_animation.samplers.size(), std::numeric_limits<uint32_t>::max());
+		std::vector<glm::vec2> sampler_times(gltf_animation.samplers.size());
 
 		for (size_t sampler_index = 0; sampler_index < gltf_animation.samplers.size(); ++sampler_index)
 		{
@@ -914,10 +1044,17 @@ sg::Scene GLTFLoader::load_scene(int scene_index)
 				}
 			}
 
-			samplers.push_back(sampler);
-		}
+			if (sampler.inputs.empty())
+			{
+				LOGW("Gltf animation sampler #{} has no keyframes", sampler_index);
+				continue;
+			}
 
-		auto animation = std::make_unique<sg::Animation>(gltf_animation.name);
+			auto time_range = std::minmax_element(sampler.inputs.begin(), sampler.inputs.end());
+
+			sampler_times[sampler_index]   = glm::vec2(*time_range.first, *time_range.second);
+			sampler_indices[sampler_index] = animation->add_sampler(sampler);
+		}
 
 		for (size_t channel_index = 0; channel_index < gltf_animation.channels.size(); ++channel_index)
 		{
@@ -947,24 +1084,15 @@ sg::Scene GLTFLoader::load_scene(int scene_index)
 				continue;
 			}
 
-			float start_time{std::numeric_limits<float>::max()};
-			float end_time{std::numeric_limits<float>::min()};
-
-			for (auto input : samplers[gltf_channel.sampler].inputs)
+			if (sampler_indices[gltf_channel.sampler] == std::numeric_limits<uint32_t>::max())
 			{
-				if (input < start_time)
-				{
-					start_time = input;
-				}
-				if (input > end_time)
-				{
-					end_time = input;
-				}
+				LOGW("Gltf animation channel #{} has an unsupported sampler", channel_index);
+				continue;
 			}
 
-			animation->update_times(start_time, end_time);
+			animation->update_times(sampler_times[gltf_channel.sampler].x, sampler_times[gltf_channel.sampler].y);
 
-			animation->add_channel(*nodes[gltf_channel.target_node], target, samplers[gltf_channel.sampler]);
+			animation->add_channel(*nodes[gltf_channel.target_node], target, sampler_indices[gltf_channel.sampler]);
 		}
 
 		animations.push_back(std::move(animation));
@@ -1050,6 +1178,127 @@ sg::Scene GLTFLoader::load_scene(int scene_index)
 	return scene;
 }
 
+void GLTFLoader::build_lods(sg::SubMesh &submesh, const tinygltf::Primitive &gltf_primitive, std::vector<uint8_t> &index_data)
+{
+	auto position_it = gltf_primitive.attributes.find("POSITION");
+	if (position_it == gltf_primitive.attributes.end() || get_attribute_format(&model, position_it->second) != VK_FORMAT_R32G32B32_SFLOAT)
+	{
+		return;
+	}
+
+	auto   position_data   = get_attribute_data(&model, position_it->second);
+	size_t position_stride = get_attribute_stride(&model, position_it->second);
+
+	std::vector<glm::vec3> positions(submesh.vertices_count);
+	for (uint32_t vertex = 0; vertex < submesh.vertices_count; ++vertex)
+	{
+		positions[vertex] = glm::make_vec3(reinterpret_cast<const float *>(position_data.data() + vertex * position_stride));
+	}
+
+	std::vector<uint32_t> indices(submesh.vertex_indices);
+	for (uint32_t i = 0; i < submesh.vertex_indices; ++i)
+	{
+		if (submesh.index_type == VK_INDEX_TYPE_UINT16)
+		{
+			indices[i] = reinterpret_cast<const uint16_t *>(index_data.data())[i];
+		}
+		else
+		{
+			indices[i] = reinterpret_cast<const uint32_t *>(index_data.data())[i];
+		}
+	}
+
+	optimize_vertex_cache(indices, positions.size());
+	optimize_overdraw(indices, positions);
+
+	submesh.lods.clear();
+	submesh.lods.push_back({0, submesh.vertex_indices, 0.0f});
+
+	// Each level halves the triangles of the previous one, all of them are simplified from the original triangles
+	std::vector<uint32_t> lod_indices{indices};
+	for (uint32_t lod = 1; lod < mesh_lod_count; ++lod)
+	{
+		size_t target_index_count = (submesh.vertex_indices >> lod) / 3 * 3;
+
+		float error = 0.0f;
+		auto  simplified_indices = simplify_mesh(indices, positions, target_index_count, error);
+
+		// Stop once the mesh cannot be simplified any further
+		if (simplified_indices.empty() || simplified_indices.size() >= submesh.lods.back().index_count)
+		{
+			break;
+		}
+
+		optimize_vertex_cache(simplified_indices, positions.size());
+
+		submesh.lods.push_back({to_u32(lod_indices.size()), to_u32(simplified_indices.size()), error});
+		lod_indices.insert(lod_indices.end(), simplified_indices.begin(), simplified_indices.end());
+	}
+
+	// Write the levels back with the index type of the primitive
+	if (submesh.index_type == VK_INDEX_TYPE_UINT16)
+	{
+		std::vector<uint16_t> lod_indices_16(lod_indices.begin(), lod_indices.end());
+		index_data.assign(reinterpret_cast<const uint8_t *>(lod_indices_16.data()), reinterpret_cast<const uint8_t *>(lod_indices_16.data() + lod_indices_16.size()));
+	}
+	else
+	{
+		index_data.assign(reinterpret_cast<const uint8_t *>(lod_indices.data()), reinterpret_cast<const uint8_t *>(lod_indices.data() + lod_indices.size()));
+	}
+
+	LOGI("Built {} levels of detail for {}, from {} down to {} triangles", submesh.lods.size(), submesh.get_name(),
+	     submesh.lods.front().index_count / 3, submesh.lods.back().index_count / 3);
+}
+
+void GLTFLoader::load_morph_targets(sg::SubMesh &submesh, const tinygltf::Primitive &gltf_primitive)
+{
+	const uint32_t vertex_count = submesh.vertices_count;
+	const uint32_t target_count = to_u32(gltf_primitive.targets.size());
+
+	// Attributes missing from a target do not move the vertices
+	std::vector<glm::vec4> offsets(2 * target_count * vertex_count, glm::vec4(0.0f));
+
+	for (uint32_t target_index = 0; target_index < target_count; ++target_index)
+	{
+		for (auto &attribute : gltf_primitive.targets[target_index])
+		{
+			uint32_t offset_index = 2 * target_index * vertex_count;
+			if (attribute.first == "NORMAL")
+			{
+				offset_index += vertex_count;
+			}
+			else if (attribute.first != "POSITION")
+			{
+				continue;
+			}
+
+			auto &accessor = model.accessors[attribute.second];
+			if (accessor.bufferView < 0 || accessor.count != vertex_count || get_attribute_format(&model, attribute.second) != VK_FORMAT_R32G32B32_SFLOAT)
+			{
+				LOGW("Gltf morph target #{} has an unsupported {} accessor", target_index, attribute.first);
+				continue;
+			}
+
+			auto   data   = get_attribute_data(&model, attribute.second);
+			size_t stride = get_attribute_stride(&model, attribute.second);
+
+			for (uint32_t vertex = 0; vertex < vertex_count; ++vertex)
+			{
+				offsets[offset_index + vertex] = glm::vec4(glm::make_vec3(reinterpret_cast<const float *>(data.data() + vertex * stride)), 0.0f);
+			}
+		}
+	}
+
+	submesh.morph_target_buffer = std::make_unique<core::Buffer>(device,
+	                                                             offsets.size() * sizeof(glm::vec4),
+	                                                             VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+	                                                             VMA_MEMORY_USAGE_GPU_TO_CPU);
+	submesh.morph_target_buffer->set_debug_name(fmt::format("{}: morph target buffer", submesh.get_name()));
+	submesh.morph_target_buffer->update(reinterpret_cast<const uint8_t *>(offsets.data()), offsets.size() * sizeof(glm::vec4));
+
+	submesh.morph_target_count = target_count;
+}
+
 std::unique_ptr<sg::SubMesh> GLTFLoader::load_model(uint32_t index)
 {
 	auto submesh = std::make_unique<sg::SubMesh>();
@@ -35,6 +35,7 @@
 namespace vkb
 {
 class Device;
+class JobSystem;
 
 namespace sg
 {
@@ -71,7 +72,12 @@ struct TypeCast
 class GLTFLoader
 {
   public:
-	GLTFLoader(Device const &device);
+	/**
+	 * @param device Device to upload the scene to
+	 * @param job_system Job system used to decode the images in parallel, if any.
+	 *                   Without one, images are decoded on the calling thread.
+	 */
+	GLTFLoader(Device const &device, JobSystem *job_system = nullptr);
 
 	virtual ~GLTFLoader() = default;
 
@@ -83,6 +89,13 @@ class GLTFLoader
 	 */
 	std::unique_ptr<sg::SubMesh> read_model_from_file(const std::string &file_name, uint32_t index);
 
+	/**
+	 * @brief Sets the number of levels of detail generated for the indexed triangle submeshes of the scenes read.
+	 *        The indices of every level are reordered for the vertex cache, and those of the most detailed one for overdraw.
+	 * @param lod_count Number of levels including the original triangles, zero to load the indices unchanged
+	 */
+	void set_mesh_lod_count(uint32_t lod_count);
+
   protected:
 	virtual std::unique_ptr<sg::Node> parse_node(const tinygltf::Node &gltf_node, size_t index) const;
 
@@ -109,6 +122,20 @@ class GLTFLoader
 	 */
 	std::vector<std::unique_ptr<sg::Light>> parse_khr_lights_punctual();
 
+	/**
+	 * @brief Loads the position and normal offsets of the morph targets of a primitive into a storage buffer
+	 *        read by the GPU skinning. The vertex count of the submesh must be set.
+	 */
+	void load_morph_targets(sg::SubMesh &submesh, const tinygltf::Primitive &gltf_primitive);
+
+	/**
+	 * @brief Optimizes the indices of a primitive and appends its simplified levels of detail to them
+	 * @param submesh Submesh of the primitive, whose index type and vertex count must be set
+	 * @param gltf_primitive Primitive to simplify
+	 * @param index_data Indices of the primitive, replaced by the indices of all the levels
+	 */
+	void build_lods(sg::SubMesh &submesh, const tinygltf::Primitive &gltf_primitive, std::vector<uint8_t> &index_data);
+
 	/**
 	 * @brief Checks if the GLTFLoader supports an extension, and that it is present in the glTF file
 	 * @param requested_extension The extension to check
@@ -126,10 +153,14 @@ class GLTFLoader
 
 	Device const &device;
 
+	JobSystem *job_system{nullptr};
+
 	tinygltf::Model model;
 
 	std::string model_path;
 
+	uint32_t mesh_lod_count{0};
+
 	/// The extensions that the GLTFLoader can load mapped to whether they should be enabled or not
 	static std::unordered_map<std::string, bool> supported_extensions;
 
@@ -454,14 +454,14 @@ void Gui::update_buffers(CommandBuffer &command_buffer, RenderFrame &render_fram
 		return;
 	}
 
-	std::vector<uint8_t> vertex_data(vertex_buffer_size);
-	std::vector<uint8_t> index_data(index_buffer_size);
-
-	upload_draw_data(draw_data, vertex_data.data(), index_data.data());
-
 	auto vertex_allocation = sample.get_render_context().get_active_frame().allocate_buffer(VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, vertex_buffer_size);
+	auto index_allocation  = sample.get_render_context().get_active_frame().allocate_buffer(VK_BUFFER_USAGE_INDEX_BUFFER_BIT, index_buffer_size);
+
+	// Write the draw data directly into the mapped frame buffers
+	upload_draw_data(draw_data, vertex_allocation.map(vertex_buffer_size), index_allocation.map(index_buffer_size));
 
-	vertex_allocation.update(vertex_data);
+	vertex_allocation.flush();
+	index_allocation.flush();
 
 	std::vector<std::reference_wrapper<const core::Buffer>> buffers;
 	buffers.emplace_back(std::ref(vertex_allocation.get_buffer()));
@@ -470,10 +470,6 @@ void Gui::update_buffers(CommandBuffer &command_buffer, RenderFrame &render_fram
 
 	command_buffer.bind_vertex_buffers(0, buffers, offsets);
 
-	auto index_allocation = sample.get_render_context().get_active_frame().allocate_buffer(VK_BUFFER_USAGE_INDEX_BUFFER_BIT, index_buffer_size);
-
-	index_allocation.update(index_data);
-
 	command_buffer.bind_index_buffer(index_allocation.get_buffer(), index_allocation.get_offset(), VK_INDEX_TYPE_UINT16);
 }
 
@@ -34,8 +34,8 @@ class HPPGLTFLoader : private vkb::GLTFLoader
   public:
 	using vkb::GLTFLoader::read_scene_from_file;
 
-	HPPGLTFLoader(vkb::core::HPPDevice const &device) :
-	    GLTFLoader(reinterpret_cast<vkb::Device const &>(device))
+	HPPGLTFLoader(vkb::core::HPPDevice const &device, vkb::JobSystem *job_system = nullptr) :
+	    GLTFLoader(reinterpret_cast<vkb::Device const &>(device), job_system)
 	{}
 
 	std::unique_ptr<vkb::scene_graph::components::HPPSubMesh> read_model_from_file(const std::string &file_name, uint32_t index)
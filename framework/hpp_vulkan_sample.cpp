@@ -193,7 +193,7 @@ void HPPVulkanSample::update_scene(float delta_time)
 		// Update scripts
 		if (scene->has_component<sg::Script>())
 		{
-			auto scripts = scene->get_components<sg::Script>();
+			auto &scripts = scene->get_component_view<sg::Script>();
 
 			for (auto script : scripts)
 			{
@@ -204,13 +204,20 @@ void HPPVulkanSample::update_scene(float delta_time)
 		// Update animations
 		if (scene->has_component<sg::Animation>())
 		{
-			auto animations = scene->get_components<sg::Animation>();
+			auto &animations = scene->get_component_view<sg::Animation>();
 
+			// Large animations sample their channels in parallel
 			for (auto animation : animations)
 			{
-				animation->update(delta_time);
+				animation->update(delta_time, &get_platform().get_job_system());
 			}
 		}
+
+		// Update the world matrices changed by the scripts and animations in one pass
+		scene->get_transform_hierarchy().update(&get_platform().get_job_system());
+
+		// Cull the scene again with the updated transforms
+		scene->get_visibility_culling().begin_frame();
 	}
 }
 
@@ -218,6 +225,8 @@ void HPPVulkanSample::update_stats(float delta_time)
 {
 	if (stats)
 	{
+		stats->set_visibility_culling(scene ? &scene->get_visibility_culling() : nullptr);
+
 		stats->update(delta_time);
 
 		static float stats_view_count = 0.0f;
@@ -361,7 +370,7 @@ bool HPPVulkanSample::resize(uint32_t width, uint32_t height)
 
 	if (scene && scene->has_component<sg::Script>())
 	{
-		auto scripts = scene->get_components<sg::Script>();
+		auto &scripts = scene->get_component_view<sg::Script>();
 
 		for (auto script : scripts)
 		{
@@ -391,7 +400,7 @@ void HPPVulkanSample::input_event(const InputEvent &input_event)
 	{
 		if (scene && scene->has_component<sg::Script>())
 		{
-			auto scripts = scene->get_components<sg::Script>();
+			auto &scripts = scene->get_component_view<sg::Script>();
 
 			for (auto script : scripts)
 			{
@@ -463,10 +472,10 @@ void HPPVulkanSample::update_debug_window()
 
 	if (scene != nullptr)
 	{
-		get_debug_info().insert<field::Static, uint32_t>("mesh_count", to_u32(scene->get_components<sg::SubMesh>().size()));
-		get_debug_info().insert<field::Static, uint32_t>("texture_count", to_u32(scene->get_components<sg::Texture>().size()));
+		get_debug_info().insert<field::Static, uint32_t>("mesh_count", to_u32(scene->get_component_view<sg::SubMesh>().size()));
+		get_debug_info().insert<field::Static, uint32_t>("texture_count", to_u32(scene->get_component_view<sg::Texture>().size()));
 
-		if (auto camera = scene->get_components<vkb::sg::Camera>()[0])
+		if (auto camera = scene->get_component_view<vkb::sg::Camera>()[0])
 		{
 			if (auto camera_node = camera->get_node())
 			{
@@ -485,7 +494,7 @@ void HPPVulkanSample::set_viewport_and_scissor(vkb::core::HPPCommandBuffer const
 
 void HPPVulkanSample::load_scene(const std::string &path)
 {
-	vkb::HPPGLTFLoader loader(*device);
+	vkb::HPPGLTFLoader loader(*device, &get_platform().get_job_system());
 
 	scene = loader.read_scene_from_file(path);
 
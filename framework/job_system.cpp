@@ -0,0 +1,351 @@
+/* Copyright (c) 2023, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "job_system.h"
+
+#include <algorithm>
+#include <exception>
+
+#include "common/logging.h"
+
+namespace vkb
+{
+namespace
+{
+// Job system the calling thread is a worker of, and its thread index
+thread_local const JobSystem *current_job_system{nullptr};
+
+thread_local uint32_t current_thread_index{0};
+}        // namespace
+
+struct JobSystem::Job
+{
+	JobFunction function;
+
+	// Dependencies left to complete before the job is queued
+	std::atomic<uint32_t> pending_dependency_count{0};
+
+	std::atomic<bool> done{false};
+
+	// Guards the dependents and the exception
+	std::mutex mutex;
+
+	std::vector<JobHandle> dependents;
+
+	std::exception_ptr exception;
+};
+
+JobSystem::JobSystem(uint32_t worker_count) :
+    owner_thread_id{std::this_thread::get_id()}
+{
+	if (worker_count == 0)
+	{
+		// The owning thread runs jobs too while waiting on them
+		worker_count = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+	}
+
+	for (uint32_t i = 0; i < worker_count; ++i)
+	{
+		queues.push_back(std::make_unique<WorkerQueue>());
+	}
+
+	for (uint32_t i = 0; i < worker_count; ++i)
+	{
+		workers.emplace_back(&JobSystem::worker_loop, this, i + 1);
+	}
+
+	LOGI("Job system started with {} worker threads", worker_count);
+}
+
+JobSystem::~JobSystem()
+{
+	{
+		std::lock_guard<std::mutex> lock(wake_mutex);
+		stop = true;
+	}
+	wake_condition.notify_all();
+
+	for (auto &worker : workers)
+	{
+		worker.join();
+	}
+}
+
+uint32_t JobSystem::get_worker_count() const
+{
+	return static_cast<uint32_t>(workers.size());
+}
+
+uint32_t JobSystem::get_thread_count() const
+{
+	return get_worker_count() + 1;
+}
+
+JobSystem::JobHandle JobSystem::submit(JobFunction &&function, const std::vector<JobHandle> &dependencies)
+{
+	auto job      = std::make_shared<Job>();
+	job->function = std::move(function);
+
+	// Hold one dependency until all of them are registered, so the job is not queued early
+	job->pending_dependency_count = 1;
+
+	for (auto &dependency : dependencies)
+	{
+		std::lock_guard<std::mutex> lock(dependency->mutex);
+
+		if (!dependency->done)
+		{
+			dependency->dependents.push_back(job);
+			job->pending_dependency_count++;
+		}
+		else if (dependency->exception)
+		{
+			std::lock_guard<std::mutex> job_lock(job->mutex);
+			job->exception = dependency->exception;
+		}
+	}
+
+	if (--job->pending_dependency_count == 0)
+	{
+		enqueue(job);
+	}
+
+	return job;
+}
+
+JobSystem::JobHandle JobSystem::submit_range(uint32_t count, uint32_t batch_size, const RangeFunction &function, const std::vector<JobHandle> &dependencies)
+{
+	if (batch_size == 0)
+	{
+		batch_size = std::max((count + get_thread_count() - 1) / get_thread_count(), 1u);
+	}
+
+	std::vector<JobHandle> batches;
+
+	for (uint32_t begin = 0; begin < count; begin += batch_size)
+	{
+		uint32_t end = std::min(begin + batch_size, count);
+
+		batches.push_back(submit([function, begin, end](uint32_t thread_index) { function(begin, end, thread_index); }, dependencies));
+	}
+
+	// Join the batches, so they can be waited on or depended on as a single job
+	return submit([](uint32_t) {}, batches.empty() ? dependencies : batches);
+}
+
+void JobSystem::parallel_for(uint32_t count, uint32_t batch_size, const RangeFunction &function)
+{
+	wait(submit_range(count, batch_size, function));
+}
+
+void JobSystem::wait(const JobHandle &job)
+{
+	uint32_t thread_index = 0;
+
+	if (get_current_thread_index(thread_index))
+	{
+		// Help running jobs rather than blocking, the job may be waiting for a thread to run it
+		while (!job->done)
+		{
+			if (auto next_job = pop_job(thread_index))
+			{
+				execute(next_job, thread_index);
+			}
+			else
+			{
+				std::this_thread::yield();
+			}
+		}
+	}
+	else
+	{
+		std::unique_lock<std::mutex> lock(done_mutex);
+		done_condition.wait(lock, [&job] { return job->done.load(); });
+	}
+
+	if (job->exception)
+	{
+		std::rethrow_exception(job->exception);
+	}
+}
+
+void JobSystem::wait(const std::vector<JobHandle> &jobs)
+{
+	for (auto &job : jobs)
+	{
+		wait(job);
+	}
+}
+
+bool JobSystem::is_done(const JobHandle &job) const
+{
+	return job->done;
+}
+
+void JobSystem::worker_loop(uint32_t thread_index)
+{
+	current_job_system   = this;
+	current_thread_index = thread_index;
+
+	while (true)
+	{
+		if (auto job = pop_job(thread_index))
+		{
+			execute(job, thread_index);
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(wake_mutex);
+		wake_condition.wait(lock, [this] { return stop || queued_job_count > 0; });
+
+		if (stop)
+		{
+			return;
+		}
+	}
+}
+
+void JobSystem::enqueue(const JobHandle &job)
+{
+	// Workers keep the jobs they submit, other threads spread them across the workers
+	uint32_t queue_index = 0;
+	if (current_job_system == this)
+	{
+		queue_index = current_thread_index - 1;
+	}
+	else
+	{
+		queue_index = next_queue++ % queues.size();
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(queues[queue_index]->mutex);
+		queues[queue_index]->jobs.push_back(job);
+	}
+
+	queued_job_count++;
+
+	// Synchronize with a worker about to sleep, so the notification is not missed
+	{
+		std::lock_guard<std::mutex> lock(wake_mutex);
+	}
+	wake_condition.notify_one();
+}
+
+JobSystem::JobHandle JobSystem::pop_job(uint32_t thread_index)
+{
+	// Workers run their most recent job first, its data is the most likely to still be in cache
+	if (thread_index > 0)
+	{
+		auto &queue = *queues[thread_index - 1];
+
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (!queue.jobs.empty())
+		{
+			auto job = std::move(queue.jobs.back());
+			queue.jobs.pop_back();
+			queued_job_count--;
+			return job;
+		}
+	}
+
+	// Steal the oldest job of another worker
+	for (size_t i = 0; i < queues.size(); ++i)
+	{
+		size_t queue_index = (thread_index + i) % queues.size();
+		if (queue_index + 1 == thread_index)
+		{
+			continue;
+		}
+
+		auto &queue = *queues[queue_index];
+
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (!queue.jobs.empty())
+		{
+			auto job = std::move(queue.jobs.front());
+			queue.jobs.pop_front();
+			queued_job_count--;
+			return job;
+		}
+	}
+
+	return nullptr;
+}
+
+void JobSystem::execute(const JobHandle &job, uint32_t thread_index)
+{
+	// Jobs whose dependencies failed are not run, and fail with the same exception
+	if (!job->exception)
+	{
+		try
+		{
+			job->function(thread_index);
+		}
+		catch (...)
+		{
+			job->exception = std::current_exception();
+		}
+	}
+
+	// Release the resources captured by the job
+	job->function = nullptr;
+
+	std::vector<JobHandle> dependents;
+	{
+		std::lock_guard<std::mutex> lock(job->mutex);
+		job->done = true;
+		dependents.swap(job->dependents);
+	}
+
+	for (auto &dependent : dependents)
+	{
+		if (job->exception)
+		{
+			std::lock_guard<std::mutex> lock(dependent->mutex);
+			dependent->exception = job->exception;
+		}
+
+		if (--dependent->pending_dependency_count == 0)
+		{
+			enqueue(dependent);
+		}
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(done_mutex);
+	}
+	done_condition.notify_all();
+}
+
+bool JobSystem::get_current_thread_index(uint32_t &thread_index) const
+{
+	if (current_job_system == this)
+	{
+		thread_index = current_thread_index;
+		return true;
+	}
+
+	if (std::this_thread::get_id() == owner_thread_id)
+	{
+		thread_index = 0;
+		return true;
+	}
+
+	return false;
+}
+}        // namespace vkb
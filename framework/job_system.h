@@ -0,0 +1,158 @@
+/* Copyright (c) 2023, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace vkb
+{
+/**
+ * @brief A fixed set of worker threads running jobs for the framework and the samples
+ *
+ *        Each worker owns a deque of jobs. A worker pushes and pops jobs at the back of its
+ *        own deque, and steals jobs from the front of the other deques once its own is empty.
+ *        Jobs may depend on other jobs, in which case they are only queued once all of their
+ *        dependencies completed.
+ *
+ *        Workers run jobs with thread indices 1 to the worker count, while the thread that
+ *        created the job system runs jobs with thread index 0 while it waits on them. The thread
+ *        index can therefore select per-thread resources, such as the pools of a RenderFrame
+ *        prepared with get_thread_count() threads.
+ */
+class JobSystem
+{
+  public:
+	struct Job;
+
+	using JobHandle = std::shared_ptr<Job>;
+
+	using JobFunction = std::function<void(uint32_t thread_index)>;
+
+	using RangeFunction = std::function<void(uint32_t begin, uint32_t end, uint32_t thread_index)>;
+
+	/**
+	 * @brief Starts the worker threads
+	 * @param worker_count Number of worker threads, if zero one less than the hardware threads
+	 */
+	explicit JobSystem(uint32_t worker_count = 0);
+
+	JobSystem(const JobSystem &) = delete;
+
+	JobSystem(JobSystem &&) = delete;
+
+	/**
+	 * @brief Stops the worker threads. Jobs that did not start yet are not run.
+	 */
+	~JobSystem();
+
+	JobSystem &operator=(const JobSystem &) = delete;
+
+	JobSystem &operator=(JobSystem &&) = delete;
+
+	uint32_t get_worker_count() const;
+
+	/**
+	 * @return The number of thread indices jobs can run with, the workers plus the owning thread
+	 */
+	uint32_t get_thread_count() const;
+
+	/**
+	 * @brief Queues a job
+	 * @param function Function to run, receiving the index of the thread running it
+	 * @param dependencies Jobs that must complete before this one starts
+	 * @return A handle to wait on the job, or to make other jobs depend on it
+	 */
+	JobHandle submit(JobFunction &&function, const std::vector<JobHandle> &dependencies = {});
+
+	/**
+	 * @brief Queues a job for each batch of a range of elements
+	 * @param count Number of elements in the range
+	 * @param batch_size Number of elements per job, if zero the range is split evenly across the threads
+	 * @param function Function to run on each batch, receiving the first and past-the-last elements of the batch
+	 * @param dependencies Jobs that must complete before any batch starts
+	 * @return A handle completing once all the batches completed
+	 */
+	JobHandle submit_range(uint32_t count, uint32_t batch_size, const RangeFunction &function, const std::vector<JobHandle> &dependencies = {});
+
+	/**
+	 * @brief Runs a function on batches of a range of elements in parallel, and waits for all of them
+	 */
+	void parallel_for(uint32_t count, uint32_t batch_size, const RangeFunction &function);
+
+	/**
+	 * @brief Waits for a job to complete. The workers and the owning thread run other jobs in the meantime,
+	 *        any other thread blocks.
+	 *        Rethrows the exception thrown by the job or by one of its dependencies, if any.
+	 */
+	void wait(const JobHandle &job);
+
+	void wait(const std::vector<JobHandle> &jobs);
+
+	bool is_done(const JobHandle &job) const;
+
+  private:
+	struct WorkerQueue
+	{
+		std::mutex mutex;
+
+		std::deque<JobHandle> jobs;
+	};
+
+	void worker_loop(uint32_t thread_index);
+
+	void enqueue(const JobHandle &job);
+
+	JobHandle pop_job(uint32_t thread_index);
+
+	void execute(const JobHandle &job, uint32_t thread_index);
+
+	/**
+	 * @brief Finds the thread index of the calling thread
+	 * @return Whether the calling thread can run jobs
+	 */
+	bool get_current_thread_index(uint32_t &thread_index) const;
+
+	std::vector<std::unique_ptr<WorkerQueue>> queues;
+
+	std::vector<std::thread> workers;
+
+	std::thread::id owner_thread_id;
+
+	// Queue receiving the next job submitted from a thread which is not a worker
+	std::atomic<uint32_t> next_queue{0};
+
+	std::atomic<uint32_t> queued_job_count{0};
+
+	bool stop{false};
+
+	std::mutex wake_mutex;
+
+	std::condition_variable wake_condition;
+
+	std::mutex done_mutex;
+
+	std::condition_variable done_condition;
+};
+}        // namespace vkb
@@ -35,6 +35,7 @@ namespace platform
 class HPPPlatform : private vkb::Platform
 {
   public:
+	using vkb::Platform::get_job_system;
 	using vkb::Platform::get_surface_extension;
 
 	std::unique_ptr<vkb::rendering::HPPRenderContext>
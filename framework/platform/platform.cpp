@@ -111,6 +111,8 @@ ExitCode Platform::initialize(const std::vector<Plugin *> &plugins = {})
 		return ExitCode::FatalError;
 	}
 
+	job_system = std::make_unique<JobSystem>();
+
 	return ExitCode::Success;
 }
 
@@ -233,6 +235,7 @@ void Platform::terminate(ExitCode code)
 	}
 
 	active_app.reset();
+	job_system.reset();
 	window.reset();
 
 	spdlog::drop_all();
@@ -313,6 +316,12 @@ Window &Platform::get_window()
 	return *window;
 }
 
+JobSystem &Platform::get_job_system()
+{
+	assert(job_system && "Job system is not valid, the platform must be initialized first");
+	return *job_system;
+}
+
 std::vector<std::string> &Platform::get_arguments()
 {
 	return Platform::arguments;
@@ -25,6 +25,7 @@
 #include "common/optional.h"
 #include "common/utils.h"
 #include "common/vk_common.h"
+#include "job_system.h"
 #include "platform/application.h"
 #include "platform/filesystem.h"
 #include "platform/parser.h"
@@ -108,6 +109,12 @@ class Platform
 
 	Window &get_window();
 
+	/**
+	 * @brief The job system shared by the framework and the samples,
+	 *        available once the platform is initialized
+	 */
+	JobSystem &get_job_system();
+
 	Application &get_app() const;
 
 	Application &get_app();
@@ -156,6 +163,8 @@ class Platform
 
 	std::unique_ptr<Application> active_app{nullptr};
 
+	std::unique_ptr<JobSystem> job_system{nullptr};
+
 	virtual std::vector<spdlog::sink_ptr> get_platform_sinks();
 
 	/**
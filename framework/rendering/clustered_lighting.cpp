@@ -0,0 +1,324 @@
+/* Copyright (c) 2023, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "rendering/clustered_lighting.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <limits>
+
+#include "common/utils.h"
+#include "core/command_buffer.h"
+#include "core/device.h"
+#include "rendering/render_context.h"
+#include "scene_graph/components/camera.h"
+#include "scene_graph/components/light.h"
+#include "scene_graph/components/perspective_camera.h"
+#include "scene_graph/components/transform.h"
+#include "scene_graph/node.h"
+#include "timer.h"
+
+namespace vkb
+{
+namespace
+{
+// Scale applied to the light distance by the point light attenuation of lighting.h
+constexpr float LIGHT_DISTANCE_SCALE = 0.005f;
+
+// Smallest storage buffer allocated for the clusters, in bytes
+constexpr size_t MIN_BUFFER_SIZE = 256;
+}        // namespace
+
+ClusteredLighting::ClusteredLighting(RenderContext &render_context) :
+    render_context{render_context}
+{
+}
+
+float ClusteredLighting::get_light_range(sg::Light &light)
+{
+	const auto &properties = light.get_properties();
+	if (properties.range > 0.0f)
+	{
+		return properties.range;
+	}
+
+	// Distance at which intensity / (distance * LIGHT_DISTANCE_SCALE)^2 drops below the minimum contribution
+	return std::sqrt(properties.intensity / MIN_LIGHT_CONTRIBUTION) / LIGHT_DISTANCE_SCALE;
+}
+
+std::vector<sg::Light *> ClusteredLighting::get_directional_lights(const std::vector<sg::Light *> &scene_lights)
+{
+	std::vector<sg::Light *> directional_lights;
+	std::copy_if(scene_lights.begin(), scene_lights.end(), std::back_inserter(directional_lights),
+	             [](sg::Light *light) { return light->get_light_type() == sg::LightType::Directional; });
+
+	return directional_lights;
+}
+
+void ClusteredLighting::update(const std::vector<sg::Light *> &scene_lights, sg::Camera &camera, const VkExtent2D &extent)
+{
+	Timer timer;
+	timer.start();
+
+	auto perspective_camera = dynamic_cast<sg::PerspectiveCamera *>(&camera);
+	if (!perspective_camera)
+	{
+		throw std::runtime_error("Clustered lighting requires a perspective camera");
+	}
+
+	const float near_plane = perspective_camera->get_near_plane();
+	const float far_plane  = perspective_camera->get_far_plane();
+
+	grid_size = glm::uvec3((extent.width + CLUSTER_TILE_SIZE - 1) / CLUSTER_TILE_SIZE,
+	                       (extent.height + CLUSTER_TILE_SIZE - 1) / CLUSTER_TILE_SIZE,
+	                       CLUSTER_DEPTH_SLICE_COUNT);
+
+	// Slices grow exponentially, so that clusters keep about the same proportions along the depth
+	const float log_depth_ratio = std::log(far_plane / near_plane);
+
+	cluster_uniform.cluster_scale = glm::vec4(1.0f / CLUSTER_TILE_SIZE,
+	                                          1.0f / CLUSTER_TILE_SIZE,
+	                                          CLUSTER_DEPTH_SLICE_COUNT / log_depth_ratio,
+	                                          -(CLUSTER_DEPTH_SLICE_COUNT * std::log(near_plane)) / log_depth_ratio);
+
+	slice_depths.resize(CLUSTER_DEPTH_SLICE_COUNT + 1);
+	for (uint32_t i = 0; i <= CLUSTER_DEPTH_SLICE_COUNT; ++i)
+	{
+		slice_depths[i] = near_plane * std::pow(far_plane / near_plane, static_cast<float>(i) / CLUSTER_DEPTH_SLICE_COUNT);
+	}
+
+	lights.clear();
+	world_x.clear();
+	world_y.clear();
+	world_z.clear();
+
+	for (auto scene_light : scene_lights)
+	{
+		auto light_type = scene_light->get_light_type();
+		if (light_type != sg::LightType::Point && light_type != sg::LightType::Spot)
+		{
+			continue;
+		}
+
+		const auto &properties = scene_light->get_properties();
+		auto       &transform  = scene_light->get_node()->get_transform();
+		glm::vec3   position   = glm::vec3(transform.get_world_matrix()[3]);
+
+		lights.push_back({{position, static_cast<float>(light_type)},
+		                  {properties.color, properties.intensity},
+		                  {transform.get_rotation() * properties.direction, get_light_range(*scene_light)},
+		                  {properties.inner_cone_angle, properties.outer_cone_angle}});
+
+		world_x.push_back(position.x);
+		world_y.push_back(position.y);
+		world_z.push_back(position.z);
+	}
+
+	const uint32_t light_count = to_u32(lights.size());
+
+	// Transform the light centers to view space in a branchless loop, which the compiler vectorizes
+	const glm::mat4 view = camera.get_view();
+
+	center_x.resize(light_count);
+	center_y.resize(light_count);
+	center_z.resize(light_count);
+
+	for (uint32_t i = 0; i < light_count; ++i)
+	{
+		center_x[i] = view[0][0] * world_x[i] + view[1][0] * world_y[i] + view[2][0] * world_z[i] + view[3][0];
+		center_y[i] = view[0][1] * world_x[i] + view[1][1] * world_y[i] + view[2][1] * world_z[i] + view[3][1];
+		center_z[i] = view[0][2] * world_x[i] + view[1][2] * world_y[i] + view[2][2] * world_z[i] + view[3][2];
+	}
+
+	// The tiles are addressed with framebuffer coordinates, as gl_FragCoord
+	const glm::mat4 projection = camera.get_pre_rotation() * vulkan_style_projection(camera.get_projection());
+
+	rects.clear();
+	for (uint32_t i = 0; i < light_count; ++i)
+	{
+		find_cluster_rects(i, glm::vec3(center_x[i], center_y[i], center_z[i]), lights[i].direction.w, projection, extent);
+	}
+
+	// Count the lights of each cluster, then turn the counts into offsets, then fill the indices
+	const uint32_t cluster_count = grid_size.x * grid_size.y * grid_size.z;
+	clusters.assign(cluster_count, glm::uvec2(0));
+
+	for (auto &rect : rects)
+	{
+		for (uint32_t y = rect.min.y; y <= rect.max.y; ++y)
+		{
+			uint32_t row = (rect.slice * grid_size.y + y) * grid_size.x;
+			for (uint32_t x = rect.min.x; x <= rect.max.x; ++x)
+			{
+				clusters[row + x].y++;
+			}
+		}
+	}
+
+	uint32_t light_index_count = 0;
+	for (auto &cluster : clusters)
+	{
+		cluster.x = light_index_count;
+		light_index_count += cluster.y;
+		cluster.y = 0;
+	}
+
+	light_indices.resize(light_index_count);
+
+	for (auto &rect : rects)
+	{
+		for (uint32_t y = rect.min.y; y <= rect.max.y; ++y)
+		{
+			uint32_t row = (rect.slice * grid_size.y + y) * grid_size.x;
+			for (uint32_t x = rect.min.x; x <= rect.max.x; ++x)
+			{
+				auto &cluster                          = clusters[row + x];
+				light_indices[cluster.x + cluster.y++] = rect.light;
+			}
+		}
+	}
+
+	cluster_uniform.view      = view;
+	cluster_uniform.grid_size = glm::uvec4(grid_size, light_count);
+
+	upload();
+
+	frame_stats.light_count       = light_count;
+	frame_stats.light_index_count = light_index_count;
+	frame_stats.cluster_count     = cluster_count;
+	frame_stats.update_time       = timer.stop<Timer::Milliseconds>();
+}
+
+uint32_t ClusteredLighting::get_depth_slice(float depth) const
+{
+	float slice = std::log(depth) * cluster_uniform.cluster_scale.z + cluster_uniform.cluster_scale.w;
+
+	return static_cast<uint32_t>(glm::clamp(slice, 0.0f, static_cast<float>(grid_size.z - 1)));
+}
+
+void ClusteredLighting::find_cluster_rects(uint32_t light, const glm::vec3 &center, float radius, const glm::mat4 &projection, const VkExtent2D &extent)
+{
+	// The camera looks down the negative z axis
+	const float depth = -center.z;
+
+	const float near_plane = slice_depths.front();
+	const float far_plane  = slice_depths.back();
+
+	if (depth + radius <= near_plane || depth - radius >= far_plane)
+	{
+		return;
+	}
+
+	const uint32_t first_slice = get_depth_slice(std::max(depth - radius, near_plane));
+	const uint32_t last_slice  = get_depth_slice(std::min(depth + radius, far_plane));
+
+	const glm::vec2 tile_count{grid_size.x, grid_size.y};
+	const glm::vec2 tiles_per_ndc = glm::vec2(extent.width, extent.height) * (0.5f / CLUSTER_TILE_SIZE);
+
+	for (uint32_t slice = first_slice; slice <= last_slice; ++slice)
+	{
+		const float slab_near = std::max(slice_depths[slice], depth - radius);
+		const float slab_far  = std::min(slice_depths[slice + 1], depth + radius);
+
+		// Radius of the cross section of the sphere closest to its center within the slice
+		const float closest_depth = glm::clamp(depth, slab_near, slab_far);
+		const float slab_radius   = std::sqrt(std::max(radius * radius - (closest_depth - depth) * (closest_depth - depth), 0.0f));
+
+		// Project the box bounding the sphere within the slice, which is entirely in front of the camera
+		glm::vec2 min_ndc{std::numeric_limits<float>::max()};
+		glm::vec2 max_ndc{-std::numeric_limits<float>::max()};
+
+		for (uint32_t corner = 0; corner < 8; ++corner)
+		{
+			glm::vec4 view_position{center.x + ((corner & 1) ? slab_radius : -slab_radius),
+			                        center.y + ((corner & 2) ? slab_radius : -slab_radius),
+			                        (corner & 4) ? -slab_far : -slab_near,
+			                        1.0f};
+
+			glm::vec4 clip_position = projection * view_position;
+			glm::vec2 ndc           = glm::vec2(clip_position) / clip_position.w;
+
+			min_ndc = glm::min(min_ndc, ndc);
+			max_ndc = glm::max(max_ndc, ndc);
+		}
+
+		if (max_ndc.x < -1.0f || max_ndc.y < -1.0f || min_ndc.x > 1.0f || min_ndc.y > 1.0f)
+		{
+			continue;
+		}
+
+		glm::vec2 min_tile = glm::clamp(glm::floor((min_ndc + 1.0f) * tiles_per_ndc), glm::vec2(0.0f), tile_count - 1.0f);
+		glm::vec2 max_tile = glm::clamp(glm::floor((max_ndc + 1.0f) * tiles_per_ndc), glm::vec2(0.0f), tile_count - 1.0f);
+
+		rects.push_back({light, slice, glm::uvec2(min_tile), glm::uvec2(max_tile)});
+	}
+}
+
+void ClusteredLighting::write_buffer(Device &device, std::unique_ptr<core::Buffer> &buffer, const void *data, size_t size)
+{
+	if (!buffer || buffer->get_size() < size)
+	{
+		// Grow to the next power of two, so that slowly growing data does not reallocate every frame
+		size_t buffer_size = MIN_BUFFER_SIZE;
+		while (buffer_size < size)
+		{
+			buffer_size *= 2;
+		}
+
+		buffer = std::make_unique<core::Buffer>(device, buffer_size, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU);
+	}
+
+	if (size > 0)
+	{
+		buffer->update(static_cast<const uint8_t *>(data), size);
+	}
+}
+
+void ClusteredLighting::upload()
+{
+	auto &device = render_context.get_device();
+
+	frame_resources.resize(render_context.get_render_frames().size());
+	auto &frame = frame_resources[render_context.get_active_frame_index()];
+
+	write_buffer(device, frame.light_buffer, lights.data(), lights.size() * sizeof(Light));
+	write_buffer(device, frame.cluster_buffer, clusters.data(), clusters.size() * sizeof(glm::uvec2));
+	write_buffer(device, frame.light_index_buffer, light_indices.data(), light_indices.size() * sizeof(uint32_t));
+}
+
+void ClusteredLighting::bind(CommandBuffer &command_buffer, uint32_t set)
+{
+	auto frame_index = render_context.get_active_frame_index();
+	assert(frame_index < frame_resources.size() && "Clustered lights must be updated before they are bound");
+
+	auto &frame = frame_resources[frame_index];
+
+	auto allocation = render_context.get_active_frame().allocate_buffer(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, sizeof(ClusterUniform));
+	allocation.update(cluster_uniform);
+
+	command_buffer.bind_buffer(allocation.get_buffer(), allocation.get_offset(), allocation.get_size(), set, 0, 0);
+	command_buffer.bind_buffer(*frame.light_buffer, 0, frame.light_buffer->get_size(), set, 1, 0);
+	command_buffer.bind_buffer(*frame.cluster_buffer, 0, frame.cluster_buffer->get_size(), set, 2, 0);
+	command_buffer.bind_buffer(*frame.light_index_buffer, 0, frame.light_index_buffer->get_size(), set, 3, 0);
+}
+
+const ClusteredLighting::FrameStats &ClusteredLighting::get_frame_stats() const
+{
+	return frame_stats;
+}
+}        // namespace vkb
@@ -0,0 +1,210 @@
+/* Copyright (c) 2023, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "common/error.h"
+
+VKBP_DISABLE_WARNINGS()
+#include "common/glm_common.h"
+VKBP_ENABLE_WARNINGS()
+
+#include "core/buffer.h"
+#include "rendering/subpass.h"
+
+namespace vkb
+{
+class CommandBuffer;
+class RenderContext;
+
+namespace sg
+{
+class Camera;
+class Light;
+}        // namespace sg
+
+/**
+ * @brief Uniform describing the cluster grid to the lighting shaders
+ */
+struct alignas(16) ClusterUniform
+{
+	glm::mat4 view;
+
+	// xyz: number of clusters across the width, the height and the depth of the view, w: number of lights
+	glm::uvec4 grid_size;
+
+	// xy: clusters per pixel, z: scale and w: bias turning the logarithm of a view depth into a depth slice
+	glm::vec4 cluster_scale;
+};
+
+/**
+ * @brief Assigns the point and spot lights of a scene to the clusters of a camera view
+ *
+ *        The view is divided into tiles of CLUSTER_TILE_SIZE pixels, and its depth range into
+ *        CLUSTER_DEPTH_SLICE_COUNT slices growing exponentially with the distance to the camera.
+ *        Every frame, on the CPU, the bounding sphere of each light is clipped to each depth slice
+ *        it spans, and the screen rectangle of the clipped sphere selects the clusters the light
+ *        is added to. The lights, the range of light indices of every cluster and the indices
+ *        are then written to storage buffers of the active frame, so that each pixel of the
+ *        lighting shaders only evaluates the lights of its cluster.
+ *
+ *        Lights without a range are given the distance at which the point light attenuation of
+ *        lighting.h drops below MIN_LIGHT_CONTRIBUTION, and the lighting shaders fade all the
+ *        clustered lights to zero at their range. Directional lights light every cluster, and
+ *        are left to the uniform light arrays.
+ */
+class ClusteredLighting
+{
+  public:
+	/**
+	 * @brief Lights and cluster assignments of the last update
+	 */
+	struct FrameStats
+	{
+		uint32_t light_count{0};
+
+		// Number of light indices over all the clusters
+		uint32_t light_index_count{0};
+
+		uint32_t cluster_count{0};
+
+		// CPU time taken to assign the lights and upload the buffers, in milliseconds
+		double update_time{0.0};
+	};
+
+	static constexpr uint32_t CLUSTER_TILE_SIZE = 64;
+
+	static constexpr uint32_t CLUSTER_DEPTH_SLICE_COUNT = 24;
+
+	static constexpr float MIN_LIGHT_CONTRIBUTION = 0.01f;
+
+	explicit ClusteredLighting(RenderContext &render_context);
+
+	ClusteredLighting(const ClusteredLighting &) = delete;
+
+	ClusteredLighting(ClusteredLighting &&) = delete;
+
+	~ClusteredLighting() = default;
+
+	ClusteredLighting &operator=(const ClusteredLighting &) = delete;
+
+	ClusteredLighting &operator=(ClusteredLighting &&) = delete;
+
+	/**
+	 * @brief Assigns the point and spot lights to the clusters of the camera view, and uploads them for the active frame
+	 * @param scene_lights All of the light components from the scene graph, the directional ones are skipped
+	 * @param camera Perspective camera looking at the scene
+	 * @param extent Extent of the render target, in pixels
+	 */
+	void update(const std::vector<sg::Light *> &scene_lights, sg::Camera &camera, const VkExtent2D &extent);
+
+	/**
+	 * @brief Binds the cluster uniform, the lights, the cluster light ranges and the light indices of the active frame
+	 *        to the first four bindings of a descriptor set
+	 */
+	void bind(CommandBuffer &command_buffer, uint32_t set);
+
+	const FrameStats &get_frame_stats() const;
+
+	/**
+	 * @return The range of a point or spot light, or the distance at which it stops contributing if it has none
+	 */
+	static float get_light_range(sg::Light &light);
+
+	/**
+	 * @return The directional lights among the lights of a scene, which are not clustered
+	 */
+	static std::vector<sg::Light *> get_directional_lights(const std::vector<sg::Light *> &scene_lights);
+
+  private:
+	/**
+	 * @brief Storage buffers of a render frame, grown as needed
+	 */
+	struct FrameResources
+	{
+		std::unique_ptr<core::Buffer> light_buffer;
+
+		std::unique_ptr<core::Buffer> cluster_buffer;
+
+		std::unique_ptr<core::Buffer> light_index_buffer;
+	};
+
+	/**
+	 * @brief Range of clusters covered by a light in one depth slice
+	 */
+	struct ClusterRect
+	{
+		uint32_t light;
+
+		uint32_t slice;
+
+		glm::uvec2 min;
+
+		glm::uvec2 max;
+	};
+
+	/**
+	 * @brief Finds the clusters covered by the bounding sphere of a light, in view space, in each depth slice it spans
+	 */
+	void find_cluster_rects(uint32_t light, const glm::vec3 &center, float radius, const glm::mat4 &projection, const VkExtent2D &extent);
+
+	uint32_t get_depth_slice(float depth) const;
+
+	void upload();
+
+	static void write_buffer(Device &device, std::unique_ptr<core::Buffer> &buffer, const void *data, size_t size);
+
+	RenderContext &render_context;
+
+	std::vector<FrameResources> frame_resources;
+
+	ClusterUniform cluster_uniform{};
+
+	glm::uvec3 grid_size{0};
+
+	// View depths of the boundaries of the depth slices
+	std::vector<float> slice_depths;
+
+	std::vector<Light> lights;
+
+	// Offset and count of the light indices of each cluster
+	std::vector<glm::uvec2> clusters;
+
+	std::vector<uint32_t> light_indices;
+
+	// Clusters covered by the lights, in light order
+	std::vector<ClusterRect> rects;
+
+	// World space and view space centers of the lights
+	std::vector<float> world_x;
+
+	std::vector<float> world_y;
+
+	std::vector<float> world_z;
+
+	std::vector<float> center_x;
+
+	std::vector<float> center_y;
+
+	std::vector<float> center_z;
+
+	FrameStats frame_stats;
+};
+}        // namespace vkb
@@ -0,0 +1,204 @@
+/* Copyright (c) 2023, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "rendering/dynamic_resolution.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+#include "common/helpers.h"
+#include "common/logging.h"
+#include "core/command_buffer.h"
+#include "core/device.h"
+#include "rendering/render_context.h"
+
+namespace vkb
+{
+namespace
+{
+// Weight of the last frame time in the smoothed frame time
+constexpr float FRAME_TIME_SMOOTHING = 0.1f;
+
+// Fraction of the distance to the expected scale covered per frame, as the measured times lag behind the scale
+constexpr float SCALE_ADJUST_RATE = 0.2f;
+}        // namespace
+
+DynamicResolution::DynamicResolution(RenderContext &render_context, float target_frame_time, float min_scale, float max_scale) :
+    render_context{render_context}
+{
+	auto &limits = render_context.get_device().get_gpu().get_properties().limits;
+
+	if (limits.timestampComputeAndGraphics)
+	{
+		timestamp_period = limits.timestampPeriod;
+	}
+	else
+	{
+		LOGW("Timestamps are not supported, dynamic resolution keeps the maximum scale");
+	}
+
+	set_target_frame_time(target_frame_time);
+	set_scale_range(min_scale, max_scale);
+	reset();
+}
+
+void DynamicResolution::set_target_frame_time(float target_frame_time)
+{
+	assert(target_frame_time > 0.0f && "The target frame time must be positive");
+
+	stats.target_frame_time = target_frame_time;
+}
+
+void DynamicResolution::set_scale_range(float new_min_scale, float new_max_scale)
+{
+	assert(new_min_scale > 0.0f && new_min_scale <= new_max_scale && "Invalid scale range");
+
+	min_scale   = new_min_scale;
+	max_scale   = new_max_scale;
+	stats.scale = std::min(std::max(stats.scale, min_scale), max_scale);
+}
+
+void DynamicResolution::set_enabled(bool enable)
+{
+	enabled = enable;
+
+	if (!enabled)
+	{
+		stats.scale = max_scale;
+	}
+}
+
+bool DynamicResolution::is_enabled() const
+{
+	return enabled;
+}
+
+bool DynamicResolution::is_supported() const
+{
+	return render_context.get_device().get_gpu().get_properties().limits.timestampComputeAndGraphics;
+}
+
+void DynamicResolution::begin(CommandBuffer &command_buffer)
+{
+	if (!is_supported())
+	{
+		return;
+	}
+
+	uint32_t frame_count = to_u32(render_context.get_render_frames().size());
+
+	if (!timestamp_pool || frame_timed.size() != frame_count)
+	{
+		// Created on first use, and again if the number of render frames changed
+		VkQueryPoolCreateInfo pool_info{};
+		pool_info.sType      = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+		pool_info.queryType  = VK_QUERY_TYPE_TIMESTAMP;
+		pool_info.queryCount = frame_count * 2;        // Start and end of each frame
+
+		timestamp_pool = std::make_unique<QueryPool>(render_context.get_device(), pool_info);
+		frame_timed.assign(frame_count, false);
+	}
+
+	uint32_t frame_index = render_context.get_active_frame_index();
+
+	if (frame_timed[frame_index])
+	{
+		// The frame fence was waited on, so the results are available without waiting
+		std::array<uint64_t, 2> timestamps{};
+
+		VkResult result = timestamp_pool->get_results(frame_index * 2, 2,
+		                                              timestamps.size() * sizeof(uint64_t),
+		                                              timestamps.data(), sizeof(uint64_t),
+		                                              VK_QUERY_RESULT_64_BIT);
+		if (result == VK_SUCCESS && timestamps[1] >= timestamps[0])
+		{
+			float elapsed_ns = timestamp_period * static_cast<float>(timestamps[1] - timestamps[0]);
+			update_scale(elapsed_ns * 0.000001f);
+		}
+	}
+
+	command_buffer.reset_query_pool(*timestamp_pool, frame_index * 2, 2);
+	command_buffer.write_timestamp(VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, *timestamp_pool, frame_index * 2);
+
+	frame_timed[frame_index] = false;
+}
+
+void DynamicResolution::end(CommandBuffer &command_buffer)
+{
+	if (!timestamp_pool)
+	{
+		return;
+	}
+
+	uint32_t frame_index = render_context.get_active_frame_index();
+
+	command_buffer.write_timestamp(VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, *timestamp_pool, frame_index * 2 + 1);
+
+	frame_timed[frame_index] = true;
+}
+
+float DynamicResolution::get_scale() const
+{
+	return stats.scale;
+}
+
+VkExtent2D DynamicResolution::get_render_extent(const VkExtent2D &output_extent) const
+{
+	float step_scale = std::round(stats.scale / scale_step) * scale_step;
+	step_scale       = std::min(std::max(step_scale, min_scale), max_scale);
+
+	return {std::max(static_cast<uint32_t>(output_extent.width * step_scale), 1u),
+	        std::max(static_cast<uint32_t>(output_extent.height * step_scale), 1u)};
+}
+
+const DynamicResolution::Stats &DynamicResolution::get_stats() const
+{
+	return stats;
+}
+
+void DynamicResolution::reset()
+{
+	stats.scale         = max_scale;
+	stats.achieved_time = 0.0f;
+	has_achieved_time   = false;
+}
+
+void DynamicResolution::update_scale(float frame_time)
+{
+	if (has_achieved_time)
+	{
+		stats.achieved_time += (frame_time - stats.achieved_time) * FRAME_TIME_SMOOTHING;
+	}
+	else
+	{
+		stats.achieved_time = frame_time;
+		has_achieved_time   = true;
+	}
+
+	if (!enabled || stats.achieved_time <= 0.0f)
+	{
+		return;
+	}
+
+	// The GPU time is assumed to be proportional to the number of pixels, which is the square of the scale
+	float expected_scale = stats.scale * std::sqrt(stats.target_frame_time / stats.achieved_time);
+
+	stats.scale += (expected_scale - stats.scale) * SCALE_ADJUST_RATE;
+	stats.scale = std::min(std::max(stats.scale, min_scale), max_scale);
+}
+}        // namespace vkb
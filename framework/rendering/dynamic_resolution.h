@@ -0,0 +1,149 @@
+/* Copyright (c) 2023, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "common/vk_common.h"
+#include "core/query_pool.h"
+
+namespace vkb
+{
+class CommandBuffer;
+class RenderContext;
+
+/**
+ * @brief Chooses the resolution the scene is rendered at to hold a GPU frame time budget
+ *
+ *        begin() and end() write timestamps around the commands of a frame, in a query pool
+ *        with two queries per render frame. When a render frame is reused, its fence was waited
+ *        on, so the timestamps written the last time it was rendered are read back without
+ *        stalling. The GPU time of those frames is smoothed, and the scale moves towards the one
+ *        expected to reach the target frame time, assuming that the GPU time grows with the
+ *        number of pixels rendered.
+ *
+ *        The render extent is rounded to steps of the scale, which bounds the number of
+ *        framebuffers created when rendering to a sub-region of a RenderTarget with set_extent().
+ *
+ *        The scale stays at its maximum if the queue does not support timestamps.
+ */
+class DynamicResolution
+{
+  public:
+	/**
+	 * @brief State of the controller, for display
+	 */
+	struct Stats
+	{
+		// Frame time budget, in milliseconds
+		float target_frame_time{0.0f};
+
+		// Ratio between the render extent and the output extent, on each axis
+		float scale{1.0f};
+
+		// Smoothed GPU time of the frames, in milliseconds
+		float achieved_time{0.0f};
+	};
+
+	/**
+	 * @param render_context Render context whose frames are timed
+	 * @param target_frame_time GPU frame time budget, in milliseconds
+	 * @param min_scale Smallest ratio between the render extent and the output extent
+	 * @param max_scale Largest ratio between the render extent and the output extent
+	 */
+	DynamicResolution(RenderContext &render_context, float target_frame_time, float min_scale = 0.5f, float max_scale = 1.0f);
+
+	DynamicResolution(const DynamicResolution &) = delete;
+
+	DynamicResolution(DynamicResolution &&) = delete;
+
+	~DynamicResolution() = default;
+
+	DynamicResolution &operator=(const DynamicResolution &) = delete;
+
+	DynamicResolution &operator=(DynamicResolution &&) = delete;
+
+	void set_target_frame_time(float target_frame_time);
+
+	void set_scale_range(float min_scale, float max_scale);
+
+	/**
+	 * @brief Whether the scale follows the frame time, if disabled it is kept at the maximum scale
+	 *        while the frame time is still measured
+	 */
+	void set_enabled(bool enabled);
+
+	bool is_enabled() const;
+
+	/**
+	 * @return Whether the GPU frame time can be measured
+	 */
+	bool is_supported() const;
+
+	/**
+	 * @brief Updates the scale with the last timestamps of the active render frame, if any,
+	 *        and writes the timestamp starting the frame
+	 * @remarks Must be recorded outside of a render pass, as the queries are reset
+	 */
+	void begin(CommandBuffer &command_buffer);
+
+	/**
+	 * @brief Writes the timestamp ending the frame
+	 */
+	void end(CommandBuffer &command_buffer);
+
+	float get_scale() const;
+
+	/**
+	 * @return The extent to render at for an output of the given extent, rounded to the scale steps
+	 */
+	VkExtent2D get_render_extent(const VkExtent2D &output_extent) const;
+
+	const Stats &get_stats() const;
+
+	/**
+	 * @brief Returns to the maximum scale and forgets the measured frame time
+	 */
+	void reset();
+
+  private:
+	void update_scale(float frame_time);
+
+	RenderContext &render_context;
+
+	std::unique_ptr<QueryPool> timestamp_pool;
+
+	// Whether the timestamps of each render frame were written
+	std::vector<bool> frame_timed;
+
+	float timestamp_period{1.0f};
+
+	float min_scale{0.5f};
+
+	float max_scale{1.0f};
+
+	float scale_step{0.05f};
+
+	bool enabled{true};
+
+	bool has_achieved_time{false};
+
+	Stats stats;
+};
+}        // namespace vkb
@@ -0,0 +1,459 @@
+/* Copyright (c) 2023, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "rendering/gpu_skinning.h"
+
+#include <algorithm>
+#include <array>
+
+#include "common/logging.h"
+#include "common/utils.h"
+#include "core/command_buffer.h"
+#include "core/device.h"
+#include "rendering/render_context.h"
+#include "scene_graph/components/mesh.h"
+#include "scene_graph/components/skin.h"
+#include "scene_graph/components/sub_mesh.h"
+#include "scene_graph/node.h"
+#include "scene_graph/scene.h"
+
+namespace vkb
+{
+namespace
+{
+/**
+ * @return The size in bytes of the components of a joints or weights attribute, zero if unsupported
+ */
+uint32_t get_component_size(VkFormat format)
+{
+	switch (format)
+	{
+		case VK_FORMAT_R8G8B8A8_UINT:
+		case VK_FORMAT_R8G8B8A8_UNORM:
+			return 1;
+		case VK_FORMAT_R16G16B16A16_UINT:
+		case VK_FORMAT_R16G16B16A16_UNORM:
+			return 2;
+		case VK_FORMAT_R32G32B32A32_UINT:
+		case VK_FORMAT_R32G32B32A32_SFLOAT:
+			return 4;
+		default:
+			return 0;
+	}
+}
+
+/**
+ * @brief Copies a host visible buffer into a new one, which no queue family owns until its first use
+ */
+std::unique_ptr<core::Buffer> copy_input(Device &device, core::Buffer &buffer)
+{
+	const bool already_mapped = buffer.get_data() != nullptr;
+	if (!already_mapped)
+	{
+		buffer.map();
+	}
+
+	auto copy = std::make_unique<core::Buffer>(device, buffer.get_size(), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VMA_MEMORY_USAGE_GPU_TO_CPU);
+	copy->update(buffer.get_data(), buffer.get_size());
+
+	if (!already_mapped)
+	{
+		buffer.unmap();
+	}
+
+	return copy;
+}
+}        // namespace
+
+GPUSkinning::GPUSkinning(Device &device, sg::Scene &scene, ShaderSource &&skinning_shader) :
+    device{device},
+    scene{scene},
+    skinning_shader{std::move(skinning_shader)}
+{
+	timestamp_period = device.get_gpu().get_properties().limits.timestampPeriod;
+}
+
+void GPUSkinning::invalidate()
+{
+	prepared = false;
+}
+
+void GPUSkinning::prepare()
+{
+	// Release the deformed vertices of the previous submeshes
+	for (auto &deformed : deformed_submeshes)
+	{
+		deformed.sub_mesh->deformed_vertex_buffers.clear();
+	}
+
+	deformed_submeshes.clear();
+	async_inputs.clear();
+	deformed_vertex_count = 0;
+
+	for (auto mesh : scene.get_component_view<sg::Mesh>())
+	{
+		if (mesh->get_nodes().empty())
+		{
+			continue;
+		}
+
+		// Each skinned node deforms the submeshes into its own vertices, while morph targets only
+		// depend on the mesh, so the nodes without a skin share a single deformation
+		std::vector<sg::Node *> skinned_nodes;
+		for (auto node : mesh->get_nodes())
+		{
+			if (node->has_component<sg::Skin>() && !node->get_component<sg::Skin>().get_joints().empty())
+			{
+				skinned_nodes.push_back(node);
+			}
+		}
+
+		const bool has_unskinned_nodes = skinned_nodes.size() < mesh->get_nodes().size();
+
+		for (auto sub_mesh : mesh->get_submeshes())
+		{
+			sg::VertexAttribute position_attribute;
+			sg::VertexAttribute normal_attribute;
+			sg::VertexAttribute joints_attribute;
+			sg::VertexAttribute weights_attribute;
+
+			if (!sub_mesh->get_attribute("position", position_attribute) || !sub_mesh->vertex_buffers.count("position"))
+			{
+				continue;
+			}
+
+			bool has_normals = sub_mesh->get_attribute("normal", normal_attribute) && sub_mesh->vertex_buffers.count("normal");
+
+			bool skinned = !skinned_nodes.empty() &&
+			               sub_mesh->get_attribute("joints_0", joints_attribute) && sub_mesh->vertex_buffers.count("joints_0") &&
+			               sub_mesh->get_attribute("weights_0", weights_attribute) && sub_mesh->vertex_buffers.count("weights_0");
+
+			SkinningPushConstants push_constants{};
+			push_constants.vertex_count       = sub_mesh->vertices_count;
+			push_constants.position_stride    = position_attribute.stride / sizeof(float);
+			push_constants.normal_stride      = has_normals ? normal_attribute.stride / sizeof(float) : 0;
+			push_constants.morph_target_count = sub_mesh->morph_target_buffer ? sub_mesh->morph_target_count : 0;
+			push_constants.has_normals        = has_normals ? 1 : 0;
+
+			if (skinned)
+			{
+				push_constants.joints_stride         = joints_attribute.stride;
+				push_constants.weights_stride        = weights_attribute.stride;
+				push_constants.joint_component_size  = get_component_size(joints_attribute.format);
+				push_constants.weight_component_size = get_component_size(weights_attribute.format);
+
+				if (push_constants.joint_component_size == 0 || push_constants.weight_component_size == 0)
+				{
+					LOGW("Submesh {} has unsupported joints or weights formats, it is not skinned", sub_mesh->get_name());
+					skinned = false;
+				}
+			}
+
+			if (skinned)
+			{
+				for (auto node : skinned_nodes)
+				{
+					auto &skin = node->get_component<sg::Skin>();
+
+					push_constants.joint_count = to_u32(skin.get_joints().size());
+
+					add_deformed_submesh(node, &skin, *mesh, *sub_mesh, push_constants);
+				}
+			}
+
+			if ((has_unskinned_nodes || !skinned) && push_constants.morph_target_count > 0)
+			{
+				push_constants.joint_count = 0;
+
+				add_deformed_submesh(nullptr, nullptr, *mesh, *sub_mesh, push_constants);
+			}
+		}
+	}
+
+	// The timestamps are created on the next dispatch, for the render frames of that time
+	timestamp_pool.reset();
+	timestamps_written.clear();
+
+	gpu_time = 0.0f;
+	prepared = true;
+
+	if (!deformed_submeshes.empty())
+	{
+		LOGI("GPU skinning deforms {} submeshes with {} vertices", deformed_submeshes.size(), deformed_vertex_count);
+	}
+}
+
+void GPUSkinning::add_deformed_submesh(sg::Node *node, const sg::Skin *skin, sg::Mesh &mesh, sg::SubMesh &sub_mesh, const SkinningPushConstants &push_constants)
+{
+	DeformedSubMesh deformed;
+	deformed.node           = node;
+	deformed.mesh           = &mesh;
+	deformed.sub_mesh       = &sub_mesh;
+	deformed.skin           = skin;
+	deformed.push_constants = push_constants;
+
+	deformed_vertex_count += sub_mesh.vertices_count;
+	deformed_submeshes.push_back(std::move(deformed));
+}
+
+void GPUSkinning::request_deformed_buffers(DeformedSubMesh &deformed, uint32_t frame_index, size_t frame_count)
+{
+	deformed.position_buffers.resize(frame_count);
+
+	if (deformed.push_constants.has_normals)
+	{
+		deformed.normal_buffers.resize(frame_count);
+	}
+
+	if (deformed.position_buffers[frame_index])
+	{
+		return;
+	}
+
+	// Deformed vertices keep the layout of the loaded ones, so the vertex input state is unchanged
+	const VkBufferUsageFlags usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+
+	auto &sub_mesh = *deformed.sub_mesh;
+
+	const std::string &name = deformed.node ? deformed.node->get_name() : sub_mesh.get_name();
+
+	deformed.position_buffers[frame_index] = std::make_unique<core::Buffer>(device, sub_mesh.vertex_buffers.at("position").get_size(), usage, VMA_MEMORY_USAGE_GPU_ONLY);
+	deformed.position_buffers[frame_index]->set_debug_name(fmt::format("{}: deformed position buffer", name));
+
+	if (deformed.push_constants.has_normals)
+	{
+		deformed.normal_buffers[frame_index] = std::make_unique<core::Buffer>(device, sub_mesh.vertex_buffers.at("normal").get_size(), usage, VMA_MEMORY_USAGE_GPU_ONLY);
+		deformed.normal_buffers[frame_index]->set_debug_name(fmt::format("{}: deformed normal buffer", name));
+	}
+}
+
+const core::Buffer &GPUSkinning::get_input(sg::SubMesh &sub_mesh, const std::string &name)
+{
+	core::Buffer &buffer = name == "morph_targets" ? *sub_mesh.morph_target_buffer : sub_mesh.vertex_buffers.at(name);
+
+	if (!async_compute)
+	{
+		return buffer;
+	}
+
+	// The graphics queue keeps drawing the loaded vertices, so the async compute queue reads copies of its own
+	auto &copy = async_inputs[&sub_mesh][name];
+	if (!copy)
+	{
+		copy = copy_input(device, buffer);
+	}
+
+	return *copy;
+}
+
+void GPUSkinning::prepare_timestamps(size_t frame_count)
+{
+	if (timestamps_written.size() == frame_count)
+	{
+		return;
+	}
+
+	timestamps_written.assign(frame_count, false);
+
+	if (device.get_gpu().get_properties().limits.timestampComputeAndGraphics)
+	{
+		VkQueryPoolCreateInfo query_pool_info{VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO};
+		query_pool_info.queryType  = VK_QUERY_TYPE_TIMESTAMP;
+		query_pool_info.queryCount = to_u32(2 * frame_count);
+
+		timestamp_pool = std::make_unique<QueryPool>(device, query_pool_info);
+	}
+}
+
+void GPUSkinning::dispatch(CommandBuffer &command_buffer, RenderContext &render_context)
+{
+	if (!prepared)
+	{
+		prepare();
+	}
+
+	if (deformed_submeshes.empty())
+	{
+		return;
+	}
+
+	const uint32_t frame_index = render_context.get_active_frame_index();
+
+	// The number of render frames may change after prepare
+	const size_t frame_count = render_context.get_render_frames().size();
+
+	prepare_timestamps(frame_count);
+
+	read_timestamps(frame_index);
+
+	ScopedDebugLabel skinning_debug_label{command_buffer, "GPU skinning"};
+
+	// Dedicated compute queues may not support timestamps
+	const bool write_timestamps = timestamp_pool && (!async_compute || render_context.get_async_compute_queue().get_properties().timestampValidBits > 0);
+
+	if (write_timestamps)
+	{
+		command_buffer.reset_query_pool(*timestamp_pool, 2 * frame_index, 2);
+		command_buffer.write_timestamp(VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, *timestamp_pool, 2 * frame_index);
+	}
+
+	auto &resource_cache  = device.get_resource_cache();
+	auto &shader_module   = resource_cache.request_shader_module(VK_SHADER_STAGE_COMPUTE_BIT, skinning_shader);
+	auto &pipeline_layout = resource_cache.request_pipeline_layout({&shader_module});
+
+	command_buffer.bind_pipeline_layout(pipeline_layout);
+
+	auto &render_frame = render_context.get_active_frame();
+
+	for (auto &deformed : deformed_submeshes)
+	{
+		request_deformed_buffers(deformed, frame_index, frame_count);
+
+		auto &sub_mesh        = *deformed.sub_mesh;
+		auto &position_buffer = get_input(sub_mesh, "position");
+		auto &deformed_buffer = *deformed.position_buffers[frame_index];
+		auto &push_constants  = deformed.push_constants;
+
+		// Absent inputs are bound to the positions, the shader does not read them
+		const core::Buffer *normal_buffer          = push_constants.has_normals ? &get_input(sub_mesh, "normal") : &position_buffer;
+		const core::Buffer *joints_buffer          = deformed.skin ? &get_input(sub_mesh, "joints_0") : &position_buffer;
+		const core::Buffer *weights_buffer         = deformed.skin ? &get_input(sub_mesh, "weights_0") : &position_buffer;
+		const core::Buffer *morph_buffer           = push_constants.morph_target_count > 0 ? &get_input(sub_mesh, "morph_targets") : &position_buffer;
+		const core::Buffer *deformed_normal_buffer = push_constants.has_normals ? deformed.normal_buffers[frame_index].get() : &deformed_buffer;
+
+		if (deformed.skin)
+		{
+			deformed.skin->compute_joint_matrices(deformed.node->get_transform().get_world_matrix(), joint_matrices);
+		}
+		else
+		{
+			joint_matrices.assign(1, glm::mat4(1.0f));
+		}
+
+		auto joint_allocation = render_frame.allocate_buffer(VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, joint_matrices.size() * sizeof(glm::mat4));
+		joint_allocation.update(joint_matrices.data(), joint_matrices.size());
+
+		// Missing weights leave the targets at zero
+		const auto &mesh_weights = deformed.mesh->get_morph_weights();
+		morph_weights.assign(std::max(push_constants.morph_target_count, 1u), 0.0f);
+		std::copy_n(mesh_weights.begin(), std::min(mesh_weights.size(), morph_weights.size()), morph_weights.begin());
+
+		auto weight_allocation = render_frame.allocate_buffer(VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, morph_weights.size() * sizeof(float));
+		weight_allocation.update(morph_weights.data(), morph_weights.size());
+
+		command_buffer.bind_buffer(position_buffer, 0, position_buffer.get_size(), 0, 0, 0);
+		command_buffer.bind_buffer(*normal_buffer, 0, normal_buffer->get_size(), 0, 1, 0);
+		command_buffer.bind_buffer(*joints_buffer, 0, joints_buffer->get_size(), 0, 2, 0);
+		command_buffer.bind_buffer(*weights_buffer, 0, weights_buffer->get_size(), 0, 3, 0);
+		command_buffer.bind_buffer(joint_allocation.get_buffer(), joint_allocation.get_offset(), joint_allocation.get_size(), 0, 4, 0);
+		command_buffer.bind_buffer(*morph_buffer, 0, morph_buffer->get_size(), 0, 5, 0);
+		command_buffer.bind_buffer(weight_allocation.get_buffer(), weight_allocation.get_offset(), weight_allocation.get_size(), 0, 6, 0);
+		command_buffer.bind_buffer(deformed_buffer, 0, deformed_buffer.get_size(), 0, 7, 0);
+		command_buffer.bind_buffer(*deformed_normal_buffer, 0, deformed_normal_buffer->get_size(), 0, 8, 0);
+
+		command_buffer.push_constants(push_constants);
+
+		command_buffer.dispatch((push_constants.vertex_count + 63) / 64, 1, 1);
+
+		// Draw the vertices of this frame, for the node or for all the nodes without their own
+		auto &node_buffers       = sub_mesh.deformed_vertex_buffers[deformed.node];
+		node_buffers["position"] = &deformed_buffer;
+		if (push_constants.has_normals)
+		{
+			node_buffers["normal"] = deformed_normal_buffer;
+		}
+	}
+
+	// Make the deformed vertices visible to the vertex input of all the render passes of the frame
+	BufferMemoryBarrier barrier{};
+	barrier.src_stage_mask  = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+	barrier.dst_stage_mask  = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT;
+	barrier.src_access_mask = VK_ACCESS_SHADER_WRITE_BIT;
+	barrier.dst_access_mask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT;
+
+	for (auto &deformed : deformed_submeshes)
+	{
+		std::vector<const core::Buffer *> buffers{deformed.position_buffers[frame_index].get()};
+		if (!deformed.normal_buffers.empty())
+		{
+			buffers.push_back(deformed.normal_buffers[frame_index].get());
+		}
+
+		for (auto buffer : buffers)
+		{
+			if (async_compute)
+			{
+				// The render context releases the buffers after the dispatch, and acquires them before the graphics work
+				render_context.transfer_ownership(*buffer, RenderContext::QueueType::AsyncCompute, barrier);
+			}
+			else
+			{
+				command_buffer.buffer_memory_barrier(*buffer, 0, VK_WHOLE_SIZE, barrier);
+			}
+		}
+	}
+
+	if (write_timestamps)
+	{
+		command_buffer.write_timestamp(VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, *timestamp_pool, 2 * frame_index + 1);
+		timestamps_written[frame_index] = true;
+	}
+}
+
+void GPUSkinning::set_async_compute(bool enable)
+{
+	async_compute = enable;
+}
+
+bool GPUSkinning::is_async_compute() const
+{
+	return async_compute;
+}
+
+void GPUSkinning::read_timestamps(uint32_t frame_index)
+{
+	// The frame fence was waited on, so the timestamps of its previous use are available
+	if (!timestamp_pool || !timestamps_written[frame_index])
+	{
+		return;
+	}
+
+	std::array<uint64_t, 2> timestamps{};
+
+	VkResult result = timestamp_pool->get_results(2 * frame_index, 2, timestamps.size() * sizeof(uint64_t), timestamps.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+
+	if (result == VK_SUCCESS)
+	{
+		gpu_time = static_cast<float>(timestamps[1] - timestamps[0]) * timestamp_period / 1000000.0f;
+	}
+}
+
+uint32_t GPUSkinning::get_deformed_submesh_count() const
+{
+	return to_u32(deformed_submeshes.size());
+}
+
+uint32_t GPUSkinning::get_deformed_vertex_count() const
+{
+	return deformed_vertex_count;
+}
+
+float GPUSkinning::get_gpu_time() const
+{
+	return gpu_time;
+}
+}        // namespace vkb
@@ -0,0 +1,228 @@
+/* Copyright (c) 2023, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "common/error.h"
+
+VKBP_DISABLE_WARNINGS()
+#include "common/glm_common.h"
+VKBP_ENABLE_WARNINGS()
+
+#include "core/buffer.h"
+#include "core/query_pool.h"
+#include "core/shader_module.h"
+
+namespace vkb
+{
+class CommandBuffer;
+class Device;
+class RenderContext;
+
+namespace sg
+{
+class Scene;
+class Node;
+class Mesh;
+class SubMesh;
+class Skin;
+}        // namespace sg
+
+/**
+ * @brief Push constants of the skinning compute shader
+ */
+struct SkinningPushConstants
+{
+	uint32_t vertex_count;
+
+	// Strides of the vertex attributes, in floats for positions and normals, in bytes for joints and weights
+	uint32_t position_stride;
+
+	uint32_t normal_stride;
+
+	uint32_t joints_stride;
+
+	uint32_t weights_stride;
+
+	// Size in bytes of each joint index and weight, weights of 1 or 2 bytes are normalized
+	uint32_t joint_component_size;
+
+	uint32_t weight_component_size;
+
+	uint32_t joint_count;
+
+	uint32_t morph_target_count;
+
+	uint32_t has_normals;
+};
+
+/**
+ * @brief Deforms the skinned and morphed submeshes of a scene with a compute shader
+ *
+ *        Once per frame, before the render passes, the positions and normals of every deformed
+ *        submesh are blended with its morph targets, then moved by the joints of its skin, and
+ *        written into vertex buffers owned by the render frame. The submeshes draw these buffers
+ *        instead of the loaded ones through SubMesh::find_vertex_buffer, so all the subpasses
+ *        drawing a submesh share its deformed vertices.
+ *
+ *        Each node with a skin deforms the submeshes of its mesh into its own vertex buffers, drawn
+ *        for that node only. Morph targets only depend on the mesh, so the nodes without a skin
+ *        share a single deformation of each morphed submesh.
+ *
+ *        With async compute, the deformation is recorded into a command buffer of the async compute
+ *        queue of the render context, and the deformed vertex buffers are transferred to the graphics
+ *        queue, so the skinning of a frame overlaps with the graphics work of the previous one. The
+ *        compute queue then reads copies of the loaded vertices, which the graphics queue keeps drawing.
+ */
+class GPUSkinning
+{
+  public:
+	/**
+	 * @brief Constructs the GPU skinning of a scene, the deformed submeshes are found on the first dispatch
+	 * @param device Device to allocate the vertex buffers from
+	 * @param scene Scene to deform
+	 * @param skinning_shader Compute shader deforming the vertices
+	 */
+	GPUSkinning(Device &device, sg::Scene &scene, ShaderSource &&skinning_shader = ShaderSource{"skinning/skinning.comp"});
+
+	GPUSkinning(const GPUSkinning &) = delete;
+
+	GPUSkinning(GPUSkinning &&) = delete;
+
+	~GPUSkinning() = default;
+
+	GPUSkinning &operator=(const GPUSkinning &) = delete;
+
+	GPUSkinning &operator=(GPUSkinning &&) = delete;
+
+	/**
+	 * @brief Finds the deformed submeshes of the scene again, on the next dispatch
+	 */
+	void invalidate();
+
+	/**
+	 * @brief Records the deformation of all the deformed submeshes into the vertex buffers of the active frame
+	 * @param command_buffer Command buffer outside of a render pass
+	 * @param render_context Render context of the frame being recorded
+	 */
+	void dispatch(CommandBuffer &command_buffer, RenderContext &render_context);
+
+	/**
+	 * @brief Whether the deformation is dispatched on the async compute queue of the render context,
+	 *        in which case the command buffer given to dispatch must belong to that queue
+	 */
+	void set_async_compute(bool enable);
+
+	bool is_async_compute() const;
+
+	uint32_t get_deformed_submesh_count() const;
+
+	/**
+	 * @brief Number of vertices deformed per frame
+	 */
+	uint32_t get_deformed_vertex_count() const;
+
+	/**
+	 * @brief GPU time of the deformation of the last completed frame, in milliseconds, zero if unknown
+	 */
+	float get_gpu_time() const;
+
+  private:
+	/**
+	 * @brief A submesh deformed with the skin and morph weights of a node
+	 */
+	struct DeformedSubMesh
+	{
+		sg::Node *node{nullptr};
+
+		sg::Mesh *mesh{nullptr};
+
+		sg::SubMesh *sub_mesh{nullptr};
+
+		// Skin of the node, if the submesh has joints and weights, otherwise the node is null and the deformation is shared
+		const sg::Skin *skin{nullptr};
+
+		SkinningPushConstants push_constants{};
+
+		// Deformed vertex buffers of each render frame
+		std::vector<std::unique_ptr<core::Buffer>> position_buffers;
+
+		std::vector<std::unique_ptr<core::Buffer>> normal_buffers;
+	};
+
+	void prepare();
+
+	/**
+	 * @brief Adds a submesh to deform
+	 * @param node Node the vertices are deformed for, nullptr if they are shared by the nodes without a skin
+	 */
+	void add_deformed_submesh(sg::Node *node, const sg::Skin *skin, sg::Mesh &mesh, sg::SubMesh &sub_mesh, const SkinningPushConstants &push_constants);
+
+	/**
+	 * @brief Creates the deformed vertex buffers of a render frame, if the submesh has none yet
+	 */
+	void request_deformed_buffers(DeformedSubMesh &deformed, uint32_t frame_index, size_t frame_count);
+
+	/**
+	 * @brief Gets a buffer to deform a submesh from, the vertex buffers with the attribute name or "morph_targets"
+	 */
+	const core::Buffer &get_input(sg::SubMesh &sub_mesh, const std::string &name);
+
+	/**
+	 * @brief Creates the timestamp queries again if the number of render frames changed
+	 */
+	void prepare_timestamps(size_t frame_count);
+
+	void read_timestamps(uint32_t frame_index);
+
+	Device &device;
+
+	sg::Scene &scene;
+
+	ShaderSource skinning_shader;
+
+	bool prepared{false};
+
+	bool async_compute{false};
+
+	// Copies of the buffers deformed on the async compute queue, which the graphics queue keeps reading
+	std::unordered_map<const sg::SubMesh *, std::unordered_map<std::string, std::unique_ptr<core::Buffer>>> async_inputs;
+
+	std::vector<DeformedSubMesh> deformed_submeshes;
+
+	uint32_t deformed_vertex_count{0};
+
+	// Two timestamps per render frame, around the deformation
+	std::unique_ptr<QueryPool> timestamp_pool;
+
+	std::vector<bool> timestamps_written;
+
+	float timestamp_period{1.0f};
+
+	float gpu_time{0.0f};
+
+	// Joint matrices and morph weights of the submesh being deformed, kept to reuse their storage
+	std::vector<glm::mat4> joint_matrices;
+
+	std::vector<float> morph_weights;
+};
+}        // namespace vkb
@@ -18,6 +18,7 @@
 #include "postprocessing_pipeline.h"
 
 #include "common/utils.h"
+#include "postprocessing_pixelpass.h"
 
 namespace vkb
 {
@@ -28,6 +29,8 @@ PostProcessingPipeline::PostProcessingPipeline(RenderContext &render_context, Sh
 
 void PostProcessingPipeline::draw(CommandBuffer &command_buffer, RenderTarget &default_render_target)
 {
+	pixel_pass_stats = {};
+
 	for (current_pass_index = 0; current_pass_index < passes.size(); current_pass_index++)
 	{
 		auto &pass = *passes[current_pass_index];
@@ -36,6 +39,17 @@ void PostProcessingPipeline::draw(CommandBuffer &command_buffer, RenderTarget &d
 		{
 			pass.debug_name = fmt::format("PPP pass #{}", current_pass_index);
 		}
+
+		auto fused_passes = get_fused_pixel_passes(current_pass_index);
+		if (fused_passes.size() > 1)
+		{
+			draw_fused(command_buffer, default_render_target, fused_passes);
+
+			// Skip the passes drawn along with the current one
+			current_pass_index += fused_passes.size() - 1;
+			continue;
+		}
+
 		ScopedDebugLabel marker{command_buffer, pass.debug_name.c_str()};
 
 		if (!pass.prepared)
@@ -66,4 +80,77 @@ void PostProcessingPipeline::draw(CommandBuffer &command_buffer, RenderTarget &d
 	current_pass_index = 0;
 }
 
+std::vector<PostProcessingPixelPass *> PostProcessingPipeline::get_fused_pixel_passes(size_t first_pass_index) const
+{
+	std::vector<PostProcessingPixelPass *> fused_passes;
+
+	auto *first_pass = dynamic_cast<PostProcessingPixelPass *>(passes[first_pass_index].get());
+	if (first_pass == nullptr)
+	{
+		return fused_passes;
+	}
+
+	fused_passes.push_back(first_pass);
+
+	if (!pixel_pass_fusion)
+	{
+		return fused_passes;
+	}
+
+	for (size_t i = first_pass_index + 1; i < passes.size(); ++i)
+	{
+		auto *pass = dynamic_cast<PostProcessingPixelPass *>(passes[i].get());
+		if (pass == nullptr || !pass->is_chained())
+		{
+			break;
+		}
+
+		fused_passes.push_back(pass);
+	}
+
+	return fused_passes;
+}
+
+void PostProcessingPipeline::draw_fused(CommandBuffer &command_buffer, RenderTarget &default_render_target, const std::vector<PostProcessingPixelPass *> &fused_passes)
+{
+	std::string debug_name = fused_passes.front()->debug_name;
+	for (size_t i = 1; i < fused_passes.size(); ++i)
+	{
+		if (fused_passes[i]->debug_name.empty())
+		{
+			fused_passes[i]->debug_name = fmt::format("PPP pass #{}", current_pass_index + i);
+		}
+		debug_name += " + " + fused_passes[i]->debug_name;
+	}
+	ScopedDebugLabel marker{command_buffer, debug_name.c_str()};
+
+	for (auto *pass : fused_passes)
+	{
+		if (!pass->prepared)
+		{
+			pass->prepare(command_buffer, default_render_target);
+			pass->prepared = true;
+		}
+
+		if (pass->pre_draw)
+		{
+			ScopedDebugLabel marker{command_buffer, "Pre-draw"};
+
+			pass->pre_draw();
+		}
+	}
+
+	PostProcessingPixelPass::draw_stages(command_buffer, default_render_target, fused_passes);
+
+	for (auto *pass : fused_passes)
+	{
+		if (pass->post_draw)
+		{
+			ScopedDebugLabel marker{command_buffer, "Post-draw"};
+
+			pass->post_draw();
+		}
+	}
+}
+
 }        // namespace vkb
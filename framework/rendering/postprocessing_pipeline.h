@@ -22,6 +22,7 @@
 namespace vkb
 {
 class PostProcessingRenderPass;
+class PostProcessingPixelPass;
 
 /**
 * @brief A rendering pipeline specialized for fullscreen post-processing and compute passes.
@@ -30,6 +31,20 @@ class PostProcessingPipeline
 {
   public:
 	friend class PostProcessingPassBase;
+	friend class PostProcessingPixelPass;
+
+	/**
+	 * @brief Work done by the vkb::PostProcessingPixelPass of the last draw()
+	 */
+	struct PixelPassStats
+	{
+		uint32_t dispatch_count{0};
+
+		uint32_t pass_count{0};
+
+		// Bytes of the images read and written by the dispatches, assuming each texel is accessed once
+		uint64_t image_bytes{0};
+	};
 
 	/**
     * @brief Creates a rendering pipeline entirely made of fullscreen post-processing subpasses.
@@ -79,6 +94,25 @@ class PostProcessingPipeline
 		return added_pass;
 	}
 
+	/**
+	 * @brief Whether consecutive vkb::PostProcessingPixelPass are fused into a single dispatch,
+	 *        if the later passes read the output of the previous ones
+	 */
+	inline void set_pixel_pass_fusion(bool enable)
+	{
+		pixel_pass_fusion = enable;
+	}
+
+	inline bool is_pixel_pass_fusion_enabled() const
+	{
+		return pixel_pass_fusion;
+	}
+
+	inline const PixelPassStats &get_pixel_pass_stats() const
+	{
+		return pixel_pass_stats;
+	}
+
 	/**
 	 * @brief Returns the current render context.
 	 */
@@ -100,6 +134,18 @@ class PostProcessingPipeline
 	ShaderSource                                         triangle_vs;
 	std::vector<std::unique_ptr<PostProcessingPassBase>> passes{};
 	size_t                                               current_pass_index{0};
+	bool                                                 pixel_pass_fusion{true};
+	PixelPassStats                                       pixel_pass_stats{};
+
+	/**
+	 * @brief Collects the pixel passes fused with the pass at the given index, including itself
+	 */
+	std::vector<PostProcessingPixelPass *> get_fused_pixel_passes(size_t first_pass_index) const;
+
+	/**
+	 * @brief Runs the fused pixel passes as a single dispatch
+	 */
+	void draw_fused(CommandBuffer &command_buffer, RenderTarget &default_render_target, const std::vector<PostProcessingPixelPass *> &fused_passes);
 };
 
 }        // namespace vkb
\ No newline at end of file
@@ -0,0 +1,347 @@
+/* Copyright (c) 2023, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "postprocessing_pixelpass.h"
+
+#include "common/helpers.h"
+#include "common/strings.h"
+#include "postprocessing_pipeline.h"
+
+namespace vkb
+{
+namespace
+{
+/**
+ * @brief Format layout qualifier of the storage images read and written by the stages
+ */
+std::string get_image_format_qualifier(VkFormat format)
+{
+	static const std::unordered_map<VkFormat, std::string> qualifiers{
+	    {VK_FORMAT_R8G8B8A8_UNORM, "rgba8"},
+	    {VK_FORMAT_R16G16B16A16_SFLOAT, "rgba16f"},
+	    {VK_FORMAT_R32G32B32A32_SFLOAT, "rgba32f"},
+	    {VK_FORMAT_B10G11R11_UFLOAT_PACK32, "r11f_g11f_b10f"},
+	    {VK_FORMAT_A2B10G10R10_UNORM_PACK32, "rgb10_a2"}};
+
+	auto it = qualifiers.find(format);
+	if (it == qualifiers.end())
+	{
+		throw std::runtime_error{"Format " + to_string(format) + " is not supported by postprocessing pixel passes"};
+	}
+
+	return it->second;
+}
+
+uint64_t get_image_size(const core::ImageView &view)
+{
+	const auto &extent = view.get_image().get_extent();
+	return static_cast<uint64_t>(extent.width) * extent.height * get_bits_per_pixel(view.get_format()) / 8;
+}
+}        // namespace
+
+PostProcessingPixelPass::PostProcessingPixelPass(PostProcessingPipeline *parent, const ShaderSource &stage_source, std::shared_ptr<core::Sampler> &&default_sampler) :
+    PostProcessingPass{parent},
+    stage_source{stage_source}
+{
+	this->default_sampler = std::move(default_sampler);
+
+	if (this->default_sampler == nullptr)
+	{
+		// Setup a sane default sampler if none was passed
+		VkSamplerCreateInfo sampler_info{VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO};
+		sampler_info.minFilter        = VK_FILTER_LINEAR;
+		sampler_info.magFilter        = VK_FILTER_LINEAR;
+		sampler_info.mipmapMode       = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+		sampler_info.addressModeU     = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		sampler_info.addressModeV     = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		sampler_info.addressModeW     = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		sampler_info.mipLodBias       = 0.0f;
+		sampler_info.compareOp        = VK_COMPARE_OP_NEVER;
+		sampler_info.minLod           = 0.0f;
+		sampler_info.maxLod           = 0.0f;
+		sampler_info.anisotropyEnable = VK_FALSE;
+		sampler_info.maxAnisotropy    = 0.0f;
+		sampler_info.borderColor      = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
+
+		this->default_sampler = std::make_shared<vkb::core::Sampler>(get_render_context().get_device(), sampler_info);
+	}
+}
+
+PostProcessingPixelPass &PostProcessingPixelPass::bind_input(core::SampledImage &&new_image)
+{
+	input = std::make_unique<core::SampledImage>(std::move(new_image));
+
+	return *this;
+}
+
+PostProcessingPixelPass &PostProcessingPixelPass::bind_output(core::SampledImage &&new_image)
+{
+	output = std::make_unique<core::SampledImage>(std::move(new_image));
+
+	return *this;
+}
+
+PostProcessingPixelPass &PostProcessingPixelPass::bind_sampled_image(const std::string &name, core::SampledImage &&new_image)
+{
+	auto it = sampled_images.find(name);
+	if (it != sampled_images.end())
+	{
+		it->second = new_image;
+	}
+	else
+	{
+		sampled_images.emplace(name, new_image);
+	}
+
+	return *this;
+}
+
+const core::SampledImage &PostProcessingPixelPass::get_input() const
+{
+	if (input)
+	{
+		return *input;
+	}
+
+	// Chained passes are only drawn when they are the current pass, their predecessor is the previous pass
+	const size_t pass_index = parent->get_current_pass_index();
+
+	auto *previous = pass_index > 0 ? dynamic_cast<PostProcessingPixelPass *>(parent->get_passes()[pass_index - 1].get()) : nullptr;
+	if (previous == nullptr)
+	{
+		throw std::runtime_error{"Postprocessing pixel pass " + debug_name + " has no input, and does not follow a pixel pass"};
+	}
+
+	return previous->get_output();
+}
+
+const core::SampledImage &PostProcessingPixelPass::get_output() const
+{
+	if (output == nullptr)
+	{
+		throw std::runtime_error{"Postprocessing pixel pass " + debug_name + " has no output, and is not fused with the next pass"};
+	}
+
+	return *output;
+}
+
+const ShaderSource &PostProcessingPixelPass::get_fused_source(const std::vector<PostProcessingPixelPass *> &stages, VkFormat input_format, VkFormat output_format)
+{
+	size_t key = 0;
+	hash_combine(key, input_format);
+	hash_combine(key, output_format);
+	for (auto *stage : stages)
+	{
+		hash_combine(key, stage->stage_source.get_id());
+	}
+
+	auto it = fused_sources.find(key);
+	if (it != fused_sources.end())
+	{
+		return it->second;
+	}
+
+	std::string source = "#version 450\n\n"
+	                     "layout(local_size_x = 8, local_size_y = 8) in;\n\n";
+
+	source += "layout(set = 0, binding = 0, " + get_image_format_qualifier(input_format) + ") uniform readonly image2D fused_input;\n\n";
+	source += "layout(set = 0, binding = 1, " + get_image_format_qualifier(output_format) + ") uniform writeonly image2D fused_output;\n\n";
+
+	// Each stage gets its own range of bindings, and its process function is renamed after its index
+	for (size_t i = 0; i < stages.size(); ++i)
+	{
+		source += "#define STAGE_BINDING(index) layout(set = 0, binding = " + std::to_string(stage_binding_base + i * stage_binding_count) + " + index)\n";
+		source += "#define process process_" + std::to_string(i) + "\n";
+		source += stages[i]->stage_source.get_source();
+		source += "\n#undef process\n#undef STAGE_BINDING\n\n";
+	}
+
+	source += "void main()\n"
+	          "{\n"
+	          "\tivec2 size  = imageSize(fused_output);\n"
+	          "\tivec2 pixel = ivec2(gl_GlobalInvocationID.xy);\n"
+	          "\tif (pixel.x >= size.x || pixel.y >= size.y)\n"
+	          "\t{\n"
+	          "\t\treturn;\n"
+	          "\t}\n\n"
+	          "\tvec2 uv    = (vec2(pixel) + 0.5) / vec2(size);\n"
+	          "\tvec4 color = imageLoad(fused_input, pixel);\n";
+
+	for (size_t i = 0; i < stages.size(); ++i)
+	{
+		source += "\tcolor = process_" + std::to_string(i) + "(color, pixel, uv);\n";
+	}
+
+	source += "\n\timageStore(fused_output, pixel, color);\n"
+	          "}\n";
+
+	ShaderSource fused_source;
+	fused_source.set_source(source);
+
+	return fused_sources.emplace(key, std::move(fused_source)).first->second;
+}
+
+void PostProcessingPixelPass::transition_images(CommandBuffer &command_buffer, RenderTarget &default_render_target, const std::vector<PostProcessingPixelPass *> &stages)
+{
+	auto &first = *stages.front();
+
+	BarrierInfo fallback_barrier_src{};
+	fallback_barrier_src.pipeline_stage     = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+	fallback_barrier_src.image_read_access  = 0;
+	fallback_barrier_src.image_write_access = 0;
+	const auto prev_pass_barrier_info       = first.get_predecessor_src_barrier_info(fallback_barrier_src);
+	const bool has_predecessor              = first.parent->get_current_pass_index() > 0;
+
+	auto transition = [&](const core::SampledImage &image, VkImageLayout new_layout, VkAccessFlags dst_access) {
+		auto &rt = image.get_render_target(default_render_target);
+
+		vkb::ImageMemoryBarrier barrier;
+		barrier.new_layout      = new_layout;
+		barrier.src_access_mask = prev_pass_barrier_info.image_write_access;
+		barrier.dst_access_mask = dst_access;
+		barrier.src_stage_mask  = prev_pass_barrier_info.pipeline_stage;
+		barrier.dst_stage_mask  = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+
+		if (const uint32_t *attachment = image.get_target_attachment())
+		{
+			barrier.old_layout = rt.get_layout(*attachment);
+			if (barrier.old_layout == new_layout && !has_predecessor)
+			{
+				// No-op
+				return;
+			}
+
+			rt.set_layout(*attachment, new_layout);
+		}
+		else if (has_predecessor)
+		{
+			// Images which are not attachments are kept in the layout they are accessed with,
+			// only the writes of the previous pass must be made visible
+			barrier.old_layout = new_layout;
+		}
+		else
+		{
+			return;
+		}
+
+		command_buffer.image_memory_barrier(image.get_image_view(default_render_target), barrier);
+	};
+
+	transition(first.get_input(), VK_IMAGE_LAYOUT_GENERAL, VK_ACCESS_SHADER_READ_BIT);
+
+	for (auto *stage : stages)
+	{
+		for (const auto &sampled : stage->sampled_images)
+		{
+			if (sampled.second.get_target_attachment())
+			{
+				transition(sampled.second, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_ACCESS_SHADER_READ_BIT);
+			}
+		}
+	}
+
+	if (stages.back()->get_output().get_target_attachment())
+	{
+		transition(stages.back()->get_output(), VK_IMAGE_LAYOUT_GENERAL, VK_ACCESS_SHADER_WRITE_BIT);
+	}
+}
+
+void PostProcessingPixelPass::draw(CommandBuffer &command_buffer, RenderTarget &default_render_target)
+{
+	draw_stages(command_buffer, default_render_target, {this});
+}
+
+void PostProcessingPixelPass::draw_stages(CommandBuffer &command_buffer, RenderTarget &default_render_target, const std::vector<PostProcessingPixelPass *> &stages)
+{
+	assert(!stages.empty() && "A pixel pass dispatch needs at least one stage");
+
+	auto &first = *stages.front();
+
+	transition_images(command_buffer, default_render_target, stages);
+
+	const auto &input_view  = first.get_input().get_image_view(default_render_target);
+	const auto &output_view = stages.back()->get_output().get_image_view(default_render_target);
+
+	auto &resource_cache  = command_buffer.get_device().get_resource_cache();
+	auto &shader_module   = resource_cache.request_shader_module(VK_SHADER_STAGE_COMPUTE_BIT, first.get_fused_source(stages, input_view.get_format(), output_view.get_format()));
+	auto &pipeline_layout = resource_cache.request_pipeline_layout({&shader_module});
+	command_buffer.bind_pipeline_layout(pipeline_layout);
+
+	const auto &bindings = pipeline_layout.get_descriptor_set_layout(0);
+
+	command_buffer.bind_image(input_view, 0, 0, 0);
+	command_buffer.bind_image(output_view, 0, 1, 0);
+
+	const auto &extent = output_view.get_image().get_extent();
+
+	auto &stats = first.parent->pixel_pass_stats;
+	stats.dispatch_count++;
+	stats.pass_count += to_u32(stages.size());
+	stats.image_bytes += static_cast<uint64_t>(extent.width) * extent.height * (get_bits_per_pixel(input_view.get_format()) + get_bits_per_pixel(output_view.get_format())) / 8;
+
+	auto &render_frame = first.get_render_context().get_active_frame();
+
+	for (size_t i = 0; i < stages.size(); ++i)
+	{
+		auto &stage = *stages[i];
+
+		if (!stage.uniform_data.empty())
+		{
+			auto allocation = render_frame.allocate_buffer(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, stage.uniform_data.size());
+			allocation.update(stage.uniform_data);
+
+			// Bind buffer to STAGE_BINDING(0)
+			command_buffer.bind_buffer(allocation.get_buffer(), allocation.get_offset(), allocation.get_size(), 0, to_u32(stage_binding_base + i * stage_binding_count), 0);
+		}
+
+		// Bind samplers to STAGE_BINDING(<according to name>)
+		for (const auto &it : stage.sampled_images)
+		{
+			if (auto layout_binding = bindings.get_layout_binding(it.first))
+			{
+				const auto &view    = it.second.get_image_view(default_render_target);
+				const auto &sampler = it.second.get_sampler() ? *it.second.get_sampler() : *stage.default_sampler;
+
+				command_buffer.bind_image(view, sampler, 0, layout_binding->binding, 0);
+
+				stats.image_bytes += get_image_size(view);
+			}
+		}
+	}
+
+	command_buffer.dispatch((extent.width + 7) / 8, (extent.height + 7) / 8, 1);
+}
+
+PostProcessingPixelPass::BarrierInfo PostProcessingPixelPass::get_src_barrier_info() const
+{
+	BarrierInfo info{};
+	info.pipeline_stage     = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+	info.image_read_access  = VK_ACCESS_SHADER_READ_BIT;
+	info.image_write_access = VK_ACCESS_SHADER_WRITE_BIT;
+	return info;
+}
+
+PostProcessingPixelPass::BarrierInfo PostProcessingPixelPass::get_dst_barrier_info() const
+{
+	BarrierInfo info{};
+	info.pipeline_stage     = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+	info.image_read_access  = VK_ACCESS_SHADER_READ_BIT;
+	info.image_write_access = VK_ACCESS_SHADER_WRITE_BIT;
+	return info;
+}
+
+}        // namespace vkb
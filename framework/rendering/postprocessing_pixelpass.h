@@ -0,0 +1,147 @@
+/* Copyright (c) 2023, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <unordered_map>
+
+#include "core/sampled_image.h"
+#include "core/shader_module.h"
+#include "postprocessing_pass.h"
+
+namespace vkb
+{
+/**
+ * @brief A per-pixel compute stage in a vkb::PostProcessingPipeline.
+ *
+ *        The stage source is a GLSL snippet defining `vec4 process(vec4 color, ivec2 pixel, vec2 uv)`,
+ *        which receives the color of a pixel of the input image and returns the color of the same pixel
+ *        of the output image. The pass generates the compute shader reading the input and writing the
+ *        output around it. The shader is generated and built on the first draw.
+ *
+ *        The snippet declares its resources with `STAGE_BINDING(index)` instead of a layout qualifier,
+ *        index 0 being the uniform data of the pass and indices 1 to 7 its sampled images. As stages may be
+ *        fused in a single shader, the names of their resources and functions must be unique across stages.
+ *
+ *        If enabled in the pipeline, consecutive pixel passes are fused into a single dispatch, passing
+ *        the color from one stage to the next in registers. Only the input of the first pass and the output
+ *        of the last pass of a fused group are accessed, the outputs of the other passes are not written.
+ */
+class PostProcessingPixelPass : public PostProcessingPass<PostProcessingPixelPass>
+{
+	friend class PostProcessingPipeline;
+
+  public:
+	PostProcessingPixelPass(PostProcessingPipeline *parent, const ShaderSource &stage_source, std::shared_ptr<core::Sampler> &&default_sampler = {});
+
+	PostProcessingPixelPass(const PostProcessingPixelPass &to_copy) = delete;
+	PostProcessingPixelPass &operator=(const PostProcessingPixelPass &to_copy) = delete;
+
+	PostProcessingPixelPass(PostProcessingPixelPass &&to_move) = default;
+	PostProcessingPixelPass &operator=(PostProcessingPixelPass &&to_move) = default;
+
+	void draw(CommandBuffer &command_buffer, RenderTarget &default_render_target) override;
+
+	/**
+	 * @brief Sets the image read by this pass, as a storage image in GENERAL layout.
+	 * @remarks If no input is set, the pass reads the output of the previous pass of the pipeline,
+	 *          which must be a pixel pass.
+	 */
+	PostProcessingPixelPass &bind_input(core::SampledImage &&new_image);
+
+	/**
+	 * @brief Sets the image written by this pass, as a storage image in GENERAL layout.
+	 * @remarks Images from RenderTarget attachments are automatically transitioned to GENERAL layout if needed.
+	 *          The dispatch covers the extent of the output image.
+	 */
+	PostProcessingPixelPass &bind_output(core::SampledImage &&new_image);
+
+	/**
+	 * @brief Changes (or adds) the sampled image at name for this stage.
+	 * @remarks Images from RenderTarget attachments are automatically transitioned to SHADER_READ_ONLY_OPTIMAL layout if needed.
+	 */
+	PostProcessingPixelPass &bind_sampled_image(const std::string &name, core::SampledImage &&new_image);
+
+	/**
+	 * @brief Set the uniform data to be bound at STAGE_BINDING(0).
+	 */
+	template <typename T>
+	inline PostProcessingPixelPass &set_uniform_data(const T &data)
+	{
+		auto data_ptr = reinterpret_cast<const uint8_t *>(&data);
+		uniform_data.assign(data_ptr, data_ptr + sizeof(data));
+
+		return *this;
+	}
+
+	/**
+	 * @brief Whether the input of this pass is the output of the previous pixel pass
+	 */
+	inline bool is_chained() const
+	{
+		return input == nullptr;
+	}
+
+  private:
+	// Bindings of the input and output images, the stages start after them
+	static constexpr uint32_t stage_binding_base{2};
+
+	// Number of bindings reserved for each stage
+	static constexpr uint32_t stage_binding_count{8};
+
+	/**
+	 * @brief Records a single dispatch running all the stages, from the input of the first one
+	 *        to the output of the last one
+	 */
+	static void draw_stages(CommandBuffer &command_buffer, RenderTarget &default_render_target, const std::vector<PostProcessingPixelPass *> &stages);
+
+	/**
+	 * @brief Generates the compute shader running the stages, or returns the one generated previously
+	 */
+	const ShaderSource &get_fused_source(const std::vector<PostProcessingPixelPass *> &stages, VkFormat input_format, VkFormat output_format);
+
+	/**
+	 * @brief Returns the image read by this pass, which is the output of the previous pass if chained
+	 */
+	const core::SampledImage &get_input() const;
+
+	const core::SampledImage &get_output() const;
+
+	/**
+	 * @brief Transitions the input and output images to GENERAL and the sampled images to SHADER_READ_ONLY_OPTIMAL,
+	 *        and makes the writes of the previous pass visible to the dispatch
+	 */
+	static void transition_images(CommandBuffer &command_buffer, RenderTarget &default_render_target, const std::vector<PostProcessingPixelPass *> &stages);
+
+	BarrierInfo get_src_barrier_info() const override;
+	BarrierInfo get_dst_barrier_info() const override;
+
+	ShaderSource stage_source;
+
+	std::unique_ptr<core::SampledImage> input{};
+
+	std::unique_ptr<core::SampledImage> output{};
+
+	std::unordered_map<std::string, core::SampledImage> sampled_images{};
+
+	std::vector<uint8_t> uniform_data{};
+
+	// Generated compute shaders, by stages and image formats
+	std::unordered_map<size_t, ShaderSource> fused_sources{};
+};
+
+}        // namespace vkb
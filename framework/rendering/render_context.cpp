@@ -19,6 +19,10 @@
 
 #include "platform/window.h"
 
+#include <algorithm>
+#include <iterator>
+#include <limits>
+
 namespace vkb
 {
 VkFormat RenderContext::DEFAULT_VK_FORMAT = VK_FORMAT_R8G8B8A8_SRGB;
@@ -45,6 +49,19 @@ RenderContext::RenderContext(Device &device, VkSurfaceKHR surface, const Window
 			swapchain = std::make_unique<Swapchain>(device, surface);
 		}
 	}
+
+	select_async_compute_queue();
+}
+
+RenderContext::~RenderContext()
+{
+	for (auto &timeline : timelines)
+	{
+		if (timeline.semaphore != VK_NULL_HANDLE)
+		{
+			vkDestroySemaphore(device.get_handle(), timeline.semaphore, nullptr);
+		}
+	}
 }
 
 void RenderContext::request_present_mode(const VkPresentModeKHR present_mode)
@@ -92,17 +109,20 @@ void RenderContext::prepare(size_t thread_count, RenderTarget::CreateFunc create
 	}
 	else
 	{
-		// Otherwise, create a single RenderFrame
+		// Otherwise, create a RenderFrame for each frame in flight
 		swapchain = nullptr;
 
-		auto color_image = core::Image{device,
-		                               VkExtent3D{surface_extent.width, surface_extent.height, 1},
-		                               DEFAULT_VK_FORMAT,        // We can use any format here that we like
-		                               VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
-		                               VMA_MEMORY_USAGE_GPU_ONLY};
+		for (uint32_t i = 0; i < std::max(frames_in_flight, 1u); ++i)
+		{
+			auto color_image = core::Image{device,
+			                               VkExtent3D{surface_extent.width, surface_extent.height, 1},
+			                               DEFAULT_VK_FORMAT,        // We can use any format here that we like
+			                               VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+			                               VMA_MEMORY_USAGE_GPU_ONLY};
 
-		auto render_target = create_render_target_func(std::move(color_image));
-		frames.emplace_back(std::make_unique<RenderFrame>(device, std::move(render_target), thread_count));
+			auto render_target = create_render_target_func(std::move(color_image));
+			frames.emplace_back(std::make_unique<RenderFrame>(device, std::move(render_target), thread_count));
+		}
 	}
 
 	this->create_render_target_func = create_render_target_func;
@@ -122,6 +142,26 @@ void RenderContext::set_surface_format_priority(const std::vector<VkSurfaceForma
 	surface_format_priority_list = new_surface_format_priority_list;
 }
 
+void RenderContext::set_frames_in_flight(uint32_t count)
+{
+	if (prepared && count > frames.size())
+	{
+		LOGW("{} frames in flight requested, limited to the {} render frames", count, frames.size());
+	}
+
+	frames_in_flight = count;
+}
+
+uint32_t RenderContext::get_frames_in_flight() const
+{
+	if (frames_in_flight == 0)
+	{
+		return to_u32(frames.size());
+	}
+
+	return std::min(frames_in_flight, to_u32(frames.size()));
+}
+
 VkFormat RenderContext::get_format() const
 {
 	VkFormat format = DEFAULT_VK_FORMAT;
@@ -364,54 +404,26 @@ void RenderContext::begin_frame()
 
 	// Wait on all resource to be freed from the previous render to this frame
 	wait_frame();
-}
-
-VkSemaphore RenderContext::submit(const Queue &queue, const std::vector<CommandBuffer *> &command_buffers, VkSemaphore wait_semaphore, VkPipelineStageFlags wait_pipeline_stage)
-{
-	std::vector<VkCommandBuffer> cmd_buf_handles(command_buffers.size(), VK_NULL_HANDLE);
-	std::transform(command_buffers.begin(), command_buffers.end(), cmd_buf_handles.begin(), [](const CommandBuffer *cmd_buf) { return cmd_buf->get_handle(); });
 
-	RenderFrame &frame = get_active_frame();
-
-	VkSemaphore signal_semaphore = frame.request_semaphore();
-
-	VkSubmitInfo submit_info{VK_STRUCTURE_TYPE_SUBMIT_INFO};
-
-	submit_info.commandBufferCount = to_u32(cmd_buf_handles.size());
-	submit_info.pCommandBuffers    = cmd_buf_handles.data();
-
-	if (wait_semaphore != VK_NULL_HANDLE)
+	// Fewer frames in flight than render frames, wait for the frame that many frames ago
+	if (get_frames_in_flight() < frames.size())
 	{
-		submit_info.waitSemaphoreCount = 1;
-		submit_info.pWaitSemaphores    = &wait_semaphore;
-		submit_info.pWaitDstStageMask  = &wait_pipeline_stage;
+		wait_for_frame(get_frames_in_flight() - 1);
 	}
+}
 
-	submit_info.signalSemaphoreCount = 1;
-	submit_info.pSignalSemaphores    = &signal_semaphore;
-
-	VkFence fence = frame.request_fence();
+VkSemaphore RenderContext::submit(const Queue &queue, const std::vector<CommandBuffer *> &command_buffers, VkSemaphore wait_semaphore, VkPipelineStageFlags wait_pipeline_stage)
+{
+	VkSemaphore signal_semaphore = get_active_frame().request_semaphore();
 
-	queue.submit({submit_info}, fence);
+	submit(&queue == async_compute_queue ? QueueType::AsyncCompute : QueueType::Graphics, queue, command_buffers, wait_semaphore, wait_pipeline_stage, signal_semaphore);
 
 	return signal_semaphore;
 }
 
 void RenderContext::submit(const Queue &queue, const std::vector<CommandBuffer *> &command_buffers)
 {
-	std::vector<VkCommandBuffer> cmd_buf_handles(command_buffers.size(), VK_NULL_HANDLE);
-	std::transform(command_buffers.begin(), command_buffers.end(), cmd_buf_handles.begin(), [](const CommandBuffer *cmd_buf) { return cmd_buf->get_handle(); });
-
-	RenderFrame &frame = get_active_frame();
-
-	VkSubmitInfo submit_info{VK_STRUCTURE_TYPE_SUBMIT_INFO};
-
-	submit_info.commandBufferCount = to_u32(cmd_buf_handles.size());
-	submit_info.pCommandBuffers    = cmd_buf_handles.data();
-
-	VkFence fence = frame.request_fence();
-
-	queue.submit({submit_info}, fence);
+	submit(&queue == async_compute_queue ? QueueType::AsyncCompute : QueueType::Graphics, queue, command_buffers, VK_NULL_HANDLE, 0, VK_NULL_HANDLE);
 }
 
 void RenderContext::wait_frame()
@@ -452,6 +464,22 @@ void RenderContext::end_frame(VkSemaphore semaphore)
 		}
 	}
 
+	SubmittedFrame submitted_frame{};
+	submitted_frame.frame_index     = active_frame_index;
+	submitted_frame.timeline_values = {timelines[0].value, timelines[1].value};
+
+	submitted_frames.push_back(submitted_frame);
+	while (submitted_frames.size() > frames.size())
+	{
+		submitted_frames.pop_front();
+	}
+
+	// Without swapchain, the render frames are used in turn
+	if (!swapchain)
+	{
+		active_frame_index = (active_frame_index + 1) % to_u32(frames.size());
+	}
+
 	// Frame is not active anymore
 	if (acquired_semaphore)
 	{
@@ -536,6 +564,361 @@ void RenderContext::recreate_swapchain()
 	}
 }
 
+void RenderContext::set_frame_synchronization(FrameSynchronization synchronization)
+{
+	if (synchronization == FrameSynchronization::TimelineSemaphores && timelines[0].semaphore == VK_NULL_HANDLE)
+	{
+		LOGW("Timeline semaphores are not enabled, frames stay synchronized with fences");
+		return;
+	}
+
+	// The frames in flight wait for both their fences and their timeline values, so the switch needs no wait
+	frame_synchronization = synchronization;
+	submitted_frames.clear();
+}
+
+RenderContext::FrameSynchronization RenderContext::get_frame_synchronization() const
+{
+	return frame_synchronization;
+}
+
+void RenderContext::wait_for_frame(uint32_t frames_ago)
+{
+	if (frames_ago >= submitted_frames.size())
+	{
+		return;
+	}
+
+	auto &submitted_frame = submitted_frames[submitted_frames.size() - 1 - frames_ago];
+
+	if (frame_synchronization == FrameSynchronization::Fences)
+	{
+		frames[submitted_frame.frame_index]->wait();
+		return;
+	}
+
+	std::array<VkSemaphore, 2> semaphores{timelines[0].semaphore, timelines[1].semaphore};
+
+	VkSemaphoreWaitInfoKHR wait_info{VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO_KHR};
+	wait_info.semaphoreCount = to_u32(semaphores.size());
+	wait_info.pSemaphores    = semaphores.data();
+	wait_info.pValues        = submitted_frame.timeline_values.data();
+
+	VK_CHECK(vkWaitSemaphoresKHR(device.get_handle(), &wait_info, std::numeric_limits<uint64_t>::max()));
+}
+
+bool RenderContext::has_async_compute_queue() const
+{
+	return async_compute_queue != &queue;
+}
+
+const Queue &RenderContext::get_async_compute_queue() const
+{
+	return *async_compute_queue;
+}
+
+CommandBuffer &RenderContext::begin_async_compute(CommandBuffer::ResetMode reset_mode)
+{
+	assert(frame_active && "RenderContext is inactive, cannot record async compute work. Please call begin()");
+
+	return get_active_frame().request_command_buffer(*async_compute_queue, reset_mode);
+}
+
+void RenderContext::submit_async_compute(const std::vector<CommandBuffer *> &command_buffers)
+{
+	assert(frame_active && "RenderContext is inactive, cannot submit command buffer. Please call begin()");
+
+	submit(QueueType::AsyncCompute, *async_compute_queue, command_buffers, VK_NULL_HANDLE, 0, VK_NULL_HANDLE);
+}
+
+void RenderContext::transfer_ownership(const core::Buffer &buffer, QueueType src_queue, const BufferMemoryBarrier &memory_barrier)
+{
+	OwnershipTransfer transfer{};
+	transfer.buffer                         = &buffer;
+	transfer.src_queue                      = src_queue;
+	transfer.memory_barrier.src_stage_mask  = memory_barrier.src_stage_mask;
+	transfer.memory_barrier.dst_stage_mask  = memory_barrier.dst_stage_mask;
+	transfer.memory_barrier.src_access_mask = memory_barrier.src_access_mask;
+	transfer.memory_barrier.dst_access_mask = memory_barrier.dst_access_mask;
+
+	ownership_transfers.push_back(transfer);
+}
+
+void RenderContext::transfer_ownership(const core::ImageView &image_view, QueueType src_queue, const ImageMemoryBarrier &memory_barrier)
+{
+	OwnershipTransfer transfer{};
+	transfer.image_view     = &image_view;
+	transfer.src_queue      = src_queue;
+	transfer.memory_barrier = memory_barrier;
+
+	ownership_transfers.push_back(transfer);
+}
+
+void RenderContext::select_async_compute_queue()
+{
+	async_compute_queue = &queue;
+
+	// The queues wait for each other on timeline semaphores
+	if (!device.is_enabled(VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME))
+	{
+		return;
+	}
+
+	uint32_t compute_family_index = device.get_queue_family_index(VK_QUEUE_COMPUTE_BIT);
+
+	if (compute_family_index != queue.get_family_index())
+	{
+		async_compute_queue = &device.get_queue(compute_family_index, 0);
+	}
+	else if (device.get_num_queues_for_queue_family(compute_family_index) > 1)
+	{
+		// Another queue of the graphics family still runs compute work alongside the graphics work
+		async_compute_queue = &device.get_queue(compute_family_index, queue.get_index() == 0 ? 1 : 0);
+	}
+	else
+	{
+		LOGI("No queue available for async compute, it runs on the graphics queue");
+	}
+
+	VkSemaphoreTypeCreateInfoKHR semaphore_type_info{VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO_KHR};
+	semaphore_type_info.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE_KHR;
+	semaphore_type_info.initialValue  = 0;
+
+	VkSemaphoreCreateInfo semaphore_info{VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO};
+	semaphore_info.pNext = &semaphore_type_info;
+
+	for (auto &timeline : timelines)
+	{
+		VK_CHECK(vkCreateSemaphore(device.get_handle(), &semaphore_info, nullptr, &timeline.semaphore));
+	}
+
+	if (has_async_compute_queue())
+	{
+		LOGI("Async compute runs on queue {} of family {}", async_compute_queue->get_index(), async_compute_queue->get_family_index());
+	}
+}
+
+const Queue &RenderContext::get_queue(QueueType queue_type) const
+{
+	return queue_type == QueueType::Graphics ? queue : *async_compute_queue;
+}
+
+void RenderContext::submit(QueueType queue_type, const Queue &submit_queue, const std::vector<CommandBuffer *> &command_buffers,
+                           VkSemaphore wait_semaphore, VkPipelineStageFlags wait_pipeline_stage, VkSemaphore signal_semaphore,
+                           bool releases_only)
+{
+	RenderFrame &frame = get_active_frame();
+
+	// Work submitted on other queues, such as the extra graphics queues of some samples, takes no part in the transfers
+	const bool      transfers       = &submit_queue == &get_queue(queue_type);
+	const bool      timeline_pacing = transfers && frame_synchronization == FrameSynchronization::TimelineSemaphores;
+	const QueueType other_queue     = queue_type == QueueType::Graphics ? QueueType::AsyncCompute : QueueType::Graphics;
+	const bool      same_queue      = &queue == async_compute_queue;
+	const bool      same_family     = queue.get_family_index() == async_compute_queue->get_family_index();
+	const auto      is_acquired     = [other_queue](const OwnershipTransfer &transfer) { return transfer.src_queue == other_queue; };
+	const auto      is_not_released = [queue_type](const OwnershipTransfer &transfer) { return transfer.src_queue == queue_type && !transfer.released; };
+
+	std::vector<OwnershipTransfer> acquires;
+	std::vector<OwnershipTransfer> releases;
+
+	if (transfers && !releases_only)
+	{
+		// Resources whose source queue has no work pending are released on their own.
+		// That submit only releases, so it never comes back here for the transfers of this queue
+		if (std::any_of(ownership_transfers.begin(), ownership_transfers.end(), [other_queue](const OwnershipTransfer &transfer) {
+			    return transfer.src_queue == other_queue && !transfer.released;
+		    }))
+		{
+			submit_releases(other_queue);
+		}
+
+		std::copy_if(ownership_transfers.begin(), ownership_transfers.end(), std::back_inserter(acquires), is_acquired);
+
+		ownership_transfers.erase(std::remove_if(ownership_transfers.begin(), ownership_transfers.end(), is_acquired), ownership_transfers.end());
+	}
+
+	if (transfers)
+	{
+		std::copy_if(ownership_transfers.begin(), ownership_transfers.end(), std::back_inserter(releases), is_not_released);
+	}
+
+	std::vector<VkCommandBuffer> cmd_buf_handles;
+
+	if (!acquires.empty())
+	{
+		auto &acquire_command_buffer = frame.request_command_buffer(submit_queue);
+		acquire_command_buffer.begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+		record_ownership_barriers(acquire_command_buffer, acquires, false);
+		acquire_command_buffer.end();
+
+		cmd_buf_handles.push_back(acquire_command_buffer.get_handle());
+	}
+
+	for (auto command_buffer : command_buffers)
+	{
+		cmd_buf_handles.push_back(command_buffer->get_handle());
+	}
+
+	// Queues of the same family need no release barrier
+	if (!releases.empty() && !same_family)
+	{
+		auto &release_command_buffer = frame.request_command_buffer(submit_queue);
+		release_command_buffer.begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+		record_ownership_barriers(release_command_buffer, releases, true);
+		release_command_buffer.end();
+
+		cmd_buf_handles.push_back(release_command_buffer.get_handle());
+	}
+
+	// Binary semaphores ignore their value
+	std::vector<VkSemaphore>          wait_semaphores;
+	std::vector<VkPipelineStageFlags> wait_stages;
+	std::vector<uint64_t>             wait_values;
+	std::vector<VkSemaphore>          signal_semaphores;
+	std::vector<uint64_t>             signal_values;
+
+	if (wait_semaphore != VK_NULL_HANDLE)
+	{
+		wait_semaphores.push_back(wait_semaphore);
+		wait_stages.push_back(wait_pipeline_stage);
+		wait_values.push_back(0);
+	}
+
+	if (signal_semaphore != VK_NULL_HANDLE)
+	{
+		signal_semaphores.push_back(signal_semaphore);
+		signal_values.push_back(0);
+	}
+
+	if (!same_queue && !acquires.empty())
+	{
+		VkPipelineStageFlags acquire_stages = 0;
+		uint64_t             release_value  = 0;
+		for (auto &acquire : acquires)
+		{
+			acquire_stages |= acquire.memory_barrier.dst_stage_mask;
+			release_value = std::max(release_value, acquire.release_value);
+		}
+
+		wait_semaphores.push_back(timelines[static_cast<size_t>(other_queue)].semaphore);
+		wait_stages.push_back(acquire_stages);
+		wait_values.push_back(release_value);
+	}
+
+	// The timeline of the queue also tells when the frame completes
+	const bool signal_timeline = (!same_queue && !releases.empty()) || timeline_pacing;
+	if (signal_timeline)
+	{
+		auto &timeline = timelines[static_cast<size_t>(queue_type)];
+
+		signal_semaphores.push_back(timeline.semaphore);
+		signal_values.push_back(++timeline.value);
+	}
+
+	for (auto &transfer : ownership_transfers)
+	{
+		if (transfers && is_not_released(transfer))
+		{
+			transfer.released      = true;
+			transfer.release_value = timelines[static_cast<size_t>(queue_type)].value;
+		}
+	}
+
+	VkSubmitInfo submit_info{VK_STRUCTURE_TYPE_SUBMIT_INFO};
+
+	submit_info.commandBufferCount   = to_u32(cmd_buf_handles.size());
+	submit_info.pCommandBuffers      = cmd_buf_handles.data();
+	submit_info.waitSemaphoreCount   = to_u32(wait_semaphores.size());
+	submit_info.pWaitSemaphores      = wait_semaphores.data();
+	submit_info.pWaitDstStageMask    = wait_stages.data();
+	submit_info.signalSemaphoreCount = to_u32(signal_semaphores.size());
+	submit_info.pSignalSemaphores    = signal_semaphores.data();
+
+	VkTimelineSemaphoreSubmitInfoKHR timeline_info{VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO_KHR};
+	timeline_info.waitSemaphoreValueCount   = to_u32(wait_values.size());
+	timeline_info.pWaitSemaphoreValues      = wait_values.data();
+	timeline_info.signalSemaphoreValueCount = to_u32(signal_values.size());
+	timeline_info.pSignalSemaphoreValues    = signal_values.data();
+
+	if ((!same_queue && !acquires.empty()) || signal_timeline)
+	{
+		submit_info.pNext = &timeline_info;
+	}
+
+	VkFence fence = VK_NULL_HANDLE;
+	if (timeline_pacing)
+	{
+		frame.add_timeline_signal(timelines[static_cast<size_t>(queue_type)].semaphore, timelines[static_cast<size_t>(queue_type)].value);
+	}
+	else
+	{
+		fence = frame.request_fence();
+	}
+
+	submit_queue.submit({submit_info}, fence);
+}
+
+void RenderContext::submit_releases(QueueType src_queue)
+{
+	if (&queue == async_compute_queue)
+	{
+		// Work on a single queue is ordered already
+		for (auto &transfer : ownership_transfers)
+		{
+			transfer.released = true;
+		}
+		return;
+	}
+
+	submit(src_queue, get_queue(src_queue), {}, VK_NULL_HANDLE, 0, VK_NULL_HANDLE, true);
+}
+
+void RenderContext::record_ownership_barriers(CommandBuffer &command_buffer, const std::vector<OwnershipTransfer> &transfers, bool release) const
+{
+	for (auto &transfer : transfers)
+	{
+		const QueueType dst_queue = transfer.src_queue == QueueType::Graphics ? QueueType::AsyncCompute : QueueType::Graphics;
+
+		ImageMemoryBarrier barrier = transfer.memory_barrier;
+
+		if (get_queue(transfer.src_queue).get_family_index() != get_queue(dst_queue).get_family_index())
+		{
+			barrier.old_queue_family = get_queue(transfer.src_queue).get_family_index();
+			barrier.new_queue_family = get_queue(dst_queue).get_family_index();
+		}
+
+		if (release)
+		{
+			// The destination half of a release is ignored
+			barrier.dst_stage_mask  = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+			barrier.dst_access_mask = 0;
+		}
+		else if (&get_queue(transfer.src_queue) != &get_queue(dst_queue))
+		{
+			// The semaphore wait already made the writes of the other queue available, chain with it
+			barrier.src_stage_mask  = barrier.dst_stage_mask;
+			barrier.src_access_mask = 0;
+		}
+
+		if (transfer.buffer)
+		{
+			BufferMemoryBarrier buffer_barrier{};
+			buffer_barrier.src_stage_mask   = barrier.src_stage_mask;
+			buffer_barrier.dst_stage_mask   = barrier.dst_stage_mask;
+			buffer_barrier.src_access_mask  = barrier.src_access_mask;
+			buffer_barrier.dst_access_mask  = barrier.dst_access_mask;
+			buffer_barrier.old_queue_family = barrier.old_queue_family;
+			buffer_barrier.new_queue_family = barrier.new_queue_family;
+
+			command_buffer.buffer_memory_barrier(*transfer.buffer, 0, VK_WHOLE_SIZE, buffer_barrier);
+		}
+		else
+		{
+			command_buffer.image_memory_barrier(*transfer.image_view, barrier);
+		}
+	}
+}
+
 bool RenderContext::has_swapchain()
 {
 	return swapchain != nullptr;
@@ -557,6 +940,11 @@ uint32_t RenderContext::get_active_frame_index() const
 	return active_frame_index;
 }
 
+size_t RenderContext::get_thread_count() const
+{
+	return thread_count;
+}
+
 std::vector<std::unique_ptr<RenderFrame>> &RenderContext::get_render_frames()
 {
 	return frames;
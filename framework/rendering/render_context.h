@@ -17,6 +17,8 @@
 
 #pragma once
 
+#include <deque>
+
 #include "common/helpers.h"
 #include "common/vk_common.h"
 #include "core/command_buffer.h"
@@ -60,6 +62,28 @@ class RenderContext
 	// The format to use for the RenderTargets if a swapchain isn't created
 	static VkFormat DEFAULT_VK_FORMAT;
 
+	/**
+	 * @brief Queues the render context submits the work of a frame to
+	 */
+	enum class QueueType
+	{
+		Graphics,
+		AsyncCompute
+	};
+
+	/**
+	 * @brief How the CPU waits for the GPU to complete a frame before reusing its resources
+	 */
+	enum class FrameSynchronization
+	{
+		// A fence per submission, waited on and reset when the frame is reused
+		Fences,
+
+		// Each submission signals the next value of the timeline semaphore of its queue,
+		// the frame waits for the last values it signaled and needs no reset
+		TimelineSemaphores
+	};
+
 	/**
 	 * @brief Constructor
 	 * @param device A valid device
@@ -72,7 +96,7 @@ class RenderContext
 
 	RenderContext(RenderContext &&) = delete;
 
-	virtual ~RenderContext() = default;
+	virtual ~RenderContext();
 
 	RenderContext &operator=(const RenderContext &) = delete;
 
@@ -98,6 +122,20 @@ class RenderContext
 	 */
 	void set_surface_format_priority(const std::vector<VkSurfaceFormatKHR> &surface_format_priority_list);
 
+	/**
+	 * @brief Sets how many frames the CPU may record while the GPU executes the previous ones.
+	 *        Without a swapchain, prepare() creates a render frame for each of them, while with a swapchain
+	 *        they are limited to the number of swapchain images. Lowering the count after prepare() makes
+	 *        begin_frame() wait for older frames, the render frames are kept.
+	 * @param count Number of frames in flight, zero for a render frame per swapchain image, or a single one without swapchain
+	 */
+	void set_frames_in_flight(uint32_t count);
+
+	/**
+	 * @return The number of frames the CPU may record ahead of the GPU
+	 */
+	uint32_t get_frames_in_flight() const;
+
 	/**
 	 * @brief Prepares the RenderFrames for rendering
 	 * @param thread_count The number of threads in the application, necessary to allocate this many resource pools for each RenderFrame
@@ -222,6 +260,11 @@ class RenderContext
 
 	uint32_t get_active_frame_index() const;
 
+	/**
+	 * @brief Returns the number of threads the render frames allocate resource pools for
+	 */
+	size_t get_thread_count() const;
+
 	std::vector<std::unique_ptr<RenderFrame>> &get_render_frames();
 
 	/**
@@ -235,6 +278,68 @@ class RenderContext
 	 */
 	VkSemaphore consume_acquired_semaphore();
 
+	/**
+	 * @brief Selects how frames are synchronized with the CPU, taking effect from the next submission.
+	 *        Timeline semaphores require VK_KHR_timeline_semaphore, otherwise fences are kept.
+	 */
+	void set_frame_synchronization(FrameSynchronization synchronization);
+
+	FrameSynchronization get_frame_synchronization() const;
+
+	/**
+	 * @brief Blocks until the GPU completed a frame submitted before the active one.
+	 *        With timeline semaphores the wait is exact, with fences it waits for the last use of the render
+	 *        frame of that frame, which may be more recent.
+	 * @param frames_ago Number of frames submitted since, zero for the last submitted frame. Frames older than
+	 *        the render frame count are not tracked, and not waited for.
+	 */
+	void wait_for_frame(uint32_t frames_ago);
+
+	/**
+	 * @return Whether async compute work runs on a queue of its own, rather than on the graphics queue.
+	 *         This requires timeline semaphores, and either a compute queue family other than the graphics
+	 *         one or a second queue in the graphics family.
+	 */
+	bool has_async_compute_queue() const;
+
+	/**
+	 * @return The queue async compute work is submitted to, the graphics queue if there is no other
+	 */
+	const Queue &get_async_compute_queue() const;
+
+	/**
+	 * @brief Requests a command buffer of the active frame for the async compute queue
+	 *        A frame should be active, begin() is expected to be called first
+	 * @param reset_mode How to reset the command buffer
+	 */
+	CommandBuffer &begin_async_compute(CommandBuffer::ResetMode reset_mode = CommandBuffer::ResetMode::ResetPool);
+
+	/**
+	 * @brief Submits work on the async compute queue, so that it overlaps with the graphics work.
+	 *        It should be submitted before the graphics work of the frame reading its results.
+	 * @param command_buffers Command buffers recorded for the async compute queue
+	 */
+	void submit_async_compute(const std::vector<CommandBuffer *> &command_buffers);
+
+	/**
+	 * @brief Transfers a buffer from the work submitted next on one queue to the work submitted next on the other.
+	 *
+	 *        If the queues belong to different families, a release barrier is recorded after the work of the source
+	 *        queue and an acquire barrier before the work of the destination queue, otherwise a single barrier is.
+	 *        If the queues differ, the destination queue waits for the source one on a timeline semaphore.
+	 *        Buffers whose contents are fully overwritten by the other queue need no transfer.
+	 * @param buffer Buffer to transfer
+	 * @param src_queue Queue last accessing the buffer
+	 * @param memory_barrier Stages and accesses of the buffer on the source queue, and on the destination queue
+	 */
+	void transfer_ownership(const core::Buffer &buffer, QueueType src_queue, const BufferMemoryBarrier &memory_barrier);
+
+	/**
+	 * @brief Transfers an image from the work submitted next on one queue to the work submitted next on the other,
+	 *        transitioning it from the old to the new layout of the memory barrier
+	 */
+	void transfer_ownership(const core::ImageView &image_view, QueueType src_queue, const ImageMemoryBarrier &memory_barrier);
+
   protected:
 	VkExtent2D surface_extent;
 
@@ -277,6 +382,84 @@ class RenderContext
 	VkSurfaceTransformFlagBitsKHR pre_transform{VK_SURFACE_TRANSFORM_IDENTITY_BIT_KHR};
 
 	size_t thread_count{1};
+
+	/**
+	 * @brief A timeline semaphore signaled by the submissions of a queue releasing resources
+	 */
+	struct QueueTimeline
+	{
+		VkSemaphore semaphore{VK_NULL_HANDLE};
+
+		uint64_t value{0};
+	};
+
+	/**
+	 * @brief A resource waiting to be released by its source queue, or acquired by the other queue
+	 */
+	struct OwnershipTransfer
+	{
+		const core::Buffer *buffer{nullptr};
+
+		const core::ImageView *image_view{nullptr};
+
+		QueueType src_queue{QueueType::Graphics};
+
+		// Stages and accesses on both queues, the layouts only apply to images
+		ImageMemoryBarrier memory_barrier;
+
+		bool released{false};
+
+		// Value of the source queue timeline signaled once released
+		uint64_t release_value{0};
+	};
+
+	void select_async_compute_queue();
+
+	const Queue &get_queue(QueueType queue_type) const;
+
+	/**
+	 * @brief Submits command buffers, with the acquire and release barriers of the pending ownership transfers
+	 *        if the queue is the one of the queue type
+	 * @param releases_only If true, only the release barriers are submitted, and the transfers from the other queue
+	 *        are neither released nor acquired
+	 */
+	void submit(QueueType queue_type, const Queue &submit_queue, const std::vector<CommandBuffer *> &command_buffers,
+	            VkSemaphore wait_semaphore, VkPipelineStageFlags wait_pipeline_stage, VkSemaphore signal_semaphore,
+	            bool releases_only = false);
+
+	/**
+	 * @brief Submits the release barriers of the resources transferred from a queue on their own
+	 */
+	void submit_releases(QueueType src_queue);
+
+	void record_ownership_barriers(CommandBuffer &command_buffer, const std::vector<OwnershipTransfer> &transfers, bool release) const;
+
+	/// Queue of the async compute work, the graphics queue if there is no other
+	const Queue *async_compute_queue{nullptr};
+
+	/// Timelines of the graphics and async compute queues, created if timeline semaphores are enabled
+	std::array<QueueTimeline, 2> timelines;
+
+	FrameSynchronization frame_synchronization{FrameSynchronization::Fences};
+
+	/**
+	 * @brief A frame submitted by the render context
+	 */
+	struct SubmittedFrame
+	{
+		uint32_t frame_index{0};
+
+		// Values of the timelines once the frame completes, with timeline semaphore frame synchronization
+		std::array<uint64_t, 2> timeline_values{};
+	};
+
+	/// The last submitted frames, the most recent last
+	std::deque<SubmittedFrame> submitted_frames;
+
+	/// Frames the CPU may record ahead of the GPU, zero for one per render frame
+	uint32_t frames_in_flight{0};
+
+	std::vector<OwnershipTransfer> ownership_transfers;
 };
 
 }        // namespace vkb
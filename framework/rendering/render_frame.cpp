@@ -17,11 +17,26 @@
 
 #include "render_frame.h"
 
+#include <algorithm>
+#include <array>
+#include <limits>
+
 #include "common/logging.h"
 #include "common/utils.h"
+#include "timer.h"
 
 namespace vkb
 {
+namespace
+{
+// Usages of the buffer pools of a thread, in the order they are stored
+const std::array<VkBufferUsageFlags, 4> buffer_pool_usages = {
+    VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+    VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+    VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+    VK_BUFFER_USAGE_INDEX_BUFFER_BIT};
+}        // namespace
+
 RenderFrame::RenderFrame(Device &device, std::unique_ptr<RenderTarget> &&render_target, size_t thread_count) :
     device{device},
     fence_pool{device},
@@ -29,24 +44,15 @@ RenderFrame::RenderFrame(Device &device, std::unique_ptr<RenderTarget> &&render_
     swapchain_render_target{std::move(render_target)},
     thread_count{thread_count}
 {
-	for (auto &usage_it : supported_usage_map)
+	for (size_t i = 0; i < thread_count; ++i)
 	{
-		std::vector<std::pair<BufferPool, BufferBlock *>> usage_buffer_pools;
-		for (size_t i = 0; i < thread_count; ++i)
+		std::vector<ThreadBufferPool> thread_buffer_pools;
+		for (auto usage : buffer_pool_usages)
 		{
-			usage_buffer_pools.push_back(std::make_pair(BufferPool{device, BUFFER_POOL_BLOCK_SIZE * 1024 * usage_it.second, usage_it.first}, nullptr));
+			thread_buffer_pools.push_back({BufferPool{device, BUFFER_POOL_BLOCK_SIZE * 1024 * supported_usage_map.at(usage), usage}});
 		}
+		buffer_pools.push_back(std::move(thread_buffer_pools));
 
-		auto res_ins_it = buffer_pools.emplace(usage_it.first, std::move(usage_buffer_pools));
-
-		if (!res_ins_it.second)
-		{
-			throw std::runtime_error("Failed to insert buffer pool");
-		}
-	}
-
-	for (size_t i = 0; i < thread_count; ++i)
-	{
 		descriptor_pools.push_back(std::make_unique<std::unordered_map<std::size_t, DescriptorPool>>());
 		descriptor_sets.push_back(std::make_unique<std::unordered_map<std::size_t, DescriptorSet>>());
 	}
@@ -64,10 +70,12 @@ void RenderFrame::update_render_target(std::unique_ptr<RenderTarget> &&render_ta
 
 void RenderFrame::reset()
 {
-	VK_CHECK(fence_pool.wait());
+	wait();
 
 	fence_pool.reset();
 
+	timeline_signals.clear();
+
 	for (auto &command_pools_per_queue : command_pools)
 	{
 		for (auto &command_pool : command_pools_per_queue.second)
@@ -76,23 +84,67 @@ void RenderFrame::reset()
 		}
 	}
 
-	for (auto &buffer_pools_per_usage : buffer_pools)
+	bool buffer_blocks_released = false;
+
+	for (auto &thread_buffer_pools : buffer_pools)
 	{
-		for (auto &buffer_pool : buffer_pools_per_usage.second)
+		for (auto &buffer_pool : thread_buffer_pools)
 		{
-			buffer_pool.first.reset();
-			buffer_pool.second = nullptr;
+			buffer_blocks_released |= buffer_pool.pool.reset();
+			buffer_pool.block            = nullptr;
+			buffer_pool.allocation_count = 0;
+			buffer_pool.allocation_time  = 0.0;
 		}
 	}
 
 	semaphore_pool.reset();
 
-	if (descriptor_management_strategy == vkb::DescriptorManagementStrategy::CreateDirectly)
+	// Cached descriptor sets may still reference the buffers of the released blocks
+	if (descriptor_management_strategy == vkb::DescriptorManagementStrategy::CreateDirectly || buffer_blocks_released)
 	{
 		clear_descriptors();
 	}
 }
 
+void RenderFrame::wait() const
+{
+	VK_CHECK(fence_pool.wait());
+
+	if (timeline_signals.empty())
+	{
+		return;
+	}
+
+	std::vector<VkSemaphore> semaphores;
+	std::vector<uint64_t>    values;
+	for (auto &signal : timeline_signals)
+	{
+		semaphores.push_back(signal.first);
+		values.push_back(signal.second);
+	}
+
+	VkSemaphoreWaitInfoKHR wait_info{VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO_KHR};
+	wait_info.semaphoreCount = to_u32(semaphores.size());
+	wait_info.pSemaphores    = semaphores.data();
+	wait_info.pValues        = values.data();
+
+	VK_CHECK(vkWaitSemaphoresKHR(device.get_handle(), &wait_info, std::numeric_limits<uint64_t>::max()));
+}
+
+void RenderFrame::add_timeline_signal(VkSemaphore semaphore, uint64_t value)
+{
+	auto it = std::find_if(timeline_signals.begin(), timeline_signals.end(), [semaphore](const std::pair<VkSemaphore, uint64_t> &signal) { return signal.first == semaphore; });
+
+	if (it != timeline_signals.end())
+	{
+		it->second = std::max(it->second, value);
+	}
+	else
+	{
+		timeline_signals.emplace_back(semaphore, value);
+	}
+}
+
 std::vector<std::unique_ptr<CommandPool>> &RenderFrame::get_command_pools(const Queue &queue, CommandBuffer::ResetMode reset_mode)
 {
 	auto command_pool_it = command_pools.find(queue.get_family_index());
@@ -266,6 +318,11 @@ void RenderFrame::set_buffer_allocation_strategy(BufferAllocationStrategy new_st
 	buffer_allocation_strategy = new_strategy;
 }
 
+void RenderFrame::set_buffer_allocation_timing(bool enable)
+{
+	buffer_allocation_timing = enable;
+}
+
 void RenderFrame::set_descriptor_management_strategy(DescriptorManagementStrategy new_strategy)
 {
 	descriptor_management_strategy = new_strategy;
@@ -275,25 +332,30 @@ BufferAllocation RenderFrame::allocate_buffer(const VkBufferUsageFlags usage, co
 {
 	assert(thread_index < thread_count && "Thread index is out of bounds");
 
-	uint32_t block_multiplier = supported_usage_map.at(usage);
+	// Find the pool of this thread for this usage
+	auto usage_it = std::find(buffer_pool_usages.begin(), buffer_pool_usages.end(), usage);
+	if (usage_it == buffer_pool_usages.end())
+	{
+		LOGE("No buffer pool for buffer usage {}", usage);
+		return BufferAllocation{};
+	}
+
+	auto &thread_buffer_pool = buffer_pools[thread_index][usage_it - buffer_pool_usages.begin()];
+	auto &buffer_pool        = thread_buffer_pool.pool;
+	auto &buffer_block       = thread_buffer_pool.block;
 
-	if (size > BUFFER_POOL_BLOCK_SIZE * 1024 * block_multiplier)
+	Timer timer;
+	if (buffer_allocation_timing)
 	{
-		LOGE("Trying to allocate {} buffer of size {}KB which is larger than the buffer pool block size ({} KB)!", buffer_usage_to_string(usage), size / 1024, BUFFER_POOL_BLOCK_SIZE * block_multiplier);
-		throw std::runtime_error("Couldn't allocate render frame buffer.");
+		timer.start();
 	}
 
-	// Find a pool for this usage
-	auto buffer_pool_it = buffer_pools.find(usage);
-	if (buffer_pool_it == buffer_pools.end())
+	if (size > buffer_pool.get_block_size())
 	{
-		LOGE("No buffer pool for buffer usage {}", usage);
-		return BufferAllocation{};
+		LOGW("Allocating {} buffer of size {} KB which is larger than the buffer pool block size ({} KB)", buffer_usage_to_string(usage), size / 1024, buffer_pool.get_block_size() / 1024);
 	}
 
-	assert(thread_index < buffer_pool_it->second.size());
-	auto &buffer_pool  = buffer_pool_it->second[thread_index].first;
-	auto &buffer_block = buffer_pool_it->second[thread_index].second;
+	thread_buffer_pool.allocation_count++;
 
 	bool want_minimal_block = buffer_allocation_strategy == BufferAllocationStrategy::OneAllocationPerBuffer;
 
@@ -314,6 +376,29 @@ BufferAllocation RenderFrame::allocate_buffer(const VkBufferUsageFlags usage, co
 		data = buffer_block->allocate(to_u32(size));
 	}
 
+	if (buffer_allocation_timing)
+	{
+		thread_buffer_pool.allocation_time += timer.stop<Timer::Milliseconds>();
+	}
+
 	return data;
 }
+
+RenderFrame::BufferPoolStats RenderFrame::get_buffer_pool_stats() const
+{
+	BufferPoolStats stats;
+
+	for (auto &thread_buffer_pools : buffer_pools)
+	{
+		for (auto &buffer_pool : thread_buffer_pools)
+		{
+			stats.allocation_count += buffer_pool.allocation_count;
+			stats.used_size += buffer_pool.pool.get_used_size();
+			stats.block_count += buffer_pool.pool.get_active_block_count();
+			stats.allocation_time += buffer_pool.allocation_time;
+		}
+	}
+
+	return stats;
+}
 }        // namespace vkb
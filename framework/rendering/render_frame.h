@@ -74,6 +74,21 @@ class RenderFrame
 	    {VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, 1},
 	    {VK_BUFFER_USAGE_INDEX_BUFFER_BIT, 1}};
 
+	/**
+	 * @brief Usage of the buffer pools since the frame was last reset
+	 */
+	struct BufferPoolStats
+	{
+		uint32_t allocation_count{0};
+
+		VkDeviceSize used_size{0};
+
+		uint32_t block_count{0};
+
+		// Time spent in allocate_buffer summed over the threads, in milliseconds, zero unless timed
+		double allocation_time{0.0};
+	};
+
 	RenderFrame(Device &device, std::unique_ptr<RenderTarget> &&render_target, size_t thread_count = 1);
 
 	RenderFrame(const RenderFrame &) = delete;
@@ -84,14 +99,28 @@ class RenderFrame
 
 	RenderFrame &operator=(RenderFrame &&) = delete;
 
+	/**
+	 * @brief Waits for the work submitted with the frame, then resets its resources
+	 */
 	void reset();
 
+	/**
+	 * @brief Waits for the fences and timeline values of the work submitted with the frame
+	 */
+	void wait() const;
+
 	Device &get_device();
 
 	const FencePool &get_fence_pool() const;
 
 	VkFence request_fence();
 
+	/**
+	 * @brief Records a timeline semaphore value signaled by work submitted with the frame,
+	 *        which is waited on in place of a fence before the frame is reset
+	 */
+	void add_timeline_signal(VkSemaphore semaphore, uint64_t value);
+
 	const SemaphorePool &get_semaphore_pool() const;
 
 	VkSemaphore request_semaphore();
@@ -137,6 +166,11 @@ class RenderFrame
 	 */
 	void set_buffer_allocation_strategy(BufferAllocationStrategy new_strategy);
 
+	/**
+	 * @brief Measures the time spent in allocate_buffer, reported by get_buffer_pool_stats
+	 */
+	void set_buffer_allocation_timing(bool enable);
+
 	/**
 	 * @brief Sets a new descriptor set management strategy
 	 * @param new_strategy The new descriptor set management strategy
@@ -151,6 +185,11 @@ class RenderFrame
 	 */
 	BufferAllocation allocate_buffer(VkBufferUsageFlags usage, VkDeviceSize size, size_t thread_index = 0);
 
+	/**
+	 * @return The usage of the buffer pools of all the threads, it should not be called while threads allocate
+	 */
+	BufferPoolStats get_buffer_pool_stats() const;
+
 	/**
 	 * @brief Updates all the descriptor sets in the current frame at a specific thread index
 	 */
@@ -181,6 +220,9 @@ class RenderFrame
 
 	SemaphorePool semaphore_pool;
 
+	/// Highest value signaled on each timeline semaphore by the work of the frame
+	std::vector<std::pair<VkSemaphore, uint64_t>> timeline_signals;
+
 	size_t thread_count;
 
 	std::unique_ptr<RenderTarget> swapchain_render_target;
@@ -188,7 +230,24 @@ class RenderFrame
 	BufferAllocationStrategy     buffer_allocation_strategy{BufferAllocationStrategy::MultipleAllocationsPerBuffer};
 	DescriptorManagementStrategy descriptor_management_strategy{DescriptorManagementStrategy::StoreInCache};
 
-	std::map<VkBufferUsageFlags, std::vector<std::pair<BufferPool, BufferBlock *>>> buffer_pools;
+	bool buffer_allocation_timing{false};
+
+	/**
+	 * @brief A buffer pool used by a single thread, and the block it currently allocates from
+	 */
+	struct ThreadBufferPool
+	{
+		BufferPool pool;
+
+		BufferBlock *block{nullptr};
+
+		uint32_t allocation_count{0};
+
+		double allocation_time{0.0};
+	};
+
+	/// Buffer pools of each thread, one per supported usage
+	std::vector<std::vector<ThreadBufferPool>> buffer_pools;
 
 	static std::vector<uint32_t> collect_bindings_to_update(const DescriptorSetLayout &descriptor_set_layout, const BindingMap<VkDescriptorBufferInfo> &buffer_infos, const BindingMap<VkDescriptorImageInfo> &image_infos);
 };
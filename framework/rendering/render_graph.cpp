@@ -0,0 +1,807 @@
+/* Copyright (c) 2023, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "rendering/render_graph.h"
+
+#include <algorithm>
+
+#include "common/error.h"
+#include "common/logging.h"
+#include "common/utils.h"
+#include "core/command_buffer.h"
+#include "core/debug.h"
+#include "core/device.h"
+#include "rendering/render_context.h"
+#include "rendering/render_pipeline.h"
+
+namespace vkb
+{
+namespace
+{
+/**
+ * @brief Layout, synchronization scope and usage an image needs for an access
+ */
+struct AccessInfo
+{
+	VkImageLayout layout{VK_IMAGE_LAYOUT_UNDEFINED};
+
+	VkPipelineStageFlags stage{0};
+
+	VkAccessFlags access{0};
+
+	VkImageUsageFlags usage{0};
+
+	bool write{false};
+
+	bool attachment{false};
+};
+
+AccessInfo get_access_info(RenderGraph::Access access, VkFormat format, bool compute)
+{
+	const bool depth = is_depth_stencil_format(format);
+
+	// Shader accesses of raster passes are made by the fragment shaders
+	const VkPipelineStageFlags shader_stage = compute ? VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT : VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+
+	AccessInfo info{};
+
+	switch (access)
+	{
+		case RenderGraph::Access::ColorAttachment:
+			info.layout     = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+			info.stage      = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+			info.access     = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+			info.usage      = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+			info.write      = true;
+			info.attachment = true;
+			break;
+		case RenderGraph::Access::DepthStencilAttachment:
+			info.layout     = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+			info.stage      = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+			info.access     = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+			info.usage      = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+			info.write      = true;
+			info.attachment = true;
+			break;
+		case RenderGraph::Access::InputAttachment:
+			info.layout     = depth ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+			info.stage      = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+			info.access     = VK_ACCESS_INPUT_ATTACHMENT_READ_BIT;
+			info.usage      = VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT;
+			info.attachment = true;
+			break;
+		case RenderGraph::Access::Sampled:
+			info.layout = depth ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+			info.stage  = shader_stage;
+			info.access = VK_ACCESS_SHADER_READ_BIT;
+			info.usage  = VK_IMAGE_USAGE_SAMPLED_BIT;
+			break;
+		case RenderGraph::Access::StorageRead:
+			info.layout = VK_IMAGE_LAYOUT_GENERAL;
+			info.stage  = shader_stage;
+			info.access = VK_ACCESS_SHADER_READ_BIT;
+			info.usage  = VK_IMAGE_USAGE_STORAGE_BIT;
+			break;
+		case RenderGraph::Access::StorageWrite:
+			info.layout = VK_IMAGE_LAYOUT_GENERAL;
+			info.stage  = shader_stage;
+			info.access = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+			info.usage  = VK_IMAGE_USAGE_STORAGE_BIT;
+			info.write  = true;
+			break;
+	}
+
+	return info;
+}
+
+constexpr VkAccessFlags write_access_mask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+}        // namespace
+
+RenderGraph::Pass::Pass(RenderGraph &graph, const std::string &name, bool compute) :
+    graph{graph},
+    name{name},
+    compute{compute}
+{
+}
+
+uint32_t RenderGraph::Pass::write_color(const std::string &image)
+{
+	return add_access(image, Access::ColorAttachment);
+}
+
+uint32_t RenderGraph::Pass::write_depth(const std::string &image)
+{
+	return add_access(image, Access::DepthStencilAttachment);
+}
+
+uint32_t RenderGraph::Pass::read_input(const std::string &image)
+{
+	return add_access(image, Access::InputAttachment);
+}
+
+void RenderGraph::Pass::read_sampled(const std::string &image)
+{
+	add_access(image, Access::Sampled);
+}
+
+void RenderGraph::Pass::read_storage(const std::string &image)
+{
+	add_access(image, Access::StorageRead);
+}
+
+void RenderGraph::Pass::write_storage(const std::string &image)
+{
+	add_access(image, Access::StorageWrite);
+}
+
+void RenderGraph::Pass::set_execute(ExecuteFunc &&execute_)
+{
+	execute = std::move(execute_);
+}
+
+const std::string &RenderGraph::Pass::get_name() const
+{
+	return name;
+}
+
+bool RenderGraph::Pass::is_compute() const
+{
+	return compute;
+}
+
+bool RenderGraph::Pass::is_culled() const
+{
+	return culled;
+}
+
+const std::vector<LoadStoreInfo> &RenderGraph::Pass::get_load_store() const
+{
+	return load_store;
+}
+
+const std::vector<VkClearValue> &RenderGraph::Pass::get_clear_value() const
+{
+	return clear_value;
+}
+
+uint32_t RenderGraph::Pass::add_access(const std::string &image, Access access)
+{
+	uint32_t image_index = graph.get_image_index(image);
+
+	assert(std::none_of(accesses.begin(), accesses.end(), [image_index](const ImageAccess &image_access) { return image_access.image == image_index; }) &&
+	       "A pass can only access an image once");
+
+	const bool attachment = access == Access::ColorAttachment || access == Access::DepthStencilAttachment || access == Access::InputAttachment;
+
+	assert((!attachment || !compute) && "Compute passes have no attachments");
+
+	accesses.push_back({image_index, access, attachment ? attachment_count++ : ~0U});
+
+	graph.dirty = true;
+
+	return accesses.back().attachment;
+}
+
+RenderGraph::RenderGraph(RenderContext &render_context) :
+    render_context{render_context}
+{
+}
+
+RenderGraph::~RenderGraph()
+{
+	release();
+}
+
+void RenderGraph::add_image(const std::string &name, VkFormat format, float scale)
+{
+	assert(image_indices.find(name) == image_indices.end() && "Image already declared");
+
+	ImageResource image{};
+	image.name   = name;
+	image.format = format;
+	image.scale  = scale;
+
+	image_indices[name] = to_u32(images.size());
+	images.push_back(image);
+
+	dirty = true;
+}
+
+void RenderGraph::set_backbuffer(const std::string &name)
+{
+	assert(backbuffer == ~0U && "Backbuffer already declared");
+
+	// The format is that of the swapchain, known once compiled
+	add_image(name, VK_FORMAT_UNDEFINED);
+
+	backbuffer = image_indices[name];
+
+	images[backbuffer].backbuffer = true;
+}
+
+RenderGraph::Pass &RenderGraph::add_pass(const std::string &name)
+{
+	passes.push_back(std::make_unique<Pass>(*this, name, false));
+
+	dirty = true;
+
+	return *passes.back();
+}
+
+RenderGraph::Pass &RenderGraph::add_pass(const std::string &name, RenderPipeline &render_pipeline)
+{
+	auto &pass = add_pass(name);
+
+	pass.set_execute([&pass, &render_pipeline](CommandBuffer &command_buffer, RenderTarget *render_target) {
+		render_pipeline.set_load_store(pass.get_load_store());
+		render_pipeline.set_clear_value(pass.get_clear_value());
+		render_pipeline.draw(command_buffer, *render_target);
+	});
+
+	return pass;
+}
+
+RenderGraph::Pass &RenderGraph::add_compute_pass(const std::string &name)
+{
+	passes.push_back(std::make_unique<Pass>(*this, name, true));
+
+	dirty = true;
+
+	return *passes.back();
+}
+
+void RenderGraph::set_aliasing(bool aliasing_)
+{
+	if (aliasing != aliasing_)
+	{
+		aliasing = aliasing_;
+		dirty    = true;
+	}
+}
+
+void RenderGraph::set_barrier_merging(bool barrier_merging_)
+{
+	if (barrier_merging != barrier_merging_)
+	{
+		barrier_merging = barrier_merging_;
+		dirty           = true;
+	}
+}
+
+void RenderGraph::execute(CommandBuffer &command_buffer, const std::function<void(CommandBuffer &)> &draw_overlay)
+{
+	assert(backbuffer != ~0U && "The backbuffer of the render graph is not set");
+
+	if (!is_compiled())
+	{
+		compile();
+	}
+
+	auto &frame = frame_resources[render_context.get_active_frame_index()];
+
+	// The overlay is drawn by the last render pass
+	size_t last_raster_pass = active_passes.size();
+	for (size_t i = 0; i < active_passes.size(); ++i)
+	{
+		if (!active_passes[i]->compute)
+		{
+			last_raster_pass = i;
+		}
+	}
+
+	for (size_t i = 0; i < active_passes.size(); ++i)
+	{
+		auto &pass = *active_passes[i];
+
+		ScopedDebugLabel pass_debug_label{command_buffer, pass.name.c_str()};
+
+		record_barriers(command_buffer, pass.barriers, frame);
+
+		if (pass.compute)
+		{
+			pass.execute(command_buffer, nullptr);
+			continue;
+		}
+
+		auto &render_target = *frame.render_targets[i];
+		auto &target_extent = render_target.get_extent();
+
+		VkViewport viewport{};
+		viewport.width    = static_cast<float>(target_extent.width);
+		viewport.height   = static_cast<float>(target_extent.height);
+		viewport.minDepth = 0.0f;
+		viewport.maxDepth = 1.0f;
+		command_buffer.set_viewport(0, {viewport});
+
+		VkRect2D scissor{};
+		scissor.extent = target_extent;
+		command_buffer.set_scissor(0, {scissor});
+
+		pass.execute(command_buffer, &render_target);
+
+		if (i == last_raster_pass && draw_overlay)
+		{
+			draw_overlay(command_buffer);
+		}
+
+		command_buffer.end_render_pass();
+	}
+
+	record_barriers(command_buffer, present_barriers, frame);
+}
+
+const core::ImageView &RenderGraph::get_view(const std::string &name) const
+{
+	auto &views = frame_resources.at(render_context.get_active_frame_index()).views;
+
+	uint32_t image_index = get_image_index(name);
+	assert(views[image_index] && "Image is not used by any pass");
+
+	return *views[image_index];
+}
+
+const RenderGraph::Stats &RenderGraph::get_stats() const
+{
+	return stats;
+}
+
+uint32_t RenderGraph::get_image_index(const std::string &name) const
+{
+	auto it = image_indices.find(name);
+	if (it == image_indices.end())
+	{
+		throw std::runtime_error("Image " + name + " is not declared in the render graph");
+	}
+
+	return it->second;
+}
+
+bool RenderGraph::is_compiled() const
+{
+	auto &surface_extent = render_context.get_surface_extent();
+	auto &render_frames  = render_context.get_render_frames();
+
+	if (dirty || surface_extent.width != extent.width || surface_extent.height != extent.height || render_frames.size() != backbuffer_handles.size())
+	{
+		return false;
+	}
+
+	// The swapchain images change when the swapchain is recreated
+	for (size_t i = 0; i < render_frames.size(); ++i)
+	{
+		if (render_frames[i]->get_render_target().get_views()[0].get_image().get_handle() != backbuffer_handles[i])
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void RenderGraph::compile()
+{
+	release();
+
+	extent = render_context.get_surface_extent();
+
+	cull_passes();
+
+	// Raster passes need a render target, passes only sampling images belong to compute passes
+	for (auto pass : active_passes)
+	{
+		if (!pass->compute && pass->attachment_count == 0)
+		{
+			throw std::runtime_error("Pass " + pass->name + " has no attachment, it must be added with add_compute_pass");
+		}
+	}
+
+	create_images();
+
+	plan_barriers();
+
+	for (auto &frame : frame_resources)
+	{
+		create_render_targets(frame);
+	}
+
+	dirty = false;
+
+	LOGI("Render graph compiled: {} passes, {} culled, {} image barriers in {} pipeline barriers, {:.1f} MB of transient images in {:.1f} MB of memory and {:.1f} MB of lazily allocated memory per frame",
+	     stats.pass_count, stats.culled_pass_count, stats.image_barrier_count, stats.pipeline_barrier_count,
+	     stats.image_memory / (1024.0 * 1024.0), stats.allocated_memory / (1024.0 * 1024.0), stats.lazy_memory / (1024.0 * 1024.0));
+}
+
+void RenderGraph::release()
+{
+	if (frame_resources.empty())
+	{
+		return;
+	}
+
+	auto &device = render_context.get_device();
+
+	// The previous frames may still use the images
+	device.wait_idle();
+
+	// Framebuffers are cached by image view handle, which may be reused
+	device.get_resource_cache().clear_framebuffers();
+
+	for (auto &frame : frame_resources)
+	{
+		frame.render_targets.clear();
+		frame.views.clear();
+		frame.images.clear();
+		frame.allocator.reset();
+	}
+
+	frame_resources.clear();
+	backbuffer_handles.clear();
+}
+
+void RenderGraph::cull_passes()
+{
+	// Walk the passes backwards from the backbuffer, keeping those writing an image a kept pass accesses
+	std::vector<bool> used_images(images.size(), false);
+	used_images[backbuffer] = true;
+
+	for (auto it = passes.rbegin(); it != passes.rend(); ++it)
+	{
+		auto &pass = **it;
+
+		pass.culled = std::none_of(pass.accesses.begin(), pass.accesses.end(), [this, &used_images](const Pass::ImageAccess &access) {
+			return used_images[access.image] && get_access_info(access.access, images[access.image].format, false).write;
+		});
+
+		if (!pass.culled)
+		{
+			for (auto &access : pass.accesses)
+			{
+				used_images[access.image] = true;
+			}
+		}
+	}
+
+	active_passes.clear();
+
+	for (auto &image : images)
+	{
+		image.usage      = 0;
+		image.first_pass      = ~0U;
+		image.last_pass       = 0;
+		image.transient_index = ~0U;
+	}
+
+	for (auto &pass : passes)
+	{
+		if (pass->culled)
+		{
+			continue;
+		}
+
+		uint32_t pass_index = to_u32(active_passes.size());
+		active_passes.push_back(pass.get());
+
+		for (auto &access : pass->accesses)
+		{
+			auto &image = images[access.image];
+
+			image.usage |= get_access_info(access.access, image.format, pass->compute).usage;
+			image.first_pass = std::min(image.first_pass, pass_index);
+			image.last_pass  = std::max(image.last_pass, pass_index);
+		}
+	}
+
+	stats.pass_count        = to_u32(active_passes.size());
+	stats.culled_pass_count = to_u32(passes.size() - active_passes.size());
+}
+
+void RenderGraph::create_images()
+{
+	auto &device        = render_context.get_device();
+	auto &render_frames = render_context.get_render_frames();
+
+	frame_resources.resize(render_frames.size());
+
+	for (uint32_t frame_index = 0; frame_index < to_u32(render_frames.size()); ++frame_index)
+	{
+		auto &frame = frame_resources[frame_index];
+
+		frame.images.resize(images.size());
+		frame.views.resize(images.size());
+		frame.allocator = std::make_unique<TransientAttachmentAllocator>(device);
+
+		for (uint32_t i = 0; i < to_u32(images.size()); ++i)
+		{
+			auto &image = images[i];
+
+			if (image.backbuffer)
+			{
+				// Wrap the swapchain image of the frame, which the graph does not own
+				auto &swapchain_image = render_frames[frame_index]->get_render_target().get_views()[0].get_image();
+
+				image.format = swapchain_image.get_format();
+
+				frame.images[i] = std::make_unique<core::Image>(device, swapchain_image.get_handle(), swapchain_image.get_extent(), swapchain_image.get_format(),
+				                                                swapchain_image.get_usage(), swapchain_image.get_sample_count());
+
+				backbuffer_handles.push_back(swapchain_image.get_handle());
+				continue;
+			}
+
+			if (image.first_pass == ~0U)
+			{
+				continue;
+			}
+
+			// Images only accessed as attachments never need to leave the tile memory of tile-based GPUs
+			VkImageUsageFlags usage = image.usage;
+			if ((usage & ~(VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT)) == 0)
+			{
+				usage |= VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+			}
+
+			VkExtent3D image_extent{std::max(static_cast<uint32_t>(extent.width * image.scale), 1U),
+			                        std::max(static_cast<uint32_t>(extent.height * image.scale), 1U),
+			                        1};
+
+			// The images are needed from the first to the last pass accessing them
+			image.transient_index = frame.allocator->add_image(image_extent, image.format, usage, image.first_pass, image.last_pass);
+		}
+
+		frame.allocator->allocate(aliasing);
+
+		for (uint32_t i = 0; i < to_u32(images.size()); ++i)
+		{
+			if (!images[i].backbuffer && images[i].first_pass != ~0U)
+			{
+				frame.images[i] = std::make_unique<core::Image>(frame.allocator->get_image(images[i].transient_index));
+			}
+
+			if (frame.images[i])
+			{
+				frame.views[i] = std::make_unique<core::ImageView>(*frame.images[i], VK_IMAGE_VIEW_TYPE_2D);
+			}
+		}
+	}
+
+	// The images of every frame are placed the same way
+	auto &allocator_stats  = frame_resources.front().allocator->get_stats();
+	stats.image_memory     = allocator_stats.image_memory;
+	stats.allocated_memory = allocator_stats.allocated_memory;
+	stats.lazy_memory      = allocator_stats.lazy_memory;
+}
+
+void RenderGraph::plan_barriers()
+{
+	/**
+	 * @brief Accesses to an image since its last barrier
+	 */
+	struct ImageState
+	{
+		VkImageLayout layout{VK_IMAGE_LAYOUT_UNDEFINED};
+
+		// Stages and accesses of the last write, or of the last layout transition
+		VkPipelineStageFlags write_stage{0};
+
+		VkAccessFlags write_access{0};
+
+		// Stages which read the image since the last write
+		VkPipelineStageFlags read_stage{0};
+
+		// Stages the last write is visible to
+		VkPipelineStageFlags visible_stage{0};
+
+		bool accessed{false};
+	};
+
+	std::vector<ImageState> states(images.size());
+
+	// Wait for the acquisition of the swapchain image, signaled at the color attachment output stage
+	states[backbuffer].write_stage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+
+	stats.image_barrier_count    = 0;
+	stats.pipeline_barrier_count = 0;
+
+	for (uint32_t pass_index = 0; pass_index < to_u32(active_passes.size()); ++pass_index)
+	{
+		auto &pass = *active_passes[pass_index];
+
+		pass.barriers.clear();
+		pass.load_store.assign(pass.attachment_count, {});
+		pass.clear_value.assign(pass.attachment_count, {});
+
+		for (auto &access : pass.accesses)
+		{
+			auto &image = images[access.image];
+			auto &state = states[access.image];
+			auto  info  = get_access_info(access.access, image.format, pass.compute);
+
+			if (!state.accessed && aliasing && !image.backbuffer)
+			{
+				// Wait for the images which last used the memory, before overwriting it
+				for (uint32_t j = 0; j < to_u32(images.size()); ++j)
+				{
+					auto &previous = images[j];
+					if (states[j].accessed && !previous.backbuffer && previous.last_pass < image.first_pass &&
+					    frame_resources.front().allocator->is_aliased(image.transient_index, previous.transient_index))
+					{
+						state.write_stage |= states[j].write_stage | states[j].read_stage;
+						state.write_access |= states[j].write_access;
+					}
+				}
+			}
+
+			const bool layout_transition = state.layout != info.layout;
+
+			bool needs_barrier = layout_transition;
+			if (info.write)
+			{
+				// Write after write, or write after read
+				needs_barrier |= state.write_access != 0 || state.read_stage != 0;
+			}
+			else
+			{
+				// Read after write, unless the write was already made visible to the stage
+				needs_barrier |= state.write_access != 0 && (state.visible_stage & info.stage) != info.stage;
+			}
+
+			if (needs_barrier)
+			{
+				ImageMemoryBarrier barrier{};
+				barrier.old_layout      = state.layout;
+				barrier.new_layout      = info.layout;
+				barrier.src_stage_mask  = state.write_stage | (info.write || layout_transition ? state.read_stage : 0);
+				barrier.src_access_mask = state.write_access;
+				barrier.dst_stage_mask  = info.stage;
+				barrier.dst_access_mask = info.access;
+
+				if (barrier.src_stage_mask == 0)
+				{
+					barrier.src_stage_mask = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+				}
+
+				pass.barriers.push_back({access.image, barrier});
+			}
+
+			if (info.attachment)
+			{
+				// Attachments written for the first time are cleared, the others keep the contents of the earlier passes
+				auto &load_store   = pass.load_store[access.attachment];
+				load_store.load_op = info.write && !state.accessed ? VK_ATTACHMENT_LOAD_OP_CLEAR : VK_ATTACHMENT_LOAD_OP_LOAD;
+
+				// Only the images accessed by later passes, or presented, are stored
+				load_store.store_op = image.backbuffer || image.last_pass > pass_index ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+
+				auto &clear_value = pass.clear_value[access.attachment];
+				if (is_depth_stencil_format(image.format))
+				{
+					clear_value.depthStencil = {0.0f, ~0U};
+				}
+				else
+				{
+					clear_value.color = {{0.0f, 0.0f, 0.0f, 1.0f}};
+				}
+			}
+
+			state.accessed = true;
+			state.layout   = info.layout;
+
+			if (info.write)
+			{
+				state.write_stage   = info.stage;
+				state.write_access  = info.access & write_access_mask;
+				state.read_stage    = 0;
+				state.visible_stage = info.stage;
+			}
+			else
+			{
+				state.read_stage |= info.stage;
+
+				if (needs_barrier)
+				{
+					state.visible_stage |= info.stage;
+				}
+
+				// Later reads from other stages wait for the layout transition
+				if (layout_transition)
+				{
+					state.write_stage |= info.stage;
+				}
+			}
+		}
+
+		stats.image_barrier_count += to_u32(pass.barriers.size());
+		stats.pipeline_barrier_count += barrier_merging ? std::min(to_u32(pass.barriers.size()), 1U) : to_u32(pass.barriers.size());
+	}
+
+	auto &state = states[backbuffer];
+
+	ImageMemoryBarrier present_barrier{};
+	present_barrier.old_layout      = state.layout;
+	present_barrier.new_layout      = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+	present_barrier.src_stage_mask  = state.write_stage | state.read_stage;
+	present_barrier.src_access_mask = state.write_access;
+	present_barrier.dst_stage_mask  = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+
+	present_barriers = {{backbuffer, present_barrier}};
+
+	stats.image_barrier_count++;
+	stats.pipeline_barrier_count++;
+}
+
+void RenderGraph::create_render_targets(FrameResources &frame)
+{
+	frame.render_targets.resize(active_passes.size());
+
+	for (size_t i = 0; i < active_passes.size(); ++i)
+	{
+		auto &pass = *active_passes[i];
+
+		if (pass.compute || pass.attachment_count == 0)
+		{
+			continue;
+		}
+
+		std::vector<core::ImageView> views;
+		views.reserve(pass.attachment_count);
+
+		std::vector<VkImageLayout> layouts;
+
+		for (auto &access : pass.accesses)
+		{
+			if (access.attachment != ~0U)
+			{
+				assert(access.attachment == views.size());
+				views.emplace_back(*frame.images[access.image], VK_IMAGE_VIEW_TYPE_2D);
+				layouts.push_back(get_access_info(access.access, images[access.image].format, false).layout);
+			}
+		}
+
+		frame.render_targets[i] = std::make_unique<RenderTarget>(std::move(views));
+
+		// The barriers transition the attachments, so the render passes keep their layouts
+		for (uint32_t attachment = 0; attachment < to_u32(layouts.size()); ++attachment)
+		{
+			frame.render_targets[i]->set_layout(attachment, layouts[attachment]);
+		}
+	}
+}
+
+void RenderGraph::record_barriers(CommandBuffer &command_buffer, const std::vector<Pass::Barrier> &barriers, const FrameResources &frame)
+{
+	if (barrier_merging)
+	{
+		std::vector<const core::ImageView *> image_views;
+		std::vector<ImageMemoryBarrier>      memory_barriers;
+
+		for (auto &barrier : barriers)
+		{
+			image_views.push_back(frame.views[barrier.image].get());
+			memory_barriers.push_back(barrier.barrier);
+		}
+
+		command_buffer.image_memory_barriers(image_views, memory_barriers);
+	}
+	else
+	{
+		for (auto &barrier : barriers)
+		{
+			command_buffer.image_memory_barrier(*frame.views[barrier.image], barrier.barrier);
+		}
+	}
+}
+}        // namespace vkb
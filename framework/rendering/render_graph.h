@@ -0,0 +1,352 @@
+/* Copyright (c) 2023, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "common/vk_common.h"
+#include "core/image.h"
+#include "core/image_view.h"
+#include "rendering/render_target.h"
+#include "rendering/transient_attachment_allocator.h"
+
+namespace vkb
+{
+class CommandBuffer;
+class RenderContext;
+class RenderPipeline;
+
+/**
+ * @brief A frame described as passes reading and writing named images
+ *
+ *        Passes declare how they access each image, and the graph derives everything
+ *        the samples otherwise write by hand around their render pipelines:
+ *        - passes which do not contribute to the backbuffer are culled;
+ *        - the layout transitions and the dependencies between passes are derived from
+ *          the accesses, and the image barriers of a pass are merged into a single
+ *          pipeline barrier recorded before it;
+ *        - the load and store operations of the attachments are derived from whether
+ *          earlier passes wrote them and later passes read them;
+ *        - the transient images are only live from their first to their last access,
+ *          so images whose lifetimes do not overlap share the same memory through a
+ *          TransientAttachmentAllocator, which also binds the images only accessed as
+ *          attachments to lazily allocated memory.
+ *
+ *        Transient images are created for every render frame, at a scale of the surface
+ *        extent. The backbuffer is the swapchain image of the active render frame, presented
+ *        after the last pass. The graph is compiled on the first execution, and again after
+ *        the surface or the graph options changed.
+ */
+class RenderGraph
+{
+  public:
+	/**
+	 * @brief How a pass accesses an image
+	 */
+	enum class Access
+	{
+		ColorAttachment,
+		DepthStencilAttachment,
+		InputAttachment,
+		Sampled,
+		StorageRead,
+		StorageWrite
+	};
+
+	/**
+	 * @brief Records the commands of a pass. Raster passes receive the render target made of
+	 *        their attachments, and begin a single render pass on it which the graph ends.
+	 *        Compute passes receive no render target.
+	 */
+	using ExecuteFunc = std::function<void(CommandBuffer &command_buffer, RenderTarget *render_target)>;
+
+	/**
+	 * @brief Result of the last compilation, barriers and memory are per frame
+	 */
+	struct Stats
+	{
+		uint32_t pass_count{0};
+
+		uint32_t culled_pass_count{0};
+
+		// Image memory barriers recorded per frame
+		uint32_t image_barrier_count{0};
+
+		// vkCmdPipelineBarrier calls recorded per frame
+		uint32_t pipeline_barrier_count{0};
+
+		// Memory the transient images would take with one allocation each
+		VkDeviceSize image_memory{0};
+
+		// Memory actually allocated for the transient images, excluding lazily allocated memory
+		VkDeviceSize allocated_memory{0};
+
+		// Lazily allocated memory reserved for the transient attachments
+		VkDeviceSize lazy_memory{0};
+	};
+
+	class Pass
+	{
+	  public:
+		Pass(RenderGraph &graph, const std::string &name, bool compute);
+
+		/**
+		 * @brief Declares an image written as a color attachment
+		 * @return The index of the attachment in the render target of the pass
+		 */
+		uint32_t write_color(const std::string &image);
+
+		/**
+		 * @brief Declares an image written as the depth stencil attachment
+		 * @return The index of the attachment in the render target of the pass
+		 */
+		uint32_t write_depth(const std::string &image);
+
+		/**
+		 * @brief Declares an image read as an input attachment
+		 * @return The index of the attachment in the render target of the pass
+		 */
+		uint32_t read_input(const std::string &image);
+
+		/**
+		 * @brief Declares an image sampled by the fragment shaders, or by the compute shaders of a compute pass
+		 */
+		void read_sampled(const std::string &image);
+
+		void read_storage(const std::string &image);
+
+		void write_storage(const std::string &image);
+
+		void set_execute(ExecuteFunc &&execute);
+
+		const std::string &get_name() const;
+
+		bool is_compute() const;
+
+		/**
+		 * @brief Whether the last compilation culled the pass, as nothing it writes is used
+		 */
+		bool is_culled() const;
+
+		/**
+		 * @brief Load and store operations derived for the attachments of the pass
+		 */
+		const std::vector<LoadStoreInfo> &get_load_store() const;
+
+		const std::vector<VkClearValue> &get_clear_value() const;
+
+	  private:
+		friend class RenderGraph;
+
+		struct ImageAccess
+		{
+			uint32_t image;
+
+			Access access;
+
+			// Index in the render target, for attachments
+			uint32_t attachment;
+		};
+
+		struct Barrier
+		{
+			uint32_t image;
+
+			ImageMemoryBarrier barrier;
+		};
+
+		uint32_t add_access(const std::string &image, Access access);
+
+		RenderGraph &graph;
+
+		std::string name;
+
+		bool compute{false};
+
+		ExecuteFunc execute;
+
+		std::vector<ImageAccess> accesses;
+
+		uint32_t attachment_count{0};
+
+		bool culled{false};
+
+		std::vector<LoadStoreInfo> load_store;
+
+		std::vector<VkClearValue> clear_value;
+
+		// Image barriers recorded before the pass
+		std::vector<Barrier> barriers;
+	};
+
+	RenderGraph(RenderContext &render_context);
+
+	RenderGraph(const RenderGraph &) = delete;
+
+	RenderGraph(RenderGraph &&) = delete;
+
+	~RenderGraph();
+
+	RenderGraph &operator=(const RenderGraph &) = delete;
+
+	RenderGraph &operator=(RenderGraph &&) = delete;
+
+	/**
+	 * @brief Declares a transient image, created by the graph for every frame
+	 * @param name Name the passes access the image with
+	 * @param format Format of the image, its usage is derived from the accesses
+	 * @param scale Size of the image relative to the surface extent
+	 */
+	void add_image(const std::string &name, VkFormat format, float scale = 1.0f);
+
+	/**
+	 * @brief Declares the name of the swapchain image of the active frame.
+	 *        Only the passes contributing to it are recorded.
+	 */
+	void set_backbuffer(const std::string &name);
+
+	/**
+	 * @brief Adds a pass drawing into attachments, it must write at least one
+	 */
+	Pass &add_pass(const std::string &name);
+
+	/**
+	 * @brief Adds a pass drawing a render pipeline into its attachments, with the load and store operations
+	 *        and the clear values derived by the graph
+	 */
+	Pass &add_pass(const std::string &name, RenderPipeline &render_pipeline);
+
+	/**
+	 * @brief Adds a pass dispatching compute shaders outside of a render pass
+	 */
+	Pass &add_compute_pass(const std::string &name);
+
+	/**
+	 * @brief Whether transient images with disjoint lifetimes share memory, rather than being allocated separately
+	 */
+	void set_aliasing(bool aliasing);
+
+	/**
+	 * @brief Whether the image barriers of a pass are recorded as one pipeline barrier, rather than one each
+	 */
+	void set_barrier_merging(bool barrier_merging);
+
+	/**
+	 * @brief Records all the passes which were not culled, and the transition of the backbuffer for presentation
+	 * @param command_buffer Command buffer of the active frame
+	 * @param draw_overlay Recorded at the end of the last render pass, such as the GUI
+	 */
+	void execute(CommandBuffer &command_buffer, const std::function<void(CommandBuffer &)> &draw_overlay = {});
+
+	/**
+	 * @return The view of an image for the active frame, to bind the sampled and storage images of a pass
+	 */
+	const core::ImageView &get_view(const std::string &name) const;
+
+	const Stats &get_stats() const;
+
+  private:
+	struct ImageResource
+	{
+		std::string name;
+
+		VkFormat format{VK_FORMAT_UNDEFINED};
+
+		float scale{1.0f};
+
+		bool backbuffer{false};
+
+		VkImageUsageFlags usage{0};
+
+		// First and last passes accessing the image, in the order of the passes which are not culled
+		uint32_t first_pass{~0U};
+
+		uint32_t last_pass{0};
+
+		// Index of the image in the transient attachment allocators of the frames
+		uint32_t transient_index{~0U};
+	};
+
+	/**
+	 * @brief Images of a render frame, and the render targets of its raster passes
+	 */
+	struct FrameResources
+	{
+		std::unique_ptr<TransientAttachmentAllocator> allocator;
+
+		std::vector<std::unique_ptr<core::Image>> images;
+
+		std::vector<std::unique_ptr<core::ImageView>> views;
+
+		std::vector<std::unique_ptr<RenderTarget>> render_targets;
+	};
+
+	uint32_t get_image_index(const std::string &name) const;
+
+	bool is_compiled() const;
+
+	void compile();
+
+	void release();
+
+	void cull_passes();
+
+	void create_images();
+
+	void plan_barriers();
+
+	void create_render_targets(FrameResources &frame);
+
+	void record_barriers(CommandBuffer &command_buffer, const std::vector<Pass::Barrier> &barriers, const FrameResources &frame);
+
+	RenderContext &render_context;
+
+	std::vector<ImageResource> images;
+
+	std::unordered_map<std::string, uint32_t> image_indices;
+
+	std::vector<std::unique_ptr<Pass>> passes;
+
+	// Passes which are not culled, in order
+	std::vector<Pass *> active_passes;
+
+	// Transition of the backbuffer for presentation
+	std::vector<Pass::Barrier> present_barriers;
+
+	std::vector<FrameResources> frame_resources;
+
+	uint32_t backbuffer{~0U};
+
+	bool aliasing{true};
+
+	bool barrier_merging{true};
+
+	bool dirty{true};
+
+	// Surface extent and swapchain images the graph was compiled for
+	VkExtent2D extent{};
+
+	std::vector<VkImage> backbuffer_handles;
+
+	Stats stats;
+};
+}        // namespace vkb
@@ -88,6 +88,11 @@ void RenderPipeline::draw(CommandBuffer &command_buffer, RenderTarget &render_ta
 		clear_value.push_back({0.0f, 0.0f, 0.0f, 1.0f});
 	}
 
+	for (auto &subpass : subpasses)
+	{
+		subpass->pre_draw(command_buffer);
+	}
+
 	for (size_t i = 0; i < subpasses.size(); ++i)
 	{
 		active_subpass_index = i;
@@ -96,13 +101,21 @@ void RenderPipeline::draw(CommandBuffer &command_buffer, RenderTarget &render_ta
 
 		subpass->update_render_target_attachments(render_target);
 
+		// Subpasses recording their draws into secondary command buffers request it themselves
+		VkSubpassContents subpass_contents = subpass->get_contents();
+
 		if (i == 0)
 		{
-			command_buffer.begin_render_pass(render_target, load_store, clear_value, subpasses, contents);
+			if (contents == VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS)
+			{
+				subpass_contents = contents;
+			}
+
+			command_buffer.begin_render_pass(render_target, load_store, clear_value, subpasses, subpass_contents);
 		}
 		else
 		{
-			command_buffer.next_subpass();
+			command_buffer.next_subpass(subpass_contents);
 		}
 
 		if (subpass->get_debug_name().empty())
@@ -73,7 +73,8 @@ vkb::RenderTarget::RenderTarget(std::vector<core::Image> &&images) :
 		throw VulkanException{VK_ERROR_INITIALIZATION_FAILED, "Extent size is not unique"};
 	}
 
-	extent = *unique_extent.begin();
+	extent       = *unique_extent.begin();
+	image_extent = extent;
 
 	for (auto &image : this->images)
 	{
@@ -111,7 +112,8 @@ vkb::RenderTarget::RenderTarget(std::vector<core::ImageView> &&image_views) :
 	{
 		throw VulkanException{VK_ERROR_INITIALIZATION_FAILED, "Extent size is not unique"};
 	}
-	extent = *unique_extent.begin();
+	extent       = *unique_extent.begin();
+	image_extent = extent;
 
 	for (auto &view : views)
 	{
@@ -125,6 +127,22 @@ const VkExtent2D &RenderTarget::get_extent() const
 	return extent;
 }
 
+void RenderTarget::set_extent(const VkExtent2D &new_extent)
+{
+	if (new_extent.width == 0 || new_extent.height == 0 ||
+	    new_extent.width > image_extent.width || new_extent.height > image_extent.height)
+	{
+		throw VulkanException{VK_ERROR_INITIALIZATION_FAILED, "Extent is empty or larger than the images"};
+	}
+
+	extent = new_extent;
+}
+
+const VkExtent2D &RenderTarget::get_image_extent() const
+{
+	return image_extent;
+}
+
 const std::vector<core::ImageView> &RenderTarget::get_views() const
 {
 	return views;
@@ -73,8 +73,20 @@ class RenderTarget
 
 	RenderTarget &operator=(RenderTarget &&other) noexcept = delete;
 
+	/**
+	 * @return The extent rendered to, which is the extent of the images unless set_extent() restricted it
+	 */
 	const VkExtent2D &get_extent() const;
 
+	/**
+	 * @brief Restricts rendering to the top-left region of the images, for example to render at a dynamic resolution
+	 *        without recreating the images. A framebuffer is created for each extent used.
+	 * @param extent Extent of the region, must not be larger than the extent of the images
+	 */
+	void set_extent(const VkExtent2D &extent);
+
+	const VkExtent2D &get_image_extent() const;
+
 	const std::vector<core::ImageView> &get_views() const;
 
 	const std::vector<Attachment> &get_attachments() const;
@@ -106,6 +118,8 @@ class RenderTarget
 
 	VkExtent2D extent{};
 
+	VkExtent2D image_extent{};
+
 	std::vector<core::Image> images;
 
 	std::vector<core::ImageView> views;
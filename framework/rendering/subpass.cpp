@@ -42,10 +42,17 @@ Subpass::Subpass(RenderContext &render_context, ShaderSource &&vertex_source, Sh
 {
 }
 
-void Subpass::update_render_target_attachments(RenderTarget &render_target)
+void Subpass::update_render_target_attachments(RenderTarget &render_target_)
 {
-	render_target.set_input_attachments(input_attachments);
-	render_target.set_output_attachments(output_attachments);
+	render_target_.set_input_attachments(input_attachments);
+	render_target_.set_output_attachments(output_attachments);
+
+	render_target = &render_target_;
+}
+
+RenderTarget *Subpass::get_render_target() const
+{
+	return render_target;
 }
 
 RenderContext &Subpass::get_render_context()
@@ -94,12 +94,36 @@ class Subpass
 	 */
 	void update_render_target_attachments(RenderTarget &render_target);
 
+	/**
+	 * @return The render target last given to update_render_target_attachments, which the subpass draws into
+	 */
+	RenderTarget *get_render_target() const;
+
 	/**
 	 * @brief Draw virtual function
 	 * @param command_buffer Command buffer to use to record draw commands
 	 */
 	virtual void draw(CommandBuffer &command_buffer) = 0;
 
+	/**
+	 * @brief Records commands that must be executed outside of the render pass,
+	 *        such as compute work feeding indirect draws. This function is called
+	 *        by the RenderPipeline before beginning the render pass.
+	 * @param command_buffer Command buffer to use to record commands
+	 */
+	virtual void pre_draw(CommandBuffer &command_buffer)
+	{}
+
+	/**
+	 * @brief Contents of the subpass, inline commands by default.
+	 *        Subpasses recording their draws into secondary command buffers
+	 *        return VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS.
+	 */
+	virtual VkSubpassContents get_contents() const
+	{
+		return VK_SUBPASS_CONTENTS_INLINE;
+	}
+
 	RenderContext &get_render_context();
 
 	const ShaderSource &get_vertex_shader() const;
@@ -198,15 +222,17 @@ class Subpass
 			}
 		}
 
-		T light_info;
+		auto &render_frame          = get_render_context().get_active_frame();
+		lighting_state.light_buffer = render_frame.allocate_buffer(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, sizeof(T));
+
+		// Fill the lights directly in the mapped uniform buffer
+		T &light_info = lighting_state.light_buffer.emplace<T>();
 
 		std::copy(lighting_state.directional_lights.begin(), lighting_state.directional_lights.end(), light_info.directional_lights);
 		std::copy(lighting_state.point_lights.begin(), lighting_state.point_lights.end(), light_info.point_lights);
 		std::copy(lighting_state.spot_lights.begin(), lighting_state.spot_lights.end(), light_info.spot_lights);
 
-		auto &render_frame          = get_render_context().get_active_frame();
-		lighting_state.light_buffer = render_frame.allocate_buffer(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, sizeof(T));
-		lighting_state.light_buffer.update(light_info);
+		lighting_state.light_buffer.flush();
 	}
 
   protected:
@@ -251,6 +277,9 @@ class Subpass
 	/// Default to no color resolve attachments
 	std::vector<uint32_t> color_resolve_attachments = {};
 
+	/// Render target of the render pass the subpass is part of
+	RenderTarget *render_target{nullptr};
+
 	/// Default to no depth stencil resolve attachment
 	uint32_t depth_stencil_resolve_attachment{VK_ATTACHMENT_UNUSED};
 };
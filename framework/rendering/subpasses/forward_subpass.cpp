@@ -47,9 +47,7 @@ void ForwardSubpass::prepare()
 			auto &variant = sub_mesh->get_mut_shader_variant();
 
 			// Same as Geometry except adds lighting definitions to sub mesh variants.
-			variant.add_definitions({"MAX_LIGHT_COUNT " + std::to_string(MAX_FORWARD_LIGHT_COUNT)});
-
-			variant.add_definitions(light_type_definitions);
+			add_lighting_definitions(variant);
 
 			auto &vert_module = device.get_resource_cache().request_shader_module(VK_SHADER_STAGE_VERTEX_BIT, get_vertex_shader(), variant);
 			auto &frag_module = device.get_resource_cache().request_shader_module(VK_SHADER_STAGE_FRAGMENT_BIT, get_fragment_shader(), variant);
@@ -59,9 +57,62 @@ void ForwardSubpass::prepare()
 
 void ForwardSubpass::draw(CommandBuffer &command_buffer)
 {
-	allocate_lights<ForwardLights>(scene.get_components<sg::Light>(), MAX_FORWARD_LIGHT_COUNT);
-	command_buffer.bind_lighting(get_lighting_state(), 0, 4);
+	bind_lights(command_buffer);
 
 	GeometrySubpass::draw(command_buffer);
 }
+
+void ForwardSubpass::set_clustered_lighting(bool clustered)
+{
+	if (clustered && !clustered_lighting)
+	{
+		clustered_lighting = std::make_unique<ClusteredLighting>(render_context);
+	}
+	else if (!clustered)
+	{
+		clustered_lighting.reset();
+	}
+}
+
+const ClusteredLighting *ForwardSubpass::get_clustered_lighting() const
+{
+	return clustered_lighting.get();
+}
+
+void ForwardSubpass::add_lighting_definitions(ShaderVariant &variant) const
+{
+	variant.add_definitions({"MAX_LIGHT_COUNT " + std::to_string(MAX_FORWARD_LIGHT_COUNT)});
+
+	variant.add_definitions(light_type_definitions);
+
+	// Sub mesh variants are shared with the subpasses prepared before, which may have clustered their lights
+	if (clustered_lighting)
+	{
+		variant.add_define("CLUSTERED_LIGHTING");
+	}
+	else
+	{
+		variant.add_undefine("CLUSTERED_LIGHTING");
+	}
+}
+
+void ForwardSubpass::bind_lights(CommandBuffer &command_buffer)
+{
+	auto &scene_lights = scene.get_component_view<sg::Light>();
+
+	if (clustered_lighting)
+	{
+		// Only the directional lights are left to the uniform light arrays
+		allocate_lights<ForwardLights>(ClusteredLighting::get_directional_lights(scene_lights), MAX_FORWARD_LIGHT_COUNT);
+
+		clustered_lighting->update(scene_lights, camera, render_context.get_active_frame().get_render_target().get_extent());
+		clustered_lighting->bind(command_buffer, 1);
+	}
+	else
+	{
+		allocate_lights<ForwardLights>(scene_lights, MAX_FORWARD_LIGHT_COUNT);
+	}
+
+	command_buffer.bind_lighting(get_lighting_state(), 0, 4);
+}
 }        // namespace vkb
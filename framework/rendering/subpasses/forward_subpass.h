@@ -18,6 +18,7 @@
 #pragma once
 
 #include "buffer_pool.h"
+#include "rendering/clustered_lighting.h"
 #include "rendering/subpasses/geometry_subpass.h"
 
 // This value is per type of light that we feed into the shader
@@ -65,6 +66,32 @@ class ForwardSubpass : public GeometrySubpass
 	 * @brief Record draw commands
 	 */
 	virtual void draw(CommandBuffer &command_buffer) override;
+
+	/**
+	 * @brief Whether the point and spot lights are assigned to clusters of the view, rather than all evaluated
+	 *        for every pixel. This lifts the limit of MAX_FORWARD_LIGHT_COUNT point and spot lights.
+	 *        Must be set before the subpass is prepared.
+	 */
+	void set_clustered_lighting(bool clustered);
+
+	/**
+	 * @return The clustered lighting of the subpass, or nullptr if it is disabled
+	 */
+	const ClusteredLighting *get_clustered_lighting() const;
+
+  protected:
+	/**
+	 * @brief Adds the definitions of the lighting shaders to a shader variant
+	 */
+	void add_lighting_definitions(ShaderVariant &variant) const;
+
+	/**
+	 * @brief Allocates the lights of the scene for the active frame, and binds them
+	 */
+	void bind_lights(CommandBuffer &command_buffer);
+
+  private:
+	std::unique_ptr<ClusteredLighting> clustered_lighting;
 };
 
 }        // namespace vkb
@@ -18,6 +18,7 @@
 #include "rendering/subpasses/geometry_subpass.h"
 #include "common/utils.h"
 #include "common/vk_common.h"
+#include "job_system.h"
 #include "rendering/render_context.h"
 #include "scene_graph/components/camera.h"
 #include "scene_graph/components/image.h"
@@ -28,11 +29,54 @@
 #include "scene_graph/node.h"
 #include "scene_graph/scene.h"
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
 namespace vkb
 {
+namespace
+{
+// Layout of the draw keys, from the most significant bit
+constexpr uint64_t TRANSPARENT_KEY_BIT = uint64_t{1} << 63;
+
+constexpr uint32_t VARIANT_KEY_SHIFT = 48;
+
+constexpr uint32_t FRONT_FACE_KEY_SHIFT = 47;
+
+constexpr uint32_t MATERIAL_KEY_SHIFT = 32;
+
+// Shader variants and materials past the first 32768 share sort indices, which only costs state changes
+constexpr uint64_t SORT_INDEX_MASK = (uint64_t{1} << 15) - 1;
+
+// Binding of the model matrices of instanced draws
+constexpr uint32_t INSTANCE_BUFFER_BINDING = 5;
+
+// Instances per draw, so that the model matrices of a draw fit in a block of the storage buffer pool
+constexpr size_t MAX_DRAW_INSTANCE_COUNT = 4096;
+
+// Levels of detail in the draw keys of instanced draws
+constexpr uint32_t LOD_KEY_SHIFT = 28;
+
+constexpr uint32_t MAX_LOD = 15;
+
+// Size of the mesh bounds on screen, as a fraction of the screen height, below which the second level of detail is drawn.
+// Each following level is drawn below half the size of the previous one.
+constexpr float LOD_SCREEN_SIZE = 0.5f;
+
+// Fraction of a level the size must move past a threshold by before the level changes
+constexpr float LOD_HYSTERESIS = 0.25f;
+
+bool is_flipped(sg::Node &node)
+{
+	const auto &scale = node.get_transform().get_scale();
+	return scale.x * scale.y * scale.z < 0;
+}
+}        // namespace
+
 GeometrySubpass::GeometrySubpass(RenderContext &render_context, ShaderSource &&vertex_source, ShaderSource &&fragment_source, sg::Scene &scene_, sg::Camera &camera) :
     Subpass{render_context, std::move(vertex_source), std::move(fragment_source)},
-    meshes{scene_.get_components<sg::Mesh>()},
+    meshes{scene_.get_component_view<sg::Mesh>()},
     camera{camera},
     scene{scene_}
 {
@@ -49,67 +93,287 @@ void GeometrySubpass::prepare()
 			auto &variant     = sub_mesh->get_shader_variant();
 			auto &vert_module = device.get_resource_cache().request_shader_module(VK_SHADER_STAGE_VERTEX_BIT, get_vertex_shader(), variant);
 			auto &frag_module = device.get_resource_cache().request_shader_module(VK_SHADER_STAGE_FRAGMENT_BIT, get_fragment_shader(), variant);
+
+			if (instancing)
+			{
+				auto &instanced_variant = request_instanced_variant(*sub_mesh);
+				device.get_resource_cache().request_shader_module(VK_SHADER_STAGE_VERTEX_BIT, get_vertex_shader(), instanced_variant);
+				device.get_resource_cache().request_shader_module(VK_SHADER_STAGE_FRAGMENT_BIT, get_fragment_shader(), instanced_variant);
+			}
 		}
 	}
 }
 
-void GeometrySubpass::get_sorted_nodes(std::multimap<float, std::pair<sg::Node *, sg::SubMesh *>> &opaque_nodes, std::multimap<float, std::pair<sg::Node *, sg::SubMesh *>> &transparent_nodes)
+void GeometrySubpass::get_sorted_nodes(std::vector<std::pair<sg::Node *, sg::SubMesh *>> &opaque_nodes, std::vector<std::pair<sg::Node *, sg::SubMesh *>> &transparent_nodes)
 {
-	auto camera_transform = camera.get_node()->get_transform().get_world_matrix();
+	opaque_nodes.clear();
+	transparent_nodes.clear();
+	draws.clear();
+	draw_keys.clear();
 
-	for (auto &mesh : meshes)
+	// Only the instances visible from the camera are sorted, the results are shared with the other subpasses using it
+	auto &culling_result = scene.get_visibility_culling().cull(camera);
+
+	const glm::mat4 projection = camera.get_projection();
+
+	triangle_count = 0;
+
+	for (auto &visible_node : culling_result.visible_nodes)
 	{
-		for (auto &node : mesh->get_nodes())
-		{
-			auto node_transform = node->get_transform().get_world_matrix();
+		uint32_t lod = level_of_detail ? select_lod(*visible_node.node, *visible_node.mesh, visible_node.distance, projection) : 0;
 
-			const sg::AABB &mesh_bounds = mesh->get_bounds();
+		// Distances are positive, so their bits sort in the same order as their values
+		uint32_t depth_bits = 0;
+		std::memcpy(&depth_bits, &visible_node.distance, sizeof(depth_bits));
 
-			sg::AABB world_bounds{mesh_bounds.get_min(), mesh_bounds.get_max()};
-			world_bounds.transform(node_transform);
+		bool flipped = is_flipped(*visible_node.node);
 
-			float distance = glm::length(glm::vec3(camera_transform[3]) - world_bounds.get_center());
+		for (auto &sub_mesh : visible_node.mesh->get_submeshes())
+		{
+			DrawKey draw_key{0, to_u32(draws.size())};
+
+			triangle_count += (sub_mesh->vertex_indices != 0 ? sub_mesh->get_lod(lod).index_count : sub_mesh->vertices_count) / 3;
 
-			for (auto &sub_mesh : mesh->get_submeshes())
+			if (sub_mesh->get_material()->alpha_mode == sg::AlphaMode::Blend)
 			{
-				if (sub_mesh->get_material()->alpha_mode == sg::AlphaMode::Blend)
-				{
-					transparent_nodes.emplace(distance, std::make_pair(node, sub_mesh));
-				}
-				else
+				// Back-to-front order
+				draw_key.key = TRANSPARENT_KEY_BIT | static_cast<uint64_t>(~depth_bits);
+			}
+			else
+			{
+				// Grouped by pipeline state, then front-to-back order, or by submesh to draw its instances together
+				uint64_t variant_index  = get_sort_index(variant_indices, sub_mesh->get_shader_variant().get_id()) & SORT_INDEX_MASK;
+				uint64_t material_index = get_sort_index(material_indices, sub_mesh->get_material()) & SORT_INDEX_MASK;
+				uint64_t order          = depth_bits;
+
+				if (instancing)
 				{
-					opaque_nodes.emplace(distance, std::make_pair(node, sub_mesh));
+					uint64_t sub_mesh_index = get_sort_index(sub_mesh_indices, static_cast<const sg::SubMesh *>(sub_mesh)) & ((uint64_t{1} << LOD_KEY_SHIFT) - 1);
+
+					order = (static_cast<uint64_t>(std::min<uint32_t>(lod, MAX_LOD)) << LOD_KEY_SHIFT) | sub_mesh_index;
 				}
+
+				draw_key.key = (variant_index << VARIANT_KEY_SHIFT) |
+				               (static_cast<uint64_t>(flipped) << FRONT_FACE_KEY_SHIFT) |
+				               (material_index << MATERIAL_KEY_SHIFT) |
+				               order;
 			}
+
+			draws.emplace_back(visible_node.node, sub_mesh);
+			draw_keys.push_back(draw_key);
+		}
+	}
+
+	radix_sort(draw_keys, sorted_draw_keys);
+
+	for (auto &draw_key : draw_keys)
+	{
+		if (draw_key.key & TRANSPARENT_KEY_BIT)
+		{
+			transparent_nodes.push_back(draws[draw_key.draw_index]);
+		}
+		else
+		{
+			opaque_nodes.push_back(draws[draw_key.draw_index]);
 		}
 	}
+
+	scene.get_visibility_culling().add_submitted_triangles(triangle_count);
+
+	draw_count = to_u32(transparent_nodes.size());
+
+	for (size_t first = 0; first < opaque_nodes.size();)
+	{
+		size_t end = get_instances_end(opaque_nodes, first, opaque_nodes.size());
+
+		// Variants are created here rather than while recording, which may run on several threads
+		if (end - first > 1)
+		{
+			request_instanced_variant(*opaque_nodes[first].second);
+		}
+
+		draw_count++;
+		first = end;
+	}
+}
+
+uint32_t GeometrySubpass::select_lod(sg::Node &node, const sg::Mesh &mesh, float distance, const glm::mat4 &projection)
+{
+	const auto &world_matrix = node.get_transform().get_world_matrix();
+	const auto &bounds       = mesh.get_bounds();
+
+	float scale  = std::max(std::max(glm::length(glm::vec3(world_matrix[0])), glm::length(glm::vec3(world_matrix[1]))), glm::length(glm::vec3(world_matrix[2])));
+	float radius = 0.5f * glm::length(bounds.get_max() - bounds.get_min()) * scale;
+
+	// Perspective projections shrink the bounds with the distance, orthographic ones do not
+	float depth       = projection[3][3] == 0.0f ? std::max(distance, radius) : 1.0f;
+	float screen_size = radius * std::abs(projection[1][1]) / depth;
+
+	float level = screen_size > 0.0f ? std::max(std::log2(LOD_SCREEN_SIZE / screen_size) + 1.0f, 0.0f) : static_cast<float>(MAX_LOD);
+
+	auto it = node_lods.find(&node);
+	if (it == node_lods.end())
+	{
+		it = node_lods.emplace(&node, 0).first;
+	}
+	else if (level > it->second - LOD_HYSTERESIS && level < it->second + 1.0f + LOD_HYSTERESIS)
+	{
+		return it->second;
+	}
+
+	it->second = std::min(static_cast<uint32_t>(level), MAX_LOD);
+
+	return it->second;
+}
+
+uint32_t GeometrySubpass::get_lod(const sg::Node &node, const sg::SubMesh &sub_mesh) const
+{
+	if (!level_of_detail || sub_mesh.lods.empty())
+	{
+		return 0;
+	}
+
+	auto it = node_lods.find(&node);
+
+	return it != node_lods.end() ? std::min(it->second, to_u32(sub_mesh.lods.size() - 1)) : 0;
+}
+
+const ShaderVariant &GeometrySubpass::request_instanced_variant(const sg::SubMesh &sub_mesh)
+{
+	auto it = instanced_variants.find(&sub_mesh);
+	if (it == instanced_variants.end())
+	{
+		auto instanced_variant = sub_mesh.get_shader_variant();
+		instanced_variant.add_define("INSTANCING");
+
+		it = instanced_variants.emplace(&sub_mesh, std::move(instanced_variant)).first;
+	}
+
+	return it->second;
+}
+
+template <class T>
+uint32_t GeometrySubpass::get_sort_index(std::unordered_map<T, uint32_t> &indices, const T &value)
+{
+	auto it = indices.find(value);
+	if (it == indices.end())
+	{
+		it = indices.emplace(value, to_u32(indices.size())).first;
+	}
+
+	return it->second;
+}
+
+size_t GeometrySubpass::get_instances_end(const std::vector<std::pair<sg::Node *, sg::SubMesh *>> &nodes, size_t first, size_t last) const
+{
+	size_t end = first + 1;
+
+	// Nodes deformed separately draw their own vertices
+	if (instancing && !nodes[first].second->has_node_deformation(*nodes[first].first))
+	{
+		bool     flipped = is_flipped(*nodes[first].first);
+		uint32_t lod     = get_lod(*nodes[first].first, *nodes[first].second);
+
+		while (end < last && end - first < MAX_DRAW_INSTANCE_COUNT && nodes[end].second == nodes[first].second && is_flipped(*nodes[end].first) == flipped &&
+		       get_lod(*nodes[end].first, *nodes[end].second) == lod && !nodes[end].second->has_node_deformation(*nodes[end].first))
+		{
+			end++;
+		}
+	}
+
+	return end;
 }
 
 void GeometrySubpass::draw(CommandBuffer &command_buffer)
 {
-	std::multimap<float, std::pair<sg::Node *, sg::SubMesh *>> opaque_nodes;
-	std::multimap<float, std::pair<sg::Node *, sg::SubMesh *>> transparent_nodes;
+	get_sorted_nodes(sorted_opaque_nodes, sorted_transparent_nodes);
 
-	get_sorted_nodes(opaque_nodes, transparent_nodes);
+	if (get_contents() == VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS)
+	{
+		draw_secondary(command_buffer, sorted_opaque_nodes, sorted_transparent_nodes);
+		return;
+	}
 
-	// Draw opaque objects in front-to-back order
+	// Draw opaque objects grouped by pipeline state, in front-to-back order within each group
 	{
 		ScopedDebugLabel opaque_debug_label{command_buffer, "Opaque objects"};
 
-		for (auto node_it = opaque_nodes.begin(); node_it != opaque_nodes.end(); node_it++)
+		draw_opaque_nodes(command_buffer, sorted_opaque_nodes, 0, sorted_opaque_nodes.size(), thread_index);
+	}
+
+	// Enable alpha blending
+	prepare_transparent_state(command_buffer);
+
+	// Draw transparesnt objects in back-to-front order
+	{
+		ScopedDebugLabel transparent_debug_label{command_buffer, "Transparent objects"};
+
+		for (auto &node : sorted_transparent_nodes)
 		{
-			update_uniform(command_buffer, *node_it->second.first, thread_index);
+			draw_transparent_submesh(command_buffer, *node.first, *node.second, thread_index);
+		}
+	}
+}
 
-			// Invert the front face if the mesh was flipped
-			const auto &scale      = node_it->second.first->get_transform().get_scale();
-			bool        flipped    = scale.x * scale.y * scale.z < 0;
-			VkFrontFace front_face = flipped ? VK_FRONT_FACE_CLOCKWISE : VK_FRONT_FACE_COUNTER_CLOCKWISE;
+void GeometrySubpass::draw_opaque_nodes(CommandBuffer &command_buffer, const std::vector<std::pair<sg::Node *, sg::SubMesh *>> &nodes,
+                                        size_t first, size_t last, size_t thread_index)
+{
+	for (size_t i = first; i < last;)
+	{
+		size_t end = get_instances_end(nodes, i, last);
 
-			draw_submesh(command_buffer, *node_it->second.second, front_face);
+		if (end - i > 1)
+		{
+			draw_opaque_instances(command_buffer, nodes, i, end, thread_index);
+		}
+		else
+		{
+			draw_opaque_submesh(command_buffer, *nodes[i].first, *nodes[i].second, thread_index);
 		}
+
+		i = end;
 	}
+}
 
-	// Enable alpha blending
+void GeometrySubpass::draw_opaque_submesh(CommandBuffer &command_buffer, sg::Node &node, sg::SubMesh &sub_mesh, size_t thread_index)
+{
+	update_uniform(command_buffer, node, thread_index);
+
+	// Invert the front face if the mesh was flipped
+	VkFrontFace front_face = is_flipped(node) ? VK_FRONT_FACE_CLOCKWISE : VK_FRONT_FACE_COUNTER_CLOCKWISE;
+
+	draw_submesh(command_buffer, sub_mesh, front_face, 1, get_lod(node, sub_mesh), &node);
+}
+
+void GeometrySubpass::draw_transparent_submesh(CommandBuffer &command_buffer, sg::Node &node, sg::SubMesh &sub_mesh, size_t thread_index)
+{
+	update_uniform(command_buffer, node, thread_index);
+
+	draw_submesh(command_buffer, sub_mesh, VK_FRONT_FACE_COUNTER_CLOCKWISE, 1, get_lod(node, sub_mesh), &node);
+}
+
+void GeometrySubpass::draw_opaque_instances(CommandBuffer &command_buffer, const std::vector<std::pair<sg::Node *, sg::SubMesh *>> &nodes,
+                                            size_t first, size_t last, size_t thread_index)
+{
+	// The global uniform still provides the camera, the vertex shader ignores its model matrix
+	update_uniform(command_buffer, *nodes[first].first, thread_index);
+
+	auto allocation = get_render_context().get_active_frame().allocate_buffer(VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, (last - first) * sizeof(glm::mat4), thread_index);
+
+	for (size_t i = first; i < last; ++i)
+	{
+		allocation.update(nodes[i].first->get_transform().get_world_matrix(), to_u32((i - first) * sizeof(glm::mat4)));
+	}
+
+	command_buffer.bind_buffer(allocation.get_buffer(), allocation.get_offset(), allocation.get_size(), 0, INSTANCE_BUFFER_BINDING, 0);
+
+	VkFrontFace front_face = is_flipped(*nodes[first].first) ? VK_FRONT_FACE_CLOCKWISE : VK_FRONT_FACE_COUNTER_CLOCKWISE;
+
+	draw_submesh(command_buffer, *nodes[first].second, front_face, to_u32(last - first), get_lod(*nodes[first].first, *nodes[first].second), nodes[first].first);
+}
+
+void GeometrySubpass::prepare_transparent_state(CommandBuffer &command_buffer)
+{
 	ColorBlendAttachmentState color_blend_attachment{};
 	color_blend_attachment.blend_enable           = VK_TRUE;
 	color_blend_attachment.src_color_blend_factor = VK_BLEND_FACTOR_SRC_ALPHA;
@@ -125,18 +389,108 @@ void GeometrySubpass::draw(CommandBuffer &command_buffer)
 	command_buffer.set_color_blend_state(color_blend_state);
 
 	command_buffer.set_depth_stencil_state(get_depth_stencil_state());
+}
 
-	// Draw transparesnt objects in back-to-front order
+void GeometrySubpass::draw_secondary(CommandBuffer                                           &primary_command_buffer,
+                                     const std::vector<std::pair<sg::Node *, sg::SubMesh *>> &opaque_nodes,
+                                     const std::vector<std::pair<sg::Node *, sg::SubMesh *>> &transparent_nodes)
+{
+	assert(render_context.get_thread_count() >= job_system->get_thread_count() && "The render context must be prepared with a thread for each thread of the job system");
+
+	// Split the opaque draws evenly, the first buffers take the remainder
+	size_t buffer_count = std::min<size_t>(recording_command_buffer_count, opaque_nodes.size());
+
+	std::vector<CommandBuffer *>      secondary_command_buffers(buffer_count + (transparent_nodes.empty() ? 0 : 1), nullptr);
+	std::vector<JobSystem::JobHandle> recording_jobs;
+
+	size_t first = 0;
+	for (size_t i = 0; i < buffer_count; ++i)
 	{
-		ScopedDebugLabel transparent_debug_label{command_buffer, "Transparent objects"};
+		size_t target = (i + 1) * (opaque_nodes.size() / buffer_count) + std::min(i + 1, opaque_nodes.size() % buffer_count);
+
+		// Walk the draws up to the first one starting at or after the target,
+		// so the instances of an instanced draw are not split across command buffers
+		size_t last = first;
+		while (last < target)
+		{
+			last = get_instances_end(opaque_nodes, last, opaque_nodes.size());
+		}
 
-		for (auto node_it = transparent_nodes.rbegin(); node_it != transparent_nodes.rend(); node_it++)
+		if (first == last)
 		{
-			update_uniform(command_buffer, *node_it->second.first, thread_index);
+			continue;
+		}
+
+		recording_jobs.push_back(job_system->submit(
+		    [this, &primary_command_buffer, &opaque_nodes, &secondary_command_buffers, i, first, last](uint32_t thread_index) {
+			    secondary_command_buffers[i] = record_draws_secondary(primary_command_buffer, opaque_nodes, first, last, false, thread_index);
+		    }));
+
+		first = last;
+	}
+
+	if (!transparent_nodes.empty())
+	{
+		recording_jobs.push_back(job_system->submit(
+		    [this, &primary_command_buffer, &transparent_nodes, &secondary_command_buffers](uint32_t thread_index) {
+			    secondary_command_buffers.back() = record_draws_secondary(primary_command_buffer, transparent_nodes, 0, transparent_nodes.size(), true, thread_index);
+		    }));
+	}
+
+	job_system->wait(recording_jobs);
+
+	// Aligning the ranges to instanced draws may have left command buffers unused
+	secondary_command_buffers.erase(std::remove(secondary_command_buffers.begin(), secondary_command_buffers.end(), nullptr), secondary_command_buffers.end());
+
+	// Execute in submission order, so the transparent draws come last
+	if (!secondary_command_buffers.empty())
+	{
+		primary_command_buffer.execute_commands(secondary_command_buffers);
+	}
+}
+
+CommandBuffer *GeometrySubpass::record_draws_secondary(CommandBuffer &primary_command_buffer, const std::vector<std::pair<sg::Node *, sg::SubMesh *>> &nodes,
+                                                       size_t first, size_t last, bool transparent, size_t thread_index)
+{
+	const auto &queue = render_context.get_device().get_queue_by_flags(VK_QUEUE_GRAPHICS_BIT, 0);
+
+	auto &secondary_command_buffer = render_context.get_active_frame().request_command_buffer(queue, primary_command_buffer.get_reset_mode(), VK_COMMAND_BUFFER_LEVEL_SECONDARY, thread_index);
+
+	secondary_command_buffer.begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT, &primary_command_buffer);
+
+	// Viewport, scissor and bindings are not inherited from the primary command buffer
+	const auto &extent = primary_command_buffer.get_current_render_pass().framebuffer->get_extent();
 
-			draw_submesh(command_buffer, *node_it->second.second);
+	VkViewport viewport{};
+	viewport.width    = static_cast<float>(extent.width);
+	viewport.height   = static_cast<float>(extent.height);
+	viewport.minDepth = 0.0f;
+	viewport.maxDepth = 1.0f;
+	secondary_command_buffer.set_viewport(0, {viewport});
+
+	VkRect2D scissor{};
+	scissor.extent = extent;
+	secondary_command_buffer.set_scissor(0, {scissor});
+
+	secondary_command_buffer.inherit_binding_state(primary_command_buffer);
+
+	if (transparent)
+	{
+		prepare_transparent_state(secondary_command_buffer);
+
+		for (size_t i = first; i < last; ++i)
+		{
+			draw_transparent_submesh(secondary_command_buffer, *nodes[i].first, *nodes[i].second, thread_index);
 		}
 	}
+	else
+	{
+		draw_opaque_nodes(secondary_command_buffer, nodes, first, last, thread_index);
+	}
+
+	secondary_command_buffer.end();
+
+	return &secondary_command_buffer;
 }
 
 void GeometrySubpass::update_uniform(CommandBuffer &command_buffer, sg::Node &node, size_t thread_index)
@@ -160,7 +514,7 @@ void GeometrySubpass::update_uniform(CommandBuffer &command_buffer, sg::Node &no
 	command_buffer.bind_buffer(allocation.get_buffer(), allocation.get_offset(), allocation.get_size(), 0, 1, 0);
 }
 
-void GeometrySubpass::draw_submesh(CommandBuffer &command_buffer, sg::SubMesh &sub_mesh, VkFrontFace front_face)
+void GeometrySubpass::draw_submesh(CommandBuffer &command_buffer, sg::SubMesh &sub_mesh, VkFrontFace front_face, uint32_t instance_count, uint32_t lod, const sg::Node *node)
 {
 	auto &device = command_buffer.get_device();
 
@@ -172,8 +526,16 @@ void GeometrySubpass::draw_submesh(CommandBuffer &command_buffer, sg::SubMesh &s
 	multisample_state.rasterization_samples = sample_count;
 	command_buffer.set_multisample_state(multisample_state);
 
-	auto &vert_shader_module = device.get_resource_cache().request_shader_module(VK_SHADER_STAGE_VERTEX_BIT, get_vertex_shader(), sub_mesh.get_shader_variant());
-	auto &frag_shader_module = device.get_resource_cache().request_shader_module(VK_SHADER_STAGE_FRAGMENT_BIT, get_fragment_shader(), sub_mesh.get_shader_variant());
+	const ShaderVariant *variant = &sub_mesh.get_shader_variant();
+	if (instance_count > 1)
+	{
+		auto it = instanced_variants.find(&sub_mesh);
+		assert(it != instanced_variants.end() && "Instanced variants are created when the instanced draws are sorted");
+		variant = &it->second;
+	}
+
+	auto &vert_shader_module = device.get_resource_cache().request_shader_module(VK_SHADER_STAGE_VERTEX_BIT, get_vertex_shader(), *variant);
+	auto &frag_shader_module = device.get_resource_cache().request_shader_module(VK_SHADER_STAGE_FRAGMENT_BIT, get_fragment_shader(), *variant);
 
 	std::vector<ShaderModule *> shader_modules{&vert_shader_module, &frag_shader_module};
 
@@ -228,22 +590,20 @@ void GeometrySubpass::draw_submesh(CommandBuffer &command_buffer, sg::SubMesh &s
 
 	command_buffer.set_vertex_input_state(vertex_input_state);
 
-	// Find submesh vertex buffers matching the shader input attribute names
+	// Find submesh vertex buffers matching the shader input attribute names, skinned vertices replace the loaded ones
 	for (auto &input_resource : vertex_input_resources)
 	{
-		const auto &buffer_iter = sub_mesh.vertex_buffers.find(input_resource.name);
-
-		if (buffer_iter != sub_mesh.vertex_buffers.end())
+		if (auto vertex_buffer = sub_mesh.find_vertex_buffer(input_resource.name, node))
 		{
 			std::vector<std::reference_wrapper<const core::Buffer>> buffers;
-			buffers.emplace_back(std::ref(buffer_iter->second));
+			buffers.emplace_back(std::cref(*vertex_buffer));
 
 			// Bind vertex buffers only for the attribute locations defined
 			command_buffer.bind_vertex_buffers(input_resource.location, std::move(buffers), {0});
 		}
 	}
 
-	draw_submesh_command(command_buffer, sub_mesh);
+	draw_submesh_command(command_buffer, sub_mesh, instance_count, lod);
 }
 
 void GeometrySubpass::prepare_pipeline_state(CommandBuffer &command_buffer, VkFrontFace front_face, bool double_sided_material)
@@ -286,15 +646,10 @@ void GeometrySubpass::prepare_push_constants(CommandBuffer &command_buffer, sg::
 	pbr_material_uniform.metallic_factor   = pbr_material->metallic_factor;
 	pbr_material_uniform.roughness_factor  = pbr_material->roughness_factor;
 
-	auto data = to_bytes(pbr_material_uniform);
-
-	if (!data.empty())
-	{
-		command_buffer.push_constants(data);
-	}
+	command_buffer.push_constants(pbr_material_uniform);
 }
 
-void GeometrySubpass::draw_submesh_command(CommandBuffer &command_buffer, sg::SubMesh &sub_mesh)
+void GeometrySubpass::draw_submesh_command(CommandBuffer &command_buffer, sg::SubMesh &sub_mesh, uint32_t instance_count, uint32_t lod)
 {
 	// Draw submesh indexed if indices exists
 	if (sub_mesh.vertex_indices != 0)
@@ -303,12 +658,13 @@ void GeometrySubpass::draw_submesh_command(CommandBuffer &command_buffer, sg::Su
 		command_buffer.bind_index_buffer(*sub_mesh.index_buffer, sub_mesh.index_offset, sub_mesh.index_type);
 
 		// Draw submesh using indexed data
-		command_buffer.draw_indexed(sub_mesh.vertex_indices, 1, 0, 0, 0);
+		auto sub_mesh_lod = sub_mesh.get_lod(lod);
+		command_buffer.draw_indexed(sub_mesh_lod.index_count, instance_count, sub_mesh_lod.first_index, 0, 0);
 	}
 	else
 	{
 		// Draw submesh using vertices only
-		command_buffer.draw(sub_mesh.vertices_count, 1, 0, 0);
+		command_buffer.draw(sub_mesh.vertices_count, instance_count, 0, 0);
 	}
 }
 
@@ -316,4 +672,50 @@ void GeometrySubpass::set_thread_index(uint32_t index)
 {
 	thread_index = index;
 }
+
+void GeometrySubpass::set_parallel_recording(JobSystem *job_system_, uint32_t command_buffer_count)
+{
+	job_system                     = job_system_;
+	recording_command_buffer_count = command_buffer_count;
+}
+
+uint32_t GeometrySubpass::get_recording_command_buffer_count() const
+{
+	return job_system ? recording_command_buffer_count : 0;
+}
+
+void GeometrySubpass::set_instancing(bool instancing_)
+{
+	instancing = instancing_;
+}
+
+bool GeometrySubpass::is_instancing_enabled() const
+{
+	return instancing;
+}
+
+uint32_t GeometrySubpass::get_draw_count() const
+{
+	return draw_count;
+}
+
+void GeometrySubpass::set_level_of_detail(bool level_of_detail_)
+{
+	level_of_detail = level_of_detail_;
+}
+
+bool GeometrySubpass::is_level_of_detail_enabled() const
+{
+	return level_of_detail;
+}
+
+uint64_t GeometrySubpass::get_triangle_count() const
+{
+	return triangle_count;
+}
+
+VkSubpassContents GeometrySubpass::get_contents() const
+{
+	return get_recording_command_buffer_count() > 0 ? VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS : VK_SUBPASS_CONTENTS_INLINE;
+}
 }        // namespace vkb
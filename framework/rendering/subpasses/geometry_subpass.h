@@ -31,11 +31,14 @@ namespace sg
 {
 class Scene;
 class Node;
+class Material;
 class Mesh;
 class SubMesh;
 class Camera;
 }        // namespace sg
 
+class JobSystem;
+
 /**
  * @brief Global uniform structure for base shader
  */
@@ -90,10 +93,57 @@ class GeometrySubpass : public Subpass
 	 */
 	void set_thread_index(uint32_t index);
 
+	/**
+	 * @brief Records the draws into secondary command buffers, as jobs of a job system.
+	 *        The opaque draws are split across command_buffer_count jobs, and the transparent
+	 *        draws are recorded by one more job.
+	 *        Without a job system or command buffers, the default, draws are recorded inline in
+	 *        the primary command buffer.
+	 *        The render context must be prepared with the thread count of the job system.
+	 * @param job_system Job system running the recording jobs
+	 * @param command_buffer_count Number of secondary command buffers recording the opaque draws
+	 */
+	void set_parallel_recording(JobSystem *job_system, uint32_t command_buffer_count);
+
+	uint32_t get_recording_command_buffer_count() const;
+
+	/**
+	 * @brief Draws the opaque instances of a submesh sharing a material and front face with a single
+	 *        instanced draw. The model matrices of the instances are written to a storage buffer at
+	 *        binding 5, which the vertex shader must read with gl_InstanceIndex when INSTANCING is defined.
+	 *        Instanced opaque draws are grouped by submesh rather than drawn front-to-back.
+	 */
+	void set_instancing(bool instancing);
+
+	bool is_instancing_enabled() const;
+
+	/**
+	 * @brief Number of draw calls recorded by the last draw, each instanced draw counting once
+	 */
+	uint32_t get_draw_count() const;
+
+	/**
+	 * @brief Draws the submeshes with levels of detail at the level matching the size of their mesh on screen.
+	 *        The level of each instance only changes once its size moved past the threshold by a margin.
+	 */
+	void set_level_of_detail(bool level_of_detail);
+
+	bool is_level_of_detail_enabled() const;
+
+	/**
+	 * @brief Number of triangles drawn by the last draw
+	 */
+	uint64_t get_triangle_count() const;
+
+	virtual VkSubpassContents get_contents() const override;
+
   protected:
 	virtual void update_uniform(CommandBuffer &command_buffer, sg::Node &node, size_t thread_index);
 
-	void draw_submesh(CommandBuffer &command_buffer, sg::SubMesh &sub_mesh, VkFrontFace front_face = VK_FRONT_FACE_COUNTER_CLOCKWISE);
+	/**
+	 * @param node Node drawn, whose deformed vertices are bound, nullptr to bind the vertices shared by all the nodes
+	 */
+	void draw_submesh(CommandBuffer &command_buffer, sg::SubMesh &sub_mesh, VkFrontFace front_face = VK_FRONT_FACE_COUNTER_CLOCKWISE, uint32_t instance_count = 1, uint32_t lod = 0, const sg::Node *node = nullptr);
 
 	virtual void prepare_pipeline_state(CommandBuffer &command_buffer, VkFrontFace front_face, bool double_sided_material);
 
@@ -101,24 +151,157 @@ class GeometrySubpass : public Subpass
 
 	virtual void prepare_push_constants(CommandBuffer &command_buffer, sg::SubMesh &sub_mesh);
 
-	virtual void draw_submesh_command(CommandBuffer &command_buffer, sg::SubMesh &sub_mesh);
+	virtual void draw_submesh_command(CommandBuffer &command_buffer, sg::SubMesh &sub_mesh, uint32_t instance_count, uint32_t lod);
+
+	/**
+	 * @brief Sorts the objects visible from the camera and classifies them into opaque and transparent
+	 *        in the arrays provided, which are cleared first.
+	 *        Opaque objects are grouped by shader variant, front face and material, and drawn front-to-back
+	 *        within each group. Transparent objects are drawn back-to-front.
+	 */
+	void get_sorted_nodes(std::vector<std::pair<sg::Node *, sg::SubMesh *>> &opaque_nodes,
+	                      std::vector<std::pair<sg::Node *, sg::SubMesh *>> &transparent_nodes);
+
+	/**
+	 * @brief Draws an opaque submesh, inverting the front face if the node was flipped
+	 */
+	void draw_opaque_submesh(CommandBuffer &command_buffer, sg::Node &node, sg::SubMesh &sub_mesh, size_t thread_index);
+
+	/**
+	 * @brief Draws a transparent submesh
+	 */
+	void draw_transparent_submesh(CommandBuffer &command_buffer, sg::Node &node, sg::SubMesh &sub_mesh, size_t thread_index);
+
+	/**
+	 * @brief Gets the level of detail to draw a submesh of a node with, selected by the last sort
+	 */
+	virtual uint32_t get_lod(const sg::Node &node, const sg::SubMesh &sub_mesh) const;
+
+	/**
+	 * @brief Draws a range of the sorted opaque nodes, with instanced draws if instancing is enabled
+	 */
+	void draw_opaque_nodes(CommandBuffer &command_buffer, const std::vector<std::pair<sg::Node *, sg::SubMesh *>> &nodes,
+	                       size_t first, size_t last, size_t thread_index);
+
+	/**
+	 * @brief Sets the alpha blending and depth state used to draw transparent objects
+	 */
+	void prepare_transparent_state(CommandBuffer &command_buffer);
 
 	/**
-	 * @brief Sorts objects based on distance from camera and classifies them
-	 *        into opaque and transparent in the arrays provided
+	 * @brief Records a range of the sorted nodes into a secondary command buffer
+	 * @param primary_command_buffer Primary command buffer the secondary one continues
+	 * @param nodes Sorted nodes and submeshes to draw
+	 * @param first Index of the first node to draw
+	 * @param last Index past the last node to draw
+	 * @param transparent Whether the nodes are drawn with alpha blending
+	 * @param thread_index Thread index to use for allocating resources
+	 * @return The recorded secondary command buffer
 	 */
-	void get_sorted_nodes(std::multimap<float, std::pair<sg::Node *, sg::SubMesh *>> &opaque_nodes,
-	                      std::multimap<float, std::pair<sg::Node *, sg::SubMesh *>> &transparent_nodes);
+	CommandBuffer *record_draws_secondary(CommandBuffer &primary_command_buffer, const std::vector<std::pair<sg::Node *, sg::SubMesh *>> &nodes,
+	                                      size_t first, size_t last, bool transparent, size_t thread_index);
 
 	sg::Camera &camera;
 
-	std::vector<sg::Mesh *> meshes;
+	// Meshes of the scene, kept up to date by the scene as meshes are added
+	const std::vector<sg::Mesh *> &meshes;
 
 	sg::Scene &scene;
 
 	uint32_t thread_index{0};
 
 	vkb::RasterizationState base_rasterization_state{};
+
+  private:
+	/**
+	 * @brief A draw of the sorted nodes, ordered by its key
+	 *
+	 *        From the most significant bit: whether the draw is transparent, then for opaque draws
+	 *        the shader variant, the front face, the material and the distance to the camera, or the
+	 *        level of detail and the submesh if instancing is enabled.
+	 *        Transparent draws only use the inverted distance to the camera.
+	 */
+	struct DrawKey
+	{
+		uint64_t key;
+
+		uint32_t draw_index;
+	};
+
+	/**
+	 * @brief Splits the opaque draws across the recording jobs, and records the
+	 *        transparent draws in a single secondary command buffer to keep their order
+	 */
+	void draw_secondary(CommandBuffer &primary_command_buffer,
+	                    const std::vector<std::pair<sg::Node *, sg::SubMesh *>> &opaque_nodes,
+	                    const std::vector<std::pair<sg::Node *, sg::SubMesh *>> &transparent_nodes);
+
+	/**
+	 * @brief Small index identifying a shader variant or a material in the draw keys
+	 */
+	template <class T>
+	uint32_t get_sort_index(std::unordered_map<T, uint32_t> &indices, const T &value);
+
+	/**
+	 * @brief Finds the end of the instances drawn along with the first node of a range
+	 * @return Index past the last node drawn by the same instanced draw, first + 1 without instancing
+	 */
+	size_t get_instances_end(const std::vector<std::pair<sg::Node *, sg::SubMesh *>> &nodes, size_t first, size_t last) const;
+
+	/**
+	 * @brief Selects the level of detail of the mesh of a node from its size on screen
+	 * @param node Node instancing the mesh
+	 * @param mesh Mesh of the node
+	 * @param distance Distance from the camera to the center of the mesh bounds
+	 * @param projection Projection matrix of the camera
+	 */
+	uint32_t select_lod(sg::Node &node, const sg::Mesh &mesh, float distance, const glm::mat4 &projection);
+
+	/**
+	 * @brief Gets the shader variant of a submesh with INSTANCING defined, creating it on first use
+	 */
+	const ShaderVariant &request_instanced_variant(const sg::SubMesh &sub_mesh);
+
+	/**
+	 * @brief Draws the opaque instances of a submesh with one instanced draw
+	 */
+	void draw_opaque_instances(CommandBuffer &command_buffer, const std::vector<std::pair<sg::Node *, sg::SubMesh *>> &nodes,
+	                           size_t first, size_t last, size_t thread_index);
+
+	JobSystem *job_system{nullptr};
+
+	// Storage of the draw sorting, kept across frames to avoid allocating it every frame
+	std::vector<std::pair<sg::Node *, sg::SubMesh *>> draws;
+
+	std::vector<DrawKey> draw_keys;
+
+	std::vector<DrawKey> sorted_draw_keys;
+
+	std::vector<std::pair<sg::Node *, sg::SubMesh *>> sorted_opaque_nodes;
+
+	std::vector<std::pair<sg::Node *, sg::SubMesh *>> sorted_transparent_nodes;
+
+	std::unordered_map<size_t, uint32_t> variant_indices;
+
+	std::unordered_map<const sg::Material *, uint32_t> material_indices;
+
+	std::unordered_map<const sg::SubMesh *, uint32_t> sub_mesh_indices;
+
+	// Shader variants of the submeshes with INSTANCING defined, created on the first instanced draw of each submesh
+	std::unordered_map<const sg::SubMesh *, ShaderVariant> instanced_variants;
+
+	bool instancing{false};
+
+	uint32_t draw_count{0};
+
+	bool level_of_detail{false};
+
+	// Level of detail of the visible nodes, kept across frames for the hysteresis
+	std::unordered_map<const sg::Node *, uint32_t> node_lods;
+
+	uint64_t triangle_count{0};
+
+	uint32_t recording_command_buffer_count{0};
 };
 
 }        // namespace vkb
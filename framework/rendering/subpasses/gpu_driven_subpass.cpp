@@ -0,0 +1,581 @@
+/* Copyright (c) 2023, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "rendering/subpasses/gpu_driven_subpass.h"
+
+#include <limits>
+#include <map>
+#include <tuple>
+
+#include "common/utils.h"
+#include "common/vk_common.h"
+#include "geometry/frustum.h"
+#include "rendering/render_context.h"
+#include "scene_graph/components/camera.h"
+#include "scene_graph/components/image.h"
+#include "scene_graph/components/material.h"
+#include "scene_graph/components/mesh.h"
+#include "scene_graph/components/pbr_material.h"
+#include "scene_graph/components/sub_mesh.h"
+#include "scene_graph/components/texture.h"
+#include "scene_graph/node.h"
+#include "scene_graph/scene.h"
+
+namespace vkb
+{
+namespace
+{
+/**
+ * @brief Location of a submesh in the shared vertex and index buffers
+ */
+struct PackedSubMesh
+{
+	uint32_t first_index;
+
+	uint32_t index_count;
+
+	int32_t vertex_offset;
+};
+
+bool has_attribute_format(const sg::SubMesh &sub_mesh, const std::string &name, VkFormat format, uint32_t stride)
+{
+	sg::VertexAttribute attribute;
+	return sub_mesh.get_attribute(name, attribute) && attribute.format == format && attribute.stride == stride && attribute.offset == 0;
+}
+}        // namespace
+
+GPUDrivenSubpass::GPUDrivenSubpass(RenderContext &render_context, ShaderSource &&vertex_source, ShaderSource &&fragment_source, ShaderSource &&cull_source, sg::Scene &scene_, sg::Camera &camera) :
+    ForwardSubpass{render_context, std::move(vertex_source), std::move(fragment_source), scene_, camera},
+    cull_shader{std::move(cull_source)}
+{
+}
+
+void GPUDrivenSubpass::prepare()
+{
+	auto &device = render_context.get_device();
+
+	auto requested_features = device.get_gpu().get_requested_features();
+	if (!requested_features.drawIndirectFirstInstance)
+	{
+		throw std::runtime_error("GPU-driven subpass requires the drawIndirectFirstInstance feature");
+	}
+	multi_draw_indirect = requested_features.multiDrawIndirect;
+
+	pack_meshes();
+
+	// Build all shader variance upfront
+	device.get_resource_cache().request_shader_module(VK_SHADER_STAGE_COMPUTE_BIT, cull_shader);
+	for (auto &batch : batches)
+	{
+		device.get_resource_cache().request_shader_module(VK_SHADER_STAGE_VERTEX_BIT, get_vertex_shader(), batch.variant);
+		device.get_resource_cache().request_shader_module(VK_SHADER_STAGE_FRAGMENT_BIT, get_fragment_shader(), batch.variant);
+	}
+}
+
+void GPUDrivenSubpass::pack_meshes()
+{
+	auto &device = render_context.get_device();
+
+	std::vector<glm::vec3> positions;
+	std::vector<glm::vec3> normals;
+	std::vector<glm::vec2> texcoords;
+	std::vector<uint32_t>  indices;
+
+	std::unordered_map<const sg::SubMesh *, PackedSubMesh> packed_sub_meshes;
+
+	// Append the geometry of every submesh to the shared buffers, converting indices to 32-bit
+	for (auto &mesh : meshes)
+	{
+		for (auto &sub_mesh : mesh->get_submeshes())
+		{
+			if (!has_attribute_format(*sub_mesh, "position", VK_FORMAT_R32G32B32_SFLOAT, sizeof(glm::vec3)))
+			{
+				LOGW("Skipping '{}' in GPU-driven subpass: unsupported position format", sub_mesh->get_name());
+				continue;
+			}
+
+			auto sub_mesh_positions = core::Buffer::copy<glm::vec3>(sub_mesh->vertex_buffers, "position");
+			auto vertex_count       = sub_mesh_positions.size();
+
+			std::vector<glm::vec3> sub_mesh_normals;
+			if (has_attribute_format(*sub_mesh, "normal", VK_FORMAT_R32G32B32_SFLOAT, sizeof(glm::vec3)))
+			{
+				sub_mesh_normals = core::Buffer::copy<glm::vec3>(sub_mesh->vertex_buffers, "normal");
+			}
+			sub_mesh_normals.resize(vertex_count, glm::vec3(0.0f, 0.0f, 1.0f));
+
+			std::vector<glm::vec2> sub_mesh_texcoords;
+			if (has_attribute_format(*sub_mesh, "texcoord_0", VK_FORMAT_R32G32_SFLOAT, sizeof(glm::vec2)))
+			{
+				sub_mesh_texcoords = core::Buffer::copy<glm::vec2>(sub_mesh->vertex_buffers, "texcoord_0");
+			}
+			sub_mesh_texcoords.resize(vertex_count, glm::vec2(0.0f));
+
+			PackedSubMesh packed{};
+			packed.first_index   = to_u32(indices.size());
+			packed.vertex_offset = static_cast<int32_t>(positions.size());
+
+			if (sub_mesh->vertex_indices != 0 && sub_mesh->index_buffer)
+			{
+				auto &sub_mesh_index_buffer = *sub_mesh->index_buffer;
+
+				const bool already_mapped = sub_mesh_index_buffer.get_data() != nullptr;
+				if (!already_mapped)
+				{
+					sub_mesh_index_buffer.map();
+				}
+
+				const uint8_t *index_data = sub_mesh_index_buffer.get_data() + sub_mesh->index_offset;
+				for (uint32_t i = 0; i < sub_mesh->vertex_indices; ++i)
+				{
+					if (sub_mesh->index_type == VK_INDEX_TYPE_UINT16)
+					{
+						indices.push_back(reinterpret_cast<const uint16_t *>(index_data)[i]);
+					}
+					else
+					{
+						indices.push_back(reinterpret_cast<const uint32_t *>(index_data)[i]);
+					}
+				}
+
+				if (!already_mapped)
+				{
+					sub_mesh_index_buffer.unmap();
+				}
+			}
+			else
+			{
+				for (uint32_t i = 0; i < sub_mesh->vertices_count; ++i)
+				{
+					indices.push_back(i);
+				}
+			}
+
+			packed.index_count = to_u32(indices.size()) - packed.first_index;
+
+			positions.insert(positions.end(), sub_mesh_positions.begin(), sub_mesh_positions.end());
+			normals.insert(normals.end(), sub_mesh_normals.begin(), sub_mesh_normals.end());
+			texcoords.insert(texcoords.end(), sub_mesh_texcoords.begin(), sub_mesh_texcoords.end());
+
+			packed_sub_meshes.emplace(sub_mesh, packed);
+		}
+	}
+
+	// Group the instances by submesh and front face (one indirect command each),
+	// and the commands by material and shader variant (one batch each)
+	using BatchKey   = std::tuple<bool, const sg::Material *, size_t, VkFrontFace>;
+	using CommandKey = std::pair<sg::SubMesh *, VkFrontFace>;
+
+	std::map<BatchKey, std::map<CommandKey, std::vector<uint32_t>>> batch_commands;
+
+	instances.clear();
+	instance_nodes.clear();
+
+	for (auto &mesh : meshes)
+	{
+		const auto &bounds = mesh->get_bounds();
+
+		// Meshes without valid bounds are never culled
+		glm::vec4 bounding_sphere{0.0f, 0.0f, 0.0f, std::numeric_limits<float>::max()};
+		if (glm::all(glm::lessThanEqual(bounds.get_min(), bounds.get_max())))
+		{
+			bounding_sphere = glm::vec4(bounds.get_center(), glm::length(bounds.get_scale()) * 0.5f);
+		}
+
+		for (auto &node : mesh->get_nodes())
+		{
+			auto model = node->get_transform().get_world_matrix();
+
+			// Invert the front face if the mesh was flipped
+			VkFrontFace front_face = glm::determinant(glm::mat3(model)) < 0.0f ? VK_FRONT_FACE_CLOCKWISE : VK_FRONT_FACE_COUNTER_CLOCKWISE;
+
+			for (auto &sub_mesh : mesh->get_submeshes())
+			{
+				if (packed_sub_meshes.find(sub_mesh) == packed_sub_meshes.end())
+				{
+					continue;
+				}
+
+				auto material    = sub_mesh->get_material();
+				bool transparent = material->alpha_mode == sg::AlphaMode::Blend;
+
+				auto &command_instances = batch_commands[BatchKey{transparent, material, sub_mesh->get_shader_variant().get_id(), front_face}][CommandKey{sub_mesh, front_face}];
+				command_instances.push_back(to_u32(instances.size()));
+
+				GPUDrivenInstance instance{};
+				instance.model           = model;
+				instance.bounding_sphere = bounding_sphere;
+
+				instances.push_back(instance);
+				instance_nodes.push_back(node);
+			}
+		}
+	}
+
+	// Lay out the commands of each batch contiguously, opaque batches first,
+	// reserving a range of the visible instance buffer for each command
+	std::vector<VkDrawIndexedIndirectCommand> commands;
+
+	batches.clear();
+
+	uint32_t first_instance = 0;
+
+	for (auto &batch_it : batch_commands)
+	{
+		Batch batch;
+		batch.transparent   = std::get<0>(batch_it.first);
+		batch.front_face    = std::get<3>(batch_it.first);
+		batch.sub_mesh      = batch_it.second.begin()->first.first;
+		batch.first_command = to_u32(commands.size());
+		batch.command_count = to_u32(batch_it.second.size());
+
+		// Same as Forward except the definitions are added to a copy of the sub mesh variant
+		batch.variant = batch.sub_mesh->get_shader_variant();
+		add_lighting_definitions(batch.variant);
+
+		for (auto &command_it : batch_it.second)
+		{
+			const auto &packed = packed_sub_meshes.at(command_it.first.first);
+
+			VkDrawIndexedIndirectCommand command{};
+			command.indexCount    = packed.index_count;
+			command.instanceCount = 0;
+			command.firstIndex    = packed.first_index;
+			command.vertexOffset  = packed.vertex_offset;
+			command.firstInstance = first_instance;
+
+			for (auto instance_index : command_it.second)
+			{
+				instances[instance_index].command_index = to_u32(commands.size());
+			}
+
+			first_instance += to_u32(command_it.second.size());
+
+			commands.push_back(command);
+		}
+
+		batches.push_back(std::move(batch));
+	}
+
+	command_count = to_u32(commands.size());
+
+	frame_resources.clear();
+
+	if (commands.empty())
+	{
+		return;
+	}
+
+	// Upload the shared buffers
+	auto &queue          = device.get_queue_by_flags(VK_QUEUE_GRAPHICS_BIT, 0);
+	auto &command_buffer = device.request_command_buffer();
+
+	command_buffer.begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+
+	std::vector<core::Buffer> staging_buffers;
+
+	auto upload = [&](const void *data, size_t size, VkBufferUsageFlags usage) {
+		core::Buffer stage_buffer{device, size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VMA_MEMORY_USAGE_CPU_ONLY};
+		stage_buffer.update(static_cast<const uint8_t *>(data), size);
+
+		auto buffer = std::make_unique<core::Buffer>(device, size, usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VMA_MEMORY_USAGE_GPU_ONLY);
+		command_buffer.copy_buffer(stage_buffer, *buffer, size);
+
+		staging_buffers.push_back(std::move(stage_buffer));
+		return buffer;
+	};
+
+	position_buffer         = upload(positions.data(), positions.size() * sizeof(glm::vec3), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
+	normal_buffer           = upload(normals.data(), normals.size() * sizeof(glm::vec3), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
+	texcoord_buffer         = upload(texcoords.data(), texcoords.size() * sizeof(glm::vec2), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
+	index_buffer            = upload(indices.data(), indices.size() * sizeof(uint32_t), VK_BUFFER_USAGE_INDEX_BUFFER_BIT);
+	command_template_buffer = upload(commands.data(), commands.size() * sizeof(VkDrawIndexedIndirectCommand), VK_BUFFER_USAGE_TRANSFER_SRC_BIT);
+
+	command_buffer.end();
+
+	queue.submit(command_buffer, device.request_fence());
+
+	device.get_fence_pool().wait();
+	device.get_fence_pool().reset();
+	device.get_command_pool().reset_pool();
+
+	LOGI("GPU-driven subpass packed {} vertices, {} indices, {} instances into {} commands and {} batches",
+	     positions.size(), indices.size(), instances.size(), commands.size(), batches.size());
+}
+
+void GPUDrivenSubpass::update_instances(FrameResources &frame)
+{
+	if (frame.instances_uploaded && !dynamic_transforms)
+	{
+		return;
+	}
+
+	if (dynamic_transforms)
+	{
+		for (size_t i = 0; i < instances.size(); ++i)
+		{
+			instances[i].model = instance_nodes[i]->get_transform().get_world_matrix();
+		}
+	}
+
+	frame.instance_buffer->update(reinterpret_cast<const uint8_t *>(instances.data()), instances.size() * sizeof(GPUDrivenInstance));
+	frame.instances_uploaded = true;
+}
+
+void GPUDrivenSubpass::pre_draw(CommandBuffer &command_buffer)
+{
+	if (command_count == 0)
+	{
+		return;
+	}
+
+	auto &device = command_buffer.get_device();
+
+	frame_resources.resize(render_context.get_render_frames().size());
+	auto &frame = frame_resources[render_context.get_active_frame_index()];
+
+	const VkDeviceSize instance_size       = instances.size() * sizeof(GPUDrivenInstance);
+	const VkDeviceSize command_size        = command_count * sizeof(VkDrawIndexedIndirectCommand);
+	const VkDeviceSize visible_buffer_size = instances.size() * sizeof(uint32_t);
+
+	if (!frame.instance_buffer)
+	{
+		frame.instance_buffer = std::make_unique<core::Buffer>(device, instance_size,
+		                                                       VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+		                                                       VMA_MEMORY_USAGE_CPU_TO_GPU);
+
+		frame.command_buffer = std::make_unique<core::Buffer>(device, command_size,
+		                                                      VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+		                                                      VMA_MEMORY_USAGE_GPU_ONLY);
+
+		frame.visible_instance_buffer = std::make_unique<core::Buffer>(device, visible_buffer_size,
+		                                                               VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+		                                                               VMA_MEMORY_USAGE_GPU_ONLY);
+	}
+
+	update_instances(frame);
+
+	ScopedDebugLabel cull_debug_label{command_buffer, "GPU-driven culling"};
+
+	// Reset the instance counts of the commands
+	command_buffer.copy_buffer(*command_template_buffer, *frame.command_buffer, command_size);
+
+	{
+		BufferMemoryBarrier barrier{};
+		barrier.src_stage_mask  = VK_PIPELINE_STAGE_TRANSFER_BIT;
+		barrier.dst_stage_mask  = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+		barrier.src_access_mask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dst_access_mask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+		command_buffer.buffer_memory_barrier(*frame.command_buffer, 0, command_size, barrier);
+	}
+
+	auto &resource_cache  = device.get_resource_cache();
+	auto &shader_module   = resource_cache.request_shader_module(VK_SHADER_STAGE_COMPUTE_BIT, cull_shader);
+	auto &pipeline_layout = resource_cache.request_pipeline_layout({&shader_module});
+
+	command_buffer.bind_pipeline_layout(pipeline_layout);
+
+	Frustum frustum;
+	frustum.update(camera.get_pre_rotation() * vkb::vulkan_style_projection(camera.get_projection()) * camera.get_view());
+
+	GPUDrivenCullUniform cull_uniform{};
+	std::copy(frustum.get_planes().begin(), frustum.get_planes().end(), cull_uniform.frustum_planes);
+	cull_uniform.instance_count = to_u32(instances.size());
+
+	auto allocation = render_context.get_active_frame().allocate_buffer(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, sizeof(GPUDrivenCullUniform), thread_index);
+	allocation.update(cull_uniform);
+
+	command_buffer.bind_buffer(*frame.instance_buffer, 0, instance_size, 0, 0, 0);
+	command_buffer.bind_buffer(allocation.get_buffer(), allocation.get_offset(), allocation.get_size(), 0, 1, 0);
+	command_buffer.bind_buffer(*frame.command_buffer, 0, command_size, 0, 2, 0);
+	command_buffer.bind_buffer(*frame.visible_instance_buffer, 0, visible_buffer_size, 0, 3, 0);
+
+	command_buffer.dispatch((to_u32(instances.size()) + 63) / 64, 1, 1);
+
+	{
+		BufferMemoryBarrier barrier{};
+		barrier.src_stage_mask  = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+		barrier.dst_stage_mask  = VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT;
+		barrier.src_access_mask = VK_ACCESS_SHADER_WRITE_BIT;
+		barrier.dst_access_mask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+
+		command_buffer.buffer_memory_barrier(*frame.command_buffer, 0, command_size, barrier);
+
+		barrier.dst_stage_mask  = VK_PIPELINE_STAGE_VERTEX_SHADER_BIT;
+		barrier.dst_access_mask = VK_ACCESS_SHADER_READ_BIT;
+
+		command_buffer.buffer_memory_barrier(*frame.visible_instance_buffer, 0, visible_buffer_size, barrier);
+	}
+}
+
+void GPUDrivenSubpass::draw(CommandBuffer &command_buffer)
+{
+	if (command_count == 0)
+	{
+		return;
+	}
+
+	auto frame_index = render_context.get_active_frame_index();
+	assert(frame_index < frame_resources.size() && "Culling must be recorded with pre_draw before drawing");
+
+	auto &frame = frame_resources[frame_index];
+
+	bind_lights(command_buffer);
+
+	// The model matrices are read from the instance buffer
+	GlobalUniform global_uniform;
+	global_uniform.model            = glm::mat4(1.0f);
+	global_uniform.camera_view_proj = camera.get_pre_rotation() * vkb::vulkan_style_projection(camera.get_projection()) * camera.get_view();
+	global_uniform.camera_position  = glm::vec3(glm::inverse(camera.get_view())[3]);
+
+	auto allocation = render_context.get_active_frame().allocate_buffer(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, sizeof(GlobalUniform), thread_index);
+	allocation.update(global_uniform);
+
+	command_buffer.bind_buffer(allocation.get_buffer(), allocation.get_offset(), allocation.get_size(), 0, 1, 0);
+	command_buffer.bind_buffer(*frame.instance_buffer, 0, frame.instance_buffer->get_size(), 0, 5, 0);
+	command_buffer.bind_buffer(*frame.visible_instance_buffer, 0, frame.visible_instance_buffer->get_size(), 0, 6, 0);
+
+	VertexInputState vertex_input_state;
+	vertex_input_state.bindings   = {{0, sizeof(glm::vec3), VK_VERTEX_INPUT_RATE_VERTEX},
+	                                 {1, sizeof(glm::vec2), VK_VERTEX_INPUT_RATE_VERTEX},
+	                                 {2, sizeof(glm::vec3), VK_VERTEX_INPUT_RATE_VERTEX}};
+	vertex_input_state.attributes = {{0, 0, VK_FORMAT_R32G32B32_SFLOAT, 0},
+	                                 {1, 1, VK_FORMAT_R32G32_SFLOAT, 0},
+	                                 {2, 2, VK_FORMAT_R32G32B32_SFLOAT, 0}};
+	command_buffer.set_vertex_input_state(vertex_input_state);
+
+	std::vector<std::reference_wrapper<const core::Buffer>> buffers{std::cref(*position_buffer), std::cref(*texcoord_buffer), std::cref(*normal_buffer)};
+	command_buffer.bind_vertex_buffers(0, std::move(buffers), {0, 0, 0});
+	command_buffer.bind_index_buffer(*index_buffer, 0, VK_INDEX_TYPE_UINT32);
+
+	// Batches are ordered with the opaque ones first. Transparent instances
+	// are not sorted by distance, as their order is decided by the GPU
+	auto first_transparent = std::find_if(batches.begin(), batches.end(), [](const Batch &batch) { return batch.transparent; });
+
+	{
+		ScopedDebugLabel opaque_debug_label{command_buffer, "Opaque objects"};
+
+		for (auto batch_it = batches.begin(); batch_it != first_transparent; ++batch_it)
+		{
+			draw_batch(command_buffer, *batch_it, *frame.command_buffer);
+		}
+	}
+
+	if (first_transparent == batches.end())
+	{
+		return;
+	}
+
+	// Enable alpha blending
+	ColorBlendAttachmentState color_blend_attachment{};
+	color_blend_attachment.blend_enable           = VK_TRUE;
+	color_blend_attachment.src_color_blend_factor = VK_BLEND_FACTOR_SRC_ALPHA;
+	color_blend_attachment.dst_color_blend_factor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+	color_blend_attachment.src_alpha_blend_factor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+
+	ColorBlendState color_blend_state{};
+	color_blend_state.attachments.resize(get_output_attachments().size());
+	for (auto &it : color_blend_state.attachments)
+	{
+		it = color_blend_attachment;
+	}
+	command_buffer.set_color_blend_state(color_blend_state);
+
+	command_buffer.set_depth_stencil_state(get_depth_stencil_state());
+
+	{
+		ScopedDebugLabel transparent_debug_label{command_buffer, "Transparent objects"};
+
+		for (auto batch_it = first_transparent; batch_it != batches.end(); ++batch_it)
+		{
+			draw_batch(command_buffer, *batch_it, *frame.command_buffer);
+		}
+	}
+}
+
+void GPUDrivenSubpass::draw_batch(CommandBuffer &command_buffer, const Batch &batch, const core::Buffer &indirect_buffer)
+{
+	auto &device = command_buffer.get_device();
+
+	prepare_pipeline_state(command_buffer, batch.front_face, batch.sub_mesh->get_material()->double_sided);
+
+	auto &vert_shader_module = device.get_resource_cache().request_shader_module(VK_SHADER_STAGE_VERTEX_BIT, get_vertex_shader(), batch.variant);
+	auto &frag_shader_module = device.get_resource_cache().request_shader_module(VK_SHADER_STAGE_FRAGMENT_BIT, get_fragment_shader(), batch.variant);
+
+	std::vector<ShaderModule *> shader_modules{&vert_shader_module, &frag_shader_module};
+
+	auto &pipeline_layout = prepare_pipeline_layout(command_buffer, shader_modules);
+
+	command_buffer.bind_pipeline_layout(pipeline_layout);
+
+	if (pipeline_layout.get_push_constant_range_stage(sizeof(PBRMaterialUniform)) != 0)
+	{
+		prepare_push_constants(command_buffer, *batch.sub_mesh);
+	}
+
+	DescriptorSetLayout &descriptor_set_layout = pipeline_layout.get_descriptor_set_layout(0);
+
+	for (auto &texture : batch.sub_mesh->get_material()->textures)
+	{
+		if (auto layout_binding = descriptor_set_layout.get_layout_binding(texture.first))
+		{
+			command_buffer.bind_image(texture.second->get_image()->get_vk_image_view(),
+			                          texture.second->get_sampler()->vk_sampler,
+			                          0, layout_binding->binding, 0);
+		}
+	}
+
+	const uint32_t stride = sizeof(VkDrawIndexedIndirectCommand);
+
+	if (multi_draw_indirect)
+	{
+		command_buffer.draw_indexed_indirect(indirect_buffer, batch.first_command * stride, batch.command_count, stride);
+	}
+	else
+	{
+		for (uint32_t i = 0; i < batch.command_count; ++i)
+		{
+			command_buffer.draw_indexed_indirect(indirect_buffer, (batch.first_command + i) * stride, 1, stride);
+		}
+	}
+}
+
+void GPUDrivenSubpass::set_dynamic_transforms(bool dynamic)
+{
+	if (dynamic_transforms && !dynamic)
+	{
+		// Upload the final transforms once more for every frame
+		for (auto &frame : frame_resources)
+		{
+			frame.instances_uploaded = false;
+		}
+	}
+
+	dynamic_transforms = dynamic;
+}
+
+uint32_t GPUDrivenSubpass::get_instance_count() const
+{
+	return to_u32(instances.size());
+}
+
+uint32_t GPUDrivenSubpass::get_indirect_draw_count() const
+{
+	return multi_draw_indirect ? to_u32(batches.size()) : command_count;
+}
+}        // namespace vkb
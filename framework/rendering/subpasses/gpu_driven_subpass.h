@@ -0,0 +1,179 @@
+/* Copyright (c) 2023, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "rendering/subpasses/forward_subpass.h"
+
+namespace vkb
+{
+namespace sg
+{
+class Scene;
+class Node;
+class SubMesh;
+class Camera;
+}        // namespace sg
+
+/**
+ * @brief Per-instance data read by the culling and vertex shaders
+ */
+struct alignas(16) GPUDrivenInstance
+{
+	glm::mat4 model;
+
+	// xyz: center of the mesh bounding sphere in model space, w: radius
+	glm::vec4 bounding_sphere;
+
+	uint32_t command_index;
+
+	uint32_t padding[3];
+};
+
+/**
+ * @brief Culling uniform for the GPU-driven culling shader
+ */
+struct alignas(16) GPUDrivenCullUniform
+{
+	glm::vec4 frustum_planes[6];
+
+	uint32_t instance_count;
+};
+
+/**
+ * @brief This subpass renders a Scene with GPU generated indirect draws
+ *
+ *        On prepare, all the submeshes of the scene are packed into shared vertex and
+ *        index buffers, and an indirect command is created for each submesh and front face
+ *        pair. Every frame a compute shader culls the node instances against the camera
+ *        frustum and fills the instance counts of the commands, which are then drawn with
+ *        one draw_indexed_indirect call per material batch.
+ *
+ *        Requires the drawIndirectFirstInstance feature. If multiDrawIndirect is not
+ *        enabled, each command of a batch is drawn with its own indirect call.
+ */
+class GPUDrivenSubpass : public ForwardSubpass
+{
+  public:
+	/**
+	 * @brief Constructs a subpass for GPU-driven forward rendering
+	 * @param render_context Render context
+	 * @param vertex_shader Vertex shader source, reading instances from the visible instance buffer
+	 * @param fragment_shader Fragment shader source
+	 * @param cull_shader Compute shader source used to cull instances and fill the indirect commands
+	 * @param scene Scene to render on this subpass
+	 * @param camera Camera used to look at the scene
+	 */
+	GPUDrivenSubpass(RenderContext &render_context, ShaderSource &&vertex_shader, ShaderSource &&fragment_shader, ShaderSource &&cull_shader, sg::Scene &scene, sg::Camera &camera);
+
+	virtual ~GPUDrivenSubpass() = default;
+
+	virtual void prepare() override;
+
+	/**
+	 * @brief Uploads the instances and records the culling dispatch
+	 */
+	virtual void pre_draw(CommandBuffer &command_buffer) override;
+
+	/**
+	 * @brief Record draw commands
+	 */
+	virtual void draw(CommandBuffer &command_buffer) override;
+
+	/**
+	 * @brief Whether node transforms are uploaded every frame, or only once after prepare
+	 */
+	void set_dynamic_transforms(bool dynamic);
+
+	/**
+	 * @brief Number of node and submesh instances submitted to the GPU culling
+	 */
+	uint32_t get_instance_count() const;
+
+	/**
+	 * @brief Number of indirect draw calls recorded per frame
+	 */
+	uint32_t get_indirect_draw_count() const;
+
+  private:
+	/**
+	 * @brief A group of indirect commands sharing material and pipeline state
+	 */
+	struct Batch
+	{
+		sg::SubMesh *sub_mesh{nullptr};
+
+		ShaderVariant variant;
+
+		VkFrontFace front_face{VK_FRONT_FACE_COUNTER_CLOCKWISE};
+
+		bool transparent{false};
+
+		uint32_t first_command{0};
+
+		uint32_t command_count{0};
+	};
+
+	/**
+	 * @brief Buffers written every frame, one set per render frame
+	 */
+	struct FrameResources
+	{
+		std::unique_ptr<core::Buffer> instance_buffer;
+
+		std::unique_ptr<core::Buffer> command_buffer;
+
+		std::unique_ptr<core::Buffer> visible_instance_buffer;
+
+		bool instances_uploaded{false};
+	};
+
+	void pack_meshes();
+
+	void update_instances(FrameResources &frame_resources);
+
+	void draw_batch(CommandBuffer &command_buffer, const Batch &batch, const core::Buffer &indirect_buffer);
+
+	ShaderSource cull_shader;
+
+	std::unique_ptr<core::Buffer> position_buffer;
+
+	std::unique_ptr<core::Buffer> normal_buffer;
+
+	std::unique_ptr<core::Buffer> texcoord_buffer;
+
+	std::unique_ptr<core::Buffer> index_buffer;
+
+	// Commands with zero instance count, copied over the frame commands before culling
+	std::unique_ptr<core::Buffer> command_template_buffer;
+
+	std::vector<FrameResources> frame_resources;
+
+	std::vector<Batch> batches;
+
+	std::vector<sg::Node *> instance_nodes;
+
+	std::vector<GPUDrivenInstance> instances;
+
+	uint32_t command_count{0};
+
+	bool dynamic_transforms{false};
+
+	bool multi_draw_indirect{false};
+};
+
+}        // namespace vkb
@@ -36,6 +36,12 @@ void LightingSubpass::prepare()
 	lighting_variant.add_definitions({"MAX_LIGHT_COUNT " + std::to_string(MAX_DEFERRED_LIGHT_COUNT)});
 
 	lighting_variant.add_definitions(light_type_definitions);
+
+	if (clustered_lighting)
+	{
+		lighting_variant.add_define("CLUSTERED_LIGHTING");
+	}
+
 	// Build all shaders upfront
 	auto &resource_cache = render_context.get_device().get_resource_cache();
 	resource_cache.request_shader_module(VK_SHADER_STAGE_VERTEX_BIT, get_vertex_shader(), lighting_variant);
@@ -44,7 +50,20 @@ void LightingSubpass::prepare()
 
 void LightingSubpass::draw(CommandBuffer &command_buffer)
 {
-	allocate_lights<DeferredLights>(scene.get_components<sg::Light>(), MAX_DEFERRED_LIGHT_COUNT);
+	auto &scene_lights = scene.get_component_view<sg::Light>();
+
+	if (clustered_lighting)
+	{
+		// Only the directional lights are left to the uniform light arrays
+		allocate_lights<DeferredLights>(ClusteredLighting::get_directional_lights(scene_lights), MAX_DEFERRED_LIGHT_COUNT);
+
+		clustered_lighting->update(scene_lights, camera, get_render_context().get_active_frame().get_render_target().get_extent());
+		clustered_lighting->bind(command_buffer, 1);
+	}
+	else
+	{
+		allocate_lights<DeferredLights>(scene_lights, MAX_DEFERRED_LIGHT_COUNT);
+	}
 	command_buffer.bind_lighting(get_lighting_state(), 0, 4);
 
 	// Get shaders from cache
@@ -58,20 +77,20 @@ void LightingSubpass::draw(CommandBuffer &command_buffer)
 	auto &pipeline_layout = resource_cache.request_pipeline_layout(shader_modules);
 	command_buffer.bind_pipeline_layout(pipeline_layout);
 
-	// Get image views of the attachments
-	auto &render_target = get_render_context().get_active_frame().get_render_target();
+	// Get image views of the attachments, of the render target being drawn if it is not the one of the frame
+	auto &render_target = get_render_target() ? *get_render_target() : get_render_context().get_active_frame().get_render_target();
 	auto &target_views  = render_target.get_views();
-	assert(3 < target_views.size());
-
-	// Bind depth, albedo, and normal as input attachments
-	auto &depth_view = target_views[1];
-	command_buffer.bind_input(depth_view, 0, 0, 0);
 
-	auto &albedo_view = target_views[2];
-	command_buffer.bind_input(albedo_view, 0, 1, 0);
+	// Bind depth, albedo, and normal as input attachments, attachments 1, 2 and 3 unless set otherwise
+	auto    &input_attachments = get_input_attachments();
+	uint32_t input_count       = input_attachments.empty() ? 3 : to_u32(input_attachments.size());
+	for (uint32_t i = 0; i < input_count; ++i)
+	{
+		uint32_t attachment = i < input_attachments.size() ? input_attachments[i] : i + 1;
+		assert(attachment < target_views.size());
 
-	auto &normal_view = target_views[3];
-	command_buffer.bind_input(normal_view, 0, 2, 0);
+		command_buffer.bind_input(target_views[attachment], 0, i, 0);
+	}
 
 	// Set cull mode to front as full screen triangle is clock-wise
 	RasterizationState rasterization_state;
@@ -97,4 +116,21 @@ void LightingSubpass::draw(CommandBuffer &command_buffer)
 	// Draw full screen triangle triangle
 	command_buffer.draw(3, 1, 0, 0);
 }
+
+void LightingSubpass::set_clustered_lighting(bool clustered)
+{
+	if (clustered && !clustered_lighting)
+	{
+		clustered_lighting = std::make_unique<ClusteredLighting>(render_context);
+	}
+	else if (!clustered)
+	{
+		clustered_lighting.reset();
+	}
+}
+
+const ClusteredLighting *LightingSubpass::get_clustered_lighting() const
+{
+	return clustered_lighting.get();
+}
 }        // namespace vkb
@@ -18,6 +18,7 @@
 #pragma once
 
 #include "buffer_pool.h"
+#include "rendering/clustered_lighting.h"
 #include "rendering/subpass.h"
 
 VKBP_DISABLE_WARNINGS()
@@ -66,12 +67,27 @@ class LightingSubpass : public Subpass
 
 	void draw(CommandBuffer &command_buffer) override;
 
+	/**
+	 * @brief Whether the point and spot lights are assigned to clusters of the view, rather than all evaluated
+	 *        for every pixel. This lifts the limit of MAX_DEFERRED_LIGHT_COUNT point and spot lights.
+	 *        Must be set before the subpass is prepared.
+	 */
+	void set_clustered_lighting(bool clustered);
+
+	/**
+	 * @return The clustered lighting of the subpass, or nullptr if it is disabled
+	 */
+	const ClusteredLighting *get_clustered_lighting() const;
+
+  protected:
+	ShaderVariant lighting_variant;
+
   private:
 	sg::Camera &camera;
 
 	sg::Scene &scene;
 
-	ShaderVariant lighting_variant;
+	std::unique_ptr<ClusteredLighting> clustered_lighting;
 };
 
 }        // namespace vkb
@@ -0,0 +1,724 @@
+/* Copyright (c) 2023, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "rendering/subpasses/meshlet_subpass.h"
+
+#include <algorithm>
+#include <map>
+#include <tuple>
+#include <unordered_map>
+
+#include "common/utils.h"
+#include "common/vk_common.h"
+#include "geometry/frustum.h"
+#include "geometry/meshlet_builder.h"
+#include "rendering/render_context.h"
+#include "scene_graph/components/camera.h"
+#include "scene_graph/components/image.h"
+#include "scene_graph/components/material.h"
+#include "scene_graph/components/mesh.h"
+#include "scene_graph/components/pbr_material.h"
+#include "scene_graph/components/sub_mesh.h"
+#include "scene_graph/components/texture.h"
+#include "scene_graph/node.h"
+#include "scene_graph/scene.h"
+
+namespace vkb
+{
+namespace
+{
+// Limits of the meshlets, matching the outputs of the mesh shader
+constexpr uint32_t MAX_MESHLET_VERTEX_COUNT = 64;
+
+constexpr uint32_t MAX_MESHLET_TRIANGLE_COUNT = 124;
+
+// Meshlets culled by a task shader or culling compute workgroup
+constexpr uint32_t MESHLET_TASK_SIZE = 32;
+
+// Workgroups per row of a draw or a dispatch, the minimum maxTaskWorkGroupCount and maxComputeWorkGroupCount
+constexpr uint32_t MAX_GROUP_COUNT_X = 65535;
+
+// Workgroups of a draw or a dispatch, within the minimum maxTaskWorkGroupTotalCount
+constexpr uint32_t MAX_GROUP_COUNT = MAX_GROUP_COUNT_X * 64;
+
+/**
+ * @brief Location of the meshlets of a submesh in the shared meshlet buffer
+ */
+struct PackedSubMesh
+{
+	uint32_t first_meshlet;
+
+	uint32_t meshlet_count;
+};
+
+bool has_attribute_format(const sg::SubMesh &sub_mesh, const std::string &name, VkFormat format, uint32_t stride)
+{
+	sg::VertexAttribute attribute;
+	return sub_mesh.get_attribute(name, attribute) && attribute.format == format && attribute.stride == stride && attribute.offset == 0;
+}
+
+/**
+ * @brief Reads the indices of the first level of detail of a submesh, or generates them if it is not indexed
+ */
+std::vector<uint32_t> read_indices(sg::SubMesh &sub_mesh)
+{
+	std::vector<uint32_t> indices;
+
+	if (sub_mesh.vertex_indices == 0 || !sub_mesh.index_buffer)
+	{
+		indices.resize(sub_mesh.vertices_count);
+		for (uint32_t i = 0; i < sub_mesh.vertices_count; ++i)
+		{
+			indices[i] = i;
+		}
+
+		return indices;
+	}
+
+	auto &index_buffer = *sub_mesh.index_buffer;
+
+	const bool already_mapped = index_buffer.get_data() != nullptr;
+	if (!already_mapped)
+	{
+		index_buffer.map();
+	}
+
+	auto lod = sub_mesh.get_lod(0);
+
+	const uint8_t *index_data = index_buffer.get_data() + sub_mesh.index_offset;
+	for (uint32_t i = lod.first_index; i < lod.first_index + lod.index_count; ++i)
+	{
+		if (sub_mesh.index_type == VK_INDEX_TYPE_UINT16)
+		{
+			indices.push_back(reinterpret_cast<const uint16_t *>(index_data)[i]);
+		}
+		else
+		{
+			indices.push_back(reinterpret_cast<const uint32_t *>(index_data)[i]);
+		}
+	}
+
+	if (!already_mapped)
+	{
+		index_buffer.unmap();
+	}
+
+	return indices;
+}
+}        // namespace
+
+MeshletSubpass::MeshletSubpass(RenderContext &render_context, ShaderSource &&task_source, ShaderSource &&mesh_source, ShaderSource &&vertex_source,
+                               ShaderSource &&fragment_source, ShaderSource &&cull_source, sg::Scene &scene_, sg::Camera &camera) :
+    ForwardSubpass{render_context, std::move(vertex_source), std::move(fragment_source), scene_, camera},
+    task_shader{std::move(task_source)},
+    mesh_shader{std::move(mesh_source)},
+    cull_shader{std::move(cull_source)}
+{
+}
+
+void MeshletSubpass::prepare()
+{
+	auto &device = render_context.get_device();
+
+	auto requested_features = device.get_gpu().get_requested_features();
+	if (!mesh_shading && !requested_features.drawIndirectFirstInstance)
+	{
+		throw std::runtime_error("Meshlet subpass requires mesh shading or the drawIndirectFirstInstance feature");
+	}
+	multi_draw_indirect = requested_features.multiDrawIndirect;
+
+	pack_meshlets();
+
+	// Build the shader variants of the current pipeline upfront
+	auto &resource_cache = device.get_resource_cache();
+	if (!mesh_shading)
+	{
+		resource_cache.request_shader_module(VK_SHADER_STAGE_COMPUTE_BIT, cull_shader);
+	}
+
+	for (auto &batch : batches)
+	{
+		if (mesh_shading)
+		{
+			resource_cache.request_shader_module(VK_SHADER_STAGE_TASK_BIT_EXT, task_shader, batch.variant);
+			resource_cache.request_shader_module(VK_SHADER_STAGE_MESH_BIT_EXT, mesh_shader, batch.variant);
+			resource_cache.request_shader_module(VK_SHADER_STAGE_FRAGMENT_BIT, get_fragment_shader(), batch.variant);
+		}
+		else
+		{
+			resource_cache.request_shader_module(VK_SHADER_STAGE_VERTEX_BIT, get_vertex_shader(), batch.instanced_variant);
+			resource_cache.request_shader_module(VK_SHADER_STAGE_FRAGMENT_BIT, get_fragment_shader(), batch.instanced_variant);
+		}
+	}
+}
+
+void MeshletSubpass::pack_meshlets()
+{
+	auto &device = render_context.get_device();
+
+	std::vector<glm::vec3> positions;
+	std::vector<glm::vec3> normals;
+	std::vector<glm::vec2> texcoords;
+
+	MeshletData packed_meshlets;
+
+	std::unordered_map<const sg::SubMesh *, PackedSubMesh> packed_sub_meshes;
+
+	// Append the meshlets and the vertices of every submesh to the shared buffers,
+	// offsetting the meshlet vertices so that they index the shared vertices
+	for (auto &mesh : meshes)
+	{
+		for (auto &sub_mesh : mesh->get_submeshes())
+		{
+			if (!has_attribute_format(*sub_mesh, "position", VK_FORMAT_R32G32B32_SFLOAT, sizeof(glm::vec3)))
+			{
+				LOGW("Skipping '{}' in meshlet subpass: unsupported position format", sub_mesh->get_name());
+				continue;
+			}
+
+			auto sub_mesh_positions = core::Buffer::copy<glm::vec3>(sub_mesh->vertex_buffers, "position");
+			auto vertex_count       = sub_mesh_positions.size();
+
+			std::vector<glm::vec3> sub_mesh_normals;
+			if (has_attribute_format(*sub_mesh, "normal", VK_FORMAT_R32G32B32_SFLOAT, sizeof(glm::vec3)))
+			{
+				sub_mesh_normals = core::Buffer::copy<glm::vec3>(sub_mesh->vertex_buffers, "normal");
+			}
+			sub_mesh_normals.resize(vertex_count, glm::vec3(0.0f, 0.0f, 1.0f));
+
+			std::vector<glm::vec2> sub_mesh_texcoords;
+			if (has_attribute_format(*sub_mesh, "texcoord_0", VK_FORMAT_R32G32_SFLOAT, sizeof(glm::vec2)))
+			{
+				sub_mesh_texcoords = core::Buffer::copy<glm::vec2>(sub_mesh->vertex_buffers, "texcoord_0");
+			}
+			sub_mesh_texcoords.resize(vertex_count, glm::vec2(0.0f));
+
+			auto data = build_cached_meshlets(read_indices(*sub_mesh), sub_mesh_positions, MAX_MESHLET_VERTEX_COUNT, MAX_MESHLET_TRIANGLE_COUNT);
+
+			PackedSubMesh packed{};
+			packed.first_meshlet = to_u32(packed_meshlets.meshlets.size());
+			packed.meshlet_count = to_u32(data.meshlets.size());
+
+			for (auto meshlet : data.meshlets)
+			{
+				meshlet.vertex_offset += to_u32(packed_meshlets.vertices.size());
+				meshlet.triangle_offset += to_u32(packed_meshlets.triangles.size());
+				packed_meshlets.meshlets.push_back(meshlet);
+			}
+
+			for (auto vertex : data.vertices)
+			{
+				packed_meshlets.vertices.push_back(vertex + to_u32(positions.size()));
+			}
+
+			packed_meshlets.triangles.insert(packed_meshlets.triangles.end(), data.triangles.begin(), data.triangles.end());
+
+			positions.insert(positions.end(), sub_mesh_positions.begin(), sub_mesh_positions.end());
+			normals.insert(normals.end(), sub_mesh_normals.begin(), sub_mesh_normals.end());
+			texcoords.insert(texcoords.end(), sub_mesh_texcoords.begin(), sub_mesh_texcoords.end());
+
+			packed_sub_meshes.emplace(sub_mesh, packed);
+		}
+	}
+
+	// The vertex pipeline draws the triangles of each meshlet from an index buffer in meshlet order
+	std::vector<uint32_t> meshlet_indices;
+	meshlet_indices.reserve(packed_meshlets.triangles.size() * 3);
+
+	for (const auto &meshlet : packed_meshlets.meshlets)
+	{
+		for (uint32_t i = 0; i < meshlet.triangle_count; ++i)
+		{
+			uint32_t triangle = packed_meshlets.triangles[meshlet.triangle_offset + i];
+
+			for (uint32_t j = 0; j < 3; ++j)
+			{
+				meshlet_indices.push_back(packed_meshlets.vertices[meshlet.vertex_offset + ((triangle >> (8 * j)) & 0xff)]);
+			}
+		}
+	}
+
+	// Group the submeshes of the instances by material and shader variant (one batch each)
+	using BatchKey = std::tuple<bool, const sg::Material *, size_t, VkFrontFace>;
+
+	std::map<BatchKey, std::vector<std::pair<uint32_t, sg::SubMesh *>>> batch_draws;
+
+	instances.clear();
+	instance_nodes.clear();
+
+	for (auto &mesh : meshes)
+	{
+		for (auto &node : mesh->get_nodes())
+		{
+			auto model = node->get_transform().get_world_matrix();
+
+			// Invert the front face if the mesh was flipped
+			VkFrontFace front_face = glm::determinant(glm::mat3(model)) < 0.0f ? VK_FRONT_FACE_CLOCKWISE : VK_FRONT_FACE_COUNTER_CLOCKWISE;
+
+			uint32_t instance_index = to_u32(instances.size());
+			bool     drawn          = false;
+
+			for (auto &sub_mesh : mesh->get_submeshes())
+			{
+				if (packed_sub_meshes.find(sub_mesh) == packed_sub_meshes.end())
+				{
+					continue;
+				}
+
+				auto material    = sub_mesh->get_material();
+				bool transparent = material->alpha_mode == sg::AlphaMode::Blend;
+
+				batch_draws[BatchKey{transparent, material, sub_mesh->get_shader_variant().get_id(), front_face}].emplace_back(instance_index, sub_mesh);
+				drawn = true;
+			}
+
+			if (drawn)
+			{
+				instances.push_back(model);
+				instance_nodes.push_back(node);
+			}
+		}
+	}
+
+	// Split the meshlets of each instance into tasks, laid out contiguously for each batch with the opaque
+	// batches first, and reserve an indirect command for each meshlet of each instance
+	std::vector<MeshletTask> tasks;
+
+	batches.clear();
+	command_count = 0;
+
+	for (auto &batch_it : batch_draws)
+	{
+		Batch batch;
+		batch.transparent   = std::get<0>(batch_it.first);
+		batch.front_face    = std::get<3>(batch_it.first);
+		batch.sub_mesh      = batch_it.second.front().second;
+		batch.first_task    = to_u32(tasks.size());
+		batch.first_command = command_count;
+
+		// Same as Forward except the definitions are added to a copy of the sub mesh variant
+		batch.variant = batch.sub_mesh->get_shader_variant();
+		add_lighting_definitions(batch.variant);
+
+		batch.instanced_variant = batch.variant;
+		batch.instanced_variant.add_define("INSTANCING");
+
+		for (auto &draw : batch_it.second)
+		{
+			const auto &packed = packed_sub_meshes.at(draw.second);
+
+			for (uint32_t i = 0; i < packed.meshlet_count; i += MESHLET_TASK_SIZE)
+			{
+				MeshletTask task{};
+				task.instance      = draw.first;
+				task.first_meshlet = packed.first_meshlet + i;
+				task.meshlet_count = std::min(MESHLET_TASK_SIZE, packed.meshlet_count - i);
+				task.first_command = command_count;
+
+				command_count += task.meshlet_count;
+
+				tasks.push_back(task);
+			}
+		}
+
+		batch.task_count    = to_u32(tasks.size()) - batch.first_task;
+		batch.command_count = command_count - batch.first_command;
+
+		if (batch.task_count > 0)
+		{
+			batches.push_back(std::move(batch));
+		}
+	}
+
+	frame_resources.clear();
+
+	if (tasks.empty())
+	{
+		return;
+	}
+
+	// Upload the shared buffers
+	auto &queue          = device.get_queue_by_flags(VK_QUEUE_GRAPHICS_BIT, 0);
+	auto &command_buffer = device.request_command_buffer();
+
+	command_buffer.begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+
+	std::vector<core::Buffer> staging_buffers;
+
+	auto upload = [&](const void *data, size_t size, VkBufferUsageFlags usage) {
+		core::Buffer stage_buffer{device, size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VMA_MEMORY_USAGE_CPU_ONLY};
+		stage_buffer.update(static_cast<const uint8_t *>(data), size);
+
+		auto buffer = std::make_unique<core::Buffer>(device, size, usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VMA_MEMORY_USAGE_GPU_ONLY);
+		command_buffer.copy_buffer(stage_buffer, *buffer, size);
+
+		staging_buffers.push_back(std::move(stage_buffer));
+		return buffer;
+	};
+
+	// The vertices are read as vertex attributes by the vertex pipeline, and as storage buffers by the mesh shader
+	const VkBufferUsageFlags vertex_usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+
+	position_buffer         = upload(positions.data(), positions.size() * sizeof(glm::vec3), vertex_usage);
+	normal_buffer           = upload(normals.data(), normals.size() * sizeof(glm::vec3), vertex_usage);
+	texcoord_buffer         = upload(texcoords.data(), texcoords.size() * sizeof(glm::vec2), vertex_usage);
+	meshlet_buffer          = upload(packed_meshlets.meshlets.data(), packed_meshlets.meshlets.size() * sizeof(Meshlet), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+	meshlet_vertex_buffer   = upload(packed_meshlets.vertices.data(), packed_meshlets.vertices.size() * sizeof(uint32_t), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+	meshlet_triangle_buffer = upload(packed_meshlets.triangles.data(), packed_meshlets.triangles.size() * sizeof(uint32_t), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+	meshlet_index_buffer    = upload(meshlet_indices.data(), meshlet_indices.size() * sizeof(uint32_t), VK_BUFFER_USAGE_INDEX_BUFFER_BIT);
+	task_buffer             = upload(tasks.data(), tasks.size() * sizeof(MeshletTask), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+
+	command_buffer.end();
+
+	queue.submit(command_buffer, device.request_fence());
+
+	device.get_fence_pool().wait();
+	device.get_fence_pool().reset();
+	device.get_command_pool().reset_pool();
+
+	LOGI("Meshlet subpass packed {} vertices, {} meshlets of {} triangles, {} instances into {} tasks and {} batches",
+	     positions.size(), packed_meshlets.meshlets.size(), packed_meshlets.triangles.size(), instances.size(), tasks.size(), batches.size());
+}
+
+void MeshletSubpass::update_instances(FrameResources &frame)
+{
+	if (frame.instances_uploaded && !dynamic_transforms)
+	{
+		return;
+	}
+
+	if (dynamic_transforms)
+	{
+		for (size_t i = 0; i < instances.size(); ++i)
+		{
+			instances[i] = instance_nodes[i]->get_transform().get_world_matrix();
+		}
+	}
+
+	frame.instance_buffer->update(reinterpret_cast<const uint8_t *>(instances.data()), instances.size() * sizeof(glm::mat4));
+	frame.instances_uploaded = true;
+}
+
+MeshletCullUniform MeshletSubpass::get_cull_uniform()
+{
+	Frustum frustum;
+	frustum.update(camera.get_pre_rotation() * vkb::vulkan_style_projection(camera.get_projection()) * camera.get_view());
+
+	MeshletCullUniform cull_uniform{};
+	std::copy(frustum.get_planes().begin(), frustum.get_planes().end(), cull_uniform.frustum_planes);
+	cull_uniform.camera_position = glm::inverse(camera.get_view())[3];
+
+	return cull_uniform;
+}
+
+void MeshletSubpass::bind_cull_uniform(CommandBuffer &command_buffer, MeshletCullUniform cull_uniform, const Batch &batch, uint32_t first_task, uint32_t task_count)
+{
+	cull_uniform.first_task   = first_task;
+	cull_uniform.task_count   = task_count;
+	cull_uniform.cone_culling = !batch.sub_mesh->get_material()->double_sided;
+
+	auto allocation = render_context.get_active_frame().allocate_buffer(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, sizeof(MeshletCullUniform), thread_index);
+	allocation.update(cull_uniform);
+
+	command_buffer.bind_buffer(allocation.get_buffer(), allocation.get_offset(), allocation.get_size(), 0, 2, 0);
+}
+
+void MeshletSubpass::bind_meshlet_buffers(CommandBuffer &command_buffer, FrameResources &frame)
+{
+	command_buffer.bind_buffer(*frame.instance_buffer, 0, frame.instance_buffer->get_size(), 0, 5, 0);
+	command_buffer.bind_buffer(*task_buffer, 0, task_buffer->get_size(), 0, 6, 0);
+	command_buffer.bind_buffer(*meshlet_buffer, 0, meshlet_buffer->get_size(), 0, 7, 0);
+	command_buffer.bind_buffer(*meshlet_vertex_buffer, 0, meshlet_vertex_buffer->get_size(), 0, 8, 0);
+	command_buffer.bind_buffer(*meshlet_triangle_buffer, 0, meshlet_triangle_buffer->get_size(), 0, 9, 0);
+	command_buffer.bind_buffer(*position_buffer, 0, position_buffer->get_size(), 0, 10, 0);
+	command_buffer.bind_buffer(*normal_buffer, 0, normal_buffer->get_size(), 0, 11, 0);
+	command_buffer.bind_buffer(*texcoord_buffer, 0, texcoord_buffer->get_size(), 0, 12, 0);
+}
+
+void MeshletSubpass::pre_draw(CommandBuffer &command_buffer)
+{
+	if (batches.empty())
+	{
+		return;
+	}
+
+	auto &device = command_buffer.get_device();
+
+	frame_resources.resize(render_context.get_render_frames().size());
+	auto &frame = frame_resources[render_context.get_active_frame_index()];
+
+	if (!frame.instance_buffer)
+	{
+		frame.instance_buffer = std::make_unique<core::Buffer>(device, instances.size() * sizeof(glm::mat4),
+		                                                       VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+		                                                       VMA_MEMORY_USAGE_CPU_TO_GPU);
+	}
+
+	update_instances(frame);
+
+	// Task shaders cull the meshlets while drawing
+	if (mesh_shading)
+	{
+		return;
+	}
+
+	const VkDeviceSize command_size = command_count * sizeof(VkDrawIndexedIndirectCommand);
+
+	if (!frame.command_buffer)
+	{
+		frame.command_buffer = std::make_unique<core::Buffer>(device, command_size,
+		                                                      VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+		                                                      VMA_MEMORY_USAGE_GPU_ONLY);
+	}
+
+	ScopedDebugLabel cull_debug_label{command_buffer, "Meshlet culling"};
+
+	auto &resource_cache  = device.get_resource_cache();
+	auto &shader_module   = resource_cache.request_shader_module(VK_SHADER_STAGE_COMPUTE_BIT, cull_shader);
+	auto &pipeline_layout = resource_cache.request_pipeline_layout({&shader_module});
+
+	command_buffer.bind_pipeline_layout(pipeline_layout);
+
+	bind_meshlet_buffers(command_buffer, frame);
+	command_buffer.bind_buffer(*frame.command_buffer, 0, command_size, 0, 3, 0);
+
+	auto cull_uniform = get_cull_uniform();
+
+	// Every command is written, with an instance count of zero for the culled meshlets
+	for (auto &batch : batches)
+	{
+		for (uint32_t first = 0; first < batch.task_count; first += MAX_GROUP_COUNT)
+		{
+			uint32_t task_count = std::min(batch.task_count - first, MAX_GROUP_COUNT);
+
+			bind_cull_uniform(command_buffer, cull_uniform, batch, batch.first_task + first, task_count);
+
+			command_buffer.dispatch(std::min(task_count, MAX_GROUP_COUNT_X), (task_count + MAX_GROUP_COUNT_X - 1) / MAX_GROUP_COUNT_X, 1);
+		}
+	}
+
+	BufferMemoryBarrier barrier{};
+	barrier.src_stage_mask  = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+	barrier.dst_stage_mask  = VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT;
+	barrier.src_access_mask = VK_ACCESS_SHADER_WRITE_BIT;
+	barrier.dst_access_mask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+
+	command_buffer.buffer_memory_barrier(*frame.command_buffer, 0, command_size, barrier);
+}
+
+void MeshletSubpass::draw(CommandBuffer &command_buffer)
+{
+	draw_count = 0;
+
+	if (batches.empty())
+	{
+		return;
+	}
+
+	auto frame_index = render_context.get_active_frame_index();
+	assert(frame_index < frame_resources.size() && "Instances must be uploaded with pre_draw before drawing");
+
+	auto &frame = frame_resources[frame_index];
+
+	bind_lights(command_buffer);
+
+	// The model matrices are read from the instance buffer
+	GlobalUniform global_uniform;
+	global_uniform.model            = glm::mat4(1.0f);
+	global_uniform.camera_view_proj = camera.get_pre_rotation() * vkb::vulkan_style_projection(camera.get_projection()) * camera.get_view();
+	global_uniform.camera_position  = glm::vec3(glm::inverse(camera.get_view())[3]);
+
+	auto allocation = render_context.get_active_frame().allocate_buffer(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, sizeof(GlobalUniform), thread_index);
+	allocation.update(global_uniform);
+
+	command_buffer.bind_buffer(allocation.get_buffer(), allocation.get_offset(), allocation.get_size(), 0, 1, 0);
+
+	if (mesh_shading)
+	{
+		bind_meshlet_buffers(command_buffer, frame);
+	}
+	else
+	{
+		command_buffer.bind_buffer(*frame.instance_buffer, 0, frame.instance_buffer->get_size(), 0, 5, 0);
+
+		VertexInputState vertex_input_state;
+		vertex_input_state.bindings   = {{0, sizeof(glm::vec3), VK_VERTEX_INPUT_RATE_VERTEX},
+		                                 {1, sizeof(glm::vec2), VK_VERTEX_INPUT_RATE_VERTEX},
+		                                 {2, sizeof(glm::vec3), VK_VERTEX_INPUT_RATE_VERTEX}};
+		vertex_input_state.attributes = {{0, 0, VK_FORMAT_R32G32B32_SFLOAT, 0},
+		                                 {1, 1, VK_FORMAT_R32G32_SFLOAT, 0},
+		                                 {2, 2, VK_FORMAT_R32G32B32_SFLOAT, 0}};
+		command_buffer.set_vertex_input_state(vertex_input_state);
+
+		std::vector<std::reference_wrapper<const core::Buffer>> buffers{std::cref(*position_buffer), std::cref(*texcoord_buffer), std::cref(*normal_buffer)};
+		command_buffer.bind_vertex_buffers(0, std::move(buffers), {0, 0, 0});
+		command_buffer.bind_index_buffer(*meshlet_index_buffer, 0, VK_INDEX_TYPE_UINT32);
+	}
+
+	auto cull_uniform = get_cull_uniform();
+
+	// Batches are ordered with the opaque ones first. Transparent meshlets
+	// are not sorted by distance, as their order is decided by the GPU
+	auto first_transparent = std::find_if(batches.begin(), batches.end(), [](const Batch &batch) { return batch.transparent; });
+
+	{
+		ScopedDebugLabel opaque_debug_label{command_buffer, "Opaque objects"};
+
+		for (auto batch_it = batches.begin(); batch_it != first_transparent; ++batch_it)
+		{
+			draw_batch(command_buffer, *batch_it, frame, cull_uniform);
+		}
+	}
+
+	if (first_transparent == batches.end())
+	{
+		return;
+	}
+
+	// Enable alpha blending
+	ColorBlendAttachmentState color_blend_attachment{};
+	color_blend_attachment.blend_enable           = VK_TRUE;
+	color_blend_attachment.src_color_blend_factor = VK_BLEND_FACTOR_SRC_ALPHA;
+	color_blend_attachment.dst_color_blend_factor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+	color_blend_attachment.src_alpha_blend_factor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+
+	ColorBlendState color_blend_state{};
+	color_blend_state.attachments.resize(get_output_attachments().size());
+	for (auto &it : color_blend_state.attachments)
+	{
+		it = color_blend_attachment;
+	}
+	command_buffer.set_color_blend_state(color_blend_state);
+
+	command_buffer.set_depth_stencil_state(get_depth_stencil_state());
+
+	{
+		ScopedDebugLabel transparent_debug_label{command_buffer, "Transparent objects"};
+
+		for (auto batch_it = first_transparent; batch_it != batches.end(); ++batch_it)
+		{
+			draw_batch(command_buffer, *batch_it, frame, cull_uniform);
+		}
+	}
+}
+
+void MeshletSubpass::draw_batch(CommandBuffer &command_buffer, const Batch &batch, FrameResources &frame, const MeshletCullUniform &cull_uniform)
+{
+	auto &resource_cache = command_buffer.get_device().get_resource_cache();
+
+	prepare_pipeline_state(command_buffer, batch.front_face, batch.sub_mesh->get_material()->double_sided);
+
+	std::vector<ShaderModule *> shader_modules;
+	if (mesh_shading)
+	{
+		shader_modules = {&resource_cache.request_shader_module(VK_SHADER_STAGE_TASK_BIT_EXT, task_shader, batch.variant),
+		                  &resource_cache.request_shader_module(VK_SHADER_STAGE_MESH_BIT_EXT, mesh_shader, batch.variant),
+		                  &resource_cache.request_shader_module(VK_SHADER_STAGE_FRAGMENT_BIT, get_fragment_shader(), batch.variant)};
+	}
+	else
+	{
+		shader_modules = {&resource_cache.request_shader_module(VK_SHADER_STAGE_VERTEX_BIT, get_vertex_shader(), batch.instanced_variant),
+		                  &resource_cache.request_shader_module(VK_SHADER_STAGE_FRAGMENT_BIT, get_fragment_shader(), batch.instanced_variant)};
+	}
+
+	auto &pipeline_layout = prepare_pipeline_layout(command_buffer, shader_modules);
+
+	command_buffer.bind_pipeline_layout(pipeline_layout);
+
+	if (pipeline_layout.get_push_constant_range_stage(sizeof(PBRMaterialUniform)) != 0)
+	{
+		prepare_push_constants(command_buffer, *batch.sub_mesh);
+	}
+
+	DescriptorSetLayout &descriptor_set_layout = pipeline_layout.get_descriptor_set_layout(0);
+
+	for (auto &texture : batch.sub_mesh->get_material()->textures)
+	{
+		if (auto layout_binding = descriptor_set_layout.get_layout_binding(texture.first))
+		{
+			command_buffer.bind_image(texture.second->get_image()->get_vk_image_view(),
+			                          texture.second->get_sampler()->vk_sampler,
+			                          0, layout_binding->binding, 0);
+		}
+	}
+
+	if (mesh_shading)
+	{
+		for (uint32_t first = 0; first < batch.task_count; first += MAX_GROUP_COUNT)
+		{
+			uint32_t task_count = std::min(batch.task_count - first, MAX_GROUP_COUNT);
+
+			bind_cull_uniform(command_buffer, cull_uniform, batch, batch.first_task + first, task_count);
+
+			command_buffer.draw_mesh_tasks(std::min(task_count, MAX_GROUP_COUNT_X), (task_count + MAX_GROUP_COUNT_X - 1) / MAX_GROUP_COUNT_X, 1);
+			draw_count++;
+		}
+
+		return;
+	}
+
+	const uint32_t stride = sizeof(VkDrawIndexedIndirectCommand);
+
+	if (multi_draw_indirect)
+	{
+		command_buffer.draw_indexed_indirect(*frame.command_buffer, batch.first_command * stride, batch.command_count, stride);
+		draw_count++;
+	}
+	else
+	{
+		for (uint32_t i = 0; i < batch.command_count; ++i)
+		{
+			command_buffer.draw_indexed_indirect(*frame.command_buffer, (batch.first_command + i) * stride, 1, stride);
+		}
+		draw_count += batch.command_count;
+	}
+}
+
+void MeshletSubpass::set_mesh_shading(bool mesh_shading_)
+{
+	mesh_shading = mesh_shading_;
+}
+
+bool MeshletSubpass::is_mesh_shading_enabled() const
+{
+	return mesh_shading;
+}
+
+void MeshletSubpass::set_dynamic_transforms(bool dynamic)
+{
+	if (dynamic_transforms && !dynamic)
+	{
+		// Upload the final transforms once more for every frame
+		for (auto &frame : frame_resources)
+		{
+			frame.instances_uploaded = false;
+		}
+	}
+
+	dynamic_transforms = dynamic;
+}
+
+uint32_t MeshletSubpass::get_meshlet_count() const
+{
+	return command_count;
+}
+
+uint32_t MeshletSubpass::get_draw_count() const
+{
+	return draw_count;
+}
+}        // namespace vkb
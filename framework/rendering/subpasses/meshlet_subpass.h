@@ -0,0 +1,238 @@
+/* Copyright (c) 2023, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "rendering/subpasses/forward_subpass.h"
+
+namespace vkb
+{
+namespace sg
+{
+class Scene;
+class Node;
+class SubMesh;
+class Camera;
+}        // namespace sg
+
+/**
+ * @brief Culling uniform of the meshlet task and culling shaders
+ */
+struct alignas(16) MeshletCullUniform
+{
+	glm::vec4 frustum_planes[6];
+
+	glm::vec4 camera_position;
+
+	// Range of the tasks culled by a draw or a dispatch
+	uint32_t first_task;
+
+	uint32_t task_count;
+
+	// Whether meshlets facing away from the camera are culled, false for double-sided materials
+	uint32_t cone_culling;
+};
+
+/**
+ * @brief A range of up to 32 meshlets of an instance, culled by one workgroup
+ */
+struct MeshletTask
+{
+	uint32_t instance;
+
+	uint32_t first_meshlet;
+
+	uint32_t meshlet_count;
+
+	// Indirect command of the first meshlet when drawing with the vertex pipeline
+	uint32_t first_command;
+};
+
+/**
+ * @brief This subpass renders a Scene as meshlets culled on the GPU
+ *
+ *        On prepare, the submeshes of the scene are partitioned into meshlets, which are packed
+ *        along with their vertices into shared buffers. The meshlets of each node instance are
+ *        split into tasks of up to 32 meshlets, grouped in batches sharing material and pipeline
+ *        state.
+ *
+ *        With mesh shading, a task shader workgroup culls the meshlets of each task against the
+ *        camera frustum and by their normal cone, and launches a mesh shader workgroup for each
+ *        visible meshlet. Mesh shading requires the taskShader and meshShader features of
+ *        VK_EXT_mesh_shader, with the shaders compiled for SPIR-V 1.4.
+ *
+ *        Otherwise a compute shader culls the meshlets the same way, and writes an indirect
+ *        command per meshlet of each instance drawing its triangles from an index buffer laid out
+ *        in meshlet order. This requires the drawIndirectFirstInstance feature. If multiDrawIndirect
+ *        is not enabled, each command of a batch is drawn with its own indirect call.
+ */
+class MeshletSubpass : public ForwardSubpass
+{
+  public:
+	/**
+	 * @brief Constructs a subpass drawing meshlets
+	 * @param render_context Render context
+	 * @param task_shader Task shader source, culling the meshlets of a task
+	 * @param mesh_shader Mesh shader source, drawing a meshlet
+	 * @param vertex_shader Vertex shader source of the vertex pipeline, reading the model matrices of the instances
+	 * @param fragment_shader Fragment shader source
+	 * @param cull_shader Compute shader source culling the meshlets of a task for the vertex pipeline
+	 * @param scene Scene to render on this subpass
+	 * @param camera Camera used to look at the scene
+	 */
+	MeshletSubpass(RenderContext &render_context, ShaderSource &&task_shader, ShaderSource &&mesh_shader, ShaderSource &&vertex_shader,
+	               ShaderSource &&fragment_shader, ShaderSource &&cull_shader, sg::Scene &scene, sg::Camera &camera);
+
+	virtual ~MeshletSubpass() = default;
+
+	virtual void prepare() override;
+
+	/**
+	 * @brief Uploads the instances, and records the culling dispatches when drawing with the vertex pipeline
+	 */
+	virtual void pre_draw(CommandBuffer &command_buffer) override;
+
+	/**
+	 * @brief Record draw commands
+	 */
+	virtual void draw(CommandBuffer &command_buffer) override;
+
+	/**
+	 * @brief Whether the meshlets are drawn with task and mesh shaders, or with the vertex pipeline
+	 */
+	void set_mesh_shading(bool mesh_shading);
+
+	bool is_mesh_shading_enabled() const;
+
+	/**
+	 * @brief Whether node transforms are uploaded every frame, or only once after prepare
+	 */
+	void set_dynamic_transforms(bool dynamic);
+
+	/**
+	 * @brief Number of meshlets of all the instances, culled every frame
+	 */
+	uint32_t get_meshlet_count() const;
+
+	/**
+	 * @brief Number of draw calls recorded per frame
+	 */
+	uint32_t get_draw_count() const;
+
+  private:
+	/**
+	 * @brief A group of tasks sharing material and pipeline state
+	 */
+	struct Batch
+	{
+		sg::SubMesh *sub_mesh{nullptr};
+
+		ShaderVariant variant;
+
+		// Variant of the vertex pipeline, reading the model matrices of the instances
+		ShaderVariant instanced_variant;
+
+		VkFrontFace front_face{VK_FRONT_FACE_COUNTER_CLOCKWISE};
+
+		bool transparent{false};
+
+		uint32_t first_task{0};
+
+		uint32_t task_count{0};
+
+		uint32_t first_command{0};
+
+		uint32_t command_count{0};
+	};
+
+	/**
+	 * @brief Buffers written every frame, one set per render frame
+	 */
+	struct FrameResources
+	{
+		std::unique_ptr<core::Buffer> instance_buffer;
+
+		// Indirect commands of the vertex pipeline, created on first use
+		std::unique_ptr<core::Buffer> command_buffer;
+
+		bool instances_uploaded{false};
+	};
+
+	void pack_meshlets();
+
+	void update_instances(FrameResources &frame_resources);
+
+	/**
+	 * @brief Gets the culling uniform of the current camera, without a range of tasks
+	 */
+	MeshletCullUniform get_cull_uniform();
+
+	/**
+	 * @brief Binds the culling uniform of a range of tasks of a batch
+	 */
+	void bind_cull_uniform(CommandBuffer &command_buffer, MeshletCullUniform cull_uniform, const Batch &batch, uint32_t first_task, uint32_t task_count);
+
+	/**
+	 * @brief Binds the buffers read by the task, mesh and culling shaders
+	 */
+	void bind_meshlet_buffers(CommandBuffer &command_buffer, FrameResources &frame_resources);
+
+	void draw_batch(CommandBuffer &command_buffer, const Batch &batch, FrameResources &frame_resources, const MeshletCullUniform &cull_uniform);
+
+	ShaderSource task_shader;
+
+	ShaderSource mesh_shader;
+
+	ShaderSource cull_shader;
+
+	std::unique_ptr<core::Buffer> position_buffer;
+
+	std::unique_ptr<core::Buffer> normal_buffer;
+
+	std::unique_ptr<core::Buffer> texcoord_buffer;
+
+	std::unique_ptr<core::Buffer> meshlet_buffer;
+
+	std::unique_ptr<core::Buffer> meshlet_vertex_buffer;
+
+	std::unique_ptr<core::Buffer> meshlet_triangle_buffer;
+
+	// Indices of the meshlet triangles in the packed vertices, in meshlet order
+	std::unique_ptr<core::Buffer> meshlet_index_buffer;
+
+	std::unique_ptr<core::Buffer> task_buffer;
+
+	std::vector<FrameResources> frame_resources;
+
+	std::vector<Batch> batches;
+
+	std::vector<sg::Node *> instance_nodes;
+
+	std::vector<glm::mat4> instances;
+
+	uint32_t command_count{0};
+
+	bool mesh_shading{false};
+
+	bool dynamic_transforms{false};
+
+	bool multi_draw_indirect{false};
+
+	uint32_t draw_count{0};
+};
+
+}        // namespace vkb
@@ -0,0 +1,477 @@
+/* Copyright (c) 2023, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "rendering/subpasses/shadow_subpass.h"
+
+#include "common/helpers.h"
+#include "common/logging.h"
+#include "common/utils.h"
+#include "common/vk_common.h"
+#include "rendering/render_context.h"
+#include "scene_graph/components/light.h"
+#include "scene_graph/components/material.h"
+#include "scene_graph/components/mesh.h"
+#include "scene_graph/components/perspective_camera.h"
+#include "scene_graph/components/sub_mesh.h"
+#include "scene_graph/node.h"
+#include "scene_graph/scene.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace vkb
+{
+namespace
+{
+// Weight of the logarithmic split of the cascades, the remainder being split uniformly
+constexpr float CASCADE_SPLIT_LAMBDA = 0.75f;
+
+// Near plane of the spot light shadow maps
+constexpr float SPOT_LIGHT_NEAR_PLANE = 0.1f;
+
+/**
+ * @brief Camera with an explicit projection, the view being the inverse of its node transform
+ */
+class TileCamera : public sg::Camera
+{
+  public:
+	TileCamera() :
+	    Camera{"shadow_tile_camera"}
+	{}
+
+	virtual glm::mat4 get_projection() override
+	{
+		return projection;
+	}
+
+	glm::mat4 projection{1.0f};
+};
+
+/**
+ * @brief Rotation from world space to the space of a light looking along its direction
+ */
+glm::mat4 get_light_rotation(sg::Light &light)
+{
+	auto &transform = light.get_node()->get_transform();
+
+	glm::vec3 direction = glm::normalize(transform.get_rotation() * light.get_properties().direction);
+	glm::vec3 up        = std::abs(direction.y) < 0.99f ? glm::vec3{0.0f, 1.0f, 0.0f} : glm::vec3{1.0f, 0.0f, 0.0f};
+
+	return glm::lookAt(glm::vec3{0.0f}, direction, up);
+}
+}        // namespace
+
+ShadowSubpass::ShadowSubpass(RenderContext &render_context, ShaderSource &&vertex_source, ShaderSource &&fragment_source, sg::Scene &scene, sg::Camera &camera,
+                             uint32_t atlas_resolution, uint32_t tile_resolution) :
+    GeometrySubpass{render_context, std::move(vertex_source), std::move(fragment_source), scene, camera},
+    atlas_resolution{atlas_resolution},
+    tile_resolution{tile_resolution}
+{
+	assert(tile_resolution > 0 && tile_resolution <= atlas_resolution && "Shadow tiles must fit in the atlas");
+}
+
+ShadowSubpass::~ShadowSubpass() = default;
+
+void ShadowSubpass::prepare()
+{
+	GeometrySubpass::prepare();
+
+	auto &device = render_context.get_device();
+
+	core::Image depth_image{device,
+	                        VkExtent3D{atlas_resolution, atlas_resolution, 1},
+	                        get_suitable_depth_format(device.get_gpu().get_handle()),
+	                        VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+	                        VMA_MEMORY_USAGE_GPU_ONLY};
+
+	std::vector<core::Image> images;
+	images.push_back(std::move(depth_image));
+
+	atlas = std::make_unique<RenderTarget>(std::move(images));
+
+	// The shadow pass starts in the layout the write barrier leaves the atlas in, so that the cached tiles are loaded
+	atlas->set_layout(0, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL);
+
+	atlas_initialized = false;
+	for (auto &tile : tiles)
+	{
+		tile.valid = false;
+	}
+}
+
+void ShadowSubpass::add_light(sg::Light &light, uint32_t cascade_count)
+{
+	if (light.get_light_type() == sg::LightType::Point)
+	{
+		LOGW("Point lights are not supported by the shadow subpass, light {} casts no shadows", light.get_name());
+		return;
+	}
+
+	if (light.get_light_type() == sg::LightType::Spot)
+	{
+		cascade_count = 1;
+	}
+	else if (cascade_count > 1 && dynamic_cast<sg::PerspectiveCamera *>(&camera) == nullptr)
+	{
+		throw std::runtime_error{"Shadow cascades require a perspective camera"};
+	}
+
+	const uint32_t tiles_per_row = atlas_resolution / tile_resolution;
+	if (tiles.size() + cascade_count > tiles_per_row * tiles_per_row)
+	{
+		throw std::runtime_error{fmt::format("The shadow atlas only has room for {} tiles", tiles_per_row * tiles_per_row)};
+	}
+
+	for (uint32_t cascade = 0; cascade < cascade_count; ++cascade)
+	{
+		uint32_t tile_index = to_u32(tiles.size());
+
+		Tile tile;
+		tile.light         = &light;
+		tile.cascade       = cascade;
+		tile.cascade_count = cascade_count;
+
+		tile.rect.offset = {static_cast<int32_t>((tile_index % tiles_per_row) * tile_resolution), static_cast<int32_t>((tile_index / tiles_per_row) * tile_resolution)};
+		tile.rect.extent = {tile_resolution, tile_resolution};
+
+		tile.view.atlas_rect = glm::vec4{tile.rect.offset.x, tile.rect.offset.y, tile_resolution, tile_resolution} / static_cast<float>(atlas_resolution);
+
+		tile.node   = std::make_unique<sg::Node>(0, "shadow_tile");
+		tile.camera = std::make_unique<TileCamera>();
+		tile.camera->set_node(*tile.node);
+
+		tiles.push_back(std::move(tile));
+	}
+}
+
+void ShadowSubpass::set_shadow_distance(float distance)
+{
+	shadow_distance = distance;
+}
+
+void ShadowSubpass::set_caching(bool caching_)
+{
+	caching = caching_;
+}
+
+bool ShadowSubpass::is_caching_enabled() const
+{
+	return caching;
+}
+
+void ShadowSubpass::fit_cascade(Tile &tile, const glm::mat4 &light_rotation)
+{
+	auto &view_camera = static_cast<sg::PerspectiveCamera &>(camera);
+
+	// Practical split scheme, blending logarithmic and uniform splits of the view depth
+	float near_plane = view_camera.get_near_plane();
+	float far_plane  = std::min(view_camera.get_far_plane(), shadow_distance);
+
+	auto get_split = [&](uint32_t index) {
+		float fraction = static_cast<float>(index) / tile.cascade_count;
+		return CASCADE_SPLIT_LAMBDA * near_plane * std::pow(far_plane / near_plane, fraction) +
+		       (1.0f - CASCADE_SPLIT_LAMBDA) * (near_plane + (far_plane - near_plane) * fraction);
+	};
+
+	float split_near = get_split(tile.cascade);
+	float split_far  = get_split(tile.cascade + 1);
+
+	// Corners of the slice of the view frustum, in world space
+	float     tan_half_fov_y = std::tan(view_camera.get_field_of_view() * 0.5f);
+	float     tan_half_fov_x = tan_half_fov_y * view_camera.get_aspect_ratio();
+	glm::mat4 camera_world   = glm::inverse(camera.get_view());
+
+	glm::vec3 corners[8];
+	for (uint32_t i = 0; i < 8; ++i)
+	{
+		float depth = (i & 4) ? split_far : split_near;
+		float x     = ((i & 1) ? 1.0f : -1.0f) * tan_half_fov_x * depth;
+		float y     = ((i & 2) ? 1.0f : -1.0f) * tan_half_fov_y * depth;
+
+		corners[i] = glm::vec3(camera_world * glm::vec4(x, y, -depth, 1.0f));
+	}
+
+	glm::vec3 center{0.0f};
+	for (auto &corner : corners)
+	{
+		center += corner / 8.0f;
+	}
+
+	// A bounding sphere keeps the size of the cascade when the camera rotates
+	float radius = 0.0f;
+	for (auto &corner : corners)
+	{
+		radius = std::max(radius, glm::length(corner - center));
+	}
+	radius = std::ceil(radius * 16.0f) / 16.0f;
+
+	// Snapping the center to the texels of the tile keeps the matrix unchanged for small camera moves
+	glm::vec3 light_center = glm::vec3(light_rotation * glm::vec4(center, 1.0f));
+	float     texel_size   = 2.0f * radius / tile_resolution;
+	light_center.x         = std::floor(light_center.x / texel_size) * texel_size;
+	light_center.y         = std::floor(light_center.y / texel_size) * texel_size;
+	light_center.z         = std::floor(light_center.z / texel_size) * texel_size;
+
+	glm::mat4 view = glm::translate(glm::mat4{1.0f}, -light_center) * light_rotation;
+
+	// Casters between the light and the cascade are drawn up to the shadow distance away from it.
+	// Using reversed depth-buffer, so near and far are flipped.
+	auto &tile_camera      = static_cast<TileCamera &>(*tile.camera);
+	tile_camera.projection = glm::ortho(-radius, radius, -radius, radius, radius, -radius - shadow_distance);
+
+	tile.node->get_transform().set_matrix(glm::inverse(view));
+	tile.view.light_matrix = vulkan_style_projection(tile_camera.projection) * view;
+}
+
+void ShadowSubpass::fit_spot_light(Tile &tile)
+{
+	auto &light     = *tile.light;
+	auto &transform = light.get_node()->get_transform();
+
+	glm::vec3 position = glm::vec3(transform.get_world_matrix()[3]);
+	glm::mat4 view     = glm::translate(get_light_rotation(light), -position);
+
+	float range = light.get_properties().range > 0.0f ? light.get_properties().range : shadow_distance;
+
+	// Using reversed depth-buffer, so near and far are flipped
+	auto &tile_camera      = static_cast<TileCamera &>(*tile.camera);
+	tile_camera.projection = glm::perspective(2.0f * light.get_properties().outer_cone_angle, 1.0f, range, SPOT_LIGHT_NEAR_PLANE);
+
+	tile.node->get_transform().set_matrix(glm::inverse(view));
+	tile.view.light_matrix = vulkan_style_projection(tile_camera.projection) * view;
+}
+
+void ShadowSubpass::update_tiles()
+{
+	stats = {};
+
+	for (auto &tile : tiles)
+	{
+		if (tile.light->get_light_type() == sg::LightType::Directional)
+		{
+			fit_cascade(tile, get_light_rotation(*tile.light));
+		}
+		else
+		{
+			fit_spot_light(tile);
+		}
+
+		size_t content_hash = 0;
+		for (uint32_t column = 0; column < 4; ++column)
+		{
+			for (uint32_t row = 0; row < 4; ++row)
+			{
+				hash_combine(content_hash, tile.view.light_matrix[column][row]);
+			}
+		}
+
+		tile.casters.clear();
+
+		// Casters deformed on the GPU may change their shape every frame without moving
+		bool deformed_casters = false;
+
+		auto &culling_result = scene.get_visibility_culling().cull(*tile.camera);
+
+		for (auto &visible_node : culling_result.visible_nodes)
+		{
+			hash_combine(content_hash, visible_node.node);
+			hash_combine(content_hash, visible_node.node->get_transform().get_world_matrix_version());
+
+			for (auto &sub_mesh : visible_node.mesh->get_submeshes())
+			{
+				// Blended submeshes cast no shadows
+				if (sub_mesh->get_material()->alpha_mode != sg::AlphaMode::Blend)
+				{
+					tile.casters.emplace_back(visible_node.node, sub_mesh);
+
+					deformed_casters |= sub_mesh->has_node_deformation(*visible_node.node) || sub_mesh->deformed_vertex_buffers.count(nullptr) > 0;
+				}
+			}
+		}
+
+		tile.dirty        = !caching || !tile.valid || deformed_casters || tile.content_hash != content_hash;
+		tile.content_hash = content_hash;
+
+		const uint64_t tile_bytes = static_cast<uint64_t>(tile_resolution) * tile_resolution * get_bits_per_pixel(atlas->get_views()[0].get_format()) / 8;
+
+		stats.tile_count++;
+
+		if (tile.dirty)
+		{
+			stats.rendered_tile_count++;
+			stats.draw_count += to_u32(tile.casters.size());
+			stats.written_bytes += tile_bytes;
+		}
+		else
+		{
+			stats.saved_bytes += tile_bytes;
+		}
+	}
+}
+
+void ShadowSubpass::draw(CommandBuffer &command_buffer)
+{
+	for (auto &tile : tiles)
+	{
+		if (!tile.dirty)
+		{
+			continue;
+		}
+
+		ScopedDebugLabel tile_debug_label{command_buffer, fmt::format("{} cascade {}", tile.light->get_name(), tile.cascade).c_str()};
+
+		VkViewport viewport{};
+		viewport.x        = static_cast<float>(tile.rect.offset.x);
+		viewport.y        = static_cast<float>(tile.rect.offset.y);
+		viewport.width    = static_cast<float>(tile.rect.extent.width);
+		viewport.height   = static_cast<float>(tile.rect.extent.height);
+		viewport.minDepth = 0.0f;
+		viewport.maxDepth = 1.0f;
+		command_buffer.set_viewport(0, {viewport});
+		command_buffer.set_scissor(0, {tile.rect});
+
+		// Only the tile is cleared, the other tiles keep their cached depth
+		VkClearAttachment clear_attachment{};
+		clear_attachment.aspectMask                      = VK_IMAGE_ASPECT_DEPTH_BIT;
+		clear_attachment.clearValue.depthStencil.depth   = 0.0f;
+		clear_attachment.clearValue.depthStencil.stencil = ~0U;
+
+		VkClearRect clear_rect{};
+		clear_rect.rect           = tile.rect;
+		clear_rect.baseArrayLayer = 0;
+		clear_rect.layerCount     = 1;
+		command_buffer.clear(clear_attachment, clear_rect);
+
+		current_tile = &tile;
+
+		for (auto &caster : tile.casters)
+		{
+			draw_opaque_submesh(command_buffer, *caster.first, *caster.second, thread_index);
+		}
+
+		current_tile = nullptr;
+
+		tile.valid = true;
+		tile.dirty = false;
+	}
+}
+
+std::vector<ShadowSubpass::ShadowView> ShadowSubpass::get_shadow_views(const sg::Light &light) const
+{
+	std::vector<ShadowView> views;
+
+	for (auto &tile : tiles)
+	{
+		if (tile.light == &light)
+		{
+			views.push_back(tile.view);
+		}
+	}
+
+	return views;
+}
+
+RenderTarget &ShadowSubpass::get_atlas()
+{
+	assert(atlas && "The atlas is created when the subpass is prepared");
+	return *atlas;
+}
+
+void ShadowSubpass::record_atlas_write_barrier(CommandBuffer &command_buffer)
+{
+	// Waits for the reads of the previous frames, which were submitted earlier to the same queue
+	ImageMemoryBarrier memory_barrier{};
+	memory_barrier.old_layout      = atlas_initialized ? VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_UNDEFINED;
+	memory_barrier.new_layout      = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+	memory_barrier.src_access_mask = 0;
+	memory_barrier.dst_access_mask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+	memory_barrier.src_stage_mask  = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+	memory_barrier.dst_stage_mask  = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+
+	command_buffer.image_memory_barrier(get_atlas().get_views()[0], memory_barrier);
+
+	atlas_initialized = true;
+}
+
+void ShadowSubpass::record_atlas_read_barrier(CommandBuffer &command_buffer)
+{
+	ImageMemoryBarrier memory_barrier{};
+	memory_barrier.old_layout      = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+	memory_barrier.new_layout      = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	memory_barrier.src_access_mask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+	memory_barrier.dst_access_mask = VK_ACCESS_SHADER_READ_BIT;
+	memory_barrier.src_stage_mask  = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+	memory_barrier.dst_stage_mask  = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+
+	command_buffer.image_memory_barrier(get_atlas().get_views()[0], memory_barrier);
+}
+
+const ShadowSubpass::Stats &ShadowSubpass::get_stats() const
+{
+	return stats;
+}
+
+void ShadowSubpass::update_uniform(CommandBuffer &command_buffer, sg::Node &node, size_t thread_index)
+{
+	assert(current_tile && "Shadow casters are only drawn within a tile");
+
+	GlobalUniform global_uniform;
+
+	global_uniform.model            = node.get_transform().get_world_matrix();
+	global_uniform.camera_view_proj = current_tile->view.light_matrix;
+	global_uniform.camera_position  = glm::vec3(glm::inverse(current_tile->camera->get_view())[3]);
+
+	auto allocation = get_render_context().get_active_frame().allocate_buffer(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, sizeof(GlobalUniform), thread_index);
+	allocation.update(global_uniform);
+
+	command_buffer.bind_buffer(allocation.get_buffer(), allocation.get_offset(), allocation.get_size(), 0, 1, 0);
+}
+
+void ShadowSubpass::prepare_pipeline_state(CommandBuffer &command_buffer, VkFrontFace front_face, bool double_sided_material)
+{
+	// Depth bias pushes the primitives away from the light, taking their slope into account,
+	// to avoid self-shadowing artifacts when comparing depths in the lighting pass
+	RasterizationState rasterization_state{};
+	rasterization_state.front_face        = front_face;
+	rasterization_state.depth_bias_enable = VK_TRUE;
+
+	if (double_sided_material)
+	{
+		rasterization_state.cull_mode = VK_CULL_MODE_NONE;
+	}
+
+	command_buffer.set_rasterization_state(rasterization_state);
+	command_buffer.set_depth_bias(-1.4f, 0.0f, -1.7f);
+}
+
+PipelineLayout &ShadowSubpass::prepare_pipeline_layout(CommandBuffer &command_buffer, const std::vector<ShaderModule *> &shader_modules)
+{
+	// Only the vertex shader is needed to render depth
+	assert(!shader_modules.empty());
+	auto vertex_shader_module = shader_modules[0];
+
+	vertex_shader_module->set_resource_mode("GlobalUniform", ShaderResourceMode::Dynamic);
+
+	return command_buffer.get_device().get_resource_cache().request_pipeline_layout({vertex_shader_module});
+}
+
+void ShadowSubpass::prepare_push_constants(CommandBuffer &command_buffer, sg::SubMesh &sub_mesh)
+{
+	// No push constants are used in the shadow pass
+}
+
+}        // namespace vkb
@@ -0,0 +1,224 @@
+/* Copyright (c) 2023, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "rendering/subpasses/geometry_subpass.h"
+
+namespace vkb
+{
+namespace sg
+{
+class Light;
+}        // namespace sg
+
+class RenderTarget;
+
+/**
+ * @brief This subpass renders the shadow maps of several lights into the tiles of a single depth atlas
+ *
+ *        Directional lights get one tile per cascade, splitting the view of the camera up to the shadow
+ *        distance, and spot lights get a single tile. Each cascade is fitted to a sphere around its slice
+ *        of the view frustum and snapped to the texels of its tile, so that it only moves when the camera
+ *        moved by a whole texel.
+ *
+ *        With caching, the atlas keeps its content across frames, and a tile is only cleared and rendered
+ *        again if its light matrix changed, or if the set of casters in its frustum changed or one of them
+ *        moved. Tiles with casters deformed by the GPU skinning are rendered every frame. Tiles of static
+ *        lights over static geometry are therefore rendered once.
+ *
+ *        The atlas is owned by the subpass and is shared by all the render frames. The render pipeline
+ *        drawing the subpass must load and store the atlas, and the atlas must be transitioned around the
+ *        pass with record_atlas_write_barrier() and record_atlas_read_barrier().
+ *        update_tiles() must be called once per frame, before recording this subpass and the subpasses
+ *        sampling the atlas.
+ */
+class ShadowSubpass : public GeometrySubpass
+{
+  public:
+	/**
+	 * @brief Placement of a shadow map in the atlas
+	 */
+	struct ShadowView
+	{
+		// Vulkan style view projection matrix of the shadow map
+		glm::mat4 light_matrix;
+
+		// Offset and scale of the tile in the atlas, in texture coordinates
+		glm::vec4 atlas_rect;
+	};
+
+	/**
+	 * @brief Work done by the last draw
+	 */
+	struct Stats
+	{
+		uint32_t tile_count{0};
+
+		uint32_t rendered_tile_count{0};
+
+		uint32_t draw_count{0};
+
+		// Depth written to the rendered tiles, in bytes
+		uint64_t written_bytes{0};
+
+		// Depth the cached tiles did not write, in bytes
+		uint64_t saved_bytes{0};
+	};
+
+	/**
+	 * @brief Constructs a subpass rendering shadow maps
+	 * @param render_context Render context
+	 * @param vertex_shader Vertex shader source, transforming the positions with the GlobalUniform
+	 * @param fragment_shader Fragment shader source
+	 * @param scene Scene casting the shadows
+	 * @param camera Perspective camera the cascades of the directional lights are fitted to
+	 * @param atlas_resolution Width and height of the atlas
+	 * @param tile_resolution Width and height of each shadow map
+	 */
+	ShadowSubpass(RenderContext &render_context, ShaderSource &&vertex_shader, ShaderSource &&fragment_shader, sg::Scene &scene, sg::Camera &camera,
+	              uint32_t atlas_resolution = 4096, uint32_t tile_resolution = 1024);
+
+	virtual ~ShadowSubpass();
+
+	/**
+	 * @brief Creates the atlas
+	 */
+	virtual void prepare() override;
+
+	/**
+	 * @brief Record draw commands for the tiles to render
+	 */
+	virtual void draw(CommandBuffer &command_buffer) override;
+
+	/**
+	 * @brief Adds a light casting shadows
+	 * @param light Directional or spot light, point lights are not supported
+	 * @param cascade_count Number of cascades of a directional light
+	 */
+	void add_light(sg::Light &light, uint32_t cascade_count = 1);
+
+	/**
+	 * @brief Distance from the camera up to which the cascades of the directional lights cover the view
+	 */
+	void set_shadow_distance(float distance);
+
+	/**
+	 * @brief Whether tiles whose content did not change are kept from the previous frames, rather than rendered every frame
+	 */
+	void set_caching(bool caching);
+
+	bool is_caching_enabled() const;
+
+	/**
+	 * @brief Places the shadow maps of the frame and finds the tiles to render. Must be called once per frame,
+	 *        before recording this subpass or reading the shadow views.
+	 */
+	void update_tiles();
+
+	/**
+	 * @return The shadow maps of a light, cascades being ordered from the closest to the camera
+	 */
+	std::vector<ShadowView> get_shadow_views(const sg::Light &light) const;
+
+	RenderTarget &get_atlas();
+
+	/**
+	 * @brief Transitions the atlas for the shadow pass. The content of the atlas is preserved, except before its first use.
+	 *        Recorded outside of the render pass, before it begins.
+	 */
+	void record_atlas_write_barrier(CommandBuffer &command_buffer);
+
+	/**
+	 * @brief Transitions the atlas for sampling in fragment shaders, after the end of the shadow pass
+	 */
+	void record_atlas_read_barrier(CommandBuffer &command_buffer);
+
+	const Stats &get_stats() const;
+
+  protected:
+	/**
+	 * @brief Provides the light matrix of the tile being drawn instead of the view of the camera
+	 */
+	virtual void update_uniform(CommandBuffer &command_buffer, sg::Node &node, size_t thread_index) override;
+
+	virtual void prepare_pipeline_state(CommandBuffer &command_buffer, VkFrontFace front_face, bool double_sided_material) override;
+
+	virtual PipelineLayout &prepare_pipeline_layout(CommandBuffer &command_buffer, const std::vector<ShaderModule *> &shader_modules) override;
+
+	virtual void prepare_push_constants(CommandBuffer &command_buffer, sg::SubMesh &sub_mesh) override;
+
+  private:
+	struct Tile
+	{
+		sg::Light *light{nullptr};
+
+		uint32_t cascade{0};
+
+		uint32_t cascade_count{1};
+
+		VkRect2D rect{};
+
+		ShadowView view{};
+
+		// Camera the casters are culled with, attached to a node outside of the scene
+		std::unique_ptr<sg::Node> node;
+
+		std::unique_ptr<sg::Camera> camera;
+
+		// Opaque submeshes in the frustum of the tile
+		std::vector<std::pair<sg::Node *, sg::SubMesh *>> casters;
+
+		// Hash of the light matrix and of the casters and their transforms, for the current content of the tile
+		size_t content_hash{0};
+
+		bool valid{false};
+
+		bool dirty{true};
+	};
+
+	/**
+	 * @brief Computes the light matrix of a cascade of a directional light
+	 */
+	void fit_cascade(Tile &tile, const glm::mat4 &light_rotation);
+
+	/**
+	 * @brief Computes the light matrix of a spot light
+	 */
+	void fit_spot_light(Tile &tile);
+
+	uint32_t atlas_resolution;
+
+	uint32_t tile_resolution;
+
+	float shadow_distance{100.0f};
+
+	bool caching{true};
+
+	bool atlas_initialized{false};
+
+	std::unique_ptr<RenderTarget> atlas;
+
+	std::vector<Tile> tiles;
+
+	// Tile being drawn
+	const Tile *current_tile{nullptr};
+
+	Stats stats;
+};
+
+}        // namespace vkb
@@ -0,0 +1,88 @@
+/* Copyright (c) 2023, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "rendering/subpasses/visibility_resolve_subpass.h"
+
+#include "rendering/render_context.h"
+#include "rendering/subpasses/visibility_subpass.h"
+
+namespace vkb
+{
+namespace
+{
+// Bindings following the ones of the lighting shader
+constexpr uint32_t GEOMETRY_BUFFERS_BINDING = 5;
+
+constexpr uint32_t BASE_COLOR_TEXTURES_BINDING = 11;
+}        // namespace
+
+VisibilityResolveSubpass::VisibilityResolveSubpass(RenderContext &render_context, ShaderSource &&vertex_shader, ShaderSource &&fragment_shader, sg::Camera &camera, sg::Scene &scene,
+                                                   VisibilitySubpass &visibility_subpass) :
+    LightingSubpass{render_context, std::move(vertex_shader), std::move(fragment_shader), camera, scene},
+    visibility_subpass{visibility_subpass}
+{
+}
+
+void VisibilityResolveSubpass::prepare()
+{
+	auto texture_count = visibility_subpass.get_texture_count();
+
+	if (texture_indexing && texture_count > 0)
+	{
+		auto &limits = render_context.get_device().get_gpu().get_properties().limits;
+
+		if (texture_count > limits.maxPerStageDescriptorSamplers || texture_count > limits.maxPerStageDescriptorSampledImages)
+		{
+			LOGW("Visibility resolve: {} base color textures exceed the per-stage descriptor limits, using the base color factors", texture_count);
+			texture_indexing = false;
+		}
+		else
+		{
+			lighting_variant.add_define("BASE_COLOR_TEXTURES");
+			lighting_variant.add_definitions({"BASE_COLOR_TEXTURE_COUNT " + std::to_string(texture_count)});
+		}
+	}
+	else
+	{
+		texture_indexing = false;
+	}
+
+	LightingSubpass::prepare();
+}
+
+void VisibilityResolveSubpass::draw(CommandBuffer &command_buffer)
+{
+	visibility_subpass.bind_buffers(command_buffer, GEOMETRY_BUFFERS_BINDING);
+
+	if (texture_indexing)
+	{
+		visibility_subpass.bind_textures(command_buffer, BASE_COLOR_TEXTURES_BINDING);
+	}
+
+	LightingSubpass::draw(command_buffer);
+}
+
+void VisibilityResolveSubpass::set_texture_indexing(bool texture_indexing_)
+{
+	texture_indexing = texture_indexing_;
+}
+
+bool VisibilityResolveSubpass::is_texture_indexing_enabled() const
+{
+	return texture_indexing;
+}
+}        // namespace vkb
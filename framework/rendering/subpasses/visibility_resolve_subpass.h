@@ -0,0 +1,63 @@
+/* Copyright (c) 2023, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "rendering/subpasses/lighting_subpass.h"
+
+namespace vkb
+{
+class VisibilitySubpass;
+
+/**
+ * @brief Resolve pass of visibility buffer rendering, lighting the pixels of a visibility buffer
+ *
+ *        For each pixel, the triangle stored in the visibility buffer is fetched from the packed
+ *        buffers of the visibility subpass and intersected with the view ray of the pixel. The
+ *        barycentrics of the intersection interpolate the attributes of the triangle, and the
+ *        barycentrics of the neighbor pixels give the gradients of the texture coordinates.
+ *        The lighting is the same as the LightingSubpass.
+ *
+ *        The visibility buffer is the first input attachment. The buffers of the visibility subpass
+ *        are bound from binding 5, and the base color textures at binding 11 if texture indexing is enabled.
+ */
+class VisibilityResolveSubpass : public LightingSubpass
+{
+  public:
+	VisibilityResolveSubpass(RenderContext &render_context, ShaderSource &&vertex_shader, ShaderSource &&fragment_shader, sg::Camera &camera, sg::Scene &scene,
+	                         VisibilitySubpass &visibility_subpass);
+
+	virtual void prepare() override;
+
+	void draw(CommandBuffer &command_buffer) override;
+
+	/**
+	 * @brief Whether the base color textures are sampled, indexed by material with nonuniformEXT.
+	 *        Requires the shaderSampledImageArrayNonUniformIndexing feature of descriptor indexing,
+	 *        otherwise only the base color factors of the materials are used.
+	 *        Must be set before the subpass is prepared.
+	 */
+	void set_texture_indexing(bool texture_indexing);
+
+	bool is_texture_indexing_enabled() const;
+
+  private:
+	VisibilitySubpass &visibility_subpass;
+
+	bool texture_indexing{false};
+};
+}        // namespace vkb
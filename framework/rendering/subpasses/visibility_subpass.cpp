@@ -0,0 +1,356 @@
+/* Copyright (c) 2023, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "rendering/subpasses/visibility_subpass.h"
+
+#include <algorithm>
+
+#include "common/utils.h"
+#include "common/vk_common.h"
+#include "rendering/render_context.h"
+#include "scene_graph/components/camera.h"
+#include "scene_graph/components/image.h"
+#include "scene_graph/components/material.h"
+#include "scene_graph/components/mesh.h"
+#include "scene_graph/components/pbr_material.h"
+#include "scene_graph/components/sub_mesh.h"
+#include "scene_graph/components/texture.h"
+#include "scene_graph/node.h"
+#include "scene_graph/scene.h"
+
+namespace vkb
+{
+namespace
+{
+// Draws the draw buffers of the render frames have room for when first created
+constexpr size_t MIN_DRAW_CAPACITY = 256;
+
+bool has_attribute_format(const sg::SubMesh &sub_mesh, const std::string &name, VkFormat format, uint32_t stride)
+{
+	sg::VertexAttribute attribute;
+	return sub_mesh.get_attribute(name, attribute) && attribute.format == format && attribute.stride == stride && attribute.offset == 0;
+}
+}        // namespace
+
+VisibilitySubpass::VisibilitySubpass(RenderContext &render_context, ShaderSource &&vertex_source, ShaderSource &&fragment_source, sg::Scene &scene_, sg::Camera &camera) :
+    GeometrySubpass{render_context, std::move(vertex_source), std::move(fragment_source), scene_, camera}
+{
+}
+
+void VisibilitySubpass::prepare()
+{
+	if (!render_context.get_device().get_gpu().get_requested_features().geometryShader)
+	{
+		throw std::runtime_error("Visibility subpass requires the geometryShader feature to read gl_PrimitiveID");
+	}
+
+	GeometrySubpass::prepare();
+
+	pack_meshes();
+
+	draw_buffers.clear();
+	draw_buffers.resize(render_context.get_render_frames().size());
+}
+
+uint32_t VisibilitySubpass::request_material_index(const sg::Material &material)
+{
+	auto it = material_indices.find(&material);
+	if (it != material_indices.end())
+	{
+		return it->second;
+	}
+
+	VisibilityMaterial visibility_material{};
+	visibility_material.base_color_factor  = glm::vec4(1.0f, 0.0f, 0.0f, 1.0f);
+	visibility_material.base_color_texture = -1;
+
+	if (auto pbr_material = dynamic_cast<const sg::PBRMaterial *>(&material))
+	{
+		visibility_material.base_color_factor = pbr_material->base_color_factor;
+	}
+
+	// Same as the G-buffer, the texture replaces the factor
+	auto texture_it = material.textures.find("base_color_texture");
+	if (texture_it != material.textures.end())
+	{
+		auto texture = std::find(textures.begin(), textures.end(), texture_it->second);
+		if (texture == textures.end())
+		{
+			texture = textures.insert(textures.end(), texture_it->second);
+		}
+
+		visibility_material.base_color_texture = static_cast<int32_t>(texture - textures.begin());
+	}
+
+	uint32_t material_index = to_u32(materials.size());
+	materials.push_back(visibility_material);
+	material_indices.emplace(&material, material_index);
+
+	return material_index;
+}
+
+void VisibilitySubpass::pack_meshes()
+{
+	auto &device = render_context.get_device();
+
+	std::vector<glm::vec3> positions;
+	std::vector<glm::vec3> normals;
+	std::vector<glm::vec2> texcoords;
+	std::vector<uint32_t>  indices;
+
+	packed_sub_meshes.clear();
+	material_indices.clear();
+	materials.clear();
+	textures.clear();
+
+	// Append the geometry of every opaque submesh to the shared buffers, converting indices to 32-bit
+	for (auto &mesh : meshes)
+	{
+		for (auto &sub_mesh : mesh->get_submeshes())
+		{
+			if (sub_mesh->get_material()->alpha_mode == sg::AlphaMode::Blend)
+			{
+				continue;
+			}
+
+			if (!has_attribute_format(*sub_mesh, "position", VK_FORMAT_R32G32B32_SFLOAT, sizeof(glm::vec3)))
+			{
+				LOGW("Skipping '{}' in visibility subpass: unsupported position format", sub_mesh->get_name());
+				continue;
+			}
+
+			auto sub_mesh_positions = core::Buffer::copy<glm::vec3>(sub_mesh->vertex_buffers, "position");
+			auto vertex_count       = sub_mesh_positions.size();
+
+			std::vector<glm::vec3> sub_mesh_normals;
+			if (has_attribute_format(*sub_mesh, "normal", VK_FORMAT_R32G32B32_SFLOAT, sizeof(glm::vec3)))
+			{
+				sub_mesh_normals = core::Buffer::copy<glm::vec3>(sub_mesh->vertex_buffers, "normal");
+			}
+			sub_mesh_normals.resize(vertex_count, glm::vec3(0.0f, 0.0f, 1.0f));
+
+			std::vector<glm::vec2> sub_mesh_texcoords;
+			if (has_attribute_format(*sub_mesh, "texcoord_0", VK_FORMAT_R32G32_SFLOAT, sizeof(glm::vec2)))
+			{
+				sub_mesh_texcoords = core::Buffer::copy<glm::vec2>(sub_mesh->vertex_buffers, "texcoord_0");
+			}
+			sub_mesh_texcoords.resize(vertex_count, glm::vec2(0.0f));
+
+			PackedSubMesh packed{};
+			packed.first_index    = to_u32(indices.size());
+			packed.vertex_offset  = static_cast<int32_t>(positions.size());
+			packed.material_index = request_material_index(*sub_mesh->get_material());
+
+			// The triangles are packed in the order they are drawn, so that gl_PrimitiveID indexes them
+			if (sub_mesh->vertex_indices != 0 && sub_mesh->index_buffer)
+			{
+				auto &sub_mesh_index_buffer = *sub_mesh->index_buffer;
+
+				const bool already_mapped = sub_mesh_index_buffer.get_data() != nullptr;
+				if (!already_mapped)
+				{
+					sub_mesh_index_buffer.map();
+				}
+
+				const uint8_t *index_data = sub_mesh_index_buffer.get_data() + sub_mesh->index_offset;
+				for (uint32_t i = 0; i < sub_mesh->vertex_indices; ++i)
+				{
+					if (sub_mesh->index_type == VK_INDEX_TYPE_UINT16)
+					{
+						indices.push_back(reinterpret_cast<const uint16_t *>(index_data)[i]);
+					}
+					else
+					{
+						indices.push_back(reinterpret_cast<const uint32_t *>(index_data)[i]);
+					}
+				}
+
+				if (!already_mapped)
+				{
+					sub_mesh_index_buffer.unmap();
+				}
+			}
+			else
+			{
+				for (uint32_t i = 0; i < sub_mesh->vertices_count; ++i)
+				{
+					indices.push_back(i);
+				}
+			}
+
+			positions.insert(positions.end(), sub_mesh_positions.begin(), sub_mesh_positions.end());
+			normals.insert(normals.end(), sub_mesh_normals.begin(), sub_mesh_normals.end());
+			texcoords.insert(texcoords.end(), sub_mesh_texcoords.begin(), sub_mesh_texcoords.end());
+
+			packed_sub_meshes.emplace(sub_mesh, packed);
+		}
+	}
+
+	if (positions.empty() || indices.empty())
+	{
+		throw std::runtime_error("Visibility subpass has no opaque geometry to draw");
+	}
+
+	// Upload the shared buffers
+	auto &queue          = device.get_queue_by_flags(VK_QUEUE_GRAPHICS_BIT, 0);
+	auto &command_buffer = device.request_command_buffer();
+
+	command_buffer.begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+
+	std::vector<core::Buffer> staging_buffers;
+
+	auto upload = [&](const void *data, size_t size) {
+		core::Buffer stage_buffer{device, size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VMA_MEMORY_USAGE_CPU_ONLY};
+		stage_buffer.update(static_cast<const uint8_t *>(data), size);
+
+		auto buffer = std::make_unique<core::Buffer>(device, size, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VMA_MEMORY_USAGE_GPU_ONLY);
+		command_buffer.copy_buffer(stage_buffer, *buffer, size);
+
+		staging_buffers.push_back(std::move(stage_buffer));
+		return buffer;
+	};
+
+	position_buffer = upload(positions.data(), positions.size() * sizeof(glm::vec3));
+	normal_buffer   = upload(normals.data(), normals.size() * sizeof(glm::vec3));
+	texcoord_buffer = upload(texcoords.data(), texcoords.size() * sizeof(glm::vec2));
+	index_buffer    = upload(indices.data(), indices.size() * sizeof(uint32_t));
+	material_buffer = upload(materials.data(), materials.size() * sizeof(VisibilityMaterial));
+
+	command_buffer.end();
+
+	queue.submit(command_buffer, device.request_fence());
+
+	device.get_fence_pool().wait();
+	device.get_fence_pool().reset();
+	device.get_command_pool().reset_pool();
+
+	geometry_size = position_buffer->get_size() + normal_buffer->get_size() + texcoord_buffer->get_size() + index_buffer->get_size();
+
+	LOGI("Visibility subpass packed {} vertices, {} indices, {} materials and {} textures",
+	     positions.size(), indices.size(), materials.size(), textures.size());
+}
+
+void VisibilitySubpass::draw(CommandBuffer &command_buffer)
+{
+	get_sorted_nodes(opaque_nodes, transparent_nodes);
+
+	frame_draws.clear();
+
+	{
+		ScopedDebugLabel opaque_debug_label{command_buffer, "Opaque objects"};
+
+		for (auto &node : opaque_nodes)
+		{
+			auto packed_it = packed_sub_meshes.find(node.second);
+			if (packed_it == packed_sub_meshes.end())
+			{
+				continue;
+			}
+
+			VisibilityDraw draw{};
+			draw.model          = node.first->get_transform().get_world_matrix();
+			draw.first_index    = packed_it->second.first_index;
+			draw.vertex_offset  = packed_it->second.vertex_offset;
+			draw.material_index = packed_it->second.material_index;
+
+			current_draw_index = to_u32(frame_draws.size());
+			frame_draws.push_back(draw);
+
+			draw_opaque_submesh(command_buffer, *node.first, *node.second, thread_index);
+		}
+	}
+
+	if (frame_draws.empty())
+	{
+		return;
+	}
+
+	auto frame_index = render_context.get_active_frame_index();
+	if (frame_index >= draw_buffers.size())
+	{
+		draw_buffers.resize(frame_index + 1);
+	}
+
+	// The previous draws of the render frame were read by a submission that completed
+	auto &draw_buffer = draw_buffers[frame_index];
+	auto  draws_size  = frame_draws.size() * sizeof(VisibilityDraw);
+
+	if (!draw_buffer || draw_buffer->get_size() < draws_size)
+	{
+		auto capacity = std::max(MIN_DRAW_CAPACITY, frame_draws.size() * 2) * sizeof(VisibilityDraw);
+		draw_buffer   = std::make_unique<core::Buffer>(render_context.get_device(), capacity, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU);
+	}
+
+	draw_buffer->update(reinterpret_cast<const uint8_t *>(frame_draws.data()), draws_size);
+}
+
+void VisibilitySubpass::update_uniform(CommandBuffer &command_buffer, sg::Node &node, size_t thread_index)
+{
+	VisibilityUniform visibility_uniform{};
+
+	visibility_uniform.model            = node.get_transform().get_world_matrix();
+	visibility_uniform.camera_view_proj = camera.get_pre_rotation() * vkb::vulkan_style_projection(camera.get_projection()) * camera.get_view();
+	visibility_uniform.draw_index       = current_draw_index;
+
+	auto &render_frame = get_render_context().get_active_frame();
+
+	auto allocation = render_frame.allocate_buffer(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, sizeof(VisibilityUniform), thread_index);
+
+	allocation.update(visibility_uniform);
+
+	command_buffer.bind_buffer(allocation.get_buffer(), allocation.get_offset(), allocation.get_size(), 0, 1, 0);
+}
+
+uint32_t VisibilitySubpass::get_lod(const sg::Node & /*node*/, const sg::SubMesh & /*sub_mesh*/) const
+{
+	// gl_PrimitiveID counts from the first index of the drawn level, which the resolve reads from the first level
+	return 0;
+}
+
+void VisibilitySubpass::bind_buffers(CommandBuffer &command_buffer, uint32_t first_binding) const
+{
+	auto frame_index = render_context.get_active_frame_index();
+	assert(frame_index < draw_buffers.size() && draw_buffers[frame_index] && "The draws of the frame are written when the visibility buffer is drawn");
+
+	auto &draw_buffer = draw_buffers[frame_index];
+
+	command_buffer.bind_buffer(*position_buffer, 0, position_buffer->get_size(), 0, first_binding, 0);
+	command_buffer.bind_buffer(*normal_buffer, 0, normal_buffer->get_size(), 0, first_binding + 1, 0);
+	command_buffer.bind_buffer(*texcoord_buffer, 0, texcoord_buffer->get_size(), 0, first_binding + 2, 0);
+	command_buffer.bind_buffer(*index_buffer, 0, index_buffer->get_size(), 0, first_binding + 3, 0);
+	command_buffer.bind_buffer(*draw_buffer, 0, draw_buffer->get_size(), 0, first_binding + 4, 0);
+	command_buffer.bind_buffer(*material_buffer, 0, material_buffer->get_size(), 0, first_binding + 5, 0);
+}
+
+void VisibilitySubpass::bind_textures(CommandBuffer &command_buffer, uint32_t binding) const
+{
+	for (uint32_t i = 0; i < to_u32(textures.size()); ++i)
+	{
+		command_buffer.bind_image(textures[i]->get_image()->get_vk_image_view(), textures[i]->get_sampler()->vk_sampler, 0, binding, i);
+	}
+}
+
+uint32_t VisibilitySubpass::get_texture_count() const
+{
+	return to_u32(textures.size());
+}
+
+uint64_t VisibilitySubpass::get_geometry_size() const
+{
+	return geometry_size;
+}
+}        // namespace vkb
@@ -0,0 +1,187 @@
+/* Copyright (c) 2023, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "rendering/subpasses/geometry_subpass.h"
+
+namespace vkb
+{
+namespace sg
+{
+class Texture;
+}        // namespace sg
+
+/**
+ * @brief Uniform of the visibility shaders, the model and view projection matrices of GlobalUniform
+ *        followed by the index of the draw in the draw buffer
+ */
+struct alignas(16) VisibilityUniform
+{
+	glm::mat4 model;
+
+	glm::mat4 camera_view_proj;
+
+	uint32_t draw_index;
+};
+
+/**
+ * @brief A draw of the visibility buffer, read by the resolve to find the triangles of its pixels
+ */
+struct alignas(16) VisibilityDraw
+{
+	glm::mat4 model;
+
+	// Location of the submesh in the packed index and vertex buffers
+	uint32_t first_index;
+
+	int32_t vertex_offset;
+
+	uint32_t material_index;
+
+	uint32_t padding;
+};
+
+/**
+ * @brief A material of the visibility buffer, read by the resolve
+ */
+struct alignas(16) VisibilityMaterial
+{
+	glm::vec4 base_color_factor;
+
+	// Index in the base color textures, or -1 if the material has none
+	int32_t base_color_texture;
+
+	uint32_t padding[3];
+};
+
+/**
+ * @brief This subpass renders a Scene into a visibility buffer
+ *
+ *        Rather than the attributes of the surfaces, each pixel only stores the draw and the triangle
+ *        covering it, in a R32G32_UINT attachment. The draw index is offset by one, so that zero
+ *        means that no triangle covers the pixel.
+ *
+ *        On prepare, the geometry of the submeshes is packed into shared storage buffers, which the
+ *        resolve reads along with the draws of the frame to reconstruct the attributes of the pixels.
+ *        The fragment shader reads gl_PrimitiveID, which requires the geometryShader feature.
+ *
+ *        Only opaque submeshes are drawn, without instancing and at their first level of detail.
+ */
+class VisibilitySubpass : public GeometrySubpass
+{
+  public:
+	/**
+	 * @brief Constructs a subpass for the visibility pass of visibility buffer rendering
+	 * @param render_context Render context
+	 * @param vertex_shader Vertex shader source
+	 * @param fragment_shader Fragment shader source, writing the draw and triangle indices
+	 * @param scene Scene to render on this subpass
+	 * @param camera Camera used to look at the scene
+	 */
+	VisibilitySubpass(RenderContext &render_context, ShaderSource &&vertex_shader, ShaderSource &&fragment_shader, sg::Scene &scene, sg::Camera &camera);
+
+	virtual ~VisibilitySubpass() = default;
+
+	virtual void prepare() override;
+
+	/**
+	 * @brief Record draw commands, and write the draws of the active frame
+	 */
+	virtual void draw(CommandBuffer &command_buffer) override;
+
+	/**
+	 * @brief Binds the storage buffers read by the resolve, at set 0 and consecutive bindings:
+	 *        the positions, normals, texture coordinates, indices, draws of the active frame and materials
+	 * @param command_buffer Command buffer to bind the buffers on
+	 * @param first_binding Binding of the positions
+	 */
+	void bind_buffers(CommandBuffer &command_buffer, uint32_t first_binding) const;
+
+	/**
+	 * @brief Binds the base color textures indexed by the materials, at set 0 and consecutive array elements of a binding
+	 */
+	void bind_textures(CommandBuffer &command_buffer, uint32_t binding) const;
+
+	/**
+	 * @brief Number of base color textures indexed by the materials
+	 */
+	uint32_t get_texture_count() const;
+
+	/**
+	 * @brief Size of the packed vertex and index buffers, in bytes
+	 */
+	uint64_t get_geometry_size() const;
+
+  protected:
+	virtual void update_uniform(CommandBuffer &command_buffer, sg::Node &node, size_t thread_index) override;
+
+	/**
+	 * @brief Always draws the first level of detail, the only one packed for the resolve
+	 */
+	virtual uint32_t get_lod(const sg::Node &node, const sg::SubMesh &sub_mesh) const override;
+
+  private:
+	/**
+	 * @brief Location of a submesh in the packed buffers
+	 */
+	struct PackedSubMesh
+	{
+		uint32_t first_index;
+
+		int32_t vertex_offset;
+
+		uint32_t material_index;
+	};
+
+	void pack_meshes();
+
+	uint32_t request_material_index(const sg::Material &material);
+
+	std::unique_ptr<core::Buffer> position_buffer;
+
+	std::unique_ptr<core::Buffer> normal_buffer;
+
+	std::unique_ptr<core::Buffer> texcoord_buffer;
+
+	std::unique_ptr<core::Buffer> index_buffer;
+
+	std::unique_ptr<core::Buffer> material_buffer;
+
+	// Draws written by each render frame, grown as needed
+	std::vector<std::unique_ptr<core::Buffer>> draw_buffers;
+
+	std::unordered_map<const sg::SubMesh *, PackedSubMesh> packed_sub_meshes;
+
+	std::unordered_map<const sg::Material *, uint32_t> material_indices;
+
+	std::vector<VisibilityMaterial> materials;
+
+	std::vector<sg::Texture *> textures;
+
+	std::vector<VisibilityDraw> frame_draws;
+
+	std::vector<std::pair<sg::Node *, sg::SubMesh *>> opaque_nodes;
+
+	std::vector<std::pair<sg::Node *, sg::SubMesh *>> transparent_nodes;
+
+	uint64_t geometry_size{0};
+
+	// Index of the draw being recorded, written to the uniform of its node
+	uint32_t current_draw_index{0};
+};
+}        // namespace vkb
@@ -0,0 +1,311 @@
+/* Copyright (c) 2023, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "rendering/transient_attachment_allocator.h"
+
+#include <algorithm>
+#include <map>
+
+#include "common/error.h"
+#include "common/utils.h"
+#include "core/device.h"
+
+namespace vkb
+{
+namespace
+{
+VkDeviceSize align_up(VkDeviceSize offset, VkDeviceSize alignment)
+{
+	return (offset + alignment - 1) / alignment * alignment;
+}
+}        // namespace
+
+TransientAttachmentAllocator::TransientAttachmentAllocator(Device &device) :
+    device{device}
+{
+}
+
+TransientAttachmentAllocator::~TransientAttachmentAllocator()
+{
+	reset();
+}
+
+uint32_t TransientAttachmentAllocator::add_image(const VkExtent3D &extent, VkFormat format, VkImageUsageFlags usage, uint32_t first_use, uint32_t last_use,
+                                                 VkSampleCountFlagBits sample_count)
+{
+	assert(allocations.empty() && "Images cannot be declared once allocated");
+	assert(first_use <= last_use && "The first use of an image must not be after its last use");
+
+	ImageInfo image{};
+	image.create_info.imageType     = VK_IMAGE_TYPE_2D;
+	image.create_info.format        = format;
+	image.create_info.extent        = extent;
+	image.create_info.mipLevels     = 1;
+	image.create_info.arrayLayers   = 1;
+	image.create_info.samples       = sample_count;
+	image.create_info.tiling        = VK_IMAGE_TILING_OPTIMAL;
+	image.create_info.usage         = usage;
+	image.create_info.sharingMode   = VK_SHARING_MODE_EXCLUSIVE;
+	image.create_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	image.first_use                 = first_use;
+	image.last_use                  = last_use;
+
+	images.push_back(image);
+
+	return to_u32(images.size() - 1);
+}
+
+void TransientAttachmentAllocator::allocate(bool aliasing)
+{
+	assert(allocations.empty() && "Images are already allocated");
+
+	stats = {};
+
+	// Images can only share memory of the same type
+	std::map<uint32_t, std::vector<uint32_t>> memory_type_images;
+
+	for (uint32_t i = 0; i < to_u32(images.size()); ++i)
+	{
+		auto &image = images[i];
+
+		VK_CHECK(vkCreateImage(device.get_handle(), &image.create_info, nullptr, &image.handle));
+
+		vkGetImageMemoryRequirements(device.get_handle(), image.handle, &image.memory_requirements);
+
+		find_memory_type(image);
+
+		memory_type_images[image.memory_type].push_back(i);
+
+		stats.image_memory += image.memory_requirements.size;
+	}
+
+	for (auto &memory_type : memory_type_images)
+	{
+		if (aliasing)
+		{
+			VkDeviceSize alignment = 1;
+			for (uint32_t i : memory_type.second)
+			{
+				alignment = std::max(alignment, images[i].memory_requirements.alignment);
+			}
+
+			allocate_memory(memory_type.second, place_images(memory_type.second), alignment);
+		}
+		else
+		{
+			for (uint32_t i : memory_type.second)
+			{
+				images[i].memory_offset = 0;
+				allocate_memory({i}, images[i].memory_requirements.size, images[i].memory_requirements.alignment);
+			}
+		}
+	}
+
+	for (auto &image : images)
+	{
+		VK_CHECK(vmaBindImageMemory2(device.get_memory_allocator(), allocations[image.allocation].handle, image.memory_offset, image.handle, nullptr));
+	}
+
+	for (auto &allocation : allocations)
+	{
+		if (allocation.lazy)
+		{
+			stats.lazy_memory += allocation.size;
+		}
+		else
+		{
+			stats.allocated_memory += allocation.size;
+		}
+	}
+}
+
+void TransientAttachmentAllocator::reset()
+{
+	for (auto &image : images)
+	{
+		if (image.handle != VK_NULL_HANDLE)
+		{
+			vkDestroyImage(device.get_handle(), image.handle, nullptr);
+		}
+	}
+	images.clear();
+
+	for (auto &allocation : allocations)
+	{
+		vmaFreeMemory(device.get_memory_allocator(), allocation.handle);
+	}
+	allocations.clear();
+
+	stats = {};
+}
+
+core::Image TransientAttachmentAllocator::get_image(uint32_t index) const
+{
+	auto &image = images.at(index);
+	assert(image.handle != VK_NULL_HANDLE && "Images are not allocated");
+
+	// Images created without memory are not destroyed by core::Image
+	return core::Image{device, image.handle, image.create_info.extent, image.create_info.format, image.create_info.usage, image.create_info.samples};
+}
+
+bool TransientAttachmentAllocator::is_aliased(uint32_t first_image, uint32_t second_image) const
+{
+	auto &first  = images.at(first_image);
+	auto &second = images.at(second_image);
+
+	return first_image != second_image && first.allocation == second.allocation &&
+	       first.memory_offset < second.memory_offset + second.memory_requirements.size &&
+	       second.memory_offset < first.memory_offset + first.memory_requirements.size;
+}
+
+VkDeviceSize TransientAttachmentAllocator::get_committed_lazy_memory() const
+{
+	VkDeviceSize committed_memory = 0;
+
+	for (auto &allocation : allocations)
+	{
+		if (allocation.lazy)
+		{
+			VmaAllocationInfo allocation_info{};
+			vmaGetAllocationInfo(device.get_memory_allocator(), allocation.handle, &allocation_info);
+
+			VkDeviceSize committed = 0;
+			vkGetDeviceMemoryCommitment(device.get_handle(), allocation_info.deviceMemory, &committed);
+
+			committed_memory += committed;
+		}
+	}
+
+	return committed_memory;
+}
+
+const TransientAttachmentAllocator::Stats &TransientAttachmentAllocator::get_stats() const
+{
+	return stats;
+}
+
+void TransientAttachmentAllocator::find_memory_type(ImageInfo &image) const
+{
+	VmaAllocationCreateInfo allocation_info{};
+	allocation_info.usage = VMA_MEMORY_USAGE_GPU_ONLY;
+
+	VkResult result = VK_ERROR_FEATURE_NOT_PRESENT;
+
+	// Only transient attachments may be bound to lazily allocated memory
+	if (image.create_info.usage & VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT)
+	{
+		allocation_info.requiredFlags = VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT;
+		result = vmaFindMemoryTypeIndex(device.get_memory_allocator(), image.memory_requirements.memoryTypeBits, &allocation_info, &image.memory_type);
+	}
+
+	if (result != VK_SUCCESS)
+	{
+		allocation_info.requiredFlags = 0;
+		VK_CHECK(vmaFindMemoryTypeIndex(device.get_memory_allocator(), image.memory_requirements.memoryTypeBits, &allocation_info, &image.memory_type));
+	}
+
+	auto &memory_properties = device.get_gpu().get_memory_properties();
+
+	image.lazy = (memory_properties.memoryTypes[image.memory_type].propertyFlags & VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT) != 0;
+}
+
+VkDeviceSize TransientAttachmentAllocator::place_images(const std::vector<uint32_t> &image_indices)
+{
+	std::vector<uint32_t> order{image_indices};
+
+	// Place the largest images first, the smaller ones then fill the gaps
+	std::stable_sort(order.begin(), order.end(), [this](uint32_t a, uint32_t b) { return images[a].memory_requirements.size > images[b].memory_requirements.size; });
+
+	VkDeviceSize memory_size = 0;
+
+	std::vector<uint32_t> placed;
+
+	for (uint32_t i : order)
+	{
+		auto &image = images[i];
+
+		// Images needed at the same time must not overlap in memory
+		std::vector<uint32_t> live_images;
+		for (uint32_t j : placed)
+		{
+			if (images[j].first_use <= image.last_use && image.first_use <= images[j].last_use)
+			{
+				live_images.push_back(j);
+			}
+		}
+
+		// The lowest offset is either the start of the memory, or the end of a live image
+		std::vector<VkDeviceSize> candidates{0};
+		for (uint32_t j : live_images)
+		{
+			candidates.push_back(images[j].memory_offset + images[j].memory_requirements.size);
+		}
+		std::sort(candidates.begin(), candidates.end());
+
+		for (VkDeviceSize candidate : candidates)
+		{
+			VkDeviceSize offset = align_up(candidate, image.memory_requirements.alignment);
+			VkDeviceSize end    = offset + image.memory_requirements.size;
+
+			bool overlaps = std::any_of(live_images.begin(), live_images.end(), [this, offset, end](uint32_t j) {
+				return offset < images[j].memory_offset + images[j].memory_requirements.size && images[j].memory_offset < end;
+			});
+
+			if (!overlaps)
+			{
+				image.memory_offset = offset;
+				memory_size         = std::max(memory_size, end);
+				break;
+			}
+		}
+
+		placed.push_back(i);
+	}
+
+	return memory_size;
+}
+
+void TransientAttachmentAllocator::allocate_memory(const std::vector<uint32_t> &image_indices, VkDeviceSize size, VkDeviceSize alignment)
+{
+	auto &first_image = images[image_indices.front()];
+
+	VkMemoryRequirements memory_requirements{size, alignment, 1U << first_image.memory_type};
+
+	VmaAllocationCreateInfo allocation_info{};
+	allocation_info.usage = VMA_MEMORY_USAGE_GPU_ONLY;
+
+	if (first_image.lazy)
+	{
+		// Its own device memory, so that the memory committed for it can be queried
+		allocation_info.flags         = VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT;
+		allocation_info.requiredFlags = VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT;
+	}
+
+	Allocation allocation{};
+	allocation.size = size;
+	allocation.lazy = first_image.lazy;
+
+	VK_CHECK(vmaAllocateMemory(device.get_memory_allocator(), &memory_requirements, &allocation_info, &allocation.handle, nullptr));
+
+	for (uint32_t i : image_indices)
+	{
+		images[i].allocation = to_u32(allocations.size());
+	}
+
+	allocations.push_back(allocation);
+}
+}        // namespace vkb
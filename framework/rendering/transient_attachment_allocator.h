@@ -0,0 +1,166 @@
+/* Copyright (c) 2023, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <vector>
+
+#include "common/vk_common.h"
+#include "core/image.h"
+
+namespace vkb
+{
+class Device;
+
+/**
+ * @brief Allocates the attachments of a frame which are only needed during part of it
+ *
+ *        Each image is declared with the first and last uses it is needed for, in an order chosen
+ *        by the caller, such as the passes of the frame. When aliasing, images whose uses do not
+ *        overlap are placed in the same memory, with one allocation per memory type. Otherwise
+ *        each image gets an allocation of its own.
+ *
+ *        Images with VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT are bound to lazily allocated memory
+ *        when the device has such a memory type, which tile-based GPUs only commit if the
+ *        attachment has to leave the tile memory.
+ *
+ *        The allocator owns the images and their memory, and hands out core::Image objects which
+ *        do not own them, to build image views and render targets. It must outlive them.
+ */
+class TransientAttachmentAllocator
+{
+  public:
+	struct Stats
+	{
+		// Memory the images would take with one allocation each
+		VkDeviceSize image_memory{0};
+
+		// Device memory allocated for the images, excluding the lazily allocated memory
+		VkDeviceSize allocated_memory{0};
+
+		// Lazily allocated memory reserved for the transient attachments
+		VkDeviceSize lazy_memory{0};
+	};
+
+	TransientAttachmentAllocator(Device &device);
+
+	TransientAttachmentAllocator(const TransientAttachmentAllocator &) = delete;
+
+	TransientAttachmentAllocator(TransientAttachmentAllocator &&) = delete;
+
+	~TransientAttachmentAllocator();
+
+	TransientAttachmentAllocator &operator=(const TransientAttachmentAllocator &) = delete;
+
+	TransientAttachmentAllocator &operator=(TransientAttachmentAllocator &&) = delete;
+
+	/**
+	 * @brief Declares an image
+	 * @param extent Extent of the image
+	 * @param format Format of the image
+	 * @param usage Usage of the image
+	 * @param first_use First use the image is needed for
+	 * @param last_use Last use the image is needed for, inclusive
+	 * @param sample_count Number of samples of the image
+	 * @return Index of the image
+	 */
+	uint32_t add_image(const VkExtent3D &extent, VkFormat format, VkImageUsageFlags usage, uint32_t first_use, uint32_t last_use,
+	                   VkSampleCountFlagBits sample_count = VK_SAMPLE_COUNT_1_BIT);
+
+	/**
+	 * @brief Creates the declared images and binds them to memory
+	 * @param aliasing Whether images with disjoint uses share memory
+	 */
+	void allocate(bool aliasing = true);
+
+	/**
+	 * @brief Destroys the images and frees their memory, so that other images can be declared
+	 */
+	void reset();
+
+	/**
+	 * @return An image which does not own its handle nor its memory
+	 */
+	core::Image get_image(uint32_t index) const;
+
+	/**
+	 * @return Whether two images are bound to overlapping memory. The image used later must then wait
+	 *         for the accesses to the other one before overwriting it.
+	 */
+	bool is_aliased(uint32_t first_image, uint32_t second_image) const;
+
+	/**
+	 * @return The lazily allocated memory the driver has currently committed
+	 */
+	VkDeviceSize get_committed_lazy_memory() const;
+
+	const Stats &get_stats() const;
+
+  private:
+	struct ImageInfo
+	{
+		VkImageCreateInfo create_info{VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO};
+
+		uint32_t first_use{0};
+
+		uint32_t last_use{0};
+
+		VkImage handle{VK_NULL_HANDLE};
+
+		VkMemoryRequirements memory_requirements{};
+
+		uint32_t memory_type{0};
+
+		bool lazy{false};
+
+		// Allocation the image is bound to, and its offset in it
+		uint32_t allocation{0};
+
+		VkDeviceSize memory_offset{0};
+	};
+
+	struct Allocation
+	{
+		VmaAllocation handle{VK_NULL_HANDLE};
+
+		VkDeviceSize size{0};
+
+		bool lazy{false};
+	};
+
+	/**
+	 * @brief Finds the memory type of an image, lazily allocated if possible
+	 */
+	void find_memory_type(ImageInfo &image) const;
+
+	/**
+	 * @brief Places images in a shared memory range, so that images needed at the same time do not overlap
+	 * @return Size of the memory range
+	 */
+	VkDeviceSize place_images(const std::vector<uint32_t> &image_indices);
+
+	void allocate_memory(const std::vector<uint32_t> &image_indices, VkDeviceSize size, VkDeviceSize alignment);
+
+	Device &device;
+
+	std::vector<ImageInfo> images;
+
+	std::vector<Allocation> allocations;
+
+	Stats stats;
+};
+}        // namespace vkb
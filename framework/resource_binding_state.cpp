@@ -69,7 +69,7 @@ void ResourceBindingState::bind_input(const core::ImageView &image_view, uint32_
 	dirty = true;
 }
 
-const std::unordered_map<uint32_t, ResourceSet> &ResourceBindingState::get_resource_sets()
+const std::unordered_map<uint32_t, ResourceSet> &ResourceBindingState::get_resource_sets() const
 {
 	return resource_sets;
 }
@@ -102,7 +102,7 @@ class ResourceBindingState
 
 	void bind_input(const core::ImageView &image_view, uint32_t set, uint32_t binding, uint32_t array_element);
 
-	const std::unordered_map<uint32_t, ResourceSet> &get_resource_sets();
+	const std::unordered_map<uint32_t, ResourceSet> &get_resource_sets() const;
 
   private:
 	bool dirty{false};
@@ -0,0 +1,584 @@
+/* Copyright (c) 2023, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "bounding_volume_hierarchy.h"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <numeric>
+
+#include "geometry/frustum.h"
+#include "scene_graph/components/mesh.h"
+#include "scene_graph/components/transform.h"
+#include "scene_graph/node.h"
+
+namespace vkb
+{
+namespace sg
+{
+namespace
+{
+// Parent index of the root node
+constexpr uint32_t no_parent = ~0u;
+
+inline float get_surface_area(const glm::vec3 &min, const glm::vec3 &max)
+{
+	glm::vec3 size = max - min;
+	return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+}
+
+enum class Containment
+{
+	Outside,
+	Intersecting,
+	Inside
+};
+
+inline Containment classify_bounds(const std::array<glm::vec4, 6> &planes, const glm::vec3 &min, const glm::vec3 &max)
+{
+	glm::vec3 center = (min + max) * 0.5f;
+	glm::vec3 extent = (max - min) * 0.5f;
+
+	Containment containment = Containment::Inside;
+
+	for (auto &plane : planes)
+	{
+		float distance = glm::dot(glm::vec3(plane), center) + plane.w;
+		float radius   = glm::dot(glm::abs(glm::vec3(plane)), extent);
+
+		if (distance <= -radius)
+		{
+			return Containment::Outside;
+		}
+
+		if (distance < radius)
+		{
+			containment = Containment::Intersecting;
+		}
+	}
+
+	return containment;
+}
+
+inline bool intersect_sphere(const glm::vec3 &center, float radius, const glm::vec3 &min, const glm::vec3 &max)
+{
+	glm::vec3 offset = center - glm::clamp(center, min, max);
+	return glm::dot(offset, offset) <= radius * radius;
+}
+
+inline bool intersect_ray_bounds(const glm::vec3 &origin, const glm::vec3 &inverse_direction, float max_distance,
+                                 const glm::vec3 &min, const glm::vec3 &max, float &distance)
+{
+	glm::vec3 t0    = (min - origin) * inverse_direction;
+	glm::vec3 t1    = (max - origin) * inverse_direction;
+	glm::vec3 t_min = glm::min(t0, t1);
+	glm::vec3 t_max = glm::max(t0, t1);
+
+	float entry = std::max(std::max(t_min.x, t_min.y), std::max(t_min.z, 0.0f));
+	float exit  = std::min(std::min(t_max.x, t_max.y), std::min(t_max.z, max_distance));
+
+	distance = entry;
+	return entry <= exit;
+}
+}        // namespace
+
+BoundingVolumeHierarchy::BoundingVolumeHierarchy(const std::vector<Mesh *> &meshes) :
+    meshes{meshes}
+{
+}
+
+uint32_t BoundingVolumeHierarchy::update()
+{
+	if (!built || count_instances() != instance_nodes.size())
+	{
+		build();
+		return get_instance_count();
+	}
+
+	return refit();
+}
+
+void BoundingVolumeHierarchy::invalidate()
+{
+	built = false;
+}
+
+void BoundingVolumeHierarchy::query_frustum(const Frustum &frustum, std::vector<uint32_t> &instances) const
+{
+	if (nodes.empty())
+	{
+		return;
+	}
+
+	auto &planes = frustum.get_planes();
+
+	std::vector<uint32_t> stack;
+	stack.reserve(2 * depth + 1);
+	stack.push_back(0);
+
+	while (!stack.empty())
+	{
+		auto &node = nodes[stack.back()];
+		stack.pop_back();
+
+		auto containment = classify_bounds(planes, node.min, node.max);
+
+		if (containment == Containment::Outside)
+		{
+			continue;
+		}
+
+		if (containment == Containment::Inside)
+		{
+			instances.insert(instances.end(), ordered_instances.begin() + node.first_instance,
+			                 ordered_instances.begin() + node.first_instance + node.instance_count);
+		}
+		else if (node.first_child == 0)
+		{
+			for (uint32_t i = node.first_instance; i < node.first_instance + node.instance_count; ++i)
+			{
+				uint32_t instance = ordered_instances[i];
+				if (classify_bounds(planes, instance_min[instance], instance_max[instance]) != Containment::Outside)
+				{
+					instances.push_back(instance);
+				}
+			}
+		}
+		else
+		{
+			stack.push_back(node.first_child + 1);
+			stack.push_back(node.first_child);
+		}
+	}
+}
+
+void BoundingVolumeHierarchy::query_sphere(const glm::vec3 &center, float radius, std::vector<uint32_t> &instances) const
+{
+	if (nodes.empty())
+	{
+		return;
+	}
+
+	std::vector<uint32_t> stack;
+	stack.reserve(2 * depth + 1);
+	stack.push_back(0);
+
+	while (!stack.empty())
+	{
+		auto &node = nodes[stack.back()];
+		stack.pop_back();
+
+		if (!intersect_sphere(center, radius, node.min, node.max))
+		{
+			continue;
+		}
+
+		if (node.first_child == 0)
+		{
+			for (uint32_t i = node.first_instance; i < node.first_instance + node.instance_count; ++i)
+			{
+				uint32_t instance = ordered_instances[i];
+				if (intersect_sphere(center, radius, instance_min[instance], instance_max[instance]))
+				{
+					instances.push_back(instance);
+				}
+			}
+		}
+		else
+		{
+			stack.push_back(node.first_child + 1);
+			stack.push_back(node.first_child);
+		}
+	}
+}
+
+bool BoundingVolumeHierarchy::intersect_ray(const glm::vec3 &origin, const glm::vec3 &direction, RayHit &hit, float max_distance) const
+{
+	hit = {};
+
+	if (nodes.empty())
+	{
+		return false;
+	}
+
+	glm::vec3 inverse_direction = 1.0f / direction;
+
+	float distance = 0.0f;
+	if (!intersect_ray_bounds(origin, inverse_direction, max_distance, nodes[0].min, nodes[0].max, distance))
+	{
+		return false;
+	}
+
+	// Nodes to visit with their entry distance, the closest child is visited first
+	std::vector<std::pair<uint32_t, float>> stack;
+	stack.reserve(2 * depth + 1);
+	stack.emplace_back(0, distance);
+
+	while (!stack.empty())
+	{
+		auto entry = stack.back();
+		stack.pop_back();
+
+		// Skip the nodes behind the closest hit so far
+		if (entry.second > std::min(hit.distance, max_distance))
+		{
+			continue;
+		}
+
+		auto &node = nodes[entry.first];
+
+		if (node.first_child == 0)
+		{
+			for (uint32_t i = node.first_instance; i < node.first_instance + node.instance_count; ++i)
+			{
+				uint32_t instance = ordered_instances[i];
+				if (intersect_ray_bounds(origin, inverse_direction, std::min(hit.distance, max_distance), instance_min[instance], instance_max[instance], distance))
+				{
+					hit.instance = instance;
+					hit.distance = distance;
+				}
+			}
+			continue;
+		}
+
+		float left_distance  = 0.0f;
+		float right_distance = 0.0f;
+
+		auto &left  = nodes[node.first_child];
+		auto &right = nodes[node.first_child + 1];
+
+		bool left_hit  = intersect_ray_bounds(origin, inverse_direction, max_distance, left.min, left.max, left_distance);
+		bool right_hit = intersect_ray_bounds(origin, inverse_direction, max_distance, right.min, right.max, right_distance);
+
+		if (left_hit && right_hit)
+		{
+			// The last pushed node is visited first
+			if (left_distance < right_distance)
+			{
+				stack.emplace_back(node.first_child + 1, right_distance);
+				stack.emplace_back(node.first_child, left_distance);
+			}
+			else
+			{
+				stack.emplace_back(node.first_child, left_distance);
+				stack.emplace_back(node.first_child + 1, right_distance);
+			}
+		}
+		else if (left_hit)
+		{
+			stack.emplace_back(node.first_child, left_distance);
+		}
+		else if (right_hit)
+		{
+			stack.emplace_back(node.first_child + 1, right_distance);
+		}
+	}
+
+	return hit.instance != std::numeric_limits<uint32_t>::max();
+}
+
+uint32_t BoundingVolumeHierarchy::get_instance_count() const
+{
+	return static_cast<uint32_t>(instance_nodes.size());
+}
+
+Node &BoundingVolumeHierarchy::get_instance_node(uint32_t instance) const
+{
+	assert(instance < instance_nodes.size() && "Instance index out of range");
+	return *instance_nodes[instance];
+}
+
+Mesh &BoundingVolumeHierarchy::get_instance_mesh(uint32_t instance) const
+{
+	assert(instance < instance_meshes.size() && "Instance index out of range");
+	return *instance_meshes[instance];
+}
+
+void BoundingVolumeHierarchy::get_instance_bounds(uint32_t instance, glm::vec3 &min, glm::vec3 &max) const
+{
+	assert(instance < instance_min.size() && "Instance index out of range");
+
+	min = instance_min[instance];
+	max = instance_max[instance];
+}
+
+const std::vector<uint32_t> &BoundingVolumeHierarchy::get_instance_order() const
+{
+	return ordered_instances;
+}
+
+uint32_t BoundingVolumeHierarchy::get_node_count() const
+{
+	return static_cast<uint32_t>(nodes.size());
+}
+
+uint32_t BoundingVolumeHierarchy::get_depth() const
+{
+	return depth;
+}
+
+float BoundingVolumeHierarchy::get_refit_cost_ratio() const
+{
+	return build_cost > 0.0f ? cost / build_cost : 1.0f;
+}
+
+void BoundingVolumeHierarchy::build()
+{
+	instance_nodes.clear();
+	instance_meshes.clear();
+	instance_transforms.clear();
+
+	for (auto mesh : meshes)
+	{
+		for (auto node : mesh->get_nodes())
+		{
+			instance_nodes.push_back(node);
+			instance_meshes.push_back(mesh);
+			instance_transforms.push_back(&node->get_transform());
+		}
+	}
+
+	const uint32_t instance_count = get_instance_count();
+
+	instance_versions.resize(instance_count);
+	instance_min.resize(instance_count);
+	instance_max.resize(instance_count);
+	instance_leaves.resize(instance_count);
+
+	std::vector<glm::vec3> centers(instance_count);
+
+	for (uint32_t i = 0; i < instance_count; ++i)
+	{
+		update_instance_bounds(i);
+		centers[i] = (instance_min[i] + instance_max[i]) * 0.5f;
+	}
+
+	ordered_instances.resize(instance_count);
+	std::iota(ordered_instances.begin(), ordered_instances.end(), 0);
+
+	nodes.clear();
+	parents.clear();
+	depth = 0;
+	built = true;
+
+	if (instance_count == 0)
+	{
+		build_cost = 0.0f;
+		cost       = 0.0f;
+		return;
+	}
+
+	nodes.reserve(2 * (instance_count / MAX_LEAF_SIZE + 1));
+	parents.reserve(nodes.capacity());
+
+	nodes.push_back({glm::vec3(0.0f), 0, glm::vec3(0.0f), instance_count, 0});
+	parents.push_back(no_parent);
+
+	// Nodes left to split, with their depth level
+	std::vector<std::pair<uint32_t, uint32_t>> pending_nodes{{0, 1}};
+
+	while (!pending_nodes.empty())
+	{
+		auto pending = pending_nodes.back();
+		pending_nodes.pop_back();
+
+		uint32_t index = pending.first;
+		depth          = std::max(depth, pending.second);
+
+		compute_node_bounds(nodes[index]);
+
+		uint32_t first = nodes[index].first_instance;
+		uint32_t count = nodes[index].instance_count;
+
+		if (count <= MAX_LEAF_SIZE)
+		{
+			for (uint32_t i = first; i < first + count; ++i)
+			{
+				instance_leaves[ordered_instances[i]] = index;
+			}
+			continue;
+		}
+
+		// Split at the median of the longest axis of the centers
+		glm::vec3 center_min{std::numeric_limits<float>::max()};
+		glm::vec3 center_max{-std::numeric_limits<float>::max()};
+
+		for (uint32_t i = first; i < first + count; ++i)
+		{
+			center_min = glm::min(center_min, centers[ordered_instances[i]]);
+			center_max = glm::max(center_max, centers[ordered_instances[i]]);
+		}
+
+		glm::vec3 center_extent = center_max - center_min;
+
+		int axis = 0;
+		if (center_extent.y > center_extent[axis])
+		{
+			axis = 1;
+		}
+		if (center_extent.z > center_extent[axis])
+		{
+			axis = 2;
+		}
+
+		uint32_t left_count = count / 2;
+
+		auto range_begin = ordered_instances.begin() + first;
+		std::nth_element(range_begin, range_begin + left_count, range_begin + count, [&centers, axis](uint32_t a, uint32_t b) {
+			return centers[a][axis] < centers[b][axis];
+		});
+
+		uint32_t first_child     = static_cast<uint32_t>(nodes.size());
+		nodes[index].first_child = first_child;
+
+		nodes.push_back({glm::vec3(0.0f), first, glm::vec3(0.0f), left_count, 0});
+		nodes.push_back({glm::vec3(0.0f), first + left_count, glm::vec3(0.0f), count - left_count, 0});
+		parents.push_back(index);
+		parents.push_back(index);
+
+		pending_nodes.emplace_back(first_child + 1, pending.second + 1);
+		pending_nodes.emplace_back(first_child, pending.second + 1);
+	}
+
+	cost = 0.0f;
+	for (auto &node : nodes)
+	{
+		cost += get_surface_area(node.min, node.max);
+	}
+	build_cost = cost;
+}
+
+uint32_t BoundingVolumeHierarchy::refit()
+{
+	refit_nodes.assign(nodes.size(), 0);
+
+	uint32_t refit_count = 0;
+
+	for (uint32_t i = 0; i < get_instance_count(); ++i)
+	{
+		if (instance_transforms[i]->get_world_matrix_version() == instance_versions[i])
+		{
+			continue;
+		}
+
+		update_instance_bounds(i);
+		refit_count++;
+
+		// Mark the ancestors, up to one marked by another instance
+		for (uint32_t node = instance_leaves[i]; node != no_parent && !refit_nodes[node]; node = parents[node])
+		{
+			refit_nodes[node] = 1;
+		}
+	}
+
+	if (refit_count == 0)
+	{
+		return 0;
+	}
+
+	// Children are stored after their parent, so they are refit first
+	for (size_t i = nodes.size(); i-- > 0;)
+	{
+		if (!refit_nodes[i])
+		{
+			continue;
+		}
+
+		auto &node = nodes[i];
+
+		cost -= get_surface_area(node.min, node.max);
+
+		if (node.first_child == 0)
+		{
+			compute_node_bounds(node);
+		}
+		else
+		{
+			auto &left  = nodes[node.first_child];
+			auto &right = nodes[node.first_child + 1];
+
+			node.min = glm::min(left.min, right.min);
+			node.max = glm::max(left.max, right.max);
+		}
+
+		cost += get_surface_area(node.min, node.max);
+	}
+
+	if (cost > build_cost * REBUILD_COST_RATIO)
+	{
+		build();
+	}
+
+	return refit_count;
+}
+
+void BoundingVolumeHierarchy::update_instance_bounds(uint32_t instance)
+{
+	auto &transform = *instance_transforms[instance];
+
+	instance_versions[instance] = transform.get_world_matrix_version();
+
+	glm::mat4 world_matrix = transform.get_world_matrix();
+
+	const AABB &bounds = instance_meshes[instance]->get_bounds();
+
+	// Meshes without bounds are reduced to the origin of their node
+	if (!glm::all(glm::lessThanEqual(bounds.get_min(), bounds.get_max())))
+	{
+		instance_min[instance] = glm::vec3(world_matrix[3]);
+		instance_max[instance] = glm::vec3(world_matrix[3]);
+		return;
+	}
+
+	glm::vec3 center = glm::vec3(world_matrix * glm::vec4(bounds.get_center(), 1.0f));
+
+	glm::vec3 local_extent = (bounds.get_max() - bounds.get_min()) * 0.5f;
+
+	// Extent of the transformed box along the world axes
+	glm::vec3 extent = glm::abs(glm::vec3(world_matrix[0])) * local_extent.x +
+	                   glm::abs(glm::vec3(world_matrix[1])) * local_extent.y +
+	                   glm::abs(glm::vec3(world_matrix[2])) * local_extent.z;
+
+	instance_min[instance] = center - extent;
+	instance_max[instance] = center + extent;
+}
+
+void BoundingVolumeHierarchy::compute_node_bounds(TreeNode &node) const
+{
+	node.min = glm::vec3(std::numeric_limits<float>::max());
+	node.max = glm::vec3(-std::numeric_limits<float>::max());
+
+	for (uint32_t i = node.first_instance; i < node.first_instance + node.instance_count; ++i)
+	{
+		node.min = glm::min(node.min, instance_min[ordered_instances[i]]);
+		node.max = glm::max(node.max, instance_max[ordered_instances[i]]);
+	}
+}
+
+uint32_t BoundingVolumeHierarchy::count_instances() const
+{
+	size_t count = 0;
+	for (auto mesh : meshes)
+	{
+		count += mesh->get_nodes().size();
+	}
+	return static_cast<uint32_t>(count);
+}
+}        // namespace sg
+}        // namespace vkb
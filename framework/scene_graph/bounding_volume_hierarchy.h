@@ -0,0 +1,210 @@
+/* Copyright (c) 2023, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "common/error.h"
+
+VKBP_DISABLE_WARNINGS()
+#include "common/glm_common.h"
+VKBP_ENABLE_WARNINGS()
+
+namespace vkb
+{
+class Frustum;
+
+namespace sg
+{
+class Mesh;
+class Node;
+class Transform;
+
+/**
+ * @brief A bounding volume hierarchy over the world space bounds of the mesh instances of a scene
+ *
+ *        The tree is built top-down, splitting the instances of each node at the median of the
+ *        longest axis of their centers. Its nodes are stored depth first, so a parent is always
+ *        stored before its children, and the instances under a node form a contiguous range.
+ *
+ *        On update, only the instances whose transform changed get their bounds recomputed,
+ *        and the bounds of their ancestors are refit. The tree is built again when the
+ *        instances of the scene change, or when refitting degraded it too much.
+ *
+ *        The hierarchy is not thread safe, queries must not run concurrently with an update.
+ */
+class BoundingVolumeHierarchy
+{
+  public:
+	/**
+	 * @brief The closest instance hit by a ray
+	 */
+	struct RayHit
+	{
+		uint32_t instance{std::numeric_limits<uint32_t>::max()};
+
+		// Distance along the ray to the bounds of the instance, zero if the ray starts inside
+		float distance{std::numeric_limits<float>::max()};
+	};
+
+	/**
+	 * @param meshes Meshes of the scene, kept up to date by the scene
+	 */
+	BoundingVolumeHierarchy(const std::vector<Mesh *> &meshes);
+
+	/**
+	 * @brief Builds the tree if needed, otherwise refits the bounds of the instances whose transform changed
+	 * @return The number of instances whose bounds were computed
+	 */
+	uint32_t update();
+
+	/**
+	 * @brief Builds the tree again on the next update
+	 */
+	void invalidate();
+
+	/**
+	 * @brief Finds the instances whose bounds intersect a frustum. Whole subtrees inside
+	 *        the frustum are added without testing their instances.
+	 * @param frustum The frustum to test
+	 * @param instances Receives the indices of the instances, in tree order
+	 */
+	void query_frustum(const Frustum &frustum, std::vector<uint32_t> &instances) const;
+
+	/**
+	 * @brief Finds the instances whose bounds intersect a sphere, such as the range of a light
+	 * @param center Center of the sphere
+	 * @param radius Radius of the sphere
+	 * @param instances Receives the indices of the instances, in tree order
+	 */
+	void query_sphere(const glm::vec3 &center, float radius, std::vector<uint32_t> &instances) const;
+
+	/**
+	 * @brief Finds the closest instance whose bounds are hit by a ray
+	 * @param origin Origin of the ray
+	 * @param direction Direction of the ray, not necessarily normalized
+	 * @param hit Receives the instance and the distance in units of the direction length
+	 * @param max_distance Distance past which hits are ignored
+	 * @return True if an instance was hit
+	 */
+	bool intersect_ray(const glm::vec3 &origin, const glm::vec3 &direction, RayHit &hit, float max_distance = std::numeric_limits<float>::max()) const;
+
+	uint32_t get_instance_count() const;
+
+	Node &get_instance_node(uint32_t instance) const;
+
+	Mesh &get_instance_mesh(uint32_t instance) const;
+
+	/**
+	 * @brief Gets the world space bounds of an instance, as of the last update
+	 */
+	void get_instance_bounds(uint32_t instance, glm::vec3 &min, glm::vec3 &max) const;
+
+	/**
+	 * @return The instances in tree order, which keeps instances close in space next to each other
+	 */
+	const std::vector<uint32_t> &get_instance_order() const;
+
+	uint32_t get_node_count() const;
+
+	uint32_t get_depth() const;
+
+	/**
+	 * @return The surface area of the nodes relative to when the tree was built, which grows as refitting degrades it
+	 */
+	float get_refit_cost_ratio() const;
+
+	/// Maximum number of instances in a leaf node
+	static constexpr uint32_t MAX_LEAF_SIZE = 4;
+
+	/// Refit cost ratio above which the tree is built again
+	static constexpr float REBUILD_COST_RATIO = 2.0f;
+
+  private:
+	struct TreeNode
+	{
+		glm::vec3 min;
+
+		uint32_t first_instance;
+
+		glm::vec3 max;
+
+		uint32_t instance_count;
+
+		// Index of the first of the two children, the second one follows it. Zero for leaves.
+		uint32_t first_child;
+	};
+
+	/**
+	 * @brief Gathers the instances of the meshes, and builds the tree over their bounds
+	 */
+	void build();
+
+	/**
+	 * @return The number of instances whose bounds were updated
+	 */
+	uint32_t refit();
+
+	/**
+	 * @brief Computes the world space bounds of an instance, and records the version of its transform
+	 */
+	void update_instance_bounds(uint32_t instance);
+
+	void compute_node_bounds(TreeNode &node) const;
+
+	uint32_t count_instances() const;
+
+	const std::vector<Mesh *> &meshes;
+
+	bool built{false};
+
+	std::vector<TreeNode> nodes;
+
+	std::vector<uint32_t> parents;
+
+	// Instances in tree order, each leaf referencing a contiguous range of it
+	std::vector<uint32_t> ordered_instances;
+
+	std::vector<Node *> instance_nodes;
+
+	std::vector<Mesh *> instance_meshes;
+
+	std::vector<Transform *> instance_transforms;
+
+	std::vector<uint32_t> instance_versions;
+
+	std::vector<glm::vec3> instance_min;
+
+	std::vector<glm::vec3> instance_max;
+
+	// Leaf node containing each instance
+	std::vector<uint32_t> instance_leaves;
+
+	// Nodes whose bounds must be refit, kept to reuse its storage
+	std::vector<uint8_t> refit_nodes;
+
+	uint32_t depth{0};
+
+	float build_cost{0.0f};
+
+	float cost{0.0f};
+};
+}        // namespace sg
+}        // namespace vkb
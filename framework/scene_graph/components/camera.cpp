@@ -40,7 +40,7 @@ glm::mat4 Camera::get_view()
 		throw std::runtime_error{"Camera component is not attached to a node"};
 	}
 
-	auto &transform = node->get_component<Transform>();
+	auto &transform = node->get_transform();
 	return glm::inverse(transform.get_world_matrix());
 }
 
@@ -63,5 +63,29 @@ void Camera::set_pre_rotation(const glm::mat4 &pr)
 {
 	pre_rotation = pr;
 }
+
+void Camera::set_jitter(const glm::vec2 &j)
+{
+	jitter = j;
+}
+
+const glm::vec2 &Camera::get_jitter() const
+{
+	return jitter;
+}
+
+glm::mat4 Camera::apply_jitter(const glm::mat4 &projection) const
+{
+	// Add the offset scaled by w to the clip space position, so that it is constant in NDC.
+	// vulkan_style_projection only negates the y scale, so the y offset is not flipped
+	glm::mat4 jittered = projection;
+	for (int column = 0; column < 4; ++column)
+	{
+		jittered[column][0] += jitter.x * projection[column][3];
+		jittered[column][1] += jitter.y * projection[column][3];
+	}
+
+	return jittered;
+}
 }        // namespace sg
 }        // namespace vkb
\ No newline at end of file
@@ -56,10 +56,27 @@ class Camera : public Component
 
 	void set_pre_rotation(const glm::mat4 &pre_rotation);
 
+	/**
+	 * @brief Offsets the projection by a fraction of a pixel, for temporal anti-aliasing and upscaling
+	 * @param jitter Offset in normalized device coordinates, with y pointing down as in Vulkan
+	 *               (a pixel of a render target of extent w x h is 2/w x 2/h)
+	 */
+	void set_jitter(const glm::vec2 &jitter);
+
+	const glm::vec2 &get_jitter() const;
+
+  protected:
+	/**
+	 * @brief Applies the jitter to a projection matrix, for get_projection() implementations
+	 */
+	glm::mat4 apply_jitter(const glm::mat4 &projection) const;
+
   private:
 	Node *node{nullptr};
 
 	glm::mat4 pre_rotation{1.0f};
+
+	glm::vec2 jitter{0.0f};
 };
 }        // namespace sg
 }        // namespace vkb
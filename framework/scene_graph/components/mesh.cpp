@@ -59,5 +59,33 @@ const std::vector<Node *> &Mesh::get_nodes() const
 {
 	return nodes;
 }
+
+void Mesh::set_morph_weights(const std::vector<float> &weights)
+{
+	morph_weights = weights;
+}
+
+const std::vector<float> &Mesh::get_morph_weights() const
+{
+	return morph_weights;
+}
+
+void Mesh::set_occluder_bounds(const glm::vec3 &min, const glm::vec3 &max)
+{
+	occluder_bounds.reset();
+	occluder_bounds.update(min);
+	occluder_bounds.update(max);
+	occluder = true;
+}
+
+bool Mesh::has_occluder_bounds() const
+{
+	return occluder;
+}
+
+const AABB &Mesh::get_occluder_bounds() const
+{
+	return occluder_bounds;
+}
 }        // namespace sg
 }        // namespace vkb
@@ -52,12 +52,35 @@ class Mesh : public Component
 
 	const std::vector<Node *> &get_nodes() const;
 
+	/**
+	 * @brief Sets the weights of the morph targets of the submeshes
+	 */
+	void set_morph_weights(const std::vector<float> &weights);
+
+	const std::vector<float> &get_morph_weights() const;
+
+	/**
+	 * @brief Sets a box lying entirely inside the closed geometry of the mesh, in model space.
+	 *        Only meshes with such a box occlude other instances in the occlusion culling.
+	 */
+	void set_occluder_bounds(const glm::vec3 &min, const glm::vec3 &max);
+
+	bool has_occluder_bounds() const;
+
+	const AABB &get_occluder_bounds() const;
+
   private:
 	AABB bounds;
 
+	AABB occluder_bounds;
+
+	bool occluder{false};
+
 	std::vector<SubMesh *> submeshes;
 
 	std::vector<Node *> nodes;
+
+	std::vector<float> morph_weights;
 };
 }        // namespace sg
 }        // namespace vkb
@@ -72,7 +72,7 @@ float PerspectiveCamera::get_aspect_ratio()
 glm::mat4 PerspectiveCamera::get_projection()
 {
 	// Note: Using Revsered depth-buffer for increased precision, so Znear and Zfar are flipped
-	return glm::perspective(fov, aspect_ratio, far_plane, near_plane);
+	return apply_jitter(glm::perspective(fov, aspect_ratio, far_plane, near_plane));
 }
 }        // namespace sg
 }        // namespace vkb
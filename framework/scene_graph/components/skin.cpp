@@ -0,0 +1,64 @@
+/* Copyright (c) 2023, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "skin.h"
+
+#include "scene_graph/node.h"
+
+namespace vkb
+{
+namespace sg
+{
+Skin::Skin(const std::string &name) :
+    Component{name}
+{}
+
+std::type_index Skin::get_type()
+{
+	return typeid(Skin);
+}
+
+void Skin::add_joint(Node &joint, const glm::mat4 &inverse_bind_matrix)
+{
+	joints.push_back(&joint);
+	inverse_bind_matrices.push_back(inverse_bind_matrix);
+}
+
+const std::vector<Node *> &Skin::get_joints() const
+{
+	return joints;
+}
+
+const std::vector<glm::mat4> &Skin::get_inverse_bind_matrices() const
+{
+	return inverse_bind_matrices;
+}
+
+void Skin::compute_joint_matrices(const glm::mat4 &node_world_matrix, std::vector<glm::mat4> &joint_matrices) const
+{
+	// The skinned node transform is applied when drawing, so it is removed from the joint matrices
+	glm::mat4 inverse_node_matrix = glm::inverse(node_world_matrix);
+
+	joint_matrices.resize(joints.size());
+
+	for (size_t i = 0; i < joints.size(); ++i)
+	{
+		joint_matrices[i] = inverse_node_matrix * joints[i]->get_transform().get_world_matrix() * inverse_bind_matrices[i];
+	}
+}
+}        // namespace sg
+}        // namespace vkb
@@ -0,0 +1,73 @@
+/* Copyright (c) 2023, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <string>
+#include <typeinfo>
+#include <vector>
+
+#include "common/error.h"
+
+VKBP_DISABLE_WARNINGS()
+#include "common/glm_common.h"
+VKBP_ENABLE_WARNINGS()
+
+#include "scene_graph/component.h"
+
+namespace vkb
+{
+namespace sg
+{
+class Node;
+
+/**
+ * @brief Joints deforming the vertices of the meshes of a node
+ *
+ *        Each vertex of a skinned submesh is moved by up to four joints, weighted by its
+ *        joints_0 and weights_0 attributes. The inverse bind matrix of a joint takes the
+ *        vertices from model space to the space of the joint in the bind pose.
+ */
+class Skin : public Component
+{
+  public:
+	Skin(const std::string &name = {});
+
+	virtual ~Skin() = default;
+
+	virtual std::type_index get_type() override;
+
+	void add_joint(Node &joint, const glm::mat4 &inverse_bind_matrix);
+
+	const std::vector<Node *> &get_joints() const;
+
+	const std::vector<glm::mat4> &get_inverse_bind_matrices() const;
+
+	/**
+	 * @brief Computes the matrices moving the vertices from the bind pose to the current pose of the joints
+	 * @param node_world_matrix World matrix of the skinned node, the vertices stay in its space
+	 * @param joint_matrices Filled with a matrix per joint
+	 */
+	void compute_joint_matrices(const glm::mat4 &node_world_matrix, std::vector<glm::mat4> &joint_matrices) const;
+
+  private:
+	std::vector<Node *> joints;
+
+	std::vector<glm::mat4> inverse_bind_matrices;
+};
+}        // namespace sg
+}        // namespace vkb
@@ -17,6 +17,8 @@
 
 #include "sub_mesh.h"
 
+#include <algorithm>
+
 #include "material.h"
 #include "rendering/subpass.h"
 
@@ -54,6 +56,48 @@ bool SubMesh::get_attribute(const std::string &attribute_name, VertexAttribute &
 	return true;
 }
 
+const core::Buffer *SubMesh::find_vertex_buffer(const std::string &name, const Node *node) const
+{
+	// Buffers deformed for the node, then the ones shared by all the nodes
+	for (auto deformed_node : {node, static_cast<const Node *>(nullptr)})
+	{
+		auto node_it = deformed_vertex_buffers.find(deformed_node);
+		if (node_it == deformed_vertex_buffers.end())
+		{
+			continue;
+		}
+
+		auto deformed_it = node_it->second.find(name);
+		if (deformed_it != node_it->second.end())
+		{
+			return deformed_it->second;
+		}
+	}
+
+	auto buffer_it = vertex_buffers.find(name);
+	if (buffer_it != vertex_buffers.end())
+	{
+		return &buffer_it->second;
+	}
+
+	return nullptr;
+}
+
+bool SubMesh::has_node_deformation(const Node &node) const
+{
+	return deformed_vertex_buffers.count(&node) > 0;
+}
+
+SubMeshLod SubMesh::get_lod(std::uint32_t lod) const
+{
+	if (lods.empty())
+	{
+		return {0, vertex_indices, 0.0f};
+	}
+
+	return lods[std::min<size_t>(lod, lods.size() - 1)];
+}
+
 void SubMesh::set_material(const Material &new_material)
 {
 	material = &new_material;
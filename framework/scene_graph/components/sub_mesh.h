@@ -33,6 +33,7 @@ namespace vkb
 namespace sg
 {
 class Material;
+class Node;
 
 struct VertexAttribute
 {
@@ -43,6 +44,19 @@ struct VertexAttribute
 	std::uint32_t offset = 0;
 };
 
+/**
+ * @brief A level of detail of a submesh, drawn with a range of its index buffer
+ */
+struct SubMeshLod
+{
+	std::uint32_t first_index = 0;
+
+	std::uint32_t index_count = 0;
+
+	// Largest distance the simplification moved a vertex by, in model space
+	float error = 0.0f;
+};
+
 class SubMesh : public Component
 {
   public:
@@ -64,6 +78,44 @@ class SubMesh : public Component
 
 	std::unique_ptr<core::Buffer> index_buffer;
 
+	/**
+	 * @brief Levels of detail sharing the vertices of the submesh, from the most detailed one.
+	 *        Empty if none were generated, otherwise the first level draws the first vertex_indices indices.
+	 */
+	std::vector<SubMeshLod> lods;
+
+	/**
+	 * @brief Vertex buffers written by the GPU skinning for each node, replacing the buffers of the same name
+	 *        when drawing the node. Buffers under a null node are shared by the nodes without their own.
+	 */
+	std::unordered_map<const Node *, std::unordered_map<std::string, const core::Buffer *>> deformed_vertex_buffers;
+
+	/**
+	 * @brief Position and normal offsets of the morph targets, as a vec4 per vertex.
+	 *        For each target, the position offsets of all the vertices are followed by their normal offsets.
+	 */
+	std::unique_ptr<core::Buffer> morph_target_buffer;
+
+	std::uint32_t morph_target_count = 0;
+
+	/**
+	 * @brief Finds the vertex buffer to draw an attribute with, the deformed one if any
+	 * @param node Node drawing the submesh, whose deformed buffers are preferred
+	 * @return The vertex buffer, or nullptr if the submesh has no buffer for the attribute
+	 */
+	const core::Buffer *find_vertex_buffer(const std::string &name, const Node *node = nullptr) const;
+
+	/**
+	 * @return Whether the node draws the submesh with vertex buffers deformed for it alone
+	 */
+	bool has_node_deformation(const Node &node) const;
+
+	/**
+	 * @brief Gets a level of detail, or the least detailed one if there are fewer levels.
+	 *        Without levels of detail, all the indices are drawn.
+	 */
+	SubMeshLod get_lod(std::uint32_t lod) const;
+
 	void set_attribute(const std::string &name, const VertexAttribute &attribute);
 
 	bool get_attribute(const std::string &name, VertexAttribute &attribute) const;
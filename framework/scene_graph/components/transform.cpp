@@ -23,6 +23,7 @@ VKBP_DISABLE_WARNINGS()
 VKBP_ENABLE_WARNINGS()
 
 #include "scene_graph/node.h"
+#include "scene_graph/transform_hierarchy.h"
 
 namespace vkb
 {
@@ -97,6 +98,11 @@ glm::mat4 Transform::get_matrix() const
 
 glm::mat4 Transform::get_world_matrix()
 {
+	if (hierarchy)
+	{
+		return hierarchy->get_world_matrix(hierarchy_index);
+	}
+
 	update_world_transform();
 
 	return world_matrix;
@@ -104,7 +110,36 @@ glm::mat4 Transform::get_world_matrix()
 
 void Transform::invalidate_world_matrix()
 {
+	if (hierarchy)
+	{
+		hierarchy->set_local_matrix(hierarchy_index, get_matrix());
+		hierarchy->set_dirty(hierarchy_index);
+		return;
+	}
+
+	// The descendants of an invalid transform are invalid already
+	if (update_world_matrix)
+	{
+		return;
+	}
+
 	update_world_matrix = true;
+	world_matrix_version++;
+
+	for (auto child : node.get_children())
+	{
+		child->get_transform().invalidate_world_matrix();
+	}
+}
+
+TransformHierarchy *Transform::get_hierarchy() const
+{
+	return hierarchy;
+}
+
+uint32_t Transform::get_world_matrix_version() const
+{
+	return world_matrix_version;
 }
 
 void Transform::update_world_transform()
@@ -120,8 +155,7 @@ void Transform::update_world_transform()
 
 	if (parent)
 	{
-		auto &transform = parent->get_component<Transform>();
-		world_matrix    = transform.get_world_matrix() * world_matrix;
+		world_matrix = parent->get_transform().get_world_matrix() * world_matrix;
 	}
 
 	update_world_matrix = false;
@@ -36,6 +36,7 @@ namespace vkb
 namespace sg
 {
 class Node;
+class TransformHierarchy;
 
 class Transform : public Component
 {
@@ -69,11 +70,25 @@ class Transform : public Component
 	/**
 	 * @brief Marks the world transform invalid if any of
 	 *        the local transform are changed or the parent
-	 *        world transform has changed.
+	 *        world transform has changed. The world transforms
+	 *        of the descendants are invalidated as well.
 	 */
 	void invalidate_world_matrix();
 
+	/**
+	 * @return The hierarchy storing the matrices of this transform, if any
+	 */
+	TransformHierarchy *get_hierarchy() const;
+
+	/**
+	 * @brief Incremented whenever the world matrix becomes invalid, so that changes
+	 *        can be detected without computing the world matrix
+	 */
+	uint32_t get_world_matrix_version() const;
+
   private:
+	friend class TransformHierarchy;
+
 	Node &node;
 
 	glm::vec3 translation = glm::vec3(0.0, 0.0, 0.0);
@@ -86,6 +101,12 @@ class Transform : public Component
 
 	bool update_world_matrix = false;
 
+	TransformHierarchy *hierarchy{nullptr};
+
+	uint32_t hierarchy_index{0};
+
+	uint32_t world_matrix_version{0};
+
 	void update_world_transform();
 };
 
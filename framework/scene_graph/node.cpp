@@ -19,6 +19,7 @@
 
 #include "component.h"
 #include "components/transform.h"
+#include "transform_hierarchy.h"
 
 namespace vkb
 {
@@ -46,6 +47,11 @@ void Node::set_parent(Node &p)
 {
 	parent = &p;
 
+	if (auto hierarchy = transform.get_hierarchy())
+	{
+		hierarchy->invalidate_structure();
+	}
+
 	transform.invalidate_world_matrix();
 }
 
@@ -56,6 +62,11 @@ Node *Node::get_parent() const
 
 void Node::add_child(Node &child)
 {
+	if (auto hierarchy = transform.get_hierarchy())
+	{
+		hierarchy->invalidate_structure();
+	}
+
 	children.push_back(&child);
 }
 
@@ -58,10 +58,14 @@ class Node
 
 	void set_component(Component &component);
 
+	/**
+	 * @brief Gets the component stored under the type T, which Component::get_type returns for it
+	 */
 	template <class T>
 	inline T &get_component()
 	{
-		return dynamic_cast<T &>(get_component(typeid(T)));
+		// The component stored under a type derives from it, a static cast is enough
+		return static_cast<T &>(get_component(typeid(T)));
 	}
 
 	Component &get_component(const std::type_index index);
@@ -66,6 +66,9 @@ std::unique_ptr<Component> Scene::get_model(uint32_t index)
 {
 	auto meshes = std::move(components.at(typeid(SubMesh)));
 
+	components.at(typeid(SubMesh)).clear();
+	update_component_pool(typeid(SubMesh));
+
 	assert(index < meshes.size());
 	return std::move(meshes[index]);
 }
@@ -74,23 +77,39 @@ void Scene::add_component(std::unique_ptr<Component> &&component, Node &node)
 {
 	node.set_component(*component);
 
-	if (component)
-	{
-		components[component->get_type()].push_back(std::move(component));
-	}
+	add_component(std::move(component));
 }
 
 void Scene::add_component(std::unique_ptr<Component> &&component)
 {
 	if (component)
 	{
-		components[component->get_type()].push_back(std::move(component));
+		auto type_info = component->get_type();
+
+		auto pool_it = component_pools.find(type_info);
+		if (pool_it != component_pools.end())
+		{
+			pool_it->second->add(*component);
+		}
+
+		components[type_info].push_back(std::move(component));
 	}
 }
 
 void Scene::set_components(const std::type_index &type_info, std::vector<std::unique_ptr<Component>> &&new_components)
 {
 	components[type_info] = std::move(new_components);
+
+	update_component_pool(type_info);
+}
+
+void Scene::update_component_pool(const std::type_index &type_info)
+{
+	auto pool_it = component_pools.find(type_info);
+	if (pool_it != component_pools.end())
+	{
+		pool_it->second->assign(components[type_info]);
+	}
 }
 
 const std::vector<std::unique_ptr<Component>> &Scene::get_components(const std::type_index &type_info) const
@@ -134,6 +153,8 @@ Node *Scene::find_node(const std::string &node_name)
 void Scene::set_root_node(Node &node)
 {
 	root = &node;
+
+	transform_hierarchy->set_root(node);
 }
 
 Node &Scene::get_root_node()
@@ -141,6 +162,31 @@ Node &Scene::get_root_node()
 	return *root;
 }
 
+TransformHierarchy &Scene::get_transform_hierarchy()
+{
+	return *transform_hierarchy;
+}
+
+BoundingVolumeHierarchy &Scene::get_bounding_volume_hierarchy()
+{
+	if (!bounding_volume_hierarchy)
+	{
+		bounding_volume_hierarchy = std::make_unique<BoundingVolumeHierarchy>(get_component_view<Mesh>());
+	}
+
+	return *bounding_volume_hierarchy;
+}
+
+VisibilityCulling &Scene::get_visibility_culling()
+{
+	if (!visibility_culling)
+	{
+		visibility_culling = std::make_unique<VisibilityCulling>(get_component_view<Mesh>(), get_bounding_volume_hierarchy());
+	}
+
+	return *visibility_culling;
+}
+
 #ifdef ENABLE_RAYTRACING_SCENE_GRAPH
 void Scene::build_acceleration_structure(vkb::Device const &device)
 {
@@ -200,29 +246,33 @@ void Scene::build_acceleration_structure(vkb::Device const &device)
 	top_level_acceleration_structure = std::make_unique<vkb::core::AccelerationStructure>(const_cast<vkb::Device &>(device), VK_ACCELERATION_STRUCTURE_TYPE_TOP_LEVEL_KHR);
 	std::vector<VkAccelerationStructureInstanceKHR> acceleration_structure_instances;
 	
-	for (auto& mesh : get_components<vkb::sg::Mesh>())
+	// Add the instances in the order of the bounding volume hierarchy, so instances close in space are close in the TLAS input
+	auto &hierarchy = get_bounding_volume_hierarchy();
+	hierarchy.update();
+
+	for (auto instance : hierarchy.get_instance_order())
 	{
-		for (auto& node : mesh->get_nodes())
+		auto &mesh = hierarchy.get_instance_mesh(instance);
+		auto &node = hierarchy.get_instance_node(instance);
+
+		for (auto& submesh : mesh.get_submeshes())
 		{
-			for (auto& submesh : mesh->get_submeshes())
+			auto iter = bottom_level_acceleration_structures.find(submesh);
+			if (iter != bottom_level_acceleration_structures.end())
 			{
-				auto iter = bottom_level_acceleration_structures.find(submesh);
-				if (iter != bottom_level_acceleration_structures.end())
-				{
-					// NOTE: column major
-					auto instance_transform_matrix = node->get_transform().get_world_matrix();
-					VkAccelerationStructureInstanceKHR acceleration_structure_instance;
-					acceleration_structure_instance.transform = {instance_transform_matrix[0].x, instance_transform_matrix[1].x, instance_transform_matrix[2].x, instance_transform_matrix[3].x,
-					                                             instance_transform_matrix[0].y, instance_transform_matrix[1].y, instance_transform_matrix[2].y, instance_transform_matrix[3].y,
-					                                             instance_transform_matrix[0].z, instance_transform_matrix[1].z, instance_transform_matrix[2].z, instance_transform_matrix[3].z};
-					acceleration_structure_instance.instanceCustomIndex                        = 0;
-					acceleration_structure_instance.mask                                       = 0xFF;
-					acceleration_structure_instance.instanceShaderBindingTableRecordOffset     = 0;
-					acceleration_structure_instance.flags                                      = VK_GEOMETRY_INSTANCE_TRIANGLE_FACING_CULL_DISABLE_BIT_KHR;
-					acceleration_structure_instance.accelerationStructureReference             = iter->second->get_device_address();
-
-					acceleration_structure_instances.push_back(acceleration_structure_instance);
-				}
+				// NOTE: column major
+				auto instance_transform_matrix = node.get_transform().get_world_matrix();
+				VkAccelerationStructureInstanceKHR acceleration_structure_instance;
+				acceleration_structure_instance.transform = {instance_transform_matrix[0].x, instance_transform_matrix[1].x, instance_transform_matrix[2].x, instance_transform_matrix[3].x,
+				                                             instance_transform_matrix[0].y, instance_transform_matrix[1].y, instance_transform_matrix[2].y, instance_transform_matrix[3].y,
+				                                             instance_transform_matrix[0].z, instance_transform_matrix[1].z, instance_transform_matrix[2].z, instance_transform_matrix[3].z};
+				acceleration_structure_instance.instanceCustomIndex                        = 0;
+				acceleration_structure_instance.mask                                       = 0xFF;
+				acceleration_structure_instance.instanceShaderBindingTableRecordOffset     = 0;
+				acceleration_structure_instance.flags                                      = VK_GEOMETRY_INSTANCE_TRIANGLE_FACING_CULL_DISABLE_BIT_KHR;
+				acceleration_structure_instance.accelerationStructureReference             = iter->second->get_device_address();
+
+				acceleration_structure_instances.push_back(acceleration_structure_instance);
 			}
 		}
 	}
@@ -237,7 +287,7 @@ void Scene::build_acceleration_structure(vkb::Device const &device)
 	top_level_acceleration_structure->add_instance_geometry(instances_buffer, static_cast<uint32_t>(instances_count));
 
 	top_level_acceleration_structure->build(device.get_suitable_graphics_queue().get_handle(), VK_BUILD_ACCELERATION_STRUCTURE_PREFER_FAST_TRACE_BIT_KHR, VK_BUILD_ACCELERATION_STRUCTURE_MODE_BUILD_KHR);
-	LOGI("Built TLAS");
+	LOGI("Built TLAS with {} instances, in the order of a BVH of depth {}", instances_count, hierarchy.get_depth());
 }
 
 std::unique_ptr<vkb::core::AccelerationStructure>& Scene::get_acceleration_structure()
@@ -25,7 +25,10 @@
 #include <vector>
 
 #include "scene_graph/components/light.h"
+#include "scene_graph/bounding_volume_hierarchy.h"
 #include "scene_graph/components/texture.h"
+#include "scene_graph/transform_hierarchy.h"
+#include "scene_graph/visibility_culling.h"
 #include "common/ray_tracing_common.h"
 
 #ifdef ENABLE_RAYTRACING_SCENE_GRAPH
@@ -102,19 +105,37 @@ class Scene
 	template <class T>
 	std::vector<T *> get_components() const
 	{
-		std::vector<T *> result;
-		if (has_component(typeid(T)))
+		return get_component_view<T>();
+	}
+
+	/**
+	 * @brief Gets the components of a type without copying or casting them
+	 *
+	 *        The first call for a type builds a pool of pointers to its components, which is then
+	 *        kept up to date as components of that type are added or replaced. The returned
+	 *        reference stays valid for the lifetime of the scene.
+	 *        Components are stored under the type returned by Component::get_type, the template
+	 *        type must therefore be that type and not a derived one.
+	 * @return The pointers to the components of the given type
+	 */
+	template <class T>
+	const std::vector<T *> &get_component_view() const
+	{
+		auto pool_it = component_pools.find(typeid(T));
+		if (pool_it == component_pools.end())
 		{
-			auto &scene_components = get_components(typeid(T));
+			auto pool = std::make_unique<ComponentPool<T>>();
+
+			auto components_it = components.find(typeid(T));
+			if (components_it != components.end())
+			{
+				pool->assign(components_it->second);
+			}
 
-			result.resize(scene_components.size());
-			std::transform(scene_components.begin(), scene_components.end(), result.begin(),
-			               [](const std::unique_ptr<Component> &component) -> T * {
-				               return dynamic_cast<T *>(component.get());
-			               });
+			pool_it = component_pools.emplace(typeid(T), std::move(pool)).first;
 		}
 
-		return result;
+		return static_cast<const ComponentPool<T> &>(*pool_it->second).components;
 	}
 
 	/**
@@ -136,6 +157,21 @@ class Scene
 
 	Node &get_root_node();
 
+	/**
+	 * @return The hierarchy of the transforms under the root node
+	 */
+	TransformHierarchy &get_transform_hierarchy();
+
+	/**
+	 * @return The bounding volume hierarchy over the mesh instances, built on its first update
+	 */
+	BoundingVolumeHierarchy &get_bounding_volume_hierarchy();
+
+	/**
+	 * @return The culling of the mesh instances, shared by the subpasses drawing the scene
+	 */
+	VisibilityCulling &get_visibility_culling();
+
 #ifdef ENABLE_RAYTRACING_SCENE_GRAPH
   public:
 	void build_acceleration_structure(vkb::Device const &device);
@@ -147,6 +183,44 @@ class Scene
 #endif
 
   private:
+	/**
+	 * @brief Typed pointers to the components of a type, in the order they were added
+	 */
+	struct ComponentPoolBase
+	{
+		virtual ~ComponentPoolBase() = default;
+
+		virtual void add(Component &component) = 0;
+
+		virtual void assign(const std::vector<std::unique_ptr<Component>> &components) = 0;
+	};
+
+	template <class T>
+	struct ComponentPool : ComponentPoolBase
+	{
+		// Components of a type all derive from it, so they do not need a dynamic cast
+		void add(Component &component) override
+		{
+			components.push_back(static_cast<T *>(&component));
+		}
+
+		void assign(const std::vector<std::unique_ptr<Component>> &new_components) override
+		{
+			components.clear();
+			for (auto &component : new_components)
+			{
+				add(*component);
+			}
+		}
+
+		std::vector<T *> components;
+	};
+
+	/**
+	 * @brief Updates the pool of a type, if any, after its components were replaced
+	 */
+	void update_component_pool(const std::type_index &type_info);
+
 	std::string name;
 
 	/// List of all the nodes
@@ -155,6 +229,17 @@ class Scene
 	Node *root{nullptr};
 
 	std::unordered_map<std::type_index, std::vector<std::unique_ptr<Component>>> components;
+
+	/// Pools of the types whose components were requested, built on first use
+	mutable std::unordered_map<std::type_index, std::unique_ptr<ComponentPoolBase>> component_pools;
+
+	// Declared after the nodes, so it releases their transforms before they are destroyed
+	std::unique_ptr<TransformHierarchy> transform_hierarchy{std::make_unique<TransformHierarchy>()};
+
+	/// Created on first use, as they keep a view of the meshes
+	std::unique_ptr<BoundingVolumeHierarchy> bounding_volume_hierarchy;
+
+	std::unique_ptr<VisibilityCulling> visibility_culling;
 };
 }        // namespace sg
 }        // namespace vkb
\ No newline at end of file
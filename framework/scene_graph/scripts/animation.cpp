@@ -17,6 +17,11 @@
 
 #include "animation.h"
 
+#include <algorithm>
+
+#include "common/helpers.h"
+#include "common/logging.h"
+#include "job_system.h"
 #include "scene_graph/node.h"
 
 namespace vkb
@@ -29,16 +34,63 @@ Animation::Animation(const std::string &name) :
 }
 
 Animation::Animation(const Animation &other) :
-    channels{other.channels}
+    channels{other.channels},
+    samplers{other.samplers},
+    keyframe_times{other.keyframe_times},
+    keyframe_values{other.keyframe_values},
+    start_time{other.start_time},
+    end_time{other.end_time}
+{
+}
+
+uint32_t Animation::add_sampler(const AnimationSampler &sampler)
+{
+	SamplerRange range{};
+	range.type           = sampler.type;
+	range.first_keyframe = to_u32(keyframe_times.size());
+	range.keyframe_count = to_u32(sampler.inputs.size());
+	range.first_value    = to_u32(keyframe_values.size());
+
+	size_t value_count = sampler.type == AnimationType::CubicSpline ? 3 * sampler.inputs.size() : sampler.inputs.size();
+	if (sampler.outputs.size() < value_count)
+	{
+		LOGW("Animation sampler has {} outputs for {} inputs, it is ignored", sampler.outputs.size(), sampler.inputs.size());
+		range.keyframe_count = 0;
+	}
+	else
+	{
+		keyframe_times.insert(keyframe_times.end(), sampler.inputs.begin(), sampler.inputs.end());
+		keyframe_values.insert(keyframe_values.end(), sampler.outputs.begin(), sampler.outputs.begin() + value_count);
+	}
+
+	samplers.push_back(range);
+
+	return to_u32(samplers.size() - 1);
+}
+
+void Animation::add_channel(Node &node, const AnimationTarget &target, uint32_t sampler_index)
 {
+	assert(sampler_index < samplers.size() && "Animation channel sampler index out of range");
+
+	channels.push_back({node, target, sampler_index});
 }
 
 void Animation::add_channel(Node &node, const AnimationTarget &target, const AnimationSampler &sampler)
 {
-	channels.push_back({node, target, sampler});
+	add_channel(node, target, add_sampler(sampler));
+}
+
+uint32_t Animation::get_channel_count() const
+{
+	return to_u32(channels.size());
 }
 
 void Animation::update(float delta_time)
+{
+	update(delta_time, nullptr);
+}
+
+void Animation::update(float delta_time, JobSystem *job_system)
 {
 	current_time += delta_time;
 	if (current_time > end_time)
@@ -46,114 +98,144 @@ void Animation::update(float delta_time)
 		current_time -= end_time;
 	}
 
-	for (auto &channel : channels)
+	const uint32_t channel_count = to_u32(channels.size());
+
+	channel_values.resize(channel_count);
+	channel_sampled.resize(channel_count);
+
+	// Sampling only reads the keyframes and writes the values of its own channels
+	if (job_system && channel_count >= PARALLEL_CHANNEL_COUNT)
+	{
+		job_system->parallel_for(channel_count, 0, [this](uint32_t begin, uint32_t end, uint32_t) {
+			sample_channels(begin, end);
+		});
+	}
+	else
+	{
+		sample_channels(0, channel_count);
+	}
+
+	// Setting the transforms marks the world matrices dirty, which is not thread safe
+	for (uint32_t i = 0; i < channel_count; ++i)
+	{
+		if (!channel_sampled[i])
+		{
+			continue;
+		}
+
+		auto &transform = channels[i].node.get_transform();
+		auto &value     = channel_values[i];
+
+		switch (channels[i].target)
+		{
+			case Translation:
+			{
+				transform.set_translation(glm::vec3(value));
+				break;
+			}
+			case Rotation:
+			{
+				transform.set_rotation(glm::normalize(glm::quat(value.w, value.x, value.y, value.z)));
+				break;
+			}
+			case Scale:
+			{
+				transform.set_scale(glm::vec3(value));
+				break;
+			}
+		}
+	}
+}
+
+void Animation::sample_channels(uint32_t begin, uint32_t end)
+{
+	for (uint32_t i = begin; i < end; ++i)
+	{
+		channel_sampled[i] = sample_channel(channels[i], channel_values[i]);
+	}
+}
+
+bool Animation::sample_channel(AnimationChannel &channel, glm::vec4 &value) const
+{
+	const auto &sampler = samplers[channel.sampler_index];
+
+	if (sampler.keyframe_count < 2)
+	{
+		return false;
+	}
+
+	const float *times = &keyframe_times[sampler.first_keyframe];
+	const auto   count = sampler.keyframe_count;
+
+	if (current_time < times[0] || current_time > times[count - 1])
+	{
+		return false;
+	}
+
+	// Find the keyframe i such that times[i] <= current_time <= times[i + 1]
+	uint32_t i = channel.cursor;
+
+	bool found = i + 1 < count && current_time >= times[i];
+	for (uint32_t step = 0; found && current_time > times[i + 1]; ++step)
 	{
-		for (size_t i = 0; i < channel.sampler.inputs.size() - 1; ++i)
+		found = step < MAX_CURSOR_STEPS;
+		++i;
+	}
+
+	if (!found)
+	{
+		i = static_cast<uint32_t>(std::upper_bound(times, times + count, current_time) - times);
+		i = std::min(std::max(i, 1u), count - 1) - 1;
+	}
+
+	channel.cursor = i;
+
+	float delta = times[i + 1] - times[i];
+	float time  = delta > 0.0f ? (current_time - times[i]) / delta : 0.0f;
+
+	const glm::vec4 *values = &keyframe_values[sampler.first_value];
+
+	switch (sampler.type)
+	{
+		case AnimationType::Linear:
 		{
-			if ((current_time >= channel.sampler.inputs[i]) && (current_time <= channel.sampler.inputs[i + 1]))
+			if (channel.target == Rotation)
 			{
-				float time = (current_time - channel.sampler.inputs[i]) / (channel.sampler.inputs[i + 1] - channel.sampler.inputs[i]);
-
-				auto &transform = channel.node.get_transform();
-
-				if (channel.sampler.type == AnimationType::Linear)
-				{
-					switch (channel.target)
-					{
-						case Translation: {
-							transform.set_translation(glm::vec3(glm::mix(channel.sampler.outputs[i],
-							                                             channel.sampler.outputs[i + 1],
-							                                             time)));
-							break;
-						}
-						case Rotation: {
-							glm::quat q1;
-							q1.x = channel.sampler.outputs[i].x;
-							q1.y = channel.sampler.outputs[i].y;
-							q1.z = channel.sampler.outputs[i].z;
-							q1.w = channel.sampler.outputs[i].w;
-
-							glm::quat q2;
-							q2.x = channel.sampler.outputs[i + 1].x;
-							q2.y = channel.sampler.outputs[i + 1].y;
-							q2.z = channel.sampler.outputs[i + 1].z;
-							q2.w = channel.sampler.outputs[i + 1].w;
-
-							transform.set_rotation(glm::normalize(glm::slerp(q1, q2, time)));
-							break;
-						}
-
-						case Scale: {
-							transform.set_scale(glm::vec3(glm::mix(channel.sampler.outputs[i],
-							                                       channel.sampler.outputs[i + 1],
-							                                       time)));
-						}
-					}
-				}
-				else if (channel.sampler.type == AnimationType::Step)
-				{
-					switch (channel.target)
-					{
-						case Translation: {
-							transform.set_translation(glm::vec3(channel.sampler.outputs[i]));
-							break;
-						}
-						case Rotation: {
-							glm::quat q1;
-							q1.x = channel.sampler.outputs[i].x;
-							q1.y = channel.sampler.outputs[i].y;
-							q1.z = channel.sampler.outputs[i].z;
-							q1.w = channel.sampler.outputs[i].w;
-
-							transform.set_rotation(glm::normalize(q1));
-							break;
-						}
-
-						case Scale: {
-							transform.set_scale(glm::vec3(channel.sampler.outputs[i]));
-						}
-					}
-				}
-				else if (channel.sampler.type == AnimationType::CubicSpline)
-				{
-					float delta = channel.sampler.inputs[i + 1] - channel.sampler.inputs[i];
-
-					glm::vec4 p0 = channel.sampler.outputs[i * 3 + 1];              // Starting point
-					glm::vec4 p1 = channel.sampler.outputs[(i + 1) * 3 + 1];        // Ending point
-
-					glm::vec4 m0 = delta * channel.sampler.outputs[i * 3 + 2];              // Delta time * out tangent
-					glm::vec4 m1 = delta * channel.sampler.outputs[(i + 1) * 3 + 0];        // Delta time * in tangent of next point
-
-					// This equation is taken from the GLTF 2.0 specification Appendix C (https://github.com/KhronosGroup/glTF/tree/master/specification/2.0#appendix-c-spline-interpolation)
-					glm::vec4 result = (2.0f * glm::pow(time, 3.0f) - 3.0f * glm::pow(time, 2.0f) + 1.0f) * p0 + (glm::pow(time, 3.0f) - 2.0f * glm::pow(time, 2.0f) + time) * m0 + (-2.0f * glm::pow(time, 3.0f) + 3.0f * glm::pow(time, 2.0f)) * p1 + (glm::pow(time, 3.0f) - glm::pow(time, 2.0f)) * m1;
-
-					auto &transform = channel.node.get_transform();
-
-					switch (channel.target)
-					{
-						case Translation: {
-							transform.set_translation(glm::vec3(result));
-							break;
-						}
-						case Rotation: {
-							glm::quat q1;
-							q1.x = result.x;
-							q1.y = result.y;
-							q1.z = result.z;
-							q1.w = result.w;
-
-							transform.set_rotation(glm::normalize(q1));
-							break;
-						}
-
-						case Scale: {
-							transform.set_scale(glm::vec3(result));
-						}
-					}
-				}
+				glm::quat q1(values[i].w, values[i].x, values[i].y, values[i].z);
+				glm::quat q2(values[i + 1].w, values[i + 1].x, values[i + 1].y, values[i + 1].z);
+
+				glm::quat q = glm::slerp(q1, q2, time);
+				value       = glm::vec4(q.x, q.y, q.z, q.w);
 			}
+			else
+			{
+				value = glm::mix(values[i], values[i + 1], time);
+			}
+			break;
+		}
+		case AnimationType::Step:
+		{
+			value = values[i];
+			break;
+		}
+		case AnimationType::CubicSpline:
+		{
+			glm::vec4 p0 = values[i * 3 + 1];              // Starting point
+			glm::vec4 p1 = values[(i + 1) * 3 + 1];        // Ending point
+
+			glm::vec4 m0 = delta * values[i * 3 + 2];              // Delta time * out tangent
+			glm::vec4 m1 = delta * values[(i + 1) * 3 + 0];        // Delta time * in tangent of next point
+
+			float time_2 = time * time;
+			float time_3 = time_2 * time;
+
+			// This equation is taken from the GLTF 2.0 specification Appendix C (https://github.com/KhronosGroup/glTF/tree/master/specification/2.0#appendix-c-spline-interpolation)
+			value = (2.0f * time_3 - 3.0f * time_2 + 1.0f) * p0 + (time_3 - 2.0f * time_2 + time) * m0 + (-2.0f * time_3 + 3.0f * time_2) * p1 + (time_3 - time_2) * m1;
+			break;
 		}
 	}
+
+	return true;
 }
 
 void Animation::update_times(float new_start_time, float new_end_time)
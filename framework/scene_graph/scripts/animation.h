@@ -28,6 +28,8 @@
 
 namespace vkb
 {
+class JobSystem;
+
 namespace sg
 {
 enum AnimationType
@@ -44,6 +46,9 @@ enum AnimationTarget
 	Scale
 };
 
+/**
+ * @brief Keyframes of an animated property, as loaded from a model
+ */
 struct AnimationSampler
 {
 	AnimationType type{Linear};
@@ -59,9 +64,20 @@ struct AnimationChannel
 
 	AnimationTarget target;
 
-	AnimationSampler sampler;
+	uint32_t sampler_index;
+
+	// Keyframe the channel was last sampled at, where the next search starts
+	uint32_t cursor{0};
 };
 
+/**
+ * @brief Animates the transforms of nodes with keyframes
+ *
+ *        The keyframes of all the samplers are stored in two contiguous arrays, one for the
+ *        times and one for the values, and samplers can be shared by several channels.
+ *        Each channel keeps the keyframe it was last sampled at: moving forward in time steps
+ *        from it, while looping or seeking backward binary searches the keyframes.
+ */
 class Animation : public Script
 {
   public:
@@ -71,13 +87,70 @@ class Animation : public Script
 
 	virtual void update(float delta_time) override;
 
+	/**
+	 * @brief Advances the animation and sets the transforms of the animated nodes
+	 * @param delta_time Time elapsed since the last update
+	 * @param job_system If not null and there are many channels, the channels are sampled in parallel on its threads
+	 */
+	void update(float delta_time, JobSystem *job_system);
+
 	void update_times(float start_time, float end_time);
 
+	/**
+	 * @brief Copies the keyframes of a sampler
+	 * @return The index of the sampler, to share it between channels
+	 */
+	uint32_t add_sampler(const AnimationSampler &sampler);
+
+	void add_channel(Node &node, const AnimationTarget &target, uint32_t sampler_index);
+
 	void add_channel(Node &node, const AnimationTarget &target, const AnimationSampler &sampler);
 
+	uint32_t get_channel_count() const;
+
+	/// Minimum number of channels to sample them in parallel
+	static constexpr uint32_t PARALLEL_CHANNEL_COUNT = 4096;
+
+	/// Keyframes a cursor steps forward before falling back to a binary search
+	static constexpr uint32_t MAX_CURSOR_STEPS = 4;
+
   private:
+	/**
+	 * @brief Range of a sampler in the keyframe arrays
+	 */
+	struct SamplerRange
+	{
+		AnimationType type;
+
+		uint32_t first_keyframe;
+
+		uint32_t keyframe_count;
+
+		// Cubic spline samplers have an in tangent, a value and an out tangent per keyframe
+		uint32_t first_value;
+	};
+
+	/**
+	 * @brief Samples a channel at the current time
+	 * @return Whether the current time is within the keyframes of the channel
+	 */
+	bool sample_channel(AnimationChannel &channel, glm::vec4 &value) const;
+
+	void sample_channels(uint32_t begin, uint32_t end);
+
 	std::vector<AnimationChannel> channels;
 
+	std::vector<SamplerRange> samplers;
+
+	std::vector<float> keyframe_times;
+
+	std::vector<glm::vec4> keyframe_values;
+
+	// Values sampled by the last update, and whether each channel was within its keyframes
+	std::vector<glm::vec4> channel_values;
+
+	std::vector<uint8_t> channel_sampled;
+
 	float current_time{0.0f};
 
 	float start_time{std::numeric_limits<float>::max()};
@@ -26,6 +26,7 @@ VKBP_DISABLE_WARNINGS()
 #include <glm/gtx/quaternion.hpp>
 VKBP_ENABLE_WARNINGS()
 
+#include "scene_graph/bounding_volume_hierarchy.h"
 #include "scene_graph/components/perspective_camera.h"
 #include "scene_graph/components/transform.h"
 #include "scene_graph/node.h"
@@ -143,7 +144,7 @@ void FreeCamera::update(float delta_time)
 	// Only re-calculate the transform if it's changed
 	if (delta_rotation != glm::vec3(0.0f, 0.0f, 0.0f) || delta_translation != glm::vec3(0.0f, 0.0f, 0.0f))
 	{
-		auto &transform = get_node().get_component<Transform>();
+		auto &transform = get_node().get_transform();
 
 		glm::quat qx = glm::angleAxis(delta_rotation.x, glm::vec3(1.0f, 0.0f, 0.0f));
 		glm::quat qy = glm::angleAxis(delta_rotation.y, glm::vec3(0.0f, 1.0f, 0.0f));
@@ -196,6 +197,8 @@ void FreeCamera::input_event(const InputEvent &input_event)
 
 			mouse_last_pos = mouse_pos;
 		}
+
+		pointer_pos = mouse_pos;
 	}
 	else if (input_event.get_source() == EventSource::Touchscreen)
 	{
@@ -223,11 +226,18 @@ void FreeCamera::input_event(const InputEvent &input_event)
 
 			touch_last_pos = touch_pos;
 		}
+
+		if (touch_event.get_pointer_id() == 0)
+		{
+			pointer_pos = touch_pos;
+		}
 	}
 }
 
 void FreeCamera::resize(uint32_t width, uint32_t height)
 {
+	viewport_size = glm::vec2(width, height);
+
 	auto &camera_node = get_node();
 
 	if (camera_node.has_component<Camera>())
@@ -239,5 +249,42 @@ void FreeCamera::resize(uint32_t width, uint32_t height)
 	}
 }
 
+Node *FreeCamera::pick(const BoundingVolumeHierarchy &bounding_volume_hierarchy, const glm::vec2 &screen_position)
+{
+	auto &camera_node = get_node();
+
+	if (!camera_node.has_component<Camera>())
+	{
+		return nullptr;
+	}
+
+	auto &camera = camera_node.get_component<Camera>();
+
+	// Window coordinates grow downwards, normalized device coordinates upwards
+	glm::vec2 ndc{2.0f * screen_position.x / viewport_size.x - 1.0f, 1.0f - 2.0f * screen_position.y / viewport_size.y};
+
+	glm::mat4 inverse_view_projection = glm::inverse(camera.get_projection() * camera.get_view());
+
+	// The projection maps the near plane to a depth of one, and the far plane to zero
+	glm::vec4 near_position = inverse_view_projection * glm::vec4(ndc, 1.0f, 1.0f);
+	glm::vec4 far_position  = inverse_view_projection * glm::vec4(ndc, 0.0f, 1.0f);
+
+	glm::vec3 origin    = glm::vec3(near_position) / near_position.w;
+	glm::vec3 direction = glm::normalize(glm::vec3(far_position) / far_position.w - origin);
+
+	BoundingVolumeHierarchy::RayHit hit;
+	if (!bounding_volume_hierarchy.intersect_ray(origin, direction, hit))
+	{
+		return nullptr;
+	}
+
+	return &bounding_volume_hierarchy.get_instance_node(hit.instance);
+}
+
+Node *FreeCamera::pick(const BoundingVolumeHierarchy &bounding_volume_hierarchy)
+{
+	return pick(bounding_volume_hierarchy, pointer_pos);
+}
+
 }        // namespace sg
 }        // namespace vkb
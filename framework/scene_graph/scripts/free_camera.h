@@ -35,6 +35,8 @@ namespace vkb
 {
 namespace sg
 {
+class BoundingVolumeHierarchy;
+
 class FreeCamera : public NodeScript
 {
   public:
@@ -60,6 +62,19 @@ class FreeCamera : public NodeScript
 
 	virtual void resize(uint32_t width, uint32_t height) override;
 
+	/**
+	 * @brief Finds the mesh instance whose bounds are hit first by the ray through a screen position
+	 * @param bounding_volume_hierarchy Hierarchy over the instances of the scene
+	 * @param screen_position Position in pixels from the top left corner of the window
+	 * @return The node of the instance, or nullptr if no instance was hit
+	 */
+	Node *pick(const BoundingVolumeHierarchy &bounding_volume_hierarchy, const glm::vec2 &screen_position);
+
+	/**
+	 * @brief Finds the mesh instance under the last position of the mouse or touch pointer
+	 */
+	Node *pick(const BoundingVolumeHierarchy &bounding_volume_hierarchy);
+
   private:
 	float speed_multiplier{3.0f};
 
@@ -71,6 +86,11 @@ class FreeCamera : public NodeScript
 
 	glm::vec2 touch_last_pos{0.0f};
 
+	// Last position of the mouse or of the first touch pointer
+	glm::vec2 pointer_pos{0.0f};
+
+	glm::vec2 viewport_size{1.0f};
+
 	float touch_pointer_time{0.0f};
 
 	std::unordered_map<KeyCode, bool> key_pressed;
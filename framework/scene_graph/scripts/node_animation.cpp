@@ -43,7 +43,7 @@ void NodeAnimation::update(float delta_time)
 {
 	if (animation_fn)
 	{
-		animation_fn(get_node().get_component<Transform>(), delta_time);
+		animation_fn(get_node().get_transform(), delta_time);
 	}
 }
 
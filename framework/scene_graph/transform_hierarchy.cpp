@@ -0,0 +1,256 @@
+/* Copyright (c) 2023, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "transform_hierarchy.h"
+
+#include "job_system.h"
+#include "scene_graph/components/transform.h"
+#include "scene_graph/node.h"
+
+namespace vkb
+{
+namespace sg
+{
+namespace
+{
+// Parent index of the root node
+constexpr uint32_t no_parent = ~0u;
+}        // namespace
+
+TransformHierarchy::~TransformHierarchy()
+{
+	clear();
+}
+
+void TransformHierarchy::set_root(Node &new_root)
+{
+	clear();
+
+	root              = &new_root;
+	structure_changed = true;
+}
+
+void TransformHierarchy::invalidate_structure()
+{
+	clear();
+
+	structure_changed = true;
+}
+
+uint32_t TransformHierarchy::update(JobSystem *job_system)
+{
+	if (structure_changed)
+	{
+		build();
+		structure_changed = false;
+	}
+
+	if (dirty_count == 0)
+	{
+		return 0;
+	}
+
+	uint32_t updated_count = dirty_count;
+	uint32_t node_count    = get_node_count();
+
+	if (!job_system || node_count < PARALLEL_LEVEL_SIZE)
+	{
+		update_range(0, node_count);
+	}
+	else
+	{
+		// Parents are complete once their level is, so only the nodes of a level are updated in parallel
+		for (size_t level = 0; level + 1 < level_offsets.size(); ++level)
+		{
+			uint32_t level_begin = level_offsets[level];
+			uint32_t level_end   = level_offsets[level + 1];
+
+			if (level_end - level_begin < PARALLEL_LEVEL_SIZE)
+			{
+				update_range(level_begin, level_end);
+				continue;
+			}
+
+			job_system->parallel_for(level_end - level_begin, 0, [this, level_begin](uint32_t begin, uint32_t end, uint32_t) {
+				update_range(level_begin + begin, level_begin + end);
+			});
+		}
+	}
+
+	dirty_count = 0;
+
+	return updated_count;
+}
+
+uint32_t TransformHierarchy::get_node_count() const
+{
+	return static_cast<uint32_t>(transforms.size());
+}
+
+uint32_t TransformHierarchy::get_depth() const
+{
+	return level_offsets.empty() ? 0 : static_cast<uint32_t>(level_offsets.size() - 1);
+}
+
+void TransformHierarchy::build()
+{
+	clear();
+
+	if (!root)
+	{
+		return;
+	}
+
+	std::vector<Node *> nodes{root};
+	parents.push_back(no_parent);
+
+	level_offsets.push_back(0);
+	size_t level_end = 1;
+
+	// Breadth first traversal, appending the children of each node after the nodes already visited
+	for (size_t i = 0; i < nodes.size(); ++i)
+	{
+		if (i == level_end)
+		{
+			level_offsets.push_back(static_cast<uint32_t>(i));
+			level_end = nodes.size();
+		}
+
+		auto &children = nodes[i]->get_children();
+
+		first_children.push_back(static_cast<uint32_t>(nodes.size()));
+		child_counts.push_back(static_cast<uint32_t>(children.size()));
+
+		for (auto child : children)
+		{
+			nodes.push_back(child);
+			parents.push_back(static_cast<uint32_t>(i));
+		}
+	}
+
+	level_offsets.push_back(static_cast<uint32_t>(nodes.size()));
+
+	transforms.reserve(nodes.size());
+	local_matrices.reserve(nodes.size());
+	world_matrices.resize(nodes.size());
+	dirty.resize(nodes.size(), 1);
+	dirty_count = static_cast<uint32_t>(nodes.size());
+
+	for (size_t i = 0; i < nodes.size(); ++i)
+	{
+		auto &transform = nodes[i]->get_transform();
+
+		transform.hierarchy       = this;
+		transform.hierarchy_index = static_cast<uint32_t>(i);
+
+		transforms.push_back(&transform);
+		local_matrices.push_back(transform.get_matrix());
+	}
+}
+
+void TransformHierarchy::clear()
+{
+	// Hand the matrices back to the transforms, so they stay valid on their own
+	for (size_t i = 0; i < transforms.size(); ++i)
+	{
+		auto &transform = *transforms[i];
+
+		transform.hierarchy           = nullptr;
+		transform.world_matrix        = world_matrices[i];
+		transform.update_world_matrix = dirty[i] != 0;
+	}
+
+	transforms.clear();
+	parents.clear();
+	first_children.clear();
+	child_counts.clear();
+	local_matrices.clear();
+	world_matrices.clear();
+	dirty.clear();
+	level_offsets.clear();
+
+	dirty_count = 0;
+}
+
+void TransformHierarchy::set_local_matrix(uint32_t index, const glm::mat4 &matrix)
+{
+	local_matrices[index] = matrix;
+}
+
+void TransformHierarchy::set_dirty(uint32_t index)
+{
+	// The descendants of a dirty node are all dirty already
+	if (dirty[index])
+	{
+		return;
+	}
+
+	pending_nodes.push_back(index);
+
+	while (!pending_nodes.empty())
+	{
+		uint32_t node = pending_nodes.back();
+		pending_nodes.pop_back();
+
+		dirty[node] = 1;
+		dirty_count++;
+
+		transforms[node]->world_matrix_version++;
+
+		for (uint32_t child = first_children[node]; child < first_children[node] + child_counts[node]; ++child)
+		{
+			if (!dirty[child])
+			{
+				pending_nodes.push_back(child);
+			}
+		}
+	}
+}
+
+const glm::mat4 &TransformHierarchy::get_world_matrix(uint32_t index)
+{
+	if (dirty[index])
+	{
+		uint32_t parent = parents[index];
+
+		world_matrices[index] = parent == no_parent ? local_matrices[index] : get_world_matrix(parent) * local_matrices[index];
+
+		dirty[index] = 0;
+		dirty_count--;
+	}
+
+	return world_matrices[index];
+}
+
+void TransformHierarchy::update_range(uint32_t begin, uint32_t end)
+{
+	for (uint32_t i = begin; i < end; ++i)
+	{
+		if (!dirty[i])
+		{
+			continue;
+		}
+
+		uint32_t parent = parents[i];
+
+		world_matrices[i] = parent == no_parent ? local_matrices[i] : world_matrices[parent] * local_matrices[i];
+
+		dirty[i] = 0;
+	}
+}
+}        // namespace sg
+}        // namespace vkb
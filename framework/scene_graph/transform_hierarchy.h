@@ -0,0 +1,137 @@
+/* Copyright (c) 2023, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "common/error.h"
+
+VKBP_DISABLE_WARNINGS()
+#include "common/glm_common.h"
+VKBP_ENABLE_WARNINGS()
+
+namespace vkb
+{
+class JobSystem;
+
+namespace sg
+{
+class Node;
+class Transform;
+
+/**
+ * @brief Stores the local and world matrices of a tree of nodes in contiguous arrays
+ *
+ *        The nodes are sorted breadth first, so every parent is stored before its children,
+ *        the children of a node are stored next to each other, and the nodes of a depth level
+ *        form a contiguous range. Changing a transform marks it and all of its descendants
+ *        dirty, and update() recomputes all the dirty world matrices in one linear pass.
+ *
+ *        The transforms of the tree read and write their matrices from the hierarchy.
+ *        Changing the parent of a node releases the transforms, which fall back to computing
+ *        their world matrix on their own, until the tree is built again on the next update.
+ */
+class TransformHierarchy
+{
+  public:
+	TransformHierarchy() = default;
+
+	TransformHierarchy(const TransformHierarchy &) = delete;
+
+	TransformHierarchy(TransformHierarchy &&) = delete;
+
+	~TransformHierarchy();
+
+	TransformHierarchy &operator=(const TransformHierarchy &) = delete;
+
+	TransformHierarchy &operator=(TransformHierarchy &&) = delete;
+
+	/**
+	 * @brief Sets the root of the tree, which is built on the next update
+	 */
+	void set_root(Node &root);
+
+	/**
+	 * @brief Releases the transforms, and builds the tree again on the next update
+	 */
+	void invalidate_structure();
+
+	/**
+	 * @brief Recomputes the world matrices of the dirty transforms
+	 * @param job_system If not null, depth levels with many dirty nodes are split across its threads
+	 * @return The number of world matrices updated
+	 */
+	uint32_t update(JobSystem *job_system = nullptr);
+
+	uint32_t get_node_count() const;
+
+	uint32_t get_depth() const;
+
+	/// Minimum number of nodes in a depth level to update it in parallel
+	static constexpr uint32_t PARALLEL_LEVEL_SIZE = 4096;
+
+  private:
+	friend class Transform;
+
+	void build();
+
+	void clear();
+
+	void set_local_matrix(uint32_t index, const glm::mat4 &matrix);
+
+	/**
+	 * @brief Marks a node and its descendants dirty
+	 */
+	void set_dirty(uint32_t index);
+
+	/**
+	 * @brief Gets the world matrix of a node, computing it and its dirty ancestors if needed
+	 */
+	const glm::mat4 &get_world_matrix(uint32_t index);
+
+	void update_range(uint32_t begin, uint32_t end);
+
+	Node *root{nullptr};
+
+	bool structure_changed{false};
+
+	std::vector<Transform *> transforms;
+
+	std::vector<uint32_t> parents;
+
+	std::vector<uint32_t> first_children;
+
+	std::vector<uint32_t> child_counts;
+
+	std::vector<glm::mat4> local_matrices;
+
+	std::vector<glm::mat4> world_matrices;
+
+	std::vector<uint8_t> dirty;
+
+	// First node of each depth level, followed by the node count
+	std::vector<uint32_t> level_offsets;
+
+	uint32_t dirty_count{0};
+
+	// Nodes left to mark dirty, kept to reuse its storage
+	std::vector<uint32_t> pending_nodes;
+};
+}        // namespace sg
+}        // namespace vkb
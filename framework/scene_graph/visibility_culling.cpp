@@ -0,0 +1,597 @@
+/* Copyright (c) 2023, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "visibility_culling.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+#include "geometry/frustum.h"
+#include "scene_graph/bounding_volume_hierarchy.h"
+#include "scene_graph/components/camera.h"
+#include "scene_graph/components/mesh.h"
+#include "scene_graph/components/transform.h"
+#include "scene_graph/node.h"
+#include "timer.h"
+
+namespace vkb
+{
+namespace sg
+{
+namespace
+{
+// Extent given to meshes without bounds, so they always pass the tests
+constexpr float unbounded_extent = std::numeric_limits<float>::max();
+
+// Converts a normalized device coordinate to an occlusion buffer tile coordinate
+inline float to_tile(float ndc, uint32_t tile_count)
+{
+	return (ndc * 0.5f + 0.5f) * static_cast<float>(tile_count);
+}
+
+inline float cross(const glm::vec2 &a, const glm::vec2 &b, const glm::vec2 &c)
+{
+	return (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+}
+
+/**
+ * @brief Computes the convex hull of points with the monotone chain algorithm
+ * @param points Points to wrap, sorted in place
+ * @param hull Receives the vertices of the hull in counter-clockwise order, without collinear ones
+ */
+void convex_hull(std::array<glm::vec2, 8> &points, std::vector<glm::vec2> &hull)
+{
+	std::sort(points.begin(), points.end(), [](const glm::vec2 &a, const glm::vec2 &b) {
+		return a.x < b.x || (a.x == b.x && a.y < b.y);
+	});
+
+	hull.resize(2 * points.size());
+
+	size_t count = 0;
+
+	// Lower chain, then upper chain
+	for (size_t i = 0; i < points.size(); ++i)
+	{
+		while (count >= 2 && cross(hull[count - 2], hull[count - 1], points[i]) <= 0.0f)
+		{
+			count--;
+		}
+		hull[count++] = points[i];
+	}
+
+	for (size_t i = points.size() - 1, lower_count = count + 1; i > 0; --i)
+	{
+		while (count >= lower_count && cross(hull[count - 2], hull[count - 1], points[i - 1]) <= 0.0f)
+		{
+			count--;
+		}
+		hull[count++] = points[i - 1];
+	}
+
+	// The last point is the first one again
+	hull.resize(count > 0 ? count - 1 : 0);
+}
+}        // namespace
+
+VisibilityCulling::VisibilityCulling(const std::vector<Mesh *> &meshes, BoundingVolumeHierarchy &bounding_volume_hierarchy) :
+    meshes{meshes},
+    bounding_volume_hierarchy{bounding_volume_hierarchy}
+{
+}
+
+void VisibilityCulling::begin_frame()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	last_frame_stats = frame_stats;
+	frame_stats      = {};
+
+	frame_index++;
+}
+
+const VisibilityCulling::Result &VisibilityCulling::cull(Camera &camera)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	glm::mat4 view            = camera.get_view();
+	glm::mat4 projection      = camera.get_projection();
+	glm::mat4 view_projection = projection * view;
+
+	auto &camera_result = camera_results[&camera];
+	if (camera_result.frame_index == frame_index && camera_result.view_projection == view_projection)
+	{
+		return camera_result.result;
+	}
+
+	camera_result.frame_index     = frame_index;
+	camera_result.view_projection = view_projection;
+
+	Timer timer;
+	timer.start();
+
+	size_t instance_count = 0;
+
+	if (frustum_culling && hierarchical_culling)
+	{
+		// The hierarchy only returns the instances intersecting the frustum
+		instance_count = gather_visible_instances(view_projection);
+
+		inside.assign(instance_nodes.size(), 1);
+	}
+	else
+	{
+		gather_instances();
+
+		instance_count = instance_nodes.size();
+
+		inside.assign(instance_nodes.size(), 1);
+
+		if (frustum_culling)
+		{
+			test_frustum(view_projection);
+		}
+	}
+
+	candidates.clear();
+	for (uint32_t i = 0; i < static_cast<uint32_t>(inside.size()); ++i)
+	{
+		if (inside[i])
+		{
+			candidates.push_back(i);
+		}
+	}
+
+	auto &result = camera_result.result;
+
+	result.frustum_culled_count = static_cast<uint32_t>(instance_count - candidates.size());
+	result.occluded_count       = 0;
+
+	if (occlusion_culling)
+	{
+		test_occlusion(view, projection);
+
+		// The occluded candidates were cleared from the inside flags
+		auto visible_end      = std::remove_if(candidates.begin(), candidates.end(), [this](uint32_t index) { return !inside[index]; });
+		result.occluded_count = static_cast<uint32_t>(candidates.end() - visible_end);
+		candidates.erase(visible_end, candidates.end());
+	}
+
+	glm::vec3 camera_position = glm::vec3(camera.get_node()->get_transform().get_world_matrix()[3]);
+
+	result.visible_nodes.clear();
+	result.visible_nodes.reserve(candidates.size());
+
+	for (auto index : candidates)
+	{
+		glm::vec3 center{center_x[index], center_y[index], center_z[index]};
+
+		result.visible_nodes.push_back({instance_nodes[index], instance_meshes[index], glm::length(camera_position - center)});
+	}
+
+	frame_stats.visible_count += static_cast<uint32_t>(result.visible_nodes.size());
+	frame_stats.frustum_culled_count += result.frustum_culled_count;
+	frame_stats.occluded_count += result.occluded_count;
+	frame_stats.cull_time += static_cast<float>(timer.stop<Timer::Milliseconds>());
+
+	return result;
+}
+
+void VisibilityCulling::set_frustum_culling(bool enable)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	frustum_culling = enable;
+
+	// Cull again with the new settings
+	camera_results.clear();
+}
+
+bool VisibilityCulling::is_frustum_culling_enabled() const
+{
+	return frustum_culling;
+}
+
+void VisibilityCulling::set_occlusion_culling(bool enable)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	occlusion_culling = enable;
+
+	camera_results.clear();
+}
+
+bool VisibilityCulling::is_occlusion_culling_enabled() const
+{
+	return occlusion_culling;
+}
+
+void VisibilityCulling::set_hierarchical_culling(bool enable)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	hierarchical_culling = enable;
+
+	camera_results.clear();
+}
+
+bool VisibilityCulling::is_hierarchical_culling_enabled() const
+{
+	return hierarchical_culling;
+}
+
+void VisibilityCulling::add_submitted_triangles(uint64_t triangle_count)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	frame_stats.submitted_triangle_count += triangle_count;
+}
+
+VisibilityCulling::FrameStats VisibilityCulling::get_frame_stats() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	return last_frame_stats;
+}
+
+void VisibilityCulling::gather_instances()
+{
+	instance_nodes.clear();
+	instance_meshes.clear();
+	center_x.clear();
+	center_y.clear();
+	center_z.clear();
+	extent_x.clear();
+	extent_y.clear();
+	extent_z.clear();
+
+	for (auto mesh : meshes)
+	{
+		const AABB &bounds = mesh->get_bounds();
+
+		glm::vec3 local_center = bounds.get_center();
+		glm::vec3 local_extent = (bounds.get_max() - bounds.get_min()) * 0.5f;
+
+		bool bounded = glm::all(glm::lessThanEqual(bounds.get_min(), bounds.get_max()));
+
+		for (auto node : mesh->get_nodes())
+		{
+			glm::mat4 world_matrix = node->get_transform().get_world_matrix();
+
+			glm::vec3 center = glm::vec3(world_matrix * glm::vec4(local_center, 1.0f));
+
+			// Extent of the transformed box along the world axes
+			glm::vec3 extent = glm::vec3(unbounded_extent);
+			if (bounded)
+			{
+				extent = glm::abs(glm::vec3(world_matrix[0])) * local_extent.x +
+				         glm::abs(glm::vec3(world_matrix[1])) * local_extent.y +
+				         glm::abs(glm::vec3(world_matrix[2])) * local_extent.z;
+			}
+
+			instance_nodes.push_back(node);
+			instance_meshes.push_back(mesh);
+			center_x.push_back(center.x);
+			center_y.push_back(center.y);
+			center_z.push_back(center.z);
+			extent_x.push_back(extent.x);
+			extent_y.push_back(extent.y);
+			extent_z.push_back(extent.z);
+		}
+	}
+}
+
+size_t VisibilityCulling::gather_visible_instances(const glm::mat4 &view_projection)
+{
+	// Refit the hierarchy once per frame, for all the cameras
+	if (hierarchy_frame_index != frame_index)
+	{
+		bounding_volume_hierarchy.update();
+		hierarchy_frame_index = frame_index;
+	}
+
+	Frustum frustum;
+	frustum.update(view_projection);
+
+	hierarchy_instances.clear();
+	bounding_volume_hierarchy.query_frustum(frustum, hierarchy_instances);
+
+	instance_nodes.clear();
+	instance_meshes.clear();
+	center_x.clear();
+	center_y.clear();
+	center_z.clear();
+	extent_x.clear();
+	extent_y.clear();
+	extent_z.clear();
+
+	glm::vec3 min;
+	glm::vec3 max;
+
+	for (auto instance : hierarchy_instances)
+	{
+		bounding_volume_hierarchy.get_instance_bounds(instance, min, max);
+
+		glm::vec3 center = (min + max) * 0.5f;
+		glm::vec3 extent = (max - min) * 0.5f;
+
+		instance_nodes.push_back(&bounding_volume_hierarchy.get_instance_node(instance));
+		instance_meshes.push_back(&bounding_volume_hierarchy.get_instance_mesh(instance));
+		center_x.push_back(center.x);
+		center_y.push_back(center.y);
+		center_z.push_back(center.z);
+		extent_x.push_back(extent.x);
+		extent_y.push_back(extent.y);
+		extent_z.push_back(extent.z);
+	}
+
+	return bounding_volume_hierarchy.get_instance_count();
+}
+
+void VisibilityCulling::test_frustum(const glm::mat4 &view_projection)
+{
+	Frustum frustum;
+	frustum.update(view_projection);
+
+	const size_t count = inside.size();
+
+	const float *cx = center_x.data();
+	const float *cy = center_y.data();
+	const float *cz = center_z.data();
+	const float *ex = extent_x.data();
+	const float *ey = extent_y.data();
+	const float *ez = extent_z.data();
+
+	uint8_t *in = inside.data();
+
+	for (auto &plane : frustum.get_planes())
+	{
+		const float nx = plane.x;
+		const float ny = plane.y;
+		const float nz = plane.z;
+		const float nw = plane.w;
+
+		// Projection of the extent on the plane normal
+		const float ax = std::abs(plane.x);
+		const float ay = std::abs(plane.y);
+		const float az = std::abs(plane.z);
+
+		// Branchless, so the loop is vectorized over several boxes at a time
+		for (size_t i = 0; i < count; ++i)
+		{
+			float distance = nx * cx[i] + ny * cy[i] + nz * cz[i] + nw;
+			float radius   = ax * ex[i] + ay * ey[i] + az * ez[i];
+
+			in[i] &= static_cast<uint8_t>(distance > -radius);
+		}
+	}
+}
+
+bool VisibilityCulling::project_bounds(size_t index, const glm::mat4 &view, const glm::mat4 &projection, ScreenBounds &screen_bounds) const
+{
+	if (extent_x[index] == unbounded_extent)
+	{
+		return false;
+	}
+
+	glm::vec3 center{center_x[index], center_y[index], center_z[index]};
+	glm::vec3 extent{extent_x[index], extent_y[index], extent_z[index]};
+
+	screen_bounds.min        = glm::vec2(std::numeric_limits<float>::max());
+	screen_bounds.max        = glm::vec2(-std::numeric_limits<float>::max());
+	screen_bounds.near_depth = std::numeric_limits<float>::max();
+	screen_bounds.far_depth  = 0.0f;
+
+	for (uint32_t corner = 0; corner < 8; ++corner)
+	{
+		glm::vec3 sign{(corner & 1) ? 1.0f : -1.0f, (corner & 2) ? 1.0f : -1.0f, (corner & 4) ? 1.0f : -1.0f};
+
+		glm::vec4 view_position = view * glm::vec4(center + sign * extent, 1.0f);
+		glm::vec4 clip_position = projection * view_position;
+
+		// The camera looks down the negative z axis
+		float depth = -view_position.z;
+
+		if (depth <= 0.0f || clip_position.w <= std::numeric_limits<float>::epsilon())
+		{
+			return false;
+		}
+
+		glm::vec2 ndc = glm::vec2(clip_position) / clip_position.w;
+
+		screen_bounds.min        = glm::min(screen_bounds.min, ndc);
+		screen_bounds.max        = glm::max(screen_bounds.max, ndc);
+		screen_bounds.near_depth = std::min(screen_bounds.near_depth, depth);
+		screen_bounds.far_depth  = std::max(screen_bounds.far_depth, depth);
+	}
+
+	screen_bounds.min = glm::clamp(screen_bounds.min, glm::vec2(-1.0f), glm::vec2(1.0f));
+	screen_bounds.max = glm::clamp(screen_bounds.max, glm::vec2(-1.0f), glm::vec2(1.0f));
+
+	return true;
+}
+
+bool VisibilityCulling::project_occluder(size_t index, const glm::mat4 &view, const glm::mat4 &projection, std::vector<glm::vec2> &hull, float &far_depth) const
+{
+	auto &occluder_bounds = instance_meshes[index]->get_occluder_bounds();
+
+	glm::mat4 model_view = view * instance_nodes[index]->get_transform().get_world_matrix();
+	glm::vec3 min        = occluder_bounds.get_min();
+	glm::vec3 max        = occluder_bounds.get_max();
+
+	std::array<glm::vec2, 8> corners;
+	far_depth = 0.0f;
+
+	for (uint32_t corner = 0; corner < 8; ++corner)
+	{
+		glm::vec3 position{(corner & 1) ? max.x : min.x, (corner & 2) ? max.y : min.y, (corner & 4) ? max.z : min.z};
+
+		glm::vec4 view_position = model_view * glm::vec4(position, 1.0f);
+		glm::vec4 clip_position = projection * view_position;
+
+		// The camera looks down the negative z axis
+		float depth = -view_position.z;
+
+		if (depth <= 0.0f || clip_position.w <= std::numeric_limits<float>::epsilon())
+		{
+			return false;
+		}
+
+		corners[corner] = glm::vec2(clip_position) / clip_position.w;
+		far_depth       = std::max(far_depth, depth);
+	}
+
+	convex_hull(corners, hull);
+
+	return hull.size() >= 3;
+}
+
+void VisibilityCulling::test_occlusion(const glm::mat4 &view, const glm::mat4 &projection)
+{
+	candidate_bounds.resize(candidates.size());
+	candidate_projected.resize(candidates.size());
+	occluders.clear();
+
+	for (uint32_t i = 0; i < static_cast<uint32_t>(candidates.size()); ++i)
+	{
+		auto &bounds           = candidate_bounds[i];
+		candidate_projected[i] = project_bounds(candidates[i], view, projection, bounds);
+
+		// Only meshes with a box known to be inside their geometry can hide other instances.
+		// Screen rectangles span two units per axis.
+		if (candidate_projected[i] && instance_meshes[candidates[i]]->has_occluder_bounds() &&
+		    (bounds.max.x - bounds.min.x) * (bounds.max.y - bounds.min.y) >= 4.0f * MIN_OCCLUDER_AREA)
+		{
+			occluders.push_back(i);
+		}
+	}
+
+	if (occluders.empty())
+	{
+		return;
+	}
+
+	// Keep the occluders closest to the camera
+	if (occluders.size() > MAX_OCCLUDER_COUNT)
+	{
+		std::nth_element(occluders.begin(), occluders.begin() + MAX_OCCLUDER_COUNT, occluders.end(), [this](uint32_t a, uint32_t b) {
+			return candidate_bounds[a].near_depth < candidate_bounds[b].near_depth;
+		});
+		occluders.resize(MAX_OCCLUDER_COUNT);
+	}
+
+	// Each tile keeps the farthest depth of the closest occluder box covering it entirely
+	occlusion_buffer.assign(OCCLUSION_BUFFER_WIDTH * OCCLUSION_BUFFER_HEIGHT, std::numeric_limits<float>::max());
+
+	for (auto occluder : occluders)
+	{
+		float far_depth = 0.0f;
+		if (!project_occluder(candidates[occluder], view, projection, occluder_hull, far_depth))
+		{
+			continue;
+		}
+
+		glm::vec2 hull_min{std::numeric_limits<float>::max()};
+		glm::vec2 hull_max{-std::numeric_limits<float>::max()};
+		for (auto &point : occluder_hull)
+		{
+			hull_min = glm::min(hull_min, point);
+			hull_max = glm::max(hull_max, point);
+		}
+
+		auto min_x = static_cast<uint32_t>(std::max(std::floor(to_tile(hull_min.x, OCCLUSION_BUFFER_WIDTH)), 0.0f));
+		auto min_y = static_cast<uint32_t>(std::max(std::floor(to_tile(hull_min.y, OCCLUSION_BUFFER_HEIGHT)), 0.0f));
+		auto max_x = static_cast<uint32_t>(std::min(std::ceil(to_tile(hull_max.x, OCCLUSION_BUFFER_WIDTH)), static_cast<float>(OCCLUSION_BUFFER_WIDTH)));
+		auto max_y = static_cast<uint32_t>(std::min(std::ceil(to_tile(hull_max.y, OCCLUSION_BUFFER_HEIGHT)), static_cast<float>(OCCLUSION_BUFFER_HEIGHT)));
+
+		for (uint32_t y = min_y; y < max_y; ++y)
+		{
+			float *row = &occlusion_buffer[y * OCCLUSION_BUFFER_WIDTH];
+
+			for (uint32_t x = min_x; x < max_x; ++x)
+			{
+				// The hull is convex, so it covers the tile if it contains its four corners
+				bool covered = true;
+
+				for (uint32_t corner = 0; corner < 4 && covered; ++corner)
+				{
+					glm::vec2 tile_corner{static_cast<float>(x + (corner & 1)) / OCCLUSION_BUFFER_WIDTH * 2.0f - 1.0f,
+					                      static_cast<float>(y + (corner >> 1)) / OCCLUSION_BUFFER_HEIGHT * 2.0f - 1.0f};
+
+					for (size_t edge = 0; edge < occluder_hull.size(); ++edge)
+					{
+						if (cross(occluder_hull[edge], occluder_hull[(edge + 1) % occluder_hull.size()], tile_corner) < 0.0f)
+						{
+							covered = false;
+							break;
+						}
+					}
+				}
+
+				if (covered)
+				{
+					row[x] = std::min(row[x], far_depth);
+				}
+			}
+		}
+	}
+
+	// An instance is occluded if it is behind the occluders of all the tiles it touches.
+	// Occluders are never hidden by their own depth, which is farther than their nearest point.
+	for (uint32_t i = 0; i < static_cast<uint32_t>(candidates.size()); ++i)
+	{
+		if (!candidate_projected[i])
+		{
+			continue;
+		}
+
+		auto &bounds = candidate_bounds[i];
+
+		auto min_x = static_cast<uint32_t>(std::floor(to_tile(bounds.min.x, OCCLUSION_BUFFER_WIDTH)));
+		auto min_y = static_cast<uint32_t>(std::floor(to_tile(bounds.min.y, OCCLUSION_BUFFER_HEIGHT)));
+		auto max_x = static_cast<uint32_t>(std::ceil(to_tile(bounds.max.x, OCCLUSION_BUFFER_WIDTH)));
+		auto max_y = static_cast<uint32_t>(std::ceil(to_tile(bounds.max.y, OCCLUSION_BUFFER_HEIGHT)));
+
+		min_x = std::min(min_x, OCCLUSION_BUFFER_WIDTH - 1);
+		min_y = std::min(min_y, OCCLUSION_BUFFER_HEIGHT - 1);
+		max_x = std::max(max_x, min_x + 1);
+		max_y = std::max(max_y, min_y + 1);
+
+		bool occluded = true;
+
+		for (uint32_t y = min_y; y < max_y && occluded; ++y)
+		{
+			const float *row = &occlusion_buffer[y * OCCLUSION_BUFFER_WIDTH];
+
+			for (uint32_t x = min_x; x < max_x; ++x)
+			{
+				if (bounds.near_depth <= row[x])
+				{
+					occluded = false;
+					break;
+				}
+			}
+		}
+
+		if (occluded)
+		{
+			inside[candidates[i]] = 0;
+		}
+	}
+}
+}        // namespace sg
+}        // namespace vkb
@@ -0,0 +1,269 @@
+/* Copyright (c) 2023, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "common/error.h"
+
+VKBP_DISABLE_WARNINGS()
+#include "common/glm_common.h"
+VKBP_ENABLE_WARNINGS()
+
+namespace vkb
+{
+namespace sg
+{
+class BoundingVolumeHierarchy;
+class Camera;
+class Mesh;
+class Node;
+
+/**
+ * @brief Culls the mesh instances of a scene against the view of a camera
+ *
+ *        The world space bounds of all the instances are tested against the camera frustum,
+ *        one plane at a time, in linear loops over arrays of centers and extents which the
+ *        compiler vectorizes. With hierarchical culling, the frustum is tested against the
+ *        bounding volume hierarchy of the scene instead, skipping whole subtrees of instances
+ *        outside or inside the frustum. Optionally, the instances inside the frustum are then tested
+ *        against a coarse depth buffer, in which the occluder boxes of the largest instances close
+ *        to the camera are drawn. A tile only takes the depth of an occluder box whose silhouette
+ *        covers it entirely, so an instance is never culled by empty space.
+ *
+ *        The results are cached per camera until the next frame, so the subpasses drawing
+ *        the scene from the same camera during a frame share them.
+ */
+class VisibilityCulling
+{
+  public:
+	/**
+	 * @brief A mesh instance which passed the culling tests
+	 */
+	struct VisibleNode
+	{
+		Node *node;
+
+		Mesh *mesh;
+
+		// Distance from the camera to the center of the world space bounds
+		float distance;
+	};
+
+	struct Result
+	{
+		std::vector<VisibleNode> visible_nodes;
+
+		uint32_t frustum_culled_count{0};
+
+		uint32_t occluded_count{0};
+	};
+
+	/**
+	 * @brief Instance counts of all the cameras culled during a frame
+	 */
+	struct FrameStats
+	{
+		uint32_t visible_count{0};
+
+		uint32_t frustum_culled_count{0};
+
+		uint32_t occluded_count{0};
+
+		// Triangles drawn from the visible instances, as reported by the subpasses
+		uint64_t submitted_triangle_count{0};
+
+		// CPU time spent culling, in milliseconds
+		float cull_time{0.0f};
+	};
+
+	/**
+	 * @param meshes Meshes of the scene, kept up to date by the scene
+	 * @param bounding_volume_hierarchy Hierarchy over the instances of the meshes, used for hierarchical culling
+	 */
+	VisibilityCulling(const std::vector<Mesh *> &meshes, BoundingVolumeHierarchy &bounding_volume_hierarchy);
+
+	/**
+	 * @brief Invalidates the cached results, and keeps the stats of the frame which ended
+	 */
+	void begin_frame();
+
+	/**
+	 * @brief Culls the mesh instances, unless they were already culled for the camera this frame
+	 *        and the camera did not move. Thread safe.
+	 * @return The visible instances, valid until the next call for the same camera
+	 */
+	const Result &cull(Camera &camera);
+
+	void set_frustum_culling(bool enable);
+
+	bool is_frustum_culling_enabled() const;
+
+	/**
+	 * @brief Enables the occlusion test. Only meshes given occluder bounds with sg::Mesh::set_occluder_bounds
+	 *        hide other instances, so the test has no effect on scenes without them.
+	 */
+	void set_occlusion_culling(bool enable);
+
+	bool is_occlusion_culling_enabled() const;
+
+	/**
+	 * @brief Tests the frustum against the bounding volume hierarchy, which is updated once per frame,
+	 *        rather than against every instance
+	 */
+	void set_hierarchical_culling(bool enable);
+
+	bool is_hierarchical_culling_enabled() const;
+
+	/**
+	 * @brief Adds triangles drawn from the visible instances to the stats of the frame. Thread safe.
+	 */
+	void add_submitted_triangles(uint64_t triangle_count);
+
+	/**
+	 * @return The stats of the last complete frame
+	 */
+	FrameStats get_frame_stats() const;
+
+	/// Resolution of the occlusion depth buffer, in tiles
+	static constexpr uint32_t OCCLUSION_BUFFER_WIDTH = 64;
+
+	static constexpr uint32_t OCCLUSION_BUFFER_HEIGHT = 32;
+
+	/// Minimum fraction of the screen covered by the bounds of an occluder
+	static constexpr float MIN_OCCLUDER_AREA = 0.01f;
+
+	/// Maximum number of occluders drawn, closest first
+	static constexpr uint32_t MAX_OCCLUDER_COUNT = 64;
+
+  private:
+	struct CameraResult
+	{
+		uint64_t frame_index{std::numeric_limits<uint64_t>::max()};
+
+		glm::mat4 view_projection{1.0f};
+
+		Result result;
+	};
+
+	/**
+	 * @brief Screen rectangle and view depth range of the bounds of an instance
+	 */
+	struct ScreenBounds
+	{
+		glm::vec2 min;
+
+		glm::vec2 max;
+
+		float near_depth;
+
+		float far_depth;
+	};
+
+	/**
+	 * @brief Fills the arrays of world space bounds of the instances
+	 */
+	void gather_instances();
+
+	/**
+	 * @brief Fills the arrays of world space bounds with the instances of the hierarchy intersecting the frustum
+	 * @return The total number of instances
+	 */
+	size_t gather_visible_instances(const glm::mat4 &view_projection);
+
+	void test_frustum(const glm::mat4 &view_projection);
+
+	/**
+	 * @brief Projects the bounds of an instance to the screen
+	 * @return False if the bounds cross the camera plane, or are unbounded
+	 */
+	bool project_bounds(size_t index, const glm::mat4 &view, const glm::mat4 &projection, ScreenBounds &screen_bounds) const;
+
+	/**
+	 * @brief Projects the occluder box of an instance to the screen
+	 * @param hull Receives the convex hull of the projected box, counter-clockwise
+	 * @param far_depth Receives the farthest view depth of the box
+	 * @return False if the box crosses the camera plane
+	 */
+	bool project_occluder(size_t index, const glm::mat4 &view, const glm::mat4 &projection, std::vector<glm::vec2> &hull, float &far_depth) const;
+
+	void test_occlusion(const glm::mat4 &view, const glm::mat4 &projection);
+
+	const std::vector<Mesh *> &meshes;
+
+	BoundingVolumeHierarchy &bounding_volume_hierarchy;
+
+	bool frustum_culling{true};
+
+	bool occlusion_culling{false};
+
+	bool hierarchical_culling{false};
+
+	uint64_t hierarchy_frame_index{std::numeric_limits<uint64_t>::max()};
+
+	std::vector<uint32_t> hierarchy_instances;
+
+	uint64_t frame_index{0};
+
+	FrameStats frame_stats;
+
+	FrameStats last_frame_stats;
+
+	std::unordered_map<const Camera *, CameraResult> camera_results;
+
+	// Serializes the culling of cameras recorded on different threads
+	mutable std::mutex mutex;
+
+	std::vector<Node *> instance_nodes;
+
+	std::vector<Mesh *> instance_meshes;
+
+	// World space bounds of the instances, one array per component
+	std::vector<float> center_x;
+
+	std::vector<float> center_y;
+
+	std::vector<float> center_z;
+
+	std::vector<float> extent_x;
+
+	std::vector<float> extent_y;
+
+	std::vector<float> extent_z;
+
+	std::vector<uint8_t> inside;
+
+	// Instances inside the frustum, and their screen bounds for the occlusion test
+	std::vector<uint32_t> candidates;
+
+	std::vector<ScreenBounds> candidate_bounds;
+
+	std::vector<uint8_t> candidate_projected;
+
+	std::vector<uint32_t> occluders;
+
+	std::vector<glm::vec2> occluder_hull;
+
+	std::vector<float> occlusion_buffer;
+};
+}        // namespace sg
+}        // namespace vkb
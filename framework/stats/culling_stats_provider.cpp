@@ -0,0 +1,80 @@
+/* Copyright (c) 2023, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "culling_stats_provider.h"
+
+#include "scene_graph/visibility_culling.h"
+
+namespace vkb
+{
+CullingStatsProvider::CullingStatsProvider(std::set<StatIndex> &requested_stats)
+{
+	for (auto index : {StatIndex::visible_objects, StatIndex::culled_objects, StatIndex::occluded_objects, StatIndex::submitted_triangles})
+	{
+		if (requested_stats.erase(index))
+		{
+			supported_stats.insert(index);
+		}
+	}
+}
+
+void CullingStatsProvider::set_visibility_culling(const sg::VisibilityCulling *culling)
+{
+	visibility_culling = culling;
+}
+
+bool CullingStatsProvider::is_available(StatIndex index) const
+{
+	return supported_stats.count(index) > 0;
+}
+
+StatsProvider::Counters CullingStatsProvider::sample(float delta_time)
+{
+	Counters res;
+
+	if (!visibility_culling)
+	{
+		return res;
+	}
+
+	// Counts of the last complete frame, summed over the cameras culled during that frame
+	auto frame_stats = visibility_culling->get_frame_stats();
+
+	for (auto index : supported_stats)
+	{
+		switch (index)
+		{
+			case StatIndex::visible_objects:
+				res[index].result = frame_stats.visible_count;
+				break;
+			case StatIndex::culled_objects:
+				res[index].result = frame_stats.frustum_culled_count;
+				break;
+			case StatIndex::occluded_objects:
+				res[index].result = frame_stats.occluded_count;
+				break;
+			case StatIndex::submitted_triangles:
+				res[index].result = static_cast<double>(frame_stats.submitted_triangle_count);
+				break;
+			default:
+				break;
+		}
+	}
+
+	return res;
+}
+}        // namespace vkb
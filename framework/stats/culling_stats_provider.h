@@ -0,0 +1,64 @@
+/* Copyright (c) 2023, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "stats_provider.h"
+
+namespace vkb
+{
+namespace sg
+{
+class VisibilityCulling;
+}        // namespace sg
+
+/**
+ * @brief Provides the instance counts of the scene visibility culling, and the triangles drawn from the visible instances
+ */
+class CullingStatsProvider : public StatsProvider
+{
+  public:
+	/**
+	 * @brief Constructs a CullingStatsProvider
+	 * @param requested_stats Set of stats to be collected. Supported stats will be removed from the set.
+	 */
+	CullingStatsProvider(std::set<StatIndex> &requested_stats);
+
+	/**
+	 * @brief Sets the visibility culling of the scene to sample, or nullptr if there is none
+	 */
+	void set_visibility_culling(const sg::VisibilityCulling *culling);
+
+	/**
+	 * @brief Checks if this provider can supply the given enabled stat
+	 * @param index The stat index
+	 * @return True if the stat is available, false otherwise
+	 */
+	bool is_available(StatIndex index) const override;
+
+	/**
+	 * @brief Retrieve a new sample set
+	 * @param delta_time Time since last sample
+	 */
+	Counters sample(float delta_time) override;
+
+  private:
+	std::set<StatIndex> supported_stats;
+
+	const sg::VisibilityCulling *visibility_culling{nullptr};
+};
+}        // namespace vkb
@@ -39,6 +39,7 @@ class HPPStats : private vkb::Stats
 	using vkb::Stats::is_available;
 	using vkb::Stats::request_stats;
 	using vkb::Stats::resize;
+	using vkb::Stats::set_visibility_culling;
 	using vkb::Stats::update;
 
 	explicit HPPStats(vkb::rendering::HPPRenderContext &render_context, size_t buffer_size = 16) :
@@ -19,6 +19,7 @@
 #include "stats/stats.h"
 #include "core/device.h"
 
+#include "culling_stats_provider.h"
 #include "frame_time_stats_provider.h"
 #include "hwcpipe_stats_provider.h"
 #include "vulkan_stats_provider.h"
@@ -63,6 +64,11 @@ void Stats::request_stats(const std::set<StatIndex> &wanted_stats,
 	// All supported stats will be removed from the given 'stats' set by the provider's constructor
 	// so subsequent providers only see requests for stats that aren't already supported.
 	providers.emplace_back(std::make_unique<FrameTimeStatsProvider>(stats));
+
+	auto culling_stats_provider = std::make_unique<CullingStatsProvider>(stats);
+	culling_provider            = culling_stats_provider.get();
+	providers.emplace_back(std::move(culling_stats_provider));
+
 	providers.emplace_back(std::make_unique<HWCPipeStatsProvider>(stats));
 	providers.emplace_back(std::make_unique<VulkanStatsProvider>(stats, sampling_config, render_context));
 
@@ -136,6 +142,14 @@ static void add_smoothed_value(std::vector<float> &values, float value, float al
 	values.back() = value * alpha + *(values.end() - 2) * (1.0f - alpha);
 }
 
+void Stats::set_visibility_culling(const sg::VisibilityCulling *culling)
+{
+	if (culling_provider)
+	{
+		culling_provider->set_visibility_culling(culling);
+	}
+}
+
 void Stats::update(float delta_time)
 {
 	switch (sampling_config.mode)
@@ -202,9 +216,12 @@ void Stats::update(float delta_time)
 			// Clamp the number of samples
 			sample_count = std::max<size_t>(1, std::min<size_t>(sample_count, pending_samples.size()));
 
-			// Get the frame time stats (not a continuous stat)
+			// Get the frame time and culling stats (not continuous stats)
 			StatsProvider::Counters frame_time_sample = frame_time_provider->sample(delta_time);
 
+			auto culling_sample = culling_provider->sample(delta_time);
+			frame_time_sample.insert(culling_sample.begin(), culling_sample.end());
+
 			// Push the samples to circular buffers
 			std::for_each(pending_samples.begin(), pending_samples.begin() + sample_count, [this, frame_time_sample](auto &s) {
 				// Write the correct frame time into the continuous stats
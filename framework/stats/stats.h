@@ -34,6 +34,12 @@ namespace vkb
 class Device;
 class CommandBuffer;
 class RenderContext;
+class CullingStatsProvider;
+
+namespace sg
+{
+class VisibilityCulling;
+}        // namespace sg
 
 /*
  * @brief Helper class for querying statistics about the CPU and the GPU
@@ -99,6 +105,12 @@ class Stats
 		return requested_stats;
 	}
 
+	/**
+	 * @brief Sets the visibility culling sampled for the culling stats
+	 * @param culling Visibility culling of the scene, or nullptr if there is no scene
+	 */
+	void set_visibility_culling(const sg::VisibilityCulling *culling);
+
 	/**
 	 * @brief Update statistics, must be called after every frame
 	 * @param delta_time Time since last update
@@ -143,6 +155,9 @@ class Stats
 	/// Provider that tracks frame times
 	StatsProvider *frame_time_provider;
 
+	/// The culling stats are read from the scene every frame, like the frame times
+	CullingStatsProvider *culling_provider{nullptr};
+
 	/// A list of stats providers to use in priority order
 	std::vector<std::unique_ptr<StatsProvider>> providers;
 
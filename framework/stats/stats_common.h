@@ -63,6 +63,11 @@ enum class StatIndex
 	gpu_ext_read_bytes,
 	gpu_ext_write_bytes,
 	gpu_tex_cycles,
+
+	visible_objects,
+	culled_objects,
+	occluded_objects,
+	submitted_triangles,
 };
 
 struct StatIndexHash
@@ -54,6 +54,11 @@ std::map<StatIndex, StatGraphData> StatsProvider::default_graph_map{
     {StatIndex::gpu_ext_write_stalls,  {"External Write Stalls",                       "{:4.1f} M/s",   static_cast<float>(1e-6)}},
     {StatIndex::gpu_ext_read_bytes,    {"External Read Bytes",                         "{:4.1f} MiB/s", 1.0f / (1024.0f * 1024.0f)}},
     {StatIndex::gpu_ext_write_bytes,   {"External Write Bytes",                        "{:4.1f} MiB/s", 1.0f / (1024.0f * 1024.0f)}},
+
+    {StatIndex::visible_objects,       {"Visible Objects",                             "{:4.0f}"}},
+    {StatIndex::culled_objects,        {"Frustum Culled Objects",                      "{:4.0f}"}},
+    {StatIndex::occluded_objects,      {"Occluded Objects",                            "{:4.0f}"}},
+    {StatIndex::submitted_triangles,   {"Submitted Triangles",                         "{:4.1f} k",     static_cast<float>(1e-3)}},
     // clang-format on
 };
 
@@ -35,6 +35,9 @@ VKBP_ENABLE_WARNINGS()
 #include "platform/window.h"
 #include "rendering/render_context.h"
 #include "scene_graph/components/camera.h"
+#include "scene_graph/components/mesh.h"
+#include "scene_graph/components/skin.h"
+#include "scene_graph/components/sub_mesh.h"
 #include "scene_graph/script.h"
 #include "scene_graph/scripts/animation.h"
 #include "scene_graph/scripts/free_camera.h"
@@ -52,6 +55,7 @@ VulkanSample::~VulkanSample()
 		device->wait_idle();
 	}
 
+	gpu_skinning.reset();
 	scene.reset();
 
 	stats.reset();
@@ -238,7 +242,7 @@ void VulkanSample::update_scene(float delta_time)
 		// Update scripts
 		if (scene->has_component<sg::Script>())
 		{
-			auto scripts = scene->get_components<sg::Script>();
+			auto &scripts = scene->get_component_view<sg::Script>();
 
 			for (auto script : scripts)
 			{
@@ -249,13 +253,20 @@ void VulkanSample::update_scene(float delta_time)
 		// Update animations
 		if (scene->has_component<sg::Animation>())
 		{
-			auto animations = scene->get_components<sg::Animation>();
+			auto &animations = scene->get_component_view<sg::Animation>();
 
+			// Large animations sample their channels in parallel
 			for (auto animation : animations)
 			{
-				animation->update(delta_time);
+				animation->update(delta_time, &get_job_system());
 			}
 		}
+
+		// Update the world matrices changed by the scripts and animations in one pass
+		scene->get_transform_hierarchy().update(&get_job_system());
+
+		// Cull the scene again with the updated transforms
+		scene->get_visibility_culling().begin_frame();
 	}
 }
 
@@ -263,6 +274,8 @@ void VulkanSample::update_stats(float delta_time)
 {
 	if (stats)
 	{
+		stats->set_visibility_culling(scene ? &scene->get_visibility_culling() : nullptr);
+
 		stats->update(delta_time);
 
 		static float stats_view_count = 0.0f;
@@ -311,6 +324,22 @@ void VulkanSample::update(float delta_time)
 	command_buffer.begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
 	stats->begin_sampling(command_buffer);
 
+	// Deform the skinned meshes once for all the render passes of the frame
+	if (gpu_skinning && gpu_skinning->is_async_compute())
+	{
+		// Submitted first, the graphics submission waits for the deformed vertices
+		auto &compute_command_buffer = render_context->begin_async_compute();
+		compute_command_buffer.begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+		gpu_skinning->dispatch(compute_command_buffer, *render_context);
+		compute_command_buffer.end();
+
+		render_context->submit_async_compute({&compute_command_buffer});
+	}
+	else if (gpu_skinning)
+	{
+		gpu_skinning->dispatch(command_buffer, *render_context);
+	}
+
 	draw(command_buffer, render_context->get_active_frame().get_render_target());
 
 	stats->end_sampling(command_buffer);
@@ -379,7 +408,27 @@ void VulkanSample::draw_renderpass(CommandBuffer &command_buffer, RenderTarget &
 
 	if (gui)
 	{
-		gui->draw(command_buffer);
+		// The last subpass may only accept secondary command buffers, in which case the gui is recorded in its own
+		if (render_pipeline && render_pipeline->get_subpasses().back()->get_contents() == VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS)
+		{
+			const auto &queue = device->get_queue_by_flags(VK_QUEUE_GRAPHICS_BIT, 0);
+
+			auto &secondary_command_buffer = render_context->get_active_frame().request_command_buffer(queue, command_buffer.get_reset_mode(), VK_COMMAND_BUFFER_LEVEL_SECONDARY);
+
+			secondary_command_buffer.begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT, &command_buffer);
+
+			set_viewport_and_scissor(secondary_command_buffer, render_target.get_extent());
+
+			gui->draw(secondary_command_buffer);
+
+			secondary_command_buffer.end();
+
+			command_buffer.execute_commands(secondary_command_buffer);
+		}
+		else
+		{
+			gui->draw(command_buffer);
+		}
 	}
 
 	command_buffer.end_render_pass();
@@ -404,7 +453,7 @@ bool VulkanSample::resize(uint32_t width, uint32_t height)
 
 	if (scene && scene->has_component<sg::Script>())
 	{
-		auto scripts = scene->get_components<sg::Script>();
+		auto &scripts = scene->get_component_view<sg::Script>();
 
 		for (auto script : scripts)
 		{
@@ -434,7 +483,7 @@ void VulkanSample::input_event(const InputEvent &input_event)
 	{
 		if (scene && scene->has_component<sg::Script>())
 		{
-			auto scripts = scene->get_components<sg::Script>();
+			auto &scripts = scene->get_component_view<sg::Script>();
 
 			for (auto script : scripts)
 			{
@@ -502,12 +551,12 @@ void VulkanSample::update_debug_window()
 	if (scene != nullptr)
 	{
 		get_debug_info().insert<field::Static, uint32_t>("mesh_count",
-		                                                 to_u32(scene->get_components<sg::SubMesh>().size()));
+		                                                 to_u32(scene->get_component_view<sg::SubMesh>().size()));
 
 		get_debug_info().insert<field::Static, uint32_t>("texture_count",
-		                                                 to_u32(scene->get_components<sg::Texture>().size()));
+		                                                 to_u32(scene->get_component_view<sg::Texture>().size()));
 
-		auto cameras = scene->get_components<vkb::sg::Camera>();
+		auto &cameras = scene->get_component_view<vkb::sg::Camera>();
 		if (!cameras.empty())
 		{
 			if (auto camera_node = cameras[0]->get_node())
@@ -533,9 +582,10 @@ void VulkanSample::set_viewport_and_scissor(vkb::CommandBuffer &command_buffer,
 	command_buffer.set_scissor(0, {scissor});
 }
 
-void VulkanSample::load_scene(const std::string &path)
+void VulkanSample::load_scene(const std::string &path, uint32_t mesh_lod_count)
 {
-	GLTFLoader loader{*device};
+	GLTFLoader loader{*device, &get_job_system()};
+	loader.set_mesh_lod_count(mesh_lod_count);
 
 	scene = loader.read_scene_from_file(path);
 
@@ -544,6 +594,24 @@ void VulkanSample::load_scene(const std::string &path)
 		LOGE("Cannot load scene: {}", path.c_str());
 		throw std::runtime_error("Cannot load scene: " + path);
 	}
+
+	create_gpu_skinning();
+}
+
+void VulkanSample::create_gpu_skinning()
+{
+	bool deformed = !scene->get_component_view<sg::Skin>().empty();
+
+	for (auto mesh : scene->get_component_view<sg::Mesh>())
+	{
+		for (auto sub_mesh : mesh->get_submeshes())
+		{
+			deformed |= sub_mesh->morph_target_count > 0;
+		}
+	}
+
+	// Scenes without skins or morph targets skip the dispatch altogether
+	gpu_skinning = deformed ? std::make_unique<GPUSkinning>(*device, *scene) : nullptr;
 }
 
 VkSurfaceKHR VulkanSample::get_surface()
@@ -557,6 +625,12 @@ RenderContext &VulkanSample::get_render_context()
 	return *render_context;
 }
 
+JobSystem &VulkanSample::get_job_system()
+{
+	assert(platform && "Platform is not valid, the sample must be prepared first");
+	return platform->get_job_system();
+}
+
 const std::vector<const char *> VulkanSample::get_validation_layers()
 {
 	return {};
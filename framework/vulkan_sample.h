@@ -21,7 +21,9 @@
 #include "common/vk_common.h"
 #include "core/instance.h"
 #include "gui.h"
+#include "job_system.h"
 #include "platform/application.h"
+#include "rendering/gpu_skinning.h"
 #include "rendering/render_context.h"
 #include "rendering/render_pipeline.h"
 #include "scene_graph/node.h"
@@ -138,8 +140,15 @@ class VulkanSample : public Application
 	 * @brief Loads the scene
 	 *
 	 * @param path The path of the glTF file
+	 * @param mesh_lod_count Number of levels of detail generated for the meshes, zero to load the indices unchanged
 	 */
-	void load_scene(const std::string &path);
+	void load_scene(const std::string &path, uint32_t mesh_lod_count = 0);
+
+	/**
+	 * @brief Creates the GPU skinning if the scene has skins or morph targets, and removes it otherwise.
+	 *        Called by load_scene, and again by samples adding skins to the scene.
+	 */
+	void create_gpu_skinning();
 
 	VkSurfaceKHR get_surface();
 
@@ -147,6 +156,11 @@ class VulkanSample : public Application
 
 	RenderContext &get_render_context();
 
+	/**
+	 * @brief The job system of the platform, to run work in parallel without creating threads
+	 */
+	JobSystem &get_job_system();
+
 	void set_render_pipeline(RenderPipeline &&render_pipeline);
 
 	RenderPipeline &get_render_pipeline();
@@ -183,6 +197,11 @@ class VulkanSample : public Application
 	 */
 	std::unique_ptr<sg::Scene> scene{nullptr};
 
+	/**
+	 * @brief Deforms the skinned and morphed meshes of the scene once per frame, before drawing, null if the scene has none
+	 */
+	std::unique_ptr<GPUSkinning> gpu_skinning{nullptr};
+
 	std::unique_ptr<Gui> gui{nullptr};
 
 	std::unique_ptr<Stats> stats{nullptr};
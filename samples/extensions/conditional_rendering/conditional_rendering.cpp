@@ -125,7 +125,7 @@ void ConditionalRendering::build_command_buffers()
 
 void ConditionalRendering::load_assets()
 {
-	vkb::GLTFLoader loader{get_device()};
+	vkb::GLTFLoader loader{get_device(), &get_job_system()};
 	scene = loader.read_scene_from_file("scenes/Buggy/glTF-Embedded/Buggy.gltf");
 	assert(scene);
 	// Store all scene nodes in a linear vector for easier access
@@ -49,6 +49,18 @@ void GraphicsPipelineLibrary::pipeline_creation_threadfn()
 	LOGD("Pipeline created in {} ms", milliseconds.count());
 }
 
+void GraphicsPipelineLibrary::submit_pipeline_creation()
+{
+	// Chain the jobs, so the last one can be waited on before tearing down the sample
+	std::vector<vkb::JobSystem::JobHandle> dependencies;
+	if (pipeline_creation_job)
+	{
+		dependencies.push_back(pipeline_creation_job);
+	}
+
+	pipeline_creation_job = get_job_system().submit([this](uint32_t) { pipeline_creation_threadfn(); }, dependencies);
+}
+
 GraphicsPipelineLibrary::GraphicsPipelineLibrary()
 {
 	title = "Graphics pipeline library";
@@ -70,6 +82,11 @@ GraphicsPipelineLibrary::~GraphicsPipelineLibrary()
 {
 	if (device)
 	{
+		if (pipeline_creation_job)
+		{
+			get_job_system().wait(pipeline_creation_job);
+		}
+
 		for (auto pipeline : pipelines)
 		{
 			vkDestroyPipeline(get_device().get_handle(), pipeline, nullptr);
@@ -497,9 +514,8 @@ bool GraphicsPipelineLibrary::prepare(vkb::Platform &platform)
 	pipeline_cache_create_info.sType                     = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
 	vkCreatePipelineCache(get_device().get_handle(), &pipeline_cache_create_info, nullptr, &thread_pipeline_cache);
 
-	// Create first pipeline using a background thread
-	std::thread pipeline_generation_thread(&GraphicsPipelineLibrary::pipeline_creation_threadfn, this);
-	pipeline_generation_thread.detach();
+	// Create first pipeline using a background job
+	submit_pipeline_creation();
 
 	prepared = true;
 	return true;
@@ -531,9 +547,8 @@ void GraphicsPipelineLibrary::on_update_ui_overlay(vkb::Drawer &drawer)
 		(drawer.checkbox("Link time optimization", &link_time_optimization));
 		if (drawer.button("Add pipeline"))
 		{
-			// Spwan a thread to create a new pipeline in the background
-			std::thread pipeline_generation_thread(&GraphicsPipelineLibrary::pipeline_creation_threadfn, this);
-			pipeline_generation_thread.detach();
+			// Submit a job to create a new pipeline in the background
+			submit_pipeline_creation();
 		}
 	}
 }
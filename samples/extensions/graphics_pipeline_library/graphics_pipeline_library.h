@@ -62,6 +62,9 @@ class GraphicsPipelineLibrary : public ApiVulkanSample
 	std::mutex      mutex;
 	VkPipelineCache thread_pipeline_cache{VK_NULL_HANDLE};
 
+	// Last pipeline creation job submitted to the job system
+	vkb::JobSystem::JobHandle pipeline_creation_job;
+
 	bool  new_pipeline_created = false;
 	float accumulated_time{};
 
@@ -82,6 +85,7 @@ class GraphicsPipelineLibrary : public ApiVulkanSample
 	void         prepare_pipeline_library();
 	void         prepare_new_pipeline();
 	void         pipeline_creation_threadfn();
+	void         submit_pipeline_creation();
 	void         prepare_uniform_buffers();
 	void         update_uniform_buffers();
 	void         draw();
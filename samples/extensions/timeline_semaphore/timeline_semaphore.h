@@ -89,6 +89,9 @@ class TimelineSemaphore : public ApiVulkanSample
 	};
 	TimelineLock main_thread_timeline_lock{}, async_compute_timeline_lock{};
 
+	// The worker loops until the sample finishes, waiting on the main thread timeline.
+	// It runs on its own thread rather than as a job system job, a job that never completes
+	// could be picked up by the main thread while it waits on other jobs.
 	struct TimelineWorker
 	{
 		std::thread      thread;
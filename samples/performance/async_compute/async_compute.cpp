@@ -222,7 +222,7 @@ bool AsyncComputeSample::prepare(vkb::Platform &platform)
 	camera            = &camera_node.get_component<vkb::sg::Camera>();
 
 	// Attach a shadow camera to the directional light.
-	auto lights = scene->get_components<vkb::sg::Light>();
+	auto &lights = scene->get_component_view<vkb::sg::Light>();
 	for (auto &light : lights)
 	{
 		if (light->get_light_type() == vkb::sg::LightType::Directional)
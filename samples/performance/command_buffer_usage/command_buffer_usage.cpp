@@ -96,7 +96,8 @@ bool CommandBufferUsage::prepare(vkb::Platform &platform)
 
 void CommandBufferUsage::prepare_render_context()
 {
-	max_thread_count = std::max(std::thread::hardware_concurrency(), MIN_THREAD_COUNT);
+	// Recording jobs allocate from the pools of the job system thread running them
+	max_thread_count = get_job_system().get_thread_count();
 	get_render_context().prepare(max_thread_count);
 }
 
@@ -116,6 +117,8 @@ void CommandBufferUsage::update(float delta_time)
 
 	subpass_state.multi_threading = gui_multi_threading;
 
+	subpass_state.job_system = &get_job_system();
+
 	auto &render_context = get_render_context();
 
 	update_scene(delta_time);
@@ -124,6 +127,11 @@ void CommandBufferUsage::update(float delta_time)
 
 	auto &primary_command_buffer = render_context.begin(subpass_state.command_buffer_reset_mode);
 
+	// Time the uniform allocations of the frame, to compare the buffer allocation strategies
+	auto &render_frame = render_context.get_active_frame();
+	render_frame.set_buffer_allocation_strategy(static_cast<vkb::BufferAllocationStrategy>(gui_buffer_allocation_strategy));
+	render_frame.set_buffer_allocation_timing(true);
+
 	update_stats(delta_time);
 
 	primary_command_buffer.begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
@@ -140,10 +148,13 @@ void CommandBufferUsage::update(float delta_time)
 void CommandBufferUsage::draw_gui()
 {
 	const bool landscape = camera->get_aspect_ratio() > 1.0f;
-	uint32_t   lines     = landscape ? 3 : 5;
+	uint32_t   lines     = landscape ? 5 : 8;
 
 	const auto &subpass = static_cast<ForwardSubpassSecondary *>(render_pipeline->get_active_subpass().get());
 
+	// Uniform allocations of the previous frame, made by all the recording threads
+	auto buffer_pool_stats = get_render_context().get_last_rendered_frame().get_buffer_pool_stats();
+
 	gui->show_options_window(
 	    /* body = */ [&]() {
 		    // Secondary command buffer count
@@ -169,6 +180,20 @@ void CommandBufferUsage::draw_gui()
 			    ImGui::SameLine();
 		    }
 		    ImGui::RadioButton("Reset pool", &gui_command_buffer_reset_mode, static_cast<int>(vkb::CommandBuffer::ResetMode::ResetPool));
+
+		    // Uniform buffer allocation options
+		    ImGui::RadioButton("Buffer per allocation", &gui_buffer_allocation_strategy, vkb::BufferAllocationStrategy::OneAllocationPerBuffer);
+		    if (landscape)
+		    {
+			    ImGui::SameLine();
+		    }
+		    ImGui::RadioButton("Shared blocks", &gui_buffer_allocation_strategy, vkb::BufferAllocationStrategy::MultipleAllocationsPerBuffer);
+
+		    // Allocations per millisecond spent allocating, over all the recording threads
+		    double allocation_rate = buffer_pool_stats.allocation_time > 0.0 ? buffer_pool_stats.allocation_count / buffer_pool_stats.allocation_time : 0.0;
+
+		    ImGui::Text("Buffer pools: %d allocations in %.3f ms (%.0f/ms), %.1f KB in %d blocks", buffer_pool_stats.allocation_count,
+		                buffer_pool_stats.allocation_time, allocation_rate, static_cast<float>(buffer_pool_stats.used_size) / 1024.0f, buffer_pool_stats.block_count);
 	    },
 	    /* lines = */ lines);
 }
@@ -261,7 +286,7 @@ void CommandBufferUsage::ForwardSubpassSecondary::record_draw(vkb::CommandBuffer
 	{
 		update_uniform(command_buffer, *nodes[i].first, thread_index);
 
-		draw_submesh(command_buffer, *nodes[i].second);
+		draw_submesh(command_buffer, *nodes[i].second, VK_FRONT_FACE_COUNTER_CLOCKWISE, 1, 0, nodes[i].first);
 	}
 }
 
@@ -288,30 +313,14 @@ vkb::CommandBuffer *CommandBufferUsage::ForwardSubpassSecondary::record_draw_sec
 
 void CommandBufferUsage::ForwardSubpassSecondary::draw(vkb::CommandBuffer &primary_command_buffer)
 {
-	std::multimap<float, std::pair<vkb::sg::Node *, vkb::sg::SubMesh *>> opaque_nodes;
-
-	std::multimap<float, std::pair<vkb::sg::Node *, vkb::sg::SubMesh *>> transparent_nodes;
-
-	get_sorted_nodes(opaque_nodes, transparent_nodes);
-
-	// Sort opaque objects in front-to-back order
+	// Opaque objects are sorted by pipeline state and in front-to-back order, transparent objects in back-to-front order
 	// Note: sorting objects does not help on PowerVR, so it can be avoided to save CPU cycles
-	std::vector<std::pair<vkb::sg::Node *, vkb::sg::SubMesh *>> sorted_opaque_nodes;
-	for (auto node_it = opaque_nodes.begin(); node_it != opaque_nodes.end(); node_it++)
-	{
-		sorted_opaque_nodes.push_back(node_it->second);
-	}
-	const auto opaque_submeshes = vkb::to_u32(sorted_opaque_nodes.size());
+	get_sorted_nodes(sorted_opaque_nodes, sorted_transparent_nodes);
 
-	// Sort transparent objects in back-to-front order
-	std::vector<std::pair<vkb::sg::Node *, vkb::sg::SubMesh *>> sorted_transparent_nodes;
-	for (auto node_it = transparent_nodes.rbegin(); node_it != transparent_nodes.rend(); node_it++)
-	{
-		sorted_transparent_nodes.push_back(node_it->second);
-	}
+	const auto opaque_submeshes      = vkb::to_u32(sorted_opaque_nodes.size());
 	const auto transparent_submeshes = vkb::to_u32(sorted_transparent_nodes.size());
 
-	allocate_lights<vkb::ForwardLights>(scene.get_components<vkb::sg::Light>(), MAX_FORWARD_LIGHT_COUNT);
+	allocate_lights<vkb::ForwardLights>(scene.get_component_view<vkb::sg::Light>(), MAX_FORWARD_LIGHT_COUNT);
 
 	color_blend_attachment.blend_enable = VK_FALSE;
 	color_blend_state.attachments.resize(get_output_attachments().size());
@@ -323,14 +332,11 @@ void CommandBufferUsage::ForwardSubpassSecondary::draw(vkb::CommandBuffer &prima
 	std::vector<vkb::CommandBuffer *> secondary_command_buffers;
 	avg_draws_per_buffer = (state.secondary_cmd_buf_count > 0) ? static_cast<float>(opaque_submeshes) / state.secondary_cmd_buf_count : 0;
 
-	if (state.thread_count != thread_pool.size())
-	{
-		thread_pool.resize(state.thread_count);
-	}
-
 	if (use_secondary_command_buffers)
 	{
-		std::vector<std::future<vkb::CommandBuffer *>> secondary_cmd_buf_futures;
+		std::vector<vkb::JobSystem::JobHandle> secondary_cmd_buf_jobs;
+
+		secondary_command_buffers.resize(state.secondary_cmd_buf_count, nullptr);
 
 		// Save the number of draws left over, these will be distributed among the first buffers
 		uint32_t draws_per_buffer = vkb::to_u32(std::floor(avg_draws_per_buffer));
@@ -349,16 +355,16 @@ void CommandBufferUsage::ForwardSubpassSecondary::draw(vkb::CommandBuffer &prima
 
 			if (state.multi_threading)
 			{
-				auto fut = thread_pool.push(
-				    [this, cb_count, &primary_command_buffer, &sorted_opaque_nodes, mesh_start, mesh_end](size_t thread_id) {
-					    return record_draw_secondary(primary_command_buffer, sorted_opaque_nodes, mesh_start, mesh_end, thread_id);
+				auto job = state.job_system->submit(
+				    [this, cb_count, &primary_command_buffer, &secondary_command_buffers, mesh_start, mesh_end](uint32_t thread_index) {
+					    secondary_command_buffers[cb_count] = record_draw_secondary(primary_command_buffer, sorted_opaque_nodes, mesh_start, mesh_end, thread_index);
 				    });
 
-				secondary_cmd_buf_futures.push_back(std::move(fut));
+				secondary_cmd_buf_jobs.push_back(std::move(job));
 			}
 			else
 			{
-				secondary_command_buffers.push_back(record_draw_secondary(primary_command_buffer, sorted_opaque_nodes, mesh_start, mesh_end));
+				secondary_command_buffers[cb_count] = record_draw_secondary(primary_command_buffer, sorted_opaque_nodes, mesh_start, mesh_end);
 			}
 
 			mesh_start = mesh_end;
@@ -366,10 +372,7 @@ void CommandBufferUsage::ForwardSubpassSecondary::draw(vkb::CommandBuffer &prima
 
 		if (state.multi_threading)
 		{
-			for (auto &fut : secondary_cmd_buf_futures)
-			{
-				secondary_command_buffers.push_back(fut.get());
-			}
+			state.job_system->wait(secondary_cmd_buf_jobs);
 		}
 	}
 	else
@@ -17,8 +17,6 @@
 
 #pragma once
 
-#include <ctpl_stl.h>
-
 #include "buffer_pool.h"
 #include "common/utils.h"
 #include "rendering/render_pipeline.h"
@@ -56,6 +54,8 @@ class CommandBufferUsage : public vkb::VulkanSample
 		bool multi_threading = false;
 
 		uint32_t thread_count = 0;
+
+		vkb::JobSystem *job_system = nullptr;
 	};
 
 	/**
@@ -118,7 +118,10 @@ class CommandBufferUsage : public vkb::VulkanSample
 
 		float avg_draws_per_buffer{0};
 
-		ctpl::thread_pool thread_pool;
+		// Sorted draws, kept across frames to avoid allocating them every frame
+		std::vector<std::pair<vkb::sg::Node *, vkb::sg::SubMesh *>> sorted_opaque_nodes;
+
+		std::vector<std::pair<vkb::sg::Node *, vkb::sg::SubMesh *>> sorted_transparent_nodes;
 	};
 
   private:
@@ -140,9 +143,9 @@ class CommandBufferUsage : public vkb::VulkanSample
 
 	int gui_command_buffer_reset_mode{0};
 
-	bool gui_multi_threading{false};
+	int gui_buffer_allocation_strategy{vkb::BufferAllocationStrategy::MultipleAllocationsPerBuffer};
 
-	const uint32_t MIN_THREAD_COUNT{4};
+	bool gui_multi_threading{false};
 
 	uint32_t max_thread_count{0};
 };
@@ -442,7 +442,7 @@ void ConstantData::BufferArraySubpass::draw(vkb::CommandBuffer &command_buffer)
 	// Reset the instance index back to 0 for each draw call
 	instance_index = 0;
 
-	allocate_lights<vkb::ForwardLights>(scene.get_components<vkb::sg::Light>(), MAX_FORWARD_LIGHT_COUNT);
+	allocate_lights<vkb::ForwardLights>(scene.get_component_view<vkb::sg::Light>(), MAX_FORWARD_LIGHT_COUNT);
 	command_buffer.bind_lighting(get_lighting_state(), 0, 4);
 
 	GeometrySubpass::draw(command_buffer);
@@ -475,7 +475,7 @@ void ConstantData::BufferArraySubpass::prepare_push_constants(vkb::CommandBuffer
 	return;
 }
 
-void ConstantData::BufferArraySubpass::draw_submesh_command(vkb::CommandBuffer &command_buffer, vkb::sg::SubMesh &sub_mesh)
+void ConstantData::BufferArraySubpass::draw_submesh_command(vkb::CommandBuffer &command_buffer, vkb::sg::SubMesh &sub_mesh, uint32_t instance_count, uint32_t lod)
 {
 	/**
 	 * POI
@@ -492,10 +492,13 @@ void ConstantData::BufferArraySubpass::draw_submesh_command(vkb::CommandBuffer &
 		// Bind index buffer of submesh
 		command_buffer.bind_index_buffer(*sub_mesh.index_buffer, sub_mesh.index_offset, sub_mesh.index_type);
 
-		command_buffer.draw_indexed(sub_mesh.vertex_indices, 1, 0, 0, instance_index++);
+		auto sub_mesh_lod = sub_mesh.get_lod(lod);
+		command_buffer.draw_indexed(sub_mesh_lod.index_count, instance_count, sub_mesh_lod.first_index, 0, instance_index);
 	}
 	else
 	{
-		command_buffer.draw(sub_mesh.vertices_count, 1, 0, instance_index++);
+		command_buffer.draw(sub_mesh.vertices_count, instance_count, 0, instance_index);
 	}
+
+	instance_index += instance_count;
 }
@@ -210,7 +210,7 @@ class ConstantData : public vkb::VulkanSample
 		/**
 		 * @brief Overridden to send an index
 		 */
-		virtual void draw_submesh_command(vkb::CommandBuffer &command_buffer, vkb::sg::SubMesh &sub_mesh) override;
+		virtual void draw_submesh_command(vkb::CommandBuffer &command_buffer, vkb::sg::SubMesh &sub_mesh, uint32_t instance_count, uint32_t lod) override;
 
 		uint32_t instance_index{0};
 	};
@@ -0,0 +1,514 @@
+/* Copyright (c) 2023, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "deferred_render_graph.h"
+
+#include "common/utils.h"
+#include "core/device.h"
+#include "gui.h"
+#include "platform/platform.h"
+#include "rendering/postprocessing_pixelpass.h"
+#include "rendering/postprocessing_renderpass.h"
+#include "rendering/subpasses/geometry_subpass.h"
+#include "rendering/subpasses/lighting_subpass.h"
+#include "rendering/subpasses/visibility_resolve_subpass.h"
+#include "rendering/subpasses/visibility_subpass.h"
+#include "stats/stats.h"
+#include "timer.h"
+
+namespace
+{
+struct TonemapUniform
+{
+	float exposure;
+};
+
+struct ColorGradingUniform
+{
+	float contrast;
+	float saturation;
+	float vignette;
+};
+
+// Resolutions of the G-buffer and visibility buffer comparisons, in percent of the surface extent
+const int render_scales[] = {50, 100, 200};
+}        // namespace
+
+DeferredRenderGraph::DeferredRenderGraph()
+{
+	// The visibility buffer resolve indexes the base color textures by material
+	add_instance_extension(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME, true);
+	add_device_extension(VK_KHR_MAINTENANCE3_EXTENSION_NAME, true);
+	add_device_extension(VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME, true);
+
+	auto &config = get_configuration();
+
+	// Images allocated separately and one pipeline barrier per image, as the other samples record them by hand
+	config.insert<vkb::BoolSetting>(0, aliasing, false);
+	config.insert<vkb::BoolSetting>(0, barrier_merging, false);
+	config.insert<vkb::BoolSetting>(0, bloom, true);
+	config.insert<vkb::BoolSetting>(0, fused_postprocessing, false);
+	config.insert<vkb::BoolSetting>(0, visibility_buffer, false);
+	config.insert<vkb::IntSetting>(0, render_scale, 100);
+
+	config.insert<vkb::BoolSetting>(1, aliasing, true);
+	config.insert<vkb::BoolSetting>(1, barrier_merging, true);
+	config.insert<vkb::BoolSetting>(1, bloom, true);
+	config.insert<vkb::BoolSetting>(1, fused_postprocessing, false);
+	config.insert<vkb::BoolSetting>(1, visibility_buffer, false);
+	config.insert<vkb::IntSetting>(1, render_scale, 100);
+
+	config.insert<vkb::BoolSetting>(2, aliasing, true);
+	config.insert<vkb::BoolSetting>(2, barrier_merging, true);
+	config.insert<vkb::BoolSetting>(2, bloom, true);
+	config.insert<vkb::BoolSetting>(2, fused_postprocessing, true);
+	config.insert<vkb::BoolSetting>(2, visibility_buffer, false);
+	config.insert<vkb::IntSetting>(2, render_scale, 100);
+
+	config.insert<vkb::BoolSetting>(3, aliasing, true);
+	config.insert<vkb::BoolSetting>(3, barrier_merging, true);
+	config.insert<vkb::BoolSetting>(3, bloom, false);
+	config.insert<vkb::BoolSetting>(3, fused_postprocessing, true);
+	config.insert<vkb::BoolSetting>(3, visibility_buffer, false);
+	config.insert<vkb::IntSetting>(3, render_scale, 100);
+
+	// G-buffer and visibility buffer at each resolution, with the postprocessing of configuration 2
+	uint32_t config_index = 4;
+	for (int scale : render_scales)
+	{
+		for (bool visibility : {false, true})
+		{
+			config.insert<vkb::BoolSetting>(config_index, aliasing, true);
+			config.insert<vkb::BoolSetting>(config_index, barrier_merging, true);
+			config.insert<vkb::BoolSetting>(config_index, bloom, true);
+			config.insert<vkb::BoolSetting>(config_index, fused_postprocessing, true);
+			config.insert<vkb::BoolSetting>(config_index, visibility_buffer, visibility);
+			config.insert<vkb::IntSetting>(config_index, render_scale, scale);
+
+			config_index++;
+		}
+	}
+}
+
+bool DeferredRenderGraph::prepare(vkb::Platform &platform)
+{
+	if (!VulkanSample::prepare(platform))
+	{
+		return false;
+	}
+
+	load_scene("scenes/sponza/Sponza01.gltf");
+
+	scene->clear_components<vkb::sg::Light>();
+
+	auto light_pos   = glm::vec3(0.0f, 128.0f, -225.0f);
+	auto light_color = glm::vec3(1.0, 1.0, 1.0);
+
+	// Magic numbers used to offset lights in the Sponza scene
+	for (int i = -2; i < 2; ++i)
+	{
+		for (int j = 0; j < 2; ++j)
+		{
+			glm::vec3 pos = light_pos;
+			pos.x += i * 400;
+			pos.z += j * (225 + 140);
+			pos.y = 8;
+
+			for (int k = 0; k < 3; ++k)
+			{
+				pos.y = pos.y + (k * 100);
+
+				light_color.x = static_cast<float>(rand()) / (RAND_MAX);
+				light_color.y = static_cast<float>(rand()) / (RAND_MAX);
+				light_color.z = static_cast<float>(rand()) / (RAND_MAX);
+
+				vkb::sg::LightProperties props;
+				props.color     = light_color;
+				props.intensity = 0.2f;
+
+				vkb::add_point_light(*scene, pos, props);
+			}
+		}
+	}
+
+	auto &camera_node = vkb::add_free_camera(*scene, "main_camera", get_render_context().get_surface_extent());
+	camera            = &camera_node.get_component<vkb::sg::Camera>();
+
+	auto geometry_vs = vkb::ShaderSource{"deferred/geometry.vert"};
+	auto geometry_fs = vkb::ShaderSource{"deferred/geometry.frag"};
+
+	auto gbuffer_subpass = std::make_unique<vkb::GeometrySubpass>(get_render_context(), std::move(geometry_vs), std::move(geometry_fs), *scene, *camera);
+	geometry_subpass     = gbuffer_subpass.get();
+	gbuffer_pipeline.add_subpass(std::move(gbuffer_subpass));
+
+	auto lighting_vs = vkb::ShaderSource{"deferred/lighting.vert"};
+	auto lighting_fs = vkb::ShaderSource{"deferred/lighting.frag"};
+
+	auto deferred_lighting_subpass = std::make_unique<vkb::LightingSubpass>(get_render_context(), std::move(lighting_vs), std::move(lighting_fs), *camera, *scene);
+	lighting_subpass               = deferred_lighting_subpass.get();
+	lighting_pipeline.add_subpass(std::move(deferred_lighting_subpass));
+
+	if (supports_visibility_buffer)
+	{
+		auto visibility_vs = vkb::ShaderSource{"deferred/visibility.vert"};
+		auto visibility_fs = vkb::ShaderSource{"deferred/visibility.frag"};
+
+		auto scene_visibility_subpass = std::make_unique<vkb::VisibilitySubpass>(get_render_context(), std::move(visibility_vs), std::move(visibility_fs), *scene, *camera);
+		visibility_subpass            = scene_visibility_subpass.get();
+		visibility_pipeline.add_subpass(std::move(scene_visibility_subpass));
+
+		// Prepared once added, after the visibility subpass packed the geometry and materials
+		auto resolve_vs = vkb::ShaderSource{"deferred/lighting.vert"};
+		auto resolve_fs = vkb::ShaderSource{"deferred/visibility_resolve.frag"};
+
+		auto visibility_resolve_subpass = std::make_unique<vkb::VisibilityResolveSubpass>(get_render_context(), std::move(resolve_vs), std::move(resolve_fs), *camera, *scene, *visibility_subpass);
+		visibility_resolve_subpass->set_texture_indexing(supports_texture_indexing);
+		resolve_subpass = visibility_resolve_subpass.get();
+		resolve_pipeline.add_subpass(std::move(visibility_resolve_subpass));
+
+		if (!resolve_subpass->is_texture_indexing_enabled())
+		{
+			LOGW("Descriptor indexing not supported, the visibility buffer resolve uses the base color factors only");
+		}
+	}
+	else
+	{
+		LOGW("Geometry shaders not supported, the visibility buffer is disabled");
+	}
+
+	// Each postprocessing step is a pass of the graph, which transitions its images
+	bloom_pipeline = std::make_unique<vkb::PostProcessingPipeline>(get_render_context(), vkb::ShaderSource{"postprocessing/postprocessing.vert"});
+	bloom_pipeline->add_pass()
+	    .add_subpass(vkb::ShaderSource{"render_graph/bloom.frag"})
+	    .set_debug_name("Bloom");
+
+	composite_pipeline = std::make_unique<vkb::PostProcessingPipeline>(get_render_context(), vkb::ShaderSource{"postprocessing/postprocessing.vert"});
+	composite_pipeline->add_pass()
+	    .add_subpass(vkb::ShaderSource{"render_graph/composite.frag"})
+	    .set_debug_name("Composite");
+
+	build_render_graph();
+
+	stats->request_stats({vkb::StatIndex::frame_times});
+
+	gui = std::make_unique<vkb::Gui>(*this, platform.get_window(), stats.get());
+
+	return true;
+}
+
+void DeferredRenderGraph::prepare_render_context()
+{
+	// The render graph creates the other images, the render frames only hold the swapchain images
+	get_render_context().prepare(1, [](vkb::core::Image &&swapchain_image) {
+		std::vector<vkb::core::Image> images;
+		images.push_back(std::move(swapchain_image));
+
+		return std::make_unique<vkb::RenderTarget>(std::move(images));
+	});
+}
+
+void DeferredRenderGraph::request_gpu_features(vkb::PhysicalDevice &gpu)
+{
+	// The visibility buffer stores the gl_PrimitiveID of the fragments
+	if (gpu.get_features().geometryShader)
+	{
+		gpu.get_mutable_requested_features().geometryShader = VK_TRUE;
+		supports_visibility_buffer                          = true;
+	}
+
+	// Extension features can only be queried through the physical device properties 2 extension
+	if (instance->is_enabled(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME))
+	{
+		auto &descriptor_indexing_features = gpu.request_extension_features<VkPhysicalDeviceDescriptorIndexingFeaturesEXT>(VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT);
+
+		supports_texture_indexing = descriptor_indexing_features.shaderSampledImageArrayNonUniformIndexing;
+	}
+}
+
+void DeferredRenderGraph::build_postprocessing_pipeline()
+{
+	postprocessing_pipeline = std::make_unique<vkb::PostProcessingPipeline>(get_render_context(), vkb::ShaderSource{"postprocessing/postprocessing.vert"});
+	postprocessing_pipeline->set_pixel_pass_fusion(fused_postprocessing);
+
+	if (bloom)
+	{
+		postprocessing_pipeline->add_pass<vkb::PostProcessingPixelPass>(vkb::ShaderSource{"render_graph/bloom_composite.h"})
+		    .set_debug_name("Bloom composite");
+	}
+
+	postprocessing_pipeline->add_pass<vkb::PostProcessingPixelPass>(vkb::ShaderSource{"render_graph/tonemap.h"})
+	    .set_uniform_data(TonemapUniform{1.0f})
+	    .set_debug_name("Tone mapping");
+
+	postprocessing_pipeline->add_pass<vkb::PostProcessingPixelPass>(vkb::ShaderSource{"render_graph/color_grading.h"})
+	    .set_uniform_data(ColorGradingUniform{1.1f, 1.2f, 0.8f})
+	    .set_debug_name("Color grading");
+}
+
+void DeferredRenderGraph::build_render_graph()
+{
+	build_postprocessing_pipeline();
+
+	render_graph = std::make_unique<vkb::RenderGraph>(get_render_context());
+	render_graph->set_aliasing(aliasing);
+	render_graph->set_barrier_merging(barrier_merging);
+
+	// The images up to the composite pass are scaled, which upscales the graded image to the backbuffer
+	float scale = render_scale / 100.0f;
+
+	render_graph->set_backbuffer("backbuffer");
+	render_graph->add_image("depth", vkb::get_suitable_depth_format(get_device().get_gpu().get_handle()), scale);
+	render_graph->add_image("hdr", VK_FORMAT_R16G16B16A16_SFLOAT, scale);
+	render_graph->add_image("bloom", VK_FORMAT_R16G16B16A16_SFLOAT, 0.5f * scale);
+	render_graph->add_image("graded", VK_FORMAT_R8G8B8A8_UNORM, scale);
+
+	// The visibility buffer replaces the albedo and normal with the draw and triangle indices
+	if (visibility_buffer)
+	{
+		render_graph->add_image("visibility", VK_FORMAT_R32G32_UINT, scale);
+	}
+	else
+	{
+		render_graph->add_image("albedo", VK_FORMAT_R8G8B8A8_UNORM, scale);
+		render_graph->add_image("normal", VK_FORMAT_A2B10G10R10_UNORM_PACK32, scale);
+	}
+
+	// The fused pixel passes keep the intermediate colors in registers
+	if (!fused_postprocessing)
+	{
+		if (bloom)
+		{
+			render_graph->add_image("composited", VK_FORMAT_R16G16B16A16_SFLOAT, scale);
+		}
+		render_graph->add_image("tonemapped", VK_FORMAT_R8G8B8A8_UNORM, scale);
+	}
+
+	// The subpasses refer to the attachments by their index in the render target of their pass
+	if (visibility_buffer)
+	{
+		auto &visibility_pass = render_graph->add_pass("Visibility", visibility_pipeline);
+		visibility_pass.write_depth("depth");
+		visibility_subpass->set_output_attachments({visibility_pass.write_color("visibility")});
+
+		// The depth is not read after the visibility pass, only the visibility buffer is stored
+		auto &resolve_pass = render_graph->add_pass("Resolve", resolve_pipeline);
+		resolve_subpass->set_input_attachments({resolve_pass.read_input("visibility")});
+		resolve_subpass->set_output_attachments({resolve_pass.write_color("hdr")});
+	}
+	else
+	{
+		auto &gbuffer_pass = render_graph->add_pass("G-buffer", gbuffer_pipeline);
+		gbuffer_pass.write_depth("depth");
+		geometry_subpass->set_output_attachments({gbuffer_pass.write_color("albedo"), gbuffer_pass.write_color("normal")});
+
+		auto &lighting_pass = render_graph->add_pass("Lighting", lighting_pipeline);
+		lighting_subpass->set_input_attachments({lighting_pass.read_input("depth"), lighting_pass.read_input("albedo"), lighting_pass.read_input("normal")});
+		lighting_subpass->set_output_attachments({lighting_pass.write_color("hdr")});
+	}
+
+	// Culled if the postprocessing pass does not read the bloom
+	auto &bloom_pass = render_graph->add_pass("Bloom");
+	bloom_pass.read_sampled("hdr");
+	bloom_pass.write_color("bloom");
+	bloom_pass.set_execute([this](vkb::CommandBuffer &command_buffer, vkb::RenderTarget *render_target) {
+		bloom_pipeline->get_pass(0).get_subpass(0).bind_sampled_image("hdr_sampler", {render_graph->get_view("hdr")});
+		bloom_pipeline->draw(command_buffer, *render_target);
+	});
+
+	auto &postprocessing_pass = render_graph->add_compute_pass("Postprocessing");
+	postprocessing_pass.read_storage("hdr");
+	postprocessing_pass.write_storage("graded");
+
+	if (bloom)
+	{
+		postprocessing_pass.read_sampled("bloom");
+	}
+
+	if (!fused_postprocessing)
+	{
+		if (bloom)
+		{
+			postprocessing_pass.write_storage("composited");
+		}
+		postprocessing_pass.write_storage("tonemapped");
+	}
+
+	postprocessing_pass.set_execute([this](vkb::CommandBuffer &command_buffer, vkb::RenderTarget *) {
+		// Unfused passes without an input read the output of the previous pass
+		size_t pass_index = 0;
+
+		if (bloom)
+		{
+			auto &bloom_composite_pass = postprocessing_pipeline->get_pass<vkb::PostProcessingPixelPass>(pass_index++);
+			bloom_composite_pass.bind_input({render_graph->get_view("hdr")});
+			bloom_composite_pass.bind_sampled_image("bloom_sampler", {render_graph->get_view("bloom")});
+
+			if (!fused_postprocessing)
+			{
+				bloom_composite_pass.bind_output({render_graph->get_view("composited")});
+			}
+		}
+
+		auto &tonemap_pass = postprocessing_pipeline->get_pass<vkb::PostProcessingPixelPass>(pass_index++);
+		if (!bloom)
+		{
+			tonemap_pass.bind_input({render_graph->get_view("hdr")});
+		}
+
+		if (!fused_postprocessing)
+		{
+			tonemap_pass.bind_output({render_graph->get_view("tonemapped")});
+		}
+
+		auto &color_grading_pass = postprocessing_pipeline->get_pass<vkb::PostProcessingPixelPass>(pass_index++);
+		color_grading_pass.bind_output({render_graph->get_view("graded")});
+
+		// Compute passes have no render target, the pixel passes only access the graph images
+		postprocessing_pipeline->draw(command_buffer, get_render_context().get_active_frame().get_render_target());
+	});
+
+	auto &composite_pass = render_graph->add_pass("Composite");
+	composite_pass.read_sampled("graded");
+	composite_pass.write_color("backbuffer");
+	composite_pass.set_execute([this](vkb::CommandBuffer &command_buffer, vkb::RenderTarget *render_target) {
+		composite_pipeline->get_pass(0).get_subpass(0).bind_sampled_image("graded_sampler", {render_graph->get_view("graded")});
+		composite_pipeline->draw(command_buffer, *render_target);
+	});
+}
+
+void DeferredRenderGraph::draw(vkb::CommandBuffer &command_buffer, vkb::RenderTarget &render_target)
+{
+	// The graph transitions the swapchain image of the frame, and presents it after the composite pass
+	render_graph->execute(command_buffer, [this](vkb::CommandBuffer &command_buffer) {
+		if (gui)
+		{
+			gui->draw(command_buffer);
+		}
+	});
+}
+
+void DeferredRenderGraph::log_frame_time()
+{
+	if (elapsed_frames == 0)
+	{
+		return;
+	}
+
+	auto &graph_stats      = render_graph->get_stats();
+	auto &pixel_pass_stats = postprocessing_pipeline->get_pixel_pass_stats();
+
+	LOGI("{} at {}% of the surface resolution", last_visibility_buffer ? "Visibility buffer" : "G-buffer", last_render_scale);
+
+	LOGI("Render graph {} aliasing and {} barrier merging, bloom {}, {} postprocessing: {:.3f} ms average frame time over {} frames",
+	     last_aliasing ? "with" : "without", last_barrier_merging ? "with" : "without", last_bloom ? "on" : "off", last_fused_postprocessing ? "fused" : "unfused",
+	     elapsed_time / elapsed_frames, elapsed_frames);
+
+	LOGI("{} postprocessing pixel passes in {} dispatches, accessing {:.1f} MB of images per frame",
+	     pixel_pass_stats.pass_count, pixel_pass_stats.dispatch_count, pixel_pass_stats.image_bytes / (1024.0 * 1024.0));
+
+	LOGI("{} passes, {} culled, {} image barriers in {} pipeline barriers, {:.1f} MB of transient images in {:.1f} MB of memory and {:.1f} MB of lazily allocated memory per frame",
+	     graph_stats.pass_count, graph_stats.culled_pass_count, graph_stats.image_barrier_count, graph_stats.pipeline_barrier_count,
+	     graph_stats.image_memory / (1024.0 * 1024.0), graph_stats.allocated_memory / (1024.0 * 1024.0), graph_stats.lazy_memory / (1024.0 * 1024.0));
+
+	elapsed_time   = 0.0;
+	elapsed_frames = 0;
+}
+
+void DeferredRenderGraph::update(float delta_time)
+{
+	if (!supports_visibility_buffer)
+	{
+		visibility_buffer = false;
+	}
+
+	if (aliasing != last_aliasing || barrier_merging != last_barrier_merging || bloom != last_bloom || fused_postprocessing != last_fused_postprocessing ||
+	    visibility_buffer != last_visibility_buffer || render_scale != last_render_scale)
+	{
+		log_frame_time();
+
+		if (bloom != last_bloom || fused_postprocessing != last_fused_postprocessing || visibility_buffer != last_visibility_buffer || render_scale != last_render_scale)
+		{
+			build_render_graph();
+		}
+
+		// The graph is compiled again before its next execution
+		render_graph->set_aliasing(aliasing);
+		render_graph->set_barrier_merging(barrier_merging);
+
+		last_aliasing        = aliasing;
+		last_barrier_merging = barrier_merging;
+		last_bloom           = bloom;
+
+		last_fused_postprocessing = fused_postprocessing;
+		last_visibility_buffer    = visibility_buffer;
+		last_render_scale         = render_scale;
+	}
+
+	vkb::Timer timer;
+	timer.start();
+
+	VulkanSample::update(delta_time);
+
+	elapsed_time += timer.stop<vkb::Timer::Milliseconds>();
+	elapsed_frames++;
+}
+
+void DeferredRenderGraph::draw_gui()
+{
+	auto &graph_stats      = render_graph->get_stats();
+	auto &pixel_pass_stats = postprocessing_pipeline->get_pixel_pass_stats();
+
+	gui->show_options_window(
+	    /* body = */ [this, &graph_stats, &pixel_pass_stats]() {
+		    ImGui::Checkbox("Alias transient memory", &aliasing);
+		    ImGui::SameLine();
+		    ImGui::Checkbox("Merge barriers", &barrier_merging);
+		    ImGui::SameLine();
+		    ImGui::Checkbox("Bloom", &bloom);
+		    ImGui::SameLine();
+		    ImGui::Checkbox("Fuse postprocessing", &fused_postprocessing);
+
+		    if (supports_visibility_buffer)
+		    {
+			    ImGui::Checkbox("Visibility buffer", &visibility_buffer);
+		    }
+		    else
+		    {
+			    ImGui::Text("Visibility buffer not supported");
+		    }
+		    ImGui::SameLine();
+		    ImGui::Text("Resolution:");
+		    for (int scale : render_scales)
+		    {
+			    ImGui::SameLine();
+			    ImGui::RadioButton((std::to_string(scale) + "%").c_str(), &render_scale, scale);
+		    }
+
+		    ImGui::Text("Passes: %u, culled: %u, image barriers: %u in %u pipeline barriers", graph_stats.pass_count, graph_stats.culled_pass_count,
+		                graph_stats.image_barrier_count, graph_stats.pipeline_barrier_count);
+		    ImGui::Text("Transient images: %.1f MB, allocated: %.1f MB, lazily allocated: %.1f MB per frame", graph_stats.image_memory / (1024.0 * 1024.0),
+		                graph_stats.allocated_memory / (1024.0 * 1024.0), graph_stats.lazy_memory / (1024.0 * 1024.0));
+		    ImGui::Text("Postprocessing: %u pixel passes in %u dispatches, %.1f MB of images per frame", pixel_pass_stats.pass_count,
+		                pixel_pass_stats.dispatch_count, pixel_pass_stats.image_bytes / (1024.0 * 1024.0));
+	    },
+	    /* lines = */ 5);
+}
+
+std::unique_ptr<vkb::VulkanSample> create_deferred_render_graph()
+{
+	return std::make_unique<DeferredRenderGraph>();
+}
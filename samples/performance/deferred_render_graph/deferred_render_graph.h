@@ -0,0 +1,138 @@
+/* Copyright (c) 2023, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "rendering/postprocessing_pipeline.h"
+#include "rendering/render_graph.h"
+#include "rendering/render_pipeline.h"
+#include "scene_graph/components/camera.h"
+#include "vulkan_sample.h"
+
+namespace vkb
+{
+class GeometrySubpass;
+class LightingSubpass;
+class VisibilitySubpass;
+class VisibilityResolveSubpass;
+}        // namespace vkb
+
+/**
+ * @brief Deferred rendering followed by postprocessing, with the barriers, layouts, load/store
+ *        operations and transient memory derived by a render graph
+ */
+class DeferredRenderGraph : public vkb::VulkanSample
+{
+  public:
+	DeferredRenderGraph();
+
+	virtual ~DeferredRenderGraph() = default;
+
+	virtual bool prepare(vkb::Platform &platform) override;
+
+	virtual void update(float delta_time) override;
+
+	virtual void prepare_render_context() override;
+
+	virtual void request_gpu_features(vkb::PhysicalDevice &gpu) override;
+
+  private:
+	virtual void draw(vkb::CommandBuffer &command_buffer, vkb::RenderTarget &render_target) override;
+
+	virtual void draw_gui() override;
+
+	/**
+	 * @brief Declares the images and the passes of the frame
+	 */
+	void build_render_graph();
+
+	/**
+	 * @brief Creates the pixel passes compositing the bloom, tone mapping and grading the lit image
+	 */
+	void build_postprocessing_pipeline();
+
+	void log_frame_time();
+
+	vkb::sg::Camera *camera{nullptr};
+
+	vkb::RenderPipeline gbuffer_pipeline;
+
+	vkb::RenderPipeline lighting_pipeline;
+
+	vkb::GeometrySubpass *geometry_subpass{nullptr};
+
+	vkb::LightingSubpass *lighting_subpass{nullptr};
+
+	vkb::RenderPipeline visibility_pipeline;
+
+	vkb::RenderPipeline resolve_pipeline;
+
+	vkb::VisibilitySubpass *visibility_subpass{nullptr};
+
+	vkb::VisibilityResolveSubpass *resolve_subpass{nullptr};
+
+	std::unique_ptr<vkb::PostProcessingPipeline> bloom_pipeline;
+
+	std::unique_ptr<vkb::PostProcessingPipeline> postprocessing_pipeline;
+
+	std::unique_ptr<vkb::PostProcessingPipeline> composite_pipeline;
+
+	std::unique_ptr<vkb::RenderGraph> render_graph;
+
+	// Whether the transient images share memory when their lifetimes do not overlap
+	bool aliasing{true};
+
+	bool last_aliasing{true};
+
+	// Whether the image barriers of a pass are recorded as a single pipeline barrier
+	bool barrier_merging{true};
+
+	bool last_barrier_merging{true};
+
+	// Whether the postprocessing adds the bloom, otherwise the bloom pass is culled
+	bool bloom{true};
+
+	bool last_bloom{true};
+
+	// Whether the postprocessing pixel passes run as a single dispatch, without intermediate images
+	bool fused_postprocessing{true};
+
+	bool last_fused_postprocessing{true};
+
+	// Whether the scene is drawn into a visibility buffer and resolved, rather than into a G-buffer and lit
+	bool visibility_buffer{false};
+
+	bool last_visibility_buffer{false};
+
+	// Resolution of the scene and postprocessing images, in percent of the surface extent
+	int render_scale{100};
+
+	int last_render_scale{100};
+
+	// The visibility buffer requires gl_PrimitiveID in fragment shaders
+	bool supports_visibility_buffer{false};
+
+	// Otherwise the resolve only uses the base color factors of the materials
+	bool supports_texture_indexing{false};
+
+	// Accumulated frame time of the current configuration, in milliseconds
+	double elapsed_time{0.0};
+
+	uint32_t elapsed_frames{0};
+};
+
+std::unique_ptr<vkb::VulkanSample> create_deferred_render_graph();
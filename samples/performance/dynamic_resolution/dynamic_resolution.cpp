@@ -0,0 +1,415 @@
+/* Copyright (c) 2023, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "dynamic_resolution.h"
+
+#include "common/utils.h"
+#include "common/vk_common.h"
+#include "core/device.h"
+#include "gui.h"
+#include "platform/platform.h"
+#include "rendering/postprocessing_renderpass.h"
+#include "rendering/subpasses/forward_subpass.h"
+#include "stats/stats.h"
+#include "timer.h"
+
+namespace
+{
+struct TemporalUpscaleUniform
+{
+	glm::mat4 reprojection;
+	glm::vec4 jitter_scale;
+	glm::vec4 render_extent;
+};
+
+// GPU frame time budgets of the configurations, in tenths of milliseconds
+const int target_frame_times[] = {83, 166, 333};
+
+// Number of jitter positions before the sequence repeats
+constexpr uint32_t JITTER_PHASE_COUNT = 8;
+
+// Weight of the current frame in the upscaled image, the rest comes from the history
+constexpr float CURRENT_FRAME_WEIGHT = 0.1f;
+
+/**
+ * @return The element of a Halton low-discrepancy sequence, in [0, 1)
+ */
+float halton(uint32_t index, uint32_t base)
+{
+	float result   = 0.0f;
+	float fraction = 1.0f;
+
+	while (index > 0)
+	{
+		fraction /= static_cast<float>(base);
+		result += fraction * static_cast<float>(index % base);
+		index /= base;
+	}
+
+	return result;
+}
+}        // namespace
+
+DynamicResolutionSample::DynamicResolutionSample()
+{
+	auto &config = get_configuration();
+
+	// Output resolution, then each frame time budget
+	config.insert<vkb::BoolSetting>(0, dynamic, false);
+	config.insert<vkb::IntSetting>(0, target_frame_time, 166);
+
+	uint32_t config_index = 1;
+	for (int target : target_frame_times)
+	{
+		config.insert<vkb::BoolSetting>(config_index, dynamic, true);
+		config.insert<vkb::IntSetting>(config_index, target_frame_time, target);
+
+		config_index++;
+	}
+}
+
+bool DynamicResolutionSample::prepare(vkb::Platform &platform)
+{
+	if (!VulkanSample::prepare(platform))
+	{
+		return false;
+	}
+
+	load_scene("scenes/sponza/Sponza01.gltf");
+
+	auto &camera_node = vkb::add_free_camera(*scene, "main_camera", get_render_context().get_surface_extent());
+	camera            = dynamic_cast<vkb::sg::PerspectiveCamera *>(&camera_node.get_component<vkb::sg::Camera>());
+
+	vkb::ShaderSource scene_vs("base.vert");
+	vkb::ShaderSource scene_fs("base.frag");
+	auto              scene_subpass = std::make_unique<vkb::ForwardSubpass>(get_render_context(), std::move(scene_vs), std::move(scene_fs), *scene, *camera);
+	scene_pipeline                  = std::make_unique<vkb::RenderPipeline>();
+	scene_pipeline->add_subpass(std::move(scene_subpass));
+
+	// The color and depth are both read by the temporal upscale
+	std::vector<vkb::LoadStoreInfo> scene_load_store(2);
+	scene_load_store[0] = {VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_STORE};
+	scene_load_store[1] = {VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_STORE};
+	scene_pipeline->set_load_store(scene_load_store);
+
+	upscale_pipeline = std::make_unique<vkb::PostProcessingPipeline>(get_render_context(), vkb::ShaderSource{"postprocessing/postprocessing.vert"});
+	upscale_pipeline->add_pass()
+	    .add_subpass(vkb::ShaderSource{"postprocessing/temporal_upscale.frag"})
+	    .set_debug_name("Temporal upscale");
+	upscale_pipeline->add_pass()
+	    .add_subpass(vkb::ShaderSource{"postprocessing/blit.frag"})
+	    .set_debug_name("Present");
+
+	dynamic_resolution = std::make_unique<vkb::DynamicResolution>(get_render_context(), target_frame_time / 10.0f);
+	dynamic_resolution->set_enabled(dynamic);
+
+	stats->request_stats({vkb::StatIndex::frame_times});
+
+	gui = std::make_unique<vkb::Gui>(*this, platform.get_window(), stats.get());
+
+	return true;
+}
+
+void DynamicResolutionSample::prepare_render_context()
+{
+	// The scene and history images are created by the sample, the render frames only hold the swapchain images
+	get_render_context().prepare(1, [](vkb::core::Image &&swapchain_image) {
+		std::vector<vkb::core::Image> images;
+		images.push_back(std::move(swapchain_image));
+
+		return std::make_unique<vkb::RenderTarget>(std::move(images));
+	});
+}
+
+void DynamicResolutionSample::create_render_targets(const VkExtent2D &extent)
+{
+	// The previous images may still be in use, and their framebuffers are cached
+	get_device().wait_idle();
+	get_device().get_resource_cache().clear_framebuffers();
+
+	VkExtent3D image_extent{extent.width, extent.height, 1};
+	VkFormat   color_format = get_render_context().get_format();
+	VkFormat   depth_format = vkb::get_suitable_depth_format(get_device().get_gpu().get_handle());
+
+	// Allocated at the output extent, so that the render extent can change without creating images
+	std::vector<vkb::core::Image> scene_images;
+	scene_images.emplace_back(get_device(), image_extent, color_format,
+	                          VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VMA_MEMORY_USAGE_GPU_ONLY);
+	scene_images.emplace_back(get_device(), image_extent, depth_format,
+	                          VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VMA_MEMORY_USAGE_GPU_ONLY);
+	scene_target = std::make_unique<vkb::RenderTarget>(std::move(scene_images));
+
+	for (auto &history_target : history_targets)
+	{
+		std::vector<vkb::core::Image> history_images;
+		history_images.emplace_back(get_device(), image_extent, color_format,
+		                            VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VMA_MEMORY_USAGE_GPU_ONLY);
+		history_target = std::make_unique<vkb::RenderTarget>(std::move(history_images));
+	}
+
+	history_valid = false;
+}
+
+void DynamicResolutionSample::draw(vkb::CommandBuffer &command_buffer, vkb::RenderTarget &render_target)
+{
+	auto &output_extent = render_target.get_extent();
+
+	if (!scene_target || scene_target->get_image_extent().width != output_extent.width || scene_target->get_image_extent().height != output_extent.height)
+	{
+		create_render_targets(output_extent);
+	}
+
+	// Updates the scale with the GPU time of the last frame rendered by the active render frame
+	dynamic_resolution->begin(command_buffer);
+
+	VkExtent2D render_extent = dynamic_resolution->get_render_extent(output_extent);
+
+	{
+		vkb::ImageMemoryBarrier memory_barrier{};
+		memory_barrier.old_layout      = VK_IMAGE_LAYOUT_UNDEFINED;
+		memory_barrier.new_layout      = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+		memory_barrier.src_access_mask = 0;
+		memory_barrier.dst_access_mask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+		memory_barrier.src_stage_mask  = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+		memory_barrier.dst_stage_mask  = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+
+		command_buffer.image_memory_barrier(render_target.get_views()[0], memory_barrier);
+		render_target.set_layout(0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+	}
+
+	draw_scene(command_buffer, render_extent);
+
+	draw_upscale(command_buffer, render_target, render_extent);
+
+	dynamic_resolution->end(command_buffer);
+
+	{
+		// Prepare swapchain for presentation
+		vkb::ImageMemoryBarrier memory_barrier{};
+		memory_barrier.old_layout      = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+		memory_barrier.new_layout      = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+		memory_barrier.src_access_mask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+		memory_barrier.src_stage_mask  = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+		memory_barrier.dst_stage_mask  = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+
+		command_buffer.image_memory_barrier(render_target.get_views()[0], memory_barrier);
+	}
+
+	frame_index++;
+}
+
+void DynamicResolutionSample::draw_scene(vkb::CommandBuffer &command_buffer, const VkExtent2D &render_extent)
+{
+	auto &views = scene_target->get_views();
+
+	// The previous contents are not needed, the barriers wait for the previous frame to stop sampling them
+	{
+		vkb::ImageMemoryBarrier memory_barrier{};
+		memory_barrier.old_layout      = VK_IMAGE_LAYOUT_UNDEFINED;
+		memory_barrier.new_layout      = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+		memory_barrier.src_access_mask = 0;
+		memory_barrier.dst_access_mask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+		memory_barrier.src_stage_mask  = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+		memory_barrier.dst_stage_mask  = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+
+		command_buffer.image_memory_barrier(views[0], memory_barrier);
+		scene_target->set_layout(0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+	}
+
+	{
+		vkb::ImageMemoryBarrier memory_barrier{};
+		memory_barrier.old_layout      = VK_IMAGE_LAYOUT_UNDEFINED;
+		memory_barrier.new_layout      = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+		memory_barrier.src_access_mask = 0;
+		memory_barrier.dst_access_mask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+		memory_barrier.src_stage_mask  = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+		memory_barrier.dst_stage_mask  = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+
+		command_buffer.image_memory_barrier(views[1], memory_barrier);
+		scene_target->set_layout(1, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL);
+	}
+
+	// The render pass and framebuffer only cover the render extent
+	scene_target->set_extent(render_extent);
+
+	// Sub-pixel offset of the render pixels, which the temporal upscale accumulates into the output pixels
+	uint32_t  jitter_phase = frame_index % JITTER_PHASE_COUNT + 1;
+	glm::vec2 jitter{halton(jitter_phase, 2) - 0.5f, halton(jitter_phase, 3) - 0.5f};
+	camera->set_jitter(2.0f * jitter / glm::vec2(render_extent.width, render_extent.height));
+
+	VkViewport viewport{};
+	viewport.width    = static_cast<float>(render_extent.width);
+	viewport.height   = static_cast<float>(render_extent.height);
+	viewport.minDepth = 0.0f;
+	viewport.maxDepth = 1.0f;
+	command_buffer.set_viewport(0, {viewport});
+
+	VkRect2D scissor{};
+	scissor.extent = render_extent;
+	command_buffer.set_scissor(0, {scissor});
+
+	scene_pipeline->draw(command_buffer, *scene_target);
+
+	command_buffer.end_render_pass();
+
+	// Transitioned here, as the postprocessing only derives barriers from the previous postprocessing pass
+	{
+		vkb::ImageMemoryBarrier memory_barrier{};
+		memory_barrier.old_layout      = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+		memory_barrier.new_layout      = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		memory_barrier.src_access_mask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+		memory_barrier.dst_access_mask = VK_ACCESS_SHADER_READ_BIT;
+		memory_barrier.src_stage_mask  = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+		memory_barrier.dst_stage_mask  = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+
+		command_buffer.image_memory_barrier(views[0], memory_barrier);
+		scene_target->set_layout(0, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+	}
+
+	{
+		vkb::ImageMemoryBarrier memory_barrier{};
+		memory_barrier.old_layout      = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+		memory_barrier.new_layout      = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		memory_barrier.src_access_mask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+		memory_barrier.dst_access_mask = VK_ACCESS_SHADER_READ_BIT;
+		memory_barrier.src_stage_mask  = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+		memory_barrier.dst_stage_mask  = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+
+		command_buffer.image_memory_barrier(views[1], memory_barrier);
+		scene_target->set_layout(1, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+	}
+}
+
+void DynamicResolutionSample::draw_upscale(vkb::CommandBuffer &command_buffer, vkb::RenderTarget &render_target, const VkExtent2D &render_extent)
+{
+	// The history is reprojected from the output pixels, which are not jittered
+	glm::vec2 jitter = camera->get_jitter();
+	camera->set_jitter(glm::vec2(0.0f));
+	glm::mat4 view_proj = camera->get_pre_rotation() * vkb::vulkan_style_projection(camera->get_projection()) * camera->get_view();
+	camera->set_jitter(jitter);
+
+	auto &image_extent = scene_target->get_image_extent();
+
+	TemporalUpscaleUniform uniform{};
+	uniform.reprojection  = previous_view_proj * glm::inverse(view_proj);
+	uniform.jitter_scale  = glm::vec4(jitter, static_cast<float>(render_extent.width) / static_cast<float>(image_extent.width),
+	                                  static_cast<float>(render_extent.height) / static_cast<float>(image_extent.height));
+	uniform.render_extent = glm::vec4(static_cast<float>(render_extent.width), static_cast<float>(render_extent.height), CURRENT_FRAME_WEIGHT, history_valid ? 1.0f : 0.0f);
+
+	previous_view_proj = view_proj;
+
+	auto &current_history  = *history_targets[history_index];
+	auto &previous_history = *history_targets[history_index ^ 1];
+
+	auto &upscale_pass = upscale_pipeline->get_pass(0);
+	upscale_pass.set_uniform_data(uniform);
+	upscale_pass.set_render_target(&current_history);
+	upscale_pass.get_subpass(0)
+	    .bind_sampled_image("color_sampler", {0, scene_target.get()})
+	    .bind_sampled_image("depth_sampler", {1, scene_target.get()})
+	    .bind_sampled_image("history_sampler", {0, &previous_history});
+
+	upscale_pipeline->get_pass(1).get_subpass(0).bind_sampled_image("source_sampler", {0, &current_history});
+
+	// The upscaled image is the history of the next frame
+	upscale_pipeline->draw(command_buffer, render_target);
+
+	if (gui)
+	{
+		gui->draw(command_buffer);
+	}
+
+	command_buffer.end_render_pass();
+
+	history_index ^= 1;
+	history_valid = true;
+}
+
+void DynamicResolutionSample::log_frame_time()
+{
+	if (elapsed_frames == 0)
+	{
+		return;
+	}
+
+	auto &resolution_stats = dynamic_resolution->get_stats();
+
+	LOGI("Dynamic resolution {} with a {:.1f} ms target: {:.3f} ms average frame time, {:.0f}% average scale, {:.3f} ms GPU frame time over {} frames",
+	     last_dynamic ? "on" : "off", resolution_stats.target_frame_time, elapsed_time / elapsed_frames, 100.0 * elapsed_scale / elapsed_frames,
+	     resolution_stats.achieved_time, elapsed_frames);
+
+	elapsed_time   = 0.0;
+	elapsed_scale  = 0.0;
+	elapsed_frames = 0;
+}
+
+void DynamicResolutionSample::update(float delta_time)
+{
+	if (dynamic != last_dynamic || target_frame_time != last_target_frame_time)
+	{
+		log_frame_time();
+
+		dynamic_resolution->set_enabled(dynamic);
+		dynamic_resolution->set_target_frame_time(target_frame_time / 10.0f);
+
+		last_dynamic           = dynamic;
+		last_target_frame_time = target_frame_time;
+	}
+
+	vkb::Timer timer;
+	timer.start();
+
+	VulkanSample::update(delta_time);
+
+	elapsed_time += timer.stop<vkb::Timer::Milliseconds>();
+	elapsed_scale += dynamic_resolution->get_scale();
+	elapsed_frames++;
+}
+
+void DynamicResolutionSample::draw_gui()
+{
+	auto &resolution_stats = dynamic_resolution->get_stats();
+	auto  render_extent    = dynamic_resolution->get_render_extent(get_render_context().get_surface_extent());
+
+	gui->show_options_window(
+	    /* body = */ [this, &resolution_stats, &render_extent]() {
+		    ImGui::Checkbox("Dynamic resolution", &dynamic);
+		    ImGui::SameLine();
+		    ImGui::Text("Target:");
+		    for (int target : target_frame_times)
+		    {
+			    ImGui::SameLine();
+			    ImGui::RadioButton((std::to_string(target / 10) + "." + std::to_string(target % 10) + " ms").c_str(), &target_frame_time, target);
+		    }
+
+		    if (dynamic_resolution->is_supported())
+		    {
+			    ImGui::Text("Scale: %.0f%%, render extent: %ux%u, GPU frame time: %.2f ms", 100.0f * resolution_stats.scale,
+			                render_extent.width, render_extent.height, resolution_stats.achieved_time);
+		    }
+		    else
+		    {
+			    ImGui::Text("Timestamps not supported, rendering at %ux%u", render_extent.width, render_extent.height);
+		    }
+	    },
+	    /* lines = */ 2);
+}
+
+std::unique_ptr<vkb::VulkanSample> create_dynamic_resolution()
+{
+	return std::make_unique<DynamicResolutionSample>();
+}
@@ -0,0 +1,114 @@
+/* Copyright (c) 2023, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <array>
+
+#include "rendering/dynamic_resolution.h"
+#include "rendering/postprocessing_pipeline.h"
+#include "rendering/render_pipeline.h"
+#include "scene_graph/components/perspective_camera.h"
+#include "vulkan_sample.h"
+
+/**
+ * @brief Dynamic resolution with temporal upscaling
+ *
+ *        The scene is rendered with a jittered projection into a sub-region of its render target,
+ *        whose extent is chosen every frame by a vkb::DynamicResolution controller from the GPU
+ *        time of the previous frames. A postprocessing pass then reconstructs the image at the
+ *        resolution of the swapchain, by accumulating the frames into a history reprojected
+ *        with the camera motion.
+ */
+class DynamicResolutionSample : public vkb::VulkanSample
+{
+  public:
+	DynamicResolutionSample();
+
+	virtual ~DynamicResolutionSample() = default;
+
+	virtual bool prepare(vkb::Platform &platform) override;
+
+	virtual void update(float delta_time) override;
+
+	virtual void prepare_render_context() override;
+
+  private:
+	virtual void draw(vkb::CommandBuffer &command_buffer, vkb::RenderTarget &render_target) override;
+
+	virtual void draw_gui() override;
+
+	/**
+	 * @brief Creates the scene render target and the history render targets at the output extent
+	 */
+	void create_render_targets(const VkExtent2D &extent);
+
+	/**
+	 * @brief Records the scene pass into the render extent of the scene render target
+	 */
+	void draw_scene(vkb::CommandBuffer &command_buffer, const VkExtent2D &render_extent);
+
+	/**
+	 * @brief Records the temporal upscale into the current history, and copies it to the swapchain image
+	 */
+	void draw_upscale(vkb::CommandBuffer &command_buffer, vkb::RenderTarget &render_target, const VkExtent2D &render_extent);
+
+	void log_frame_time();
+
+	vkb::sg::PerspectiveCamera *camera{nullptr};
+
+	std::unique_ptr<vkb::RenderPipeline> scene_pipeline;
+
+	std::unique_ptr<vkb::PostProcessingPipeline> upscale_pipeline;
+
+	std::unique_ptr<vkb::DynamicResolution> dynamic_resolution;
+
+	// Color and depth of the scene, rendered to their top-left region
+	std::unique_ptr<vkb::RenderTarget> scene_target;
+
+	// Upscaled images, the current one is written while the previous one is reprojected
+	std::array<std::unique_ptr<vkb::RenderTarget>, 2> history_targets;
+
+	uint32_t history_index{0};
+
+	bool history_valid{false};
+
+	// Unjittered view projection of the previous frame
+	glm::mat4 previous_view_proj{1.0f};
+
+	uint32_t frame_index{0};
+
+	// Whether the render extent follows the frame time, otherwise the scene is rendered at the output resolution
+	bool dynamic{true};
+
+	bool last_dynamic{true};
+
+	// GPU frame time budget, in tenths of milliseconds
+	int target_frame_time{166};
+
+	int last_target_frame_time{166};
+
+	// Accumulated frame time of the current configuration, in milliseconds
+	double elapsed_time{0.0};
+
+	// Accumulated scale of the current configuration
+	double elapsed_scale{0.0};
+
+	uint32_t elapsed_frames{0};
+};
+
+std::unique_ptr<vkb::VulkanSample> create_dynamic_resolution();
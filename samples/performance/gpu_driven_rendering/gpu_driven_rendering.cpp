@@ -0,0 +1,1036 @@
+/* Copyright (c) 2023, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "gpu_driven_rendering.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <random>
+#include <thread>
+
+#include "glsl_compiler.h"
+#include "platform/platform.h"
+#include "scene_graph/components/mesh.h"
+#include "scene_graph/components/pbr_material.h"
+#include "scene_graph/components/skin.h"
+#include "scene_graph/components/sub_mesh.h"
+#include "timer.h"
+
+namespace
+{
+constexpr std::array<uint32_t, 3> instance_counts = {10000, 100000, 1000000};
+
+constexpr float instance_spacing = 4.0f;
+
+// Point lights scattered among the instances, the first option only keeps the lights of the scene
+constexpr std::array<uint32_t, 4> light_counts = {0, 8, 256, 4096};
+
+// Range of the scattered lights, in instance spacings
+constexpr float light_range = 2.0f;
+
+// Instance count used to measure the scaling of the CPU recorded draws across threads
+constexpr int thread_scaling_instance_count_index = 1;
+
+// Number of instances chained under each other in a deep hierarchy
+constexpr uint32_t hierarchy_chain_length = 256;
+
+// Keyframes of a full turn of the animated instances, which turn at one radian per second
+constexpr uint32_t animation_keyframe_count = 17;
+
+// Largest angle the upper half of a skinned teapot bends by, in radians
+const float bend_angle = glm::radians(30.0f);
+
+// Instances skinned with their own joints, each deformed into its own vertex buffers
+constexpr uint32_t skinned_instance_count = 256;
+
+// Levels of detail generated for the teapot submeshes, each with about half the triangles of the previous one
+constexpr uint32_t mesh_lod_count = 4;
+
+// The vertex pipeline fallback of the meshlets writes an indirect command per instance meshlet,
+// so the meshlet configurations stop short of the 1M instances
+constexpr int meshlet_instance_count_index_end = 2;
+}        // namespace
+
+GPUDrivenRendering::GPUDrivenRendering()
+{
+	max_recording_thread_count = std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+
+	// Mesh shading is optional, the meshlets fall back to the vertex pipeline without it
+	set_api_version(VK_API_VERSION_1_1);
+	add_instance_extension(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME, true);
+	add_device_extension(VK_KHR_SPIRV_1_4_EXTENSION_NAME, true);
+	add_device_extension(VK_KHR_SHADER_FLOAT_CONTROLS_EXTENSION_NAME, true);
+	add_device_extension(VK_EXT_MESH_SHADER_EXTENSION_NAME, true);
+
+	auto &config = get_configuration();
+
+	for (int i = 0; i < static_cast<int>(instance_counts.size()); ++i)
+	{
+		config.insert<vkb::IntSetting>(2 * i, instance_count_index, i);
+		config.insert<vkb::BoolSetting>(2 * i, gpu_driven_enabled, false);
+		config.insert<vkb::IntSetting>(2 * i, recording_thread_count, 0);
+		config.insert<vkb::BoolSetting>(2 * i, deep_hierarchy, false);
+		config.insert<vkb::BoolSetting>(2 * i, animated, false);
+		config.insert<vkb::BoolSetting>(2 * i, frustum_culling, true);
+		config.insert<vkb::BoolSetting>(2 * i, occlusion_culling, false);
+		config.insert<vkb::BoolSetting>(2 * i, hierarchical_culling, false);
+		config.insert<vkb::BoolSetting>(2 * i, skinned, false);
+		config.insert<vkb::BoolSetting>(2 * i, async_skinning, false);
+		config.insert<vkb::BoolSetting>(2 * i, instancing, false);
+		config.insert<vkb::BoolSetting>(2 * i, level_of_detail, false);
+		config.insert<vkb::BoolSetting>(2 * i, meshlets_enabled, false);
+		config.insert<vkb::BoolSetting>(2 * i, mesh_shading, true);
+		config.insert<vkb::IntSetting>(2 * i, light_count_index, 0);
+		config.insert<vkb::BoolSetting>(2 * i, clustered_lighting, false);
+
+		config.insert<vkb::IntSetting>(2 * i + 1, instance_count_index, i);
+		config.insert<vkb::BoolSetting>(2 * i + 1, gpu_driven_enabled, true);
+		config.insert<vkb::IntSetting>(2 * i + 1, recording_thread_count, 0);
+		config.insert<vkb::BoolSetting>(2 * i + 1, deep_hierarchy, false);
+		config.insert<vkb::BoolSetting>(2 * i + 1, animated, false);
+		config.insert<vkb::BoolSetting>(2 * i + 1, frustum_culling, true);
+		config.insert<vkb::BoolSetting>(2 * i + 1, occlusion_culling, false);
+		config.insert<vkb::BoolSetting>(2 * i + 1, hierarchical_culling, false);
+		config.insert<vkb::BoolSetting>(2 * i + 1, skinned, false);
+		config.insert<vkb::BoolSetting>(2 * i + 1, async_skinning, false);
+		config.insert<vkb::BoolSetting>(2 * i + 1, instancing, false);
+		config.insert<vkb::BoolSetting>(2 * i + 1, level_of_detail, false);
+		config.insert<vkb::BoolSetting>(2 * i + 1, meshlets_enabled, false);
+		config.insert<vkb::BoolSetting>(2 * i + 1, mesh_shading, true);
+		config.insert<vkb::IntSetting>(2 * i + 1, light_count_index, 0);
+		config.insert<vkb::BoolSetting>(2 * i + 1, clustered_lighting, false);
+	}
+
+	// Record the CPU draws in parallel with 1, 2, 4 and all the cores
+	std::vector<int> thread_counts;
+	for (int thread_count : {1, 2, 4, max_recording_thread_count})
+	{
+		if (thread_count <= max_recording_thread_count && std::find(thread_counts.begin(), thread_counts.end(), thread_count) == thread_counts.end())
+		{
+			thread_counts.push_back(thread_count);
+		}
+	}
+
+	uint32_t config_index = 2 * static_cast<uint32_t>(instance_counts.size());
+	for (int thread_count : thread_counts)
+	{
+		config.insert<vkb::IntSetting>(config_index, instance_count_index, thread_scaling_instance_count_index);
+		config.insert<vkb::BoolSetting>(config_index, gpu_driven_enabled, false);
+		config.insert<vkb::IntSetting>(config_index, recording_thread_count, thread_count);
+		config.insert<vkb::BoolSetting>(config_index, deep_hierarchy, false);
+		config.insert<vkb::BoolSetting>(config_index, animated, false);
+		config.insert<vkb::BoolSetting>(config_index, frustum_culling, true);
+		config.insert<vkb::BoolSetting>(config_index, occlusion_culling, false);
+		config.insert<vkb::BoolSetting>(config_index, hierarchical_culling, false);
+		config.insert<vkb::BoolSetting>(config_index, skinned, false);
+		config.insert<vkb::BoolSetting>(config_index, async_skinning, false);
+		config.insert<vkb::BoolSetting>(config_index, instancing, false);
+		config.insert<vkb::BoolSetting>(config_index, level_of_detail, false);
+		config.insert<vkb::BoolSetting>(config_index, meshlets_enabled, false);
+		config.insert<vkb::BoolSetting>(config_index, mesh_shading, true);
+		config.insert<vkb::IntSetting>(config_index, light_count_index, 0);
+		config.insert<vkb::BoolSetting>(config_index, clustered_lighting, false);
+		config_index++;
+	}
+
+	// Update the world matrices of wide and deep hierarchies of 100k and 1M animated instances
+	for (int i = 1; i < static_cast<int>(instance_counts.size()); ++i)
+	{
+		for (bool deep : {false, true})
+		{
+			config.insert<vkb::IntSetting>(config_index, instance_count_index, i);
+			config.insert<vkb::BoolSetting>(config_index, gpu_driven_enabled, true);
+			config.insert<vkb::IntSetting>(config_index, recording_thread_count, 0);
+			config.insert<vkb::BoolSetting>(config_index, deep_hierarchy, deep);
+			config.insert<vkb::BoolSetting>(config_index, animated, true);
+			config.insert<vkb::BoolSetting>(config_index, frustum_culling, true);
+			config.insert<vkb::BoolSetting>(config_index, occlusion_culling, false);
+			config.insert<vkb::BoolSetting>(config_index, hierarchical_culling, false);
+			config.insert<vkb::BoolSetting>(config_index, skinned, false);
+			config.insert<vkb::BoolSetting>(config_index, async_skinning, false);
+			config.insert<vkb::BoolSetting>(config_index, instancing, false);
+			config.insert<vkb::BoolSetting>(config_index, level_of_detail, false);
+			config.insert<vkb::BoolSetting>(config_index, meshlets_enabled, false);
+			config.insert<vkb::BoolSetting>(config_index, mesh_shading, true);
+			config.insert<vkb::IntSetting>(config_index, light_count_index, 0);
+			config.insert<vkb::BoolSetting>(config_index, clustered_lighting, false);
+			config_index++;
+		}
+	}
+
+	// Record the CPU draws of 100k and 1M instances without culling, with frustum culling of every instance,
+	// with frustum culling through the BVH, and with occlusion culling. The 1M instances are also animated to refit the BVH.
+	for (int i = 1; i < static_cast<int>(instance_counts.size()); ++i)
+	{
+		for (int culling_mode = 0; culling_mode < 4; ++culling_mode)
+		{
+			config.insert<vkb::IntSetting>(config_index, instance_count_index, i);
+			config.insert<vkb::BoolSetting>(config_index, gpu_driven_enabled, false);
+			config.insert<vkb::IntSetting>(config_index, recording_thread_count, 0);
+			config.insert<vkb::BoolSetting>(config_index, deep_hierarchy, false);
+			config.insert<vkb::BoolSetting>(config_index, animated, i == 2);
+			config.insert<vkb::BoolSetting>(config_index, frustum_culling, culling_mode > 0);
+			config.insert<vkb::BoolSetting>(config_index, hierarchical_culling, culling_mode == 2);
+			config.insert<vkb::BoolSetting>(config_index, occlusion_culling, culling_mode == 3);
+			config.insert<vkb::BoolSetting>(config_index, skinned, false);
+			config.insert<vkb::BoolSetting>(config_index, async_skinning, false);
+			config.insert<vkb::BoolSetting>(config_index, instancing, false);
+			config.insert<vkb::BoolSetting>(config_index, level_of_detail, false);
+			config.insert<vkb::BoolSetting>(config_index, meshlets_enabled, false);
+			config.insert<vkb::BoolSetting>(config_index, mesh_shading, true);
+			config.insert<vkb::IntSetting>(config_index, light_count_index, 0);
+			config.insert<vkb::BoolSetting>(config_index, clustered_lighting, false);
+			config_index++;
+		}
+	}
+
+	// Skin the first teapots with a bending joint each, deformed once per frame on the GPU for each skinned instance,
+	// on the graphics queue and on the async compute queue
+	for (bool async : {false, true})
+	{
+		config.insert<vkb::IntSetting>(config_index, instance_count_index, 0);
+		config.insert<vkb::BoolSetting>(config_index, gpu_driven_enabled, false);
+		config.insert<vkb::IntSetting>(config_index, recording_thread_count, 0);
+		config.insert<vkb::BoolSetting>(config_index, deep_hierarchy, false);
+		config.insert<vkb::BoolSetting>(config_index, animated, true);
+		config.insert<vkb::BoolSetting>(config_index, frustum_culling, true);
+		config.insert<vkb::BoolSetting>(config_index, hierarchical_culling, false);
+		config.insert<vkb::BoolSetting>(config_index, occlusion_culling, false);
+		config.insert<vkb::BoolSetting>(config_index, skinned, true);
+		config.insert<vkb::BoolSetting>(config_index, async_skinning, async);
+		config.insert<vkb::BoolSetting>(config_index, instancing, false);
+		config.insert<vkb::BoolSetting>(config_index, level_of_detail, false);
+		config.insert<vkb::BoolSetting>(config_index, meshlets_enabled, false);
+		config.insert<vkb::BoolSetting>(config_index, mesh_shading, true);
+		config.insert<vkb::IntSetting>(config_index, light_count_index, 0);
+		config.insert<vkb::BoolSetting>(config_index, clustered_lighting, false);
+		config_index++;
+	}
+
+	// Record the frustum culled 100k and 1M instances on the CPU with one instanced draw per submesh, rather than per instance
+	for (int i = 1; i < static_cast<int>(instance_counts.size()); ++i)
+	{
+		config.insert<vkb::IntSetting>(config_index, instance_count_index, i);
+		config.insert<vkb::BoolSetting>(config_index, gpu_driven_enabled, false);
+		config.insert<vkb::IntSetting>(config_index, recording_thread_count, 0);
+		config.insert<vkb::BoolSetting>(config_index, deep_hierarchy, false);
+		config.insert<vkb::BoolSetting>(config_index, animated, false);
+		config.insert<vkb::BoolSetting>(config_index, frustum_culling, true);
+		config.insert<vkb::BoolSetting>(config_index, hierarchical_culling, false);
+		config.insert<vkb::BoolSetting>(config_index, occlusion_culling, false);
+		config.insert<vkb::BoolSetting>(config_index, skinned, false);
+		config.insert<vkb::BoolSetting>(config_index, async_skinning, false);
+		config.insert<vkb::BoolSetting>(config_index, instancing, true);
+		config.insert<vkb::BoolSetting>(config_index, level_of_detail, false);
+		config.insert<vkb::BoolSetting>(config_index, meshlets_enabled, false);
+		config.insert<vkb::BoolSetting>(config_index, mesh_shading, true);
+		config.insert<vkb::IntSetting>(config_index, light_count_index, 0);
+		config.insert<vkb::BoolSetting>(config_index, clustered_lighting, false);
+		config_index++;
+	}
+
+	// Draw the frustum culled 100k and 1M instances at the level of detail matching their size on screen,
+	// with one draw per instance and with instanced draws
+	for (int i = 1; i < static_cast<int>(instance_counts.size()); ++i)
+	{
+		for (bool instanced : {false, true})
+		{
+			config.insert<vkb::IntSetting>(config_index, instance_count_index, i);
+			config.insert<vkb::BoolSetting>(config_index, gpu_driven_enabled, false);
+			config.insert<vkb::IntSetting>(config_index, recording_thread_count, 0);
+			config.insert<vkb::BoolSetting>(config_index, deep_hierarchy, false);
+			config.insert<vkb::BoolSetting>(config_index, animated, false);
+			config.insert<vkb::BoolSetting>(config_index, frustum_culling, true);
+			config.insert<vkb::BoolSetting>(config_index, hierarchical_culling, false);
+			config.insert<vkb::BoolSetting>(config_index, occlusion_culling, false);
+			config.insert<vkb::BoolSetting>(config_index, skinned, false);
+			config.insert<vkb::BoolSetting>(config_index, async_skinning, false);
+			config.insert<vkb::BoolSetting>(config_index, instancing, instanced);
+			config.insert<vkb::BoolSetting>(config_index, level_of_detail, true);
+			config.insert<vkb::BoolSetting>(config_index, meshlets_enabled, false);
+			config.insert<vkb::BoolSetting>(config_index, mesh_shading, true);
+			config.insert<vkb::IntSetting>(config_index, light_count_index, 0);
+			config.insert<vkb::BoolSetting>(config_index, clustered_lighting, false);
+			config_index++;
+		}
+	}
+
+	// Draw 10k and 100k instances as GPU culled meshlets, with task and mesh shaders and with the vertex pipeline fallback
+	for (int i = 0; i < meshlet_instance_count_index_end; ++i)
+	{
+		for (bool mesh_shaded : {true, false})
+		{
+			config.insert<vkb::IntSetting>(config_index, instance_count_index, i);
+			config.insert<vkb::BoolSetting>(config_index, gpu_driven_enabled, false);
+			config.insert<vkb::IntSetting>(config_index, recording_thread_count, 0);
+			config.insert<vkb::BoolSetting>(config_index, deep_hierarchy, false);
+			config.insert<vkb::BoolSetting>(config_index, animated, false);
+			config.insert<vkb::BoolSetting>(config_index, frustum_culling, true);
+			config.insert<vkb::BoolSetting>(config_index, hierarchical_culling, false);
+			config.insert<vkb::BoolSetting>(config_index, occlusion_culling, false);
+			config.insert<vkb::BoolSetting>(config_index, skinned, false);
+			config.insert<vkb::BoolSetting>(config_index, async_skinning, false);
+			config.insert<vkb::BoolSetting>(config_index, instancing, false);
+			config.insert<vkb::BoolSetting>(config_index, level_of_detail, false);
+			config.insert<vkb::BoolSetting>(config_index, meshlets_enabled, true);
+			config.insert<vkb::BoolSetting>(config_index, mesh_shading, mesh_shaded);
+			config.insert<vkb::IntSetting>(config_index, light_count_index, 0);
+			config.insert<vkb::BoolSetting>(config_index, clustered_lighting, false);
+			config_index++;
+		}
+	}
+
+	// Light 10k GPU-driven instances with every light evaluated per pixel, then with clustered lights of increasing counts
+	for (int i = 1; i < static_cast<int>(light_counts.size()); ++i)
+	{
+		for (bool clustered : {false, true})
+		{
+			// Without clusters, the lights are limited to MAX_FORWARD_LIGHT_COUNT per type
+			if (!clustered && light_counts[i] > MAX_FORWARD_LIGHT_COUNT)
+			{
+				continue;
+			}
+
+			config.insert<vkb::IntSetting>(config_index, instance_count_index, 0);
+			config.insert<vkb::BoolSetting>(config_index, gpu_driven_enabled, true);
+			config.insert<vkb::IntSetting>(config_index, recording_thread_count, 0);
+			config.insert<vkb::BoolSetting>(config_index, deep_hierarchy, false);
+			config.insert<vkb::BoolSetting>(config_index, animated, false);
+			config.insert<vkb::BoolSetting>(config_index, frustum_culling, true);
+			config.insert<vkb::BoolSetting>(config_index, hierarchical_culling, false);
+			config.insert<vkb::BoolSetting>(config_index, occlusion_culling, false);
+			config.insert<vkb::BoolSetting>(config_index, skinned, false);
+			config.insert<vkb::BoolSetting>(config_index, async_skinning, false);
+			config.insert<vkb::BoolSetting>(config_index, instancing, false);
+			config.insert<vkb::BoolSetting>(config_index, level_of_detail, false);
+			config.insert<vkb::BoolSetting>(config_index, meshlets_enabled, false);
+			config.insert<vkb::BoolSetting>(config_index, mesh_shading, true);
+			config.insert<vkb::IntSetting>(config_index, light_count_index, i);
+			config.insert<vkb::BoolSetting>(config_index, clustered_lighting, clustered);
+			config_index++;
+		}
+	}
+}
+
+GPUDrivenRendering::~GPUDrivenRendering()
+{
+	// The SPIR-V 1.4 target of the mesh shaders is global to the compiler
+	if (supports_mesh_shading)
+	{
+		vkb::GLSLCompiler::reset_target_environment();
+	}
+}
+
+void GPUDrivenRendering::prepare_render_context()
+{
+	// Recording jobs allocate from the pools of the thread running them
+	get_render_context().prepare(get_job_system().get_thread_count());
+}
+
+void GPUDrivenRendering::request_gpu_features(vkb::PhysicalDevice &gpu)
+{
+	// The culling shader writes the visible instances at the firstInstance of each command
+	if (gpu.get_features().drawIndirectFirstInstance)
+	{
+		gpu.get_mutable_requested_features().drawIndirectFirstInstance = VK_TRUE;
+		supports_gpu_driven                                            = true;
+	}
+
+	// Otherwise each indirect command is drawn separately
+	if (gpu.get_features().multiDrawIndirect)
+	{
+		gpu.get_mutable_requested_features().multiDrawIndirect = VK_TRUE;
+	}
+
+	// Extension features can only be queried through the physical device properties 2 extension
+	if (instance->is_enabled(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME))
+	{
+		auto &mesh_shader_features = gpu.request_extension_features<VkPhysicalDeviceMeshShaderFeaturesEXT>(VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MESH_SHADER_FEATURES_EXT);
+
+		supports_mesh_shading = mesh_shader_features.meshShader && mesh_shader_features.taskShader;
+		if (supports_mesh_shading)
+		{
+			mesh_shader_features.meshShader = VK_TRUE;
+			mesh_shader_features.taskShader = VK_TRUE;
+
+			// Mesh shaders require SPIR-V 1.4
+			vkb::GLSLCompiler::set_target_environment(glslang::EShTargetSpv, glslang::EShTargetSpv_1_4);
+		}
+		else
+		{
+			mesh_shader_features.meshShader = VK_FALSE;
+			mesh_shader_features.taskShader = VK_FALSE;
+		}
+	}
+}
+
+void GPUDrivenRendering::setup_scene()
+{
+	load_scene("scenes/teapot.gltf", mesh_lod_count);
+
+	// Override the default material so it's not rendering all black.
+	auto materials = scene->get_components<vkb::sg::PBRMaterial>();
+	for (auto *material : materials)
+	{
+		material->base_color_factor = glm::vec4(0.8f, 0.6f, 0.5f, 1.0f);
+		material->roughness_factor  = 1.0f;
+		material->metallic_factor   = 0.0f;
+	}
+
+	vkb::sg::Node *teapot_node = nullptr;
+
+	auto &root_node = scene->get_root_node();
+	for (auto *child : root_node.get_children())
+	{
+		if (child->has_component<vkb::sg::Mesh>())
+		{
+			teapot_node = child;
+			break;
+		}
+	}
+
+	if (!teapot_node)
+	{
+		throw std::runtime_error("Teapot mesh does not exist in teapot.gltf?");
+	}
+
+	auto &teapot_mesh = teapot_node->get_component<vkb::sg::Mesh>();
+
+	// Lay out the instances on a cube grid centered around the origin
+	const uint32_t instance_count = instance_counts[instance_count_index];
+	const uint32_t side           = static_cast<uint32_t>(std::ceil(std::cbrt(static_cast<double>(instance_count))));
+	const float    offset         = 0.5f * instance_spacing * (side - 1);
+
+	// Every animated instance shares the keyframes of a single sampler
+	animation = std::make_unique<vkb::sg::Animation>("Instances");
+
+	vkb::sg::AnimationSampler sampler;
+	sampler.type = vkb::sg::AnimationType::Linear;
+	for (uint32_t i = 0; i < animation_keyframe_count; ++i)
+	{
+		float time     = glm::two_pi<float>() * i / (animation_keyframe_count - 1);
+		auto  rotation = glm::angleAxis(time, glm::vec3(0.0f, 1.0f, 0.0f));
+
+		sampler.inputs.push_back(time);
+		sampler.outputs.push_back(glm::vec4(rotation.x, rotation.y, rotation.z, rotation.w));
+	}
+
+	uint32_t sampler_index = animation->add_sampler(sampler);
+	animation->update_times(sampler.inputs.front(), sampler.inputs.back());
+
+	vkb::sg::Node *previous_node = nullptr;
+	glm::vec3      previous_position{0.0f};
+
+	for (uint32_t i = 0; i < instance_count; ++i)
+	{
+		vkb::sg::Node *node     = teapot_node;
+		glm::vec3      position = glm::vec3(i % side, (i / side) % side, i / (side * side)) * instance_spacing - glm::vec3(offset);
+
+		// In a deep hierarchy, each instance is the child of the previous one in its chain
+		bool chained = deep_hierarchy && i % hierarchy_chain_length != 0;
+
+		// Duplicate out unique nodes, the first instance is the teapot node itself
+		if (i > 0)
+		{
+			auto new_node = std::make_unique<vkb::sg::Node>(-1, "Teapot");
+			new_node->set_component(teapot_mesh);
+			teapot_mesh.add_node(*new_node);
+
+			auto &parent_node = chained ? *previous_node : root_node;
+			new_node->set_parent(parent_node);
+			parent_node.add_child(*new_node);
+
+			node = new_node.get();
+			scene->add_node(std::move(new_node));
+		}
+
+		auto &transform = node->get_component<vkb::sg::Transform>();
+		transform.set_scale(glm::vec3(1.0f));
+		transform.set_rotation(glm::quat(1.0f, 0.0f, 0.0f, 0.0f));
+		transform.set_translation(chained ? position - previous_position : position);
+
+		// Rotating the first node of a chain moves all of its descendants
+		if (!chained)
+		{
+			animation->add_channel(*node, vkb::sg::AnimationTarget::Rotation, sampler_index);
+		}
+
+		previous_node     = node;
+		previous_position = position;
+	}
+
+	if (skinned)
+	{
+		add_teapot_skins(teapot_mesh, std::min(skinned_instance_count, instance_count));
+		create_gpu_skinning();
+	}
+	else
+	{
+		// The body of the teapot encloses the middle third of its bounds, which the occlusion culling draws as an occluder.
+		// A skinned teapot bends out of it, so it does not occlude.
+		auto &bounds = teapot_mesh.get_bounds();
+		auto  extent = 0.3f * (bounds.get_max() - bounds.get_center());
+		teapot_mesh.set_occluder_bounds(bounds.get_center() - extent, bounds.get_center() + extent);
+	}
+
+	add_lights(light_counts[light_count_index], offset + 0.5f * instance_spacing);
+
+	auto &camera_node = vkb::add_free_camera(*scene, "main_camera", get_render_context().get_surface_extent());
+	camera            = &camera_node.get_component<vkb::sg::Camera>();
+	free_camera       = dynamic_cast<vkb::sg::FreeCamera *>(&camera_node.get_component<vkb::sg::Script>());
+
+	auto &camera_transform = camera->get_node()->get_component<vkb::sg::Transform>();
+	camera_transform.set_translation(glm::vec3(0.0f, 0.0f, offset + 2.0f * instance_spacing));
+	camera_transform.set_rotation(glm::quat(1.0f, 0.0f, 0.0f, 0.0f));
+
+	// Build the BVH up front to measure it, the culling then only refits it
+	vkb::Timer bvh_timer;
+	bvh_timer.start();
+
+	auto &bounding_volume_hierarchy = scene->get_bounding_volume_hierarchy();
+	bounding_volume_hierarchy.update();
+
+	LOGI("Built a BVH of {} nodes over {} instances in {:.3f} ms", bounding_volume_hierarchy.get_node_count(),
+	     bounding_volume_hierarchy.get_instance_count(), bvh_timer.stop<vkb::Timer::Milliseconds>());
+}
+
+void GPUDrivenRendering::add_teapot_skins(vkb::sg::Mesh &teapot_mesh, uint32_t skinned_count)
+{
+	auto &bounds = teapot_mesh.get_bounds();
+
+	// A root joint at the bottom of the teapot, and a joint bending its upper half
+	const float bottom_height = bounds.get_min().y;
+	const float middle_height = bounds.get_center().y;
+	const float half_height   = 0.5f * (bounds.get_max().y - bounds.get_min().y);
+
+	// The upper joints swing back and forth over one turn of the instances
+	vkb::sg::AnimationSampler sampler;
+	sampler.type = vkb::sg::AnimationType::Linear;
+	for (uint32_t i = 0; i < animation_keyframe_count; ++i)
+	{
+		float time     = glm::two_pi<float>() * i / (animation_keyframe_count - 1);
+		auto  rotation = glm::angleAxis(bend_angle * std::sin(time), glm::vec3(0.0f, 0.0f, 1.0f));
+
+		sampler.inputs.push_back(time);
+		sampler.outputs.push_back(glm::vec4(rotation.x, rotation.y, rotation.z, rotation.w));
+	}
+
+	uint32_t sampler_index = animation->add_sampler(sampler);
+
+	for (uint32_t i = 0; i < skinned_count; ++i)
+	{
+		vkb::sg::Node *teapot_node = teapot_mesh.get_nodes()[i];
+
+		auto skin = std::make_unique<vkb::sg::Skin>("Teapot skin");
+
+		vkb::sg::Node *parent_node = teapot_node;
+		for (float joint_height : {bottom_height, middle_height})
+		{
+			auto joint_node = std::make_unique<vkb::sg::Node>(-1, "Teapot joint");
+
+			// Joints are placed relative to their parent
+			float parent_height = parent_node == teapot_node ? 0.0f : bottom_height;
+			joint_node->get_transform().set_translation(glm::vec3(0.0f, joint_height - parent_height, 0.0f));
+
+			joint_node->set_parent(*parent_node);
+			parent_node->add_child(*joint_node);
+
+			skin->add_joint(*joint_node, glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, -joint_height, 0.0f)));
+
+			parent_node = joint_node.get();
+			scene->add_node(std::move(joint_node));
+		}
+
+		animation->add_channel(*parent_node, vkb::sg::AnimationTarget::Rotation, sampler_index);
+
+		teapot_node->set_component(*skin);
+		scene->add_component(std::move(skin));
+	}
+
+	for (auto sub_mesh : teapot_mesh.get_submeshes())
+	{
+		vkb::sg::VertexAttribute position_attribute;
+		if (!sub_mesh->get_attribute("position", position_attribute))
+		{
+			continue;
+		}
+
+		auto     positions       = vkb::core::Buffer::copy<float>(sub_mesh->vertex_buffers, "position");
+		uint32_t position_stride = position_attribute.stride / sizeof(float);
+
+		// Vertices blend from the lower to the upper joint around the middle of the teapot
+		std::vector<glm::uvec4> joints(sub_mesh->vertices_count, glm::uvec4(0, 1, 0, 0));
+		std::vector<glm::vec4>  weights(sub_mesh->vertices_count);
+		for (uint32_t i = 0; i < sub_mesh->vertices_count; ++i)
+		{
+			float upper_weight = glm::clamp((positions[i * position_stride + 1] - middle_height) / half_height + 0.5f, 0.0f, 1.0f);
+			weights[i]         = glm::vec4(1.0f - upper_weight, upper_weight, 0.0f, 0.0f);
+		}
+
+		for (auto &attribute : {std::make_pair("joints_0", VK_FORMAT_R32G32B32A32_UINT), std::make_pair("weights_0", VK_FORMAT_R32G32B32A32_SFLOAT)})
+		{
+			vkb::core::Buffer buffer{get_device(),
+			                         sub_mesh->vertices_count * sizeof(glm::vec4),
+			                         VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+			                         VMA_MEMORY_USAGE_GPU_TO_CPU};
+
+			if (attribute.second == VK_FORMAT_R32G32B32A32_UINT)
+			{
+				buffer.update(reinterpret_cast<const uint8_t *>(joints.data()), joints.size() * sizeof(glm::uvec4));
+			}
+			else
+			{
+				buffer.update(reinterpret_cast<const uint8_t *>(weights.data()), weights.size() * sizeof(glm::vec4));
+			}
+
+			sub_mesh->vertex_buffers.erase(attribute.first);
+			sub_mesh->vertex_buffers.insert(std::make_pair(attribute.first, std::move(buffer)));
+
+			vkb::sg::VertexAttribute vertex_attribute;
+			vertex_attribute.format = attribute.second;
+			vertex_attribute.stride = sizeof(glm::vec4);
+			sub_mesh->set_attribute(attribute.first, vertex_attribute);
+		}
+	}
+}
+
+void GPUDrivenRendering::add_lights(uint32_t light_count, float extent)
+{
+	// A fixed seed, so that every run lights the instances the same way
+	std::mt19937                          random_engine{light_count};
+	std::uniform_real_distribution<float> position_distribution{-extent, extent};
+	std::uniform_real_distribution<float> color_distribution{0.2f, 1.0f};
+
+	vkb::sg::LightProperties properties;
+	properties.range     = light_range * instance_spacing;
+	properties.intensity = 0.001f;
+
+	for (uint32_t i = 0; i < light_count; ++i)
+	{
+		properties.color = glm::vec3{color_distribution(random_engine), color_distribution(random_engine), color_distribution(random_engine)};
+
+		glm::vec3 position{position_distribution(random_engine), position_distribution(random_engine), position_distribution(random_engine)};
+		vkb::add_point_light(*scene, position, properties);
+	}
+}
+
+vkb::ForwardSubpass *GPUDrivenRendering::get_scene_subpass() const
+{
+	return gpu_driven_subpass ? gpu_driven_subpass : meshlet_subpass ? meshlet_subpass : forward_subpass;
+}
+
+void GPUDrivenRendering::update_pipeline()
+{
+	std::unique_ptr<vkb::Subpass> scene_subpass;
+
+	gpu_driven_subpass = nullptr;
+	forward_subpass    = nullptr;
+	meshlet_subpass    = nullptr;
+
+	// The vertex pipeline fallback of the meshlets needs the same features as the GPU-driven subpass
+	if (meshlets_enabled && ((mesh_shading && supports_mesh_shading) || supports_gpu_driven))
+	{
+		auto subpass = std::make_unique<vkb::MeshletSubpass>(get_render_context(),
+		                                                     vkb::ShaderSource{"meshlet/meshlet.task"},
+		                                                     vkb::ShaderSource{"meshlet/meshlet.mesh"},
+		                                                     vkb::ShaderSource{"base.vert"},
+		                                                     vkb::ShaderSource{"base.frag"},
+		                                                     vkb::ShaderSource{"meshlet/cull.comp"},
+		                                                     *scene, *camera);
+		subpass->set_mesh_shading(mesh_shading && supports_mesh_shading);
+		subpass->set_dynamic_transforms(animated);
+
+		meshlet_subpass = subpass.get();
+		scene_subpass   = std::move(subpass);
+	}
+	else if (gpu_driven_enabled && supports_gpu_driven)
+	{
+		auto subpass = std::make_unique<vkb::GPUDrivenSubpass>(get_render_context(),
+		                                                       vkb::ShaderSource{"gpu_driven/geometry.vert"},
+		                                                       vkb::ShaderSource{"base.frag"},
+		                                                       vkb::ShaderSource{"gpu_driven/cull.comp"},
+		                                                       *scene, *camera);
+		subpass->set_dynamic_transforms(animated);
+
+		gpu_driven_subpass = subpass.get();
+		scene_subpass      = std::move(subpass);
+	}
+	else
+	{
+		auto subpass = std::make_unique<vkb::ForwardSubpass>(get_render_context(), vkb::ShaderSource{"base.vert"}, vkb::ShaderSource{"base.frag"}, *scene, *camera);
+		subpass->set_parallel_recording(&get_job_system(), recording_thread_count);
+		subpass->set_instancing(instancing);
+		subpass->set_level_of_detail(level_of_detail);
+
+		forward_subpass = subpass.get();
+		scene_subpass   = std::move(subpass);
+	}
+
+	// The lights must be clustered when there are more than the uniform light arrays hold
+	get_scene_subpass()->set_clustered_lighting(clustered_lighting || light_counts[light_count_index] > MAX_FORWARD_LIGHT_COUNT);
+
+	auto render_pipeline = vkb::RenderPipeline();
+	render_pipeline.add_subpass(std::move(scene_subpass));
+
+	set_render_pipeline(std::move(render_pipeline));
+}
+
+bool GPUDrivenRendering::prepare(vkb::Platform &platform)
+{
+	if (!VulkanSample::prepare(platform))
+	{
+		return false;
+	}
+
+	setup_scene();
+
+	update_pipeline();
+
+	last_instance_count_index   = instance_count_index;
+	last_gpu_driven_enabled     = gpu_driven_enabled;
+	last_meshlets_enabled       = meshlets_enabled;
+	last_mesh_shading           = mesh_shading;
+	last_light_count_index      = light_count_index;
+	last_clustered_lighting     = clustered_lighting;
+	last_recording_thread_count = recording_thread_count;
+	last_deep_hierarchy         = deep_hierarchy;
+	last_skinned                = skinned;
+	last_async_skinning         = async_skinning;
+
+	stats->request_stats({vkb::StatIndex::frame_times, vkb::StatIndex::visible_objects, vkb::StatIndex::culled_objects, vkb::StatIndex::occluded_objects, vkb::StatIndex::submitted_triangles});
+
+	gui = std::make_unique<vkb::Gui>(*this, platform.get_window(), stats.get());
+
+	return true;
+}
+
+void GPUDrivenRendering::log_frame_time()
+{
+	if (elapsed_frames == 0)
+	{
+		return;
+	}
+
+	std::string mode = "GPU-driven";
+	if (meshlet_subpass)
+	{
+		mode = meshlet_subpass->is_mesh_shading_enabled() ? "meshlets with mesh shaders" : "meshlets with indirect vertex pipeline draws";
+	}
+	else if (!last_gpu_driven_enabled || !supports_gpu_driven)
+	{
+		mode = last_recording_thread_count > 0 ? fmt::format("CPU recorded on {} threads", last_recording_thread_count) : "CPU recorded inline";
+
+		auto &culling = scene->get_visibility_culling();
+		mode += culling.is_occlusion_culling_enabled()    ? " with occlusion culling" :
+		        culling.is_hierarchical_culling_enabled() ? " with BVH frustum culling" :
+		        culling.is_frustum_culling_enabled()      ? " with frustum culling" :
+		                                                    " without culling";
+
+		if (forward_subpass && forward_subpass->is_instancing_enabled())
+		{
+			mode += " and instancing";
+		}
+
+		if (forward_subpass && forward_subpass->is_level_of_detail_enabled())
+		{
+			mode += " and levels of detail";
+		}
+	}
+
+	LOGI("{} instances in a {} hierarchy, {}: {:.3f} ms average frame time, {:.3f} ms world matrix update, {:.3f} ms culling, {} draws per frame over {} frames",
+	     instance_counts[last_instance_count_index], last_deep_hierarchy ? "deep" : "wide", mode,
+	     elapsed_time / elapsed_frames, elapsed_transform_time / elapsed_frames, elapsed_cull_time / elapsed_frames, elapsed_draws / elapsed_frames, elapsed_frames);
+
+	if (elapsed_triangles > 0)
+	{
+		LOGI("Triangles: {} submitted per frame", elapsed_triangles / elapsed_frames);
+	}
+
+	if (elapsed_clusters > 0)
+	{
+		LOGI("Clustered lighting: {} lights, {:.2f} lights per cluster, {:.3f} ms average assignment", light_counts[last_light_count_index],
+		     static_cast<double>(elapsed_light_indices) / elapsed_clusters, elapsed_light_cluster_time / elapsed_frames);
+	}
+
+	if (elapsed_animation_time > 0.0)
+	{
+		LOGI("Animation: {:.3f} ms average update, {:.0f} channels evaluated per ms", elapsed_animation_time / elapsed_frames,
+		     elapsed_animation_channels / elapsed_animation_time);
+	}
+
+	if (elapsed_skinning_time > 0.0)
+	{
+		LOGI("GPU skinning on the {} queue: {} vertices, {:.3f} ms average GPU time, {:.0f} vertices deformed per ms", last_async_skinning ? "async compute" : "graphics",
+		     elapsed_skinned_vertices / elapsed_frames, elapsed_skinning_time / elapsed_frames, elapsed_skinned_vertices / elapsed_skinning_time);
+	}
+
+	elapsed_time               = 0.0;
+	elapsed_transform_time     = 0.0;
+	elapsed_cull_time          = 0.0;
+	elapsed_draws              = 0;
+	elapsed_triangles          = 0;
+	elapsed_light_cluster_time = 0.0;
+	elapsed_light_indices      = 0;
+	elapsed_clusters           = 0;
+	elapsed_animation_time     = 0.0;
+	elapsed_animation_channels = 0;
+	elapsed_skinning_time      = 0.0;
+	elapsed_skinned_vertices   = 0;
+	elapsed_frames             = 0;
+}
+
+void GPUDrivenRendering::update(float delta_time)
+{
+	if (recording_thread_count != last_recording_thread_count)
+	{
+		log_frame_time();
+
+		if (forward_subpass)
+		{
+			forward_subpass->set_parallel_recording(&get_job_system(), recording_thread_count);
+		}
+
+		last_recording_thread_count = recording_thread_count;
+	}
+
+	if (async_skinning != last_async_skinning)
+	{
+		log_frame_time();
+
+		last_async_skinning = async_skinning;
+	}
+
+	// The skinning is created again with the scene
+	if (gpu_skinning)
+	{
+		gpu_skinning->set_async_compute(async_skinning);
+	}
+
+	if (instance_count_index != last_instance_count_index || gpu_driven_enabled != last_gpu_driven_enabled ||
+	    deep_hierarchy != last_deep_hierarchy || skinned != last_skinned || meshlets_enabled != last_meshlets_enabled ||
+	    mesh_shading != last_mesh_shading || light_count_index != last_light_count_index || clustered_lighting != last_clustered_lighting)
+	{
+		log_frame_time();
+
+		// The previous subpass may still have buffers in flight
+		get_device().wait_idle();
+
+		if (instance_count_index != last_instance_count_index || deep_hierarchy != last_deep_hierarchy || skinned != last_skinned ||
+		    light_count_index != last_light_count_index)
+		{
+			setup_scene();
+		}
+
+		update_pipeline();
+
+		last_instance_count_index = instance_count_index;
+		last_gpu_driven_enabled   = gpu_driven_enabled;
+		last_meshlets_enabled     = meshlets_enabled;
+		last_mesh_shading         = mesh_shading;
+		last_light_count_index    = light_count_index;
+		last_clustered_lighting   = clustered_lighting;
+		last_deep_hierarchy       = deep_hierarchy;
+		last_skinned              = skinned;
+	}
+
+	auto &culling = scene->get_visibility_culling();
+	if (frustum_culling != culling.is_frustum_culling_enabled() || occlusion_culling != culling.is_occlusion_culling_enabled() ||
+	    hierarchical_culling != culling.is_hierarchical_culling_enabled())
+	{
+		log_frame_time();
+
+		culling.set_frustum_culling(frustum_culling);
+		culling.set_occlusion_culling(occlusion_culling);
+		culling.set_hierarchical_culling(hierarchical_culling);
+	}
+
+	if (gpu_driven_subpass)
+	{
+		gpu_driven_subpass->set_dynamic_transforms(animated);
+	}
+
+	if (meshlet_subpass)
+	{
+		meshlet_subpass->set_dynamic_transforms(animated);
+	}
+
+	if (forward_subpass && instancing != forward_subpass->is_instancing_enabled())
+	{
+		log_frame_time();
+
+		forward_subpass->set_instancing(instancing);
+	}
+
+	if (forward_subpass && level_of_detail != forward_subpass->is_level_of_detail_enabled())
+	{
+		log_frame_time();
+
+		forward_subpass->set_level_of_detail(level_of_detail);
+	}
+
+	vkb::Timer timer;
+	timer.start();
+
+	if (animated)
+	{
+		vkb::Timer animation_timer;
+		animation_timer.start();
+
+		animation->update(delta_time, &get_job_system());
+
+		elapsed_animation_time += animation_timer.stop<vkb::Timer::Milliseconds>();
+		elapsed_animation_channels += animation->get_channel_count();
+	}
+
+	// Update the world matrices here to time it, the sample update then finds them up to date
+	vkb::Timer transform_timer;
+	transform_timer.start();
+
+	updated_transform_count = scene->get_transform_hierarchy().update(&get_job_system());
+
+	elapsed_transform_time += transform_timer.stop<vkb::Timer::Milliseconds>();
+
+	VulkanSample::update(delta_time);
+
+	elapsed_time += timer.stop<vkb::Timer::Milliseconds>();
+	elapsed_cull_time += culling.get_frame_stats().cull_time;
+	elapsed_draws += gpu_driven_subpass ? gpu_driven_subpass->get_indirect_draw_count() :
+	                 meshlet_subpass    ? meshlet_subpass->get_draw_count() :
+	                                      forward_subpass->get_draw_count();
+	elapsed_triangles += forward_subpass ? forward_subpass->get_triangle_count() : 0;
+
+	if (auto clustered = get_scene_subpass()->get_clustered_lighting())
+	{
+		elapsed_light_cluster_time += clustered->get_frame_stats().update_time;
+		elapsed_light_indices += clustered->get_frame_stats().light_index_count;
+		elapsed_clusters += clustered->get_frame_stats().cluster_count;
+	}
+
+	// The GPU time read back this frame belongs to an earlier frame of the same configuration
+	if (gpu_skinning)
+	{
+		elapsed_skinning_time += gpu_skinning->get_gpu_time();
+		elapsed_skinned_vertices += gpu_skinning->get_deformed_vertex_count();
+	}
+	elapsed_frames++;
+}
+
+void GPUDrivenRendering::draw_gui()
+{
+	const char *label              = supports_gpu_driven ? "GPU-driven" : "GPU-driven (unsupported by device)";
+	const char *mesh_shading_label = supports_mesh_shading ? "Mesh shading" : "Mesh shading (unsupported by device)";
+
+	gui->show_options_window(
+	    /* body = */ [this, label, mesh_shading_label]() {
+		    ImGui::Checkbox(label, &gpu_driven_enabled);
+		    ImGui::SameLine();
+		    ImGui::Checkbox("Meshlets", &meshlets_enabled);
+		    ImGui::SameLine();
+		    ImGui::Checkbox(mesh_shading_label, &mesh_shading);
+
+		    for (int i = 0; i < static_cast<int>(instance_counts.size()); ++i)
+		    {
+			    if (i > 0)
+			    {
+				    ImGui::SameLine();
+			    }
+			    ImGui::RadioButton(fmt::format("{}", instance_counts[i]).c_str(), &instance_count_index, i);
+		    }
+
+		    ImGui::Checkbox("Deep hierarchy", &deep_hierarchy);
+		    ImGui::SameLine();
+		    ImGui::Checkbox("Animated", &animated);
+		    ImGui::SameLine();
+		    ImGui::Checkbox("Skinned", &skinned);
+		    ImGui::SameLine();
+		    ImGui::Checkbox("Async compute", &async_skinning);
+
+		    ImGui::Text("Lights:");
+		    for (int i = 0; i < static_cast<int>(light_counts.size()); ++i)
+		    {
+			    ImGui::SameLine();
+			    ImGui::RadioButton(i == 0 ? "Scene" : fmt::format("{}", light_counts[i]).c_str(), &light_count_index, i);
+		    }
+		    ImGui::SameLine();
+		    ImGui::Checkbox("Clustered", &clustered_lighting);
+
+		    if (forward_subpass)
+		    {
+			    ImGui::SliderInt("Recording threads", &recording_thread_count, 0, max_recording_thread_count);
+
+			    ImGui::Checkbox("Frustum culling", &frustum_culling);
+			    ImGui::SameLine();
+			    ImGui::Checkbox("BVH", &hierarchical_culling);
+			    ImGui::SameLine();
+			    ImGui::Checkbox("Occlusion culling", &occlusion_culling);
+			    ImGui::SameLine();
+			    ImGui::Checkbox("Instancing", &instancing);
+			    ImGui::SameLine();
+			    ImGui::Checkbox("LOD", &level_of_detail);
+		    }
+
+		    if (gpu_driven_subpass)
+		    {
+			    ImGui::Text("Instances: %u, indirect draws: %u", gpu_driven_subpass->get_instance_count(), gpu_driven_subpass->get_indirect_draw_count());
+		    }
+		    else if (meshlet_subpass)
+		    {
+			    ImGui::Text("Instances: %u, meshlets: %u, draws: %u", instance_counts[last_instance_count_index], meshlet_subpass->get_meshlet_count(),
+			                meshlet_subpass->get_draw_count());
+		    }
+		    else
+		    {
+			    auto frame_stats = scene->get_visibility_culling().get_frame_stats();
+			    ImGui::Text("Instances: %u, visible: %u, draws: %u, frustum culled: %u, occluded: %u", instance_counts[last_instance_count_index],
+			                frame_stats.visible_count, forward_subpass->get_draw_count(), frame_stats.frustum_culled_count, frame_stats.occluded_count);
+			    ImGui::Text("Triangles: %llu", static_cast<unsigned long long>(forward_subpass->get_triangle_count()));
+		    }
+
+		    if (auto clustered = get_scene_subpass()->get_clustered_lighting())
+		    {
+			    auto &stats = clustered->get_frame_stats();
+			    ImGui::Text("Clustered lights: %u, clusters: %u, light indices: %u, assignment: %.3f ms", stats.light_count, stats.cluster_count,
+			                stats.light_index_count, stats.update_time);
+		    }
+
+		    auto &hierarchy = scene->get_transform_hierarchy();
+		    ImGui::Text("World matrices updated: %u, hierarchy depth: %u, animation channels: %u", updated_transform_count, hierarchy.get_depth(),
+		                animated ? animation->get_channel_count() : 0);
+
+		    if (gpu_skinning && gpu_skinning->get_deformed_submesh_count() > 0)
+		    {
+			    ImGui::Text("Skinned submeshes: %u, vertices: %u, GPU time: %.3f ms", gpu_skinning->get_deformed_submesh_count(),
+			                gpu_skinning->get_deformed_vertex_count(), gpu_skinning->get_gpu_time());
+		    }
+
+		    // The BVH is only kept up to date by the culling
+		    if (forward_subpass && frustum_culling && hierarchical_culling)
+		    {
+			    auto &bounding_volume_hierarchy = scene->get_bounding_volume_hierarchy();
+			    auto  picked_node               = free_camera ? free_camera->pick(bounding_volume_hierarchy) : nullptr;
+			    ImGui::Text("BVH nodes: %u, depth: %u, under the cursor: %s", bounding_volume_hierarchy.get_node_count(),
+			                bounding_volume_hierarchy.get_depth(), picked_node ? picked_node->get_name().c_str() : "nothing");
+		    }
+	    },
+	    /* lines = */ 11);
+}
+
+std::unique_ptr<vkb::VulkanSample> create_gpu_driven_rendering()
+{
+	return std::make_unique<GPUDrivenRendering>();
+}
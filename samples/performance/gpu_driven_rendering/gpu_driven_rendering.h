@@ -0,0 +1,196 @@
+/* Copyright (c) 2023, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "rendering/subpasses/forward_subpass.h"
+#include "rendering/subpasses/gpu_driven_subpass.h"
+#include "rendering/subpasses/meshlet_subpass.h"
+#include "scene_graph/components/camera.h"
+#include "scene_graph/components/mesh.h"
+#include "scene_graph/scripts/animation.h"
+#include "scene_graph/scripts/free_camera.h"
+#include "vulkan_sample.h"
+
+/**
+ * @brief Rendering a large number of scene graph instances with GPU culling and indirect draws,
+ *        compared to one CPU recorded draw per instance
+ */
+class GPUDrivenRendering : public vkb::VulkanSample
+{
+  public:
+	GPUDrivenRendering();
+
+	virtual ~GPUDrivenRendering();
+
+	virtual bool prepare(vkb::Platform &platform) override;
+
+	virtual void update(float delta_time) override;
+
+	virtual void request_gpu_features(vkb::PhysicalDevice &gpu) override;
+
+	virtual void prepare_render_context() override;
+
+  private:
+	vkb::sg::Camera *camera{nullptr};
+
+	vkb::sg::FreeCamera *free_camera{nullptr};
+
+	vkb::GPUDrivenSubpass *gpu_driven_subpass{nullptr};
+
+	vkb::ForwardSubpass *forward_subpass{nullptr};
+
+	vkb::MeshletSubpass *meshlet_subpass{nullptr};
+
+	virtual void draw_gui() override;
+
+	void setup_scene();
+
+	/**
+	 * @brief Skins the first nodes of the teapot mesh with two joints each, the upper one bending the top half of the teapot
+	 */
+	void add_teapot_skins(vkb::sg::Mesh &teapot_mesh, uint32_t skinned_count);
+
+	/**
+	 * @brief Scatters point lights of random colors among the instances
+	 */
+	void add_lights(uint32_t light_count, float extent);
+
+	/**
+	 * @return The subpass drawing the scene, whichever path it takes
+	 */
+	vkb::ForwardSubpass *get_scene_subpass() const;
+
+	void update_pipeline();
+
+	void log_frame_time();
+
+	int instance_count_index{0};
+
+	int last_instance_count_index{0};
+
+	bool gpu_driven_enabled{true};
+
+	bool last_gpu_driven_enabled{true};
+
+	bool supports_gpu_driven{false};
+
+	// Whether the scene is drawn as GPU culled meshlets, rather than whole submeshes
+	bool meshlets_enabled{false};
+
+	bool last_meshlets_enabled{false};
+
+	// Whether the meshlets are drawn with task and mesh shaders, or with indirect draws of the vertex pipeline
+	bool mesh_shading{true};
+
+	bool last_mesh_shading{true};
+
+	bool supports_mesh_shading{false};
+
+	// Threads recording the forward subpass into secondary command buffers, zero to record inline
+	int recording_thread_count{0};
+
+	int last_recording_thread_count{0};
+
+	int max_recording_thread_count{1};
+
+	// Whether the instances are children of the root node, or chained under each other
+	bool deep_hierarchy{false};
+
+	bool last_deep_hierarchy{false};
+
+	// Whether the instances, or the first node of each chain in a deep hierarchy, rotate every frame
+	bool animated{false};
+
+	// Whether the teapot mesh is bent by a procedural two-joint skin, deformed on the GPU
+	bool skinned{false};
+
+	bool last_skinned{false};
+
+	// Whether the skinning is dispatched on the async compute queue, overlapping with the graphics work
+	bool async_skinning{false};
+
+	bool last_async_skinning{false};
+
+	// Culling of the instances drawn by the ForwardSubpass, the GPU-driven subpass culls on the GPU
+	bool frustum_culling{true};
+
+	bool occlusion_culling{false};
+
+	// Whether the frustum is tested against the scene BVH rather than every instance
+	bool hierarchical_culling{false};
+
+	// Whether the ForwardSubpass draws the instances of each submesh with a single instanced draw
+	bool instancing{false};
+
+	// Whether the ForwardSubpass draws each instance at the level of detail matching its size on screen
+	bool level_of_detail{false};
+
+	int light_count_index{0};
+
+	int last_light_count_index{0};
+
+	// Whether the point and spot lights are assigned to clusters of the view, always the case above MAX_FORWARD_LIGHT_COUNT lights
+	bool clustered_lighting{false};
+
+	bool last_clustered_lighting{false};
+
+	// Rotation of the animated instances, sampled from keyframes
+	std::unique_ptr<vkb::sg::Animation> animation;
+
+	// Transforms updated by the last scene transform hierarchy update
+	uint32_t updated_transform_count{0};
+
+	// Accumulated frame time of the current configuration, in milliseconds
+	double elapsed_time{0.0};
+
+	uint32_t elapsed_frames{0};
+
+	// Accumulated time of the world matrix updates of the current configuration, in milliseconds
+	double elapsed_transform_time{0.0};
+
+	// Accumulated time of the CPU culling of the current configuration, in milliseconds
+	double elapsed_cull_time{0.0};
+
+	// Accumulated number of draw calls recorded in the current configuration
+	uint64_t elapsed_draws{0};
+
+	// Accumulated number of triangles drawn by the ForwardSubpass in the current configuration
+	uint64_t elapsed_triangles{0};
+
+	// Accumulated time of the light cluster assignment of the current configuration, in milliseconds
+	double elapsed_light_cluster_time{0.0};
+
+	// Accumulated number of light indices over all the clusters in the current configuration
+	uint64_t elapsed_light_indices{0};
+
+	uint64_t elapsed_clusters{0};
+
+	// Accumulated time of the animation sampling of the current configuration, in milliseconds
+	double elapsed_animation_time{0.0};
+
+	// Accumulated number of animation channels sampled in the current configuration
+	uint64_t elapsed_animation_channels{0};
+
+	// Accumulated GPU time of the skinning dispatches of the current configuration, in milliseconds
+	double elapsed_skinning_time{0.0};
+
+	// Accumulated number of vertices deformed in the current configuration
+	uint64_t elapsed_skinned_vertices{0};
+};
+
+std::unique_ptr<vkb::VulkanSample> create_gpu_driven_rendering();
@@ -304,7 +304,7 @@ bool MultiDrawIndirect::prepare(vkb::Platform &platform)
 void MultiDrawIndirect::load_scene()
 {
 	assert(!!device);
-	vkb::GLTFLoader   loader{*device};
+	vkb::GLTFLoader   loader{*device, &get_job_system()};
 	const std::string scene_path = "scenes/vokselia/";
 	auto              scene      = loader.read_scene_from_file(scene_path + "vokselia.gltf");
 
@@ -37,6 +37,9 @@ MultithreadingRenderPasses::MultithreadingRenderPasses()
 	config.insert<vkb::IntSetting>(1, multithreading_mode, 1);
 
 	config.insert<vkb::IntSetting>(2, multithreading_mode, 2);
+
+	config.insert<vkb::IntSetting>(3, multithreading_mode, 0);
+	config.insert<vkb::BoolSetting>(3, shadow_caching, true);
 }
 
 bool MultithreadingRenderPasses::prepare(vkb::Platform &platform)
@@ -46,25 +49,10 @@ bool MultithreadingRenderPasses::prepare(vkb::Platform &platform)
 		return false;
 	}
 
-	shadow_render_targets.resize(get_render_context().get_render_frames().size());
-	for (uint32_t i = 0; i < shadow_render_targets.size(); i++)
-	{
-		shadow_render_targets[i] = create_shadow_render_target(SHADOWMAP_RESOLUTION);
-	}
-
 	load_scene("scenes/bonza/Bonza4X.gltf");
 
 	scene->clear_components<vkb::sg::Light>();
-	auto &light           = vkb::add_directional_light(*scene, glm::quat({glm::radians(-30.0f), glm::radians(175.0f), glm::radians(0.0f)}));
-	auto &light_transform = light.get_node()->get_transform();
-	light_transform.set_translation(glm::vec3(-50, 0, 0));
-
-	// Attach a camera component to the light node
-	auto shadowmap_camera_ptr = std::make_unique<vkb::sg::OrthographicCamera>("shadowmap_camera", -100.0f, 100.0f, -100.0f, 100.0f, -139.0f, 120.0f);
-	shadowmap_camera_ptr->set_node(*light.get_node());
-	shadowmap_camera = shadowmap_camera_ptr.get();
-	light.get_node()->set_component(*shadowmap_camera_ptr);
-	scene->add_component(std::move(shadowmap_camera_ptr));
+	shadow_light = &vkb::add_directional_light(*scene, glm::quat({glm::radians(-30.0f), glm::radians(175.0f), glm::radians(0.0f)}));
 
 	// Attach a move script to the camera component in the scene
 	auto &camera_node = vkb::add_free_camera(*scene, "main_camera", get_render_context().get_surface_extent());
@@ -82,24 +70,8 @@ bool MultithreadingRenderPasses::prepare(vkb::Platform &platform)
 
 void MultithreadingRenderPasses::prepare_render_context()
 {
-	get_render_context().prepare(2);
-}
-
-std::unique_ptr<vkb::RenderTarget> MultithreadingRenderPasses::create_shadow_render_target(uint32_t size)
-{
-	VkExtent3D extent{size, size, 1};
-
-	vkb::core::Image depth_image{*device,
-	                             extent,
-	                             vkb::get_suitable_depth_format(device->get_gpu().get_handle()),
-	                             VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
-	                             VMA_MEMORY_USAGE_GPU_ONLY};
-
-	std::vector<vkb::core::Image> images;
-
-	images.push_back(std::move(depth_image));
-
-	return std::make_unique<vkb::RenderTarget>(std::move(images));
+	// The shadow pass is recorded with the pools of the job system thread running it
+	get_render_context().prepare(get_job_system().get_thread_count());
 }
 
 std::unique_ptr<vkb::RenderPipeline> MultithreadingRenderPasses::create_shadow_renderpass()
@@ -107,13 +79,17 @@ std::unique_ptr<vkb::RenderPipeline> MultithreadingRenderPasses::create_shadow_r
 	// Shadowmap subpass
 	auto shadowmap_vs  = vkb::ShaderSource{"shadows/shadowmap.vert"};
 	auto shadowmap_fs  = vkb::ShaderSource{"shadows/shadowmap.frag"};
-	auto scene_subpass = std::make_unique<ShadowSubpass>(get_render_context(), std::move(shadowmap_vs), std::move(shadowmap_fs), *scene, *shadowmap_camera);
+	auto scene_subpass = std::make_unique<vkb::ShadowSubpass>(get_render_context(), std::move(shadowmap_vs), std::move(shadowmap_fs), *scene, *camera,
+	                                                          SHADOW_ATLAS_RESOLUTION, SHADOW_TILE_RESOLUTION);
+	scene_subpass->add_light(*shadow_light, SHADOW_CASCADE_COUNT);
+	scene_subpass->set_shadow_distance(250.0f);
 
 	shadow_subpass = scene_subpass.get();
 
-	// Shadowmap pipeline
+	// Shadowmap pipeline, the atlas is loaded to keep the tiles which are not rendered again
 	auto shadowmap_render_pipeline = std::make_unique<vkb::RenderPipeline>();
 	shadowmap_render_pipeline->add_subpass(std::move(scene_subpass));
+	shadowmap_render_pipeline->set_load_store({{VK_ATTACHMENT_LOAD_OP_LOAD, VK_ATTACHMENT_STORE_OP_STORE}});
 
 	return shadowmap_render_pipeline;
 }
@@ -123,7 +99,7 @@ std::unique_ptr<vkb::RenderPipeline> MultithreadingRenderPasses::create_main_ren
 	// Main subpass
 	auto main_vs       = vkb::ShaderSource{"shadows/main.vert"};
 	auto main_fs       = vkb::ShaderSource{"shadows/main.frag"};
-	auto scene_subpass = std::make_unique<MainSubpass>(get_render_context(), std::move(main_vs), std::move(main_fs), *scene, *camera, *shadowmap_camera, shadow_render_targets);
+	auto scene_subpass = std::make_unique<MainSubpass>(get_render_context(), std::move(main_vs), std::move(main_fs), *scene, *camera, *shadow_subpass, *shadow_light);
 
 	// Main pipeline
 	auto main_render_pipeline = std::make_unique<vkb::RenderPipeline>();
@@ -140,6 +116,10 @@ void MultithreadingRenderPasses::update(float delta_time)
 
 	update_gui(delta_time);
 
+	// Tiles are placed before the recording, which may run on several threads
+	shadow_subpass->set_caching(shadow_caching);
+	shadow_subpass->update_tiles();
+
 	auto &main_command_buffer = render_context->begin();
 
 	auto command_buffers = record_command_buffers(main_command_buffer);
@@ -150,10 +130,12 @@ void MultithreadingRenderPasses::update(float delta_time)
 void MultithreadingRenderPasses::draw_gui()
 {
 	const bool landscape = reinterpret_cast<vkb::sg::PerspectiveCamera *>(camera)->get_aspect_ratio() > 1.0f;
-	uint32_t   lines     = landscape ? 2 : 4;
+	uint32_t   lines     = landscape ? 4 : 6;
+
+	auto &shadow_stats = shadow_subpass->get_stats();
 
 	gui->show_options_window(
-	    [this, landscape]() {
+	    [this, landscape, &shadow_stats]() {
 		    ImGui::AlignTextToFramePadding();
 		    ImGui::PushItemWidth(ImGui::GetWindowWidth() * 0.4f);
 
@@ -169,6 +151,10 @@ void MultithreadingRenderPasses::draw_gui()
 			    ImGui::SameLine();
 		    }
 		    ImGui::RadioButton("Secondary Buffers", &multithreading_mode, static_cast<int>(MultithreadingMode::SecondaryCommandBuffers));
+
+		    ImGui::Checkbox("Cache shadows", &shadow_caching);
+		    ImGui::Text("Shadow tiles rendered: %u/%u, draws: %u, %.1f MB written, %.1f MB saved", shadow_stats.rendered_tile_count, shadow_stats.tile_count,
+		                shadow_stats.draw_count, shadow_stats.written_bytes / (1024.0 * 1024.0), shadow_stats.saved_bytes / (1024.0 * 1024.0));
 	    },
 	    lines);
 }
@@ -180,14 +166,8 @@ std::vector<vkb::CommandBuffer *> MultithreadingRenderPasses::record_command_buf
 
 	std::vector<vkb::CommandBuffer *> command_buffers;
 
-	// Resources are requested from pools for thread #1 in shadow pass if multithreading is used
-	auto use_multithreading = multithreading_mode != static_cast<int>(MultithreadingMode::None);
-	shadow_subpass->set_thread_index(use_multithreading ? 1 : 0);
-
-	if (use_multithreading && thread_pool.size() < 1)
-	{
-		thread_pool.resize(1);
-	}
+	// Resources are requested from the pools of the main thread, unless the shadow pass is recorded by a job
+	shadow_subpass->set_thread_index(0);
 
 	switch (multithreading_mode)
 	{
@@ -214,18 +194,20 @@ void MultithreadingRenderPasses::record_separate_primary_command_buffers(std::ve
 	auto        reset_mode = vkb::CommandBuffer::ResetMode::ResetPool;
 	const auto &queue      = device->get_queue_by_flags(VK_QUEUE_GRAPHICS_BIT, 0);
 
-	// Shadow pass will be recorded in thread with id 1
-	auto &shadow_command_buffer = render_context->get_active_frame().request_command_buffer(queue,
-	                                                                                        reset_mode,
-	                                                                                        VK_COMMAND_BUFFER_LEVEL_PRIMARY,
-	                                                                                        1);
-
-	// Recording shadow command buffer
-	auto shadow_buffer_future = thread_pool.push(
-	    [this, &shadow_command_buffer](size_t thread_id) {
-		    shadow_command_buffer.begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
-		    draw_shadow_pass(shadow_command_buffer);
-		    shadow_command_buffer.end();
+	vkb::CommandBuffer *shadow_command_buffer = nullptr;
+
+	// Recording shadow command buffer, with the pools of the thread the job runs on
+	auto shadow_buffer_job = get_job_system().submit(
+	    [this, &shadow_command_buffer, &queue, reset_mode](uint32_t thread_index) {
+		    shadow_command_buffer = &render_context->get_active_frame().request_command_buffer(queue,
+		                                                                                        reset_mode,
+		                                                                                        VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+		                                                                                        thread_index);
+		    shadow_subpass->set_thread_index(thread_index);
+
+		    shadow_command_buffer->begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+		    draw_shadow_pass(*shadow_command_buffer);
+		    shadow_command_buffer->end();
 	    });
 
 	// Recording scene command buffer
@@ -233,11 +215,11 @@ void MultithreadingRenderPasses::record_separate_primary_command_buffers(std::ve
 	draw_main_pass(main_command_buffer);
 	main_command_buffer.end();
 
-	command_buffers.push_back(&shadow_command_buffer);
-	command_buffers.push_back(&main_command_buffer);
-
 	// Wait for recording
-	shadow_buffer_future.get();
+	get_job_system().wait(shadow_buffer_job);
+
+	command_buffers.push_back(shadow_command_buffer);
+	command_buffers.push_back(&main_command_buffer);
 }
 
 void MultithreadingRenderPasses::record_separate_secondary_command_buffers(std::vector<vkb::CommandBuffer *> &command_buffers, vkb::CommandBuffer &main_command_buffer)
@@ -251,15 +233,9 @@ void MultithreadingRenderPasses::record_separate_secondary_command_buffers(std::
 	                                                                                       VK_COMMAND_BUFFER_LEVEL_SECONDARY,
 	                                                                                       0);
 
-	// Shadow pass will be recorded in thread with id 1
-	auto &shadow_command_buffer = render_context->get_active_frame().request_command_buffer(queue,
-	                                                                                        reset_mode,
-	                                                                                        VK_COMMAND_BUFFER_LEVEL_SECONDARY,
-	                                                                                        1);
-
 	// Same framebuffer and render pass should be specified in the inheritance info for secondary command buffers
 	// and vkCmdBeginRenderPass for primary command buffers
-	auto &shadow_render_target = *shadow_render_targets[render_context->get_active_frame_index()];
+	auto &shadow_render_target = shadow_subpass->get_atlas();
 	auto &shadow_render_pass   = main_command_buffer.get_render_pass(shadow_render_target, shadow_render_pipeline->get_load_store(), shadow_render_pipeline->get_subpasses());
 	auto &shadow_framebuffer   = get_device().get_resource_cache().request_framebuffer(shadow_render_target, shadow_render_pass);
 
@@ -267,12 +243,20 @@ void MultithreadingRenderPasses::record_separate_secondary_command_buffers(std::
 	auto &scene_render_pass   = main_command_buffer.get_render_pass(scene_render_target, main_render_pipeline->get_load_store(), main_render_pipeline->get_subpasses());
 	auto &scene_framebuffer   = get_device().get_resource_cache().request_framebuffer(scene_render_target, scene_render_pass);
 
-	// Recording shadow command buffer
-	auto shadow_buffer_future = thread_pool.push(
-	    [this, &shadow_command_buffer, &shadow_render_pass, &shadow_framebuffer](size_t thread_id) {
-		    shadow_command_buffer.begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT, &shadow_render_pass, &shadow_framebuffer, 0);
-		    draw_shadow_pass(shadow_command_buffer);
-		    shadow_command_buffer.end();
+	vkb::CommandBuffer *shadow_command_buffer = nullptr;
+
+	// Recording shadow command buffer, with the pools of the thread the job runs on
+	auto shadow_buffer_job = get_job_system().submit(
+	    [this, &shadow_command_buffer, &queue, reset_mode, &shadow_render_pass, &shadow_framebuffer](uint32_t thread_index) {
+		    shadow_command_buffer = &render_context->get_active_frame().request_command_buffer(queue,
+		                                                                                        reset_mode,
+		                                                                                        VK_COMMAND_BUFFER_LEVEL_SECONDARY,
+		                                                                                        thread_index);
+		    shadow_subpass->set_thread_index(thread_index);
+
+		    shadow_command_buffer->begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT, &shadow_render_pass, &shadow_framebuffer, 0);
+		    draw_shadow_pass(*shadow_command_buffer);
+		    shadow_command_buffer->end();
 	    });
 
 	// Recording scene command buffer
@@ -285,15 +269,15 @@ void MultithreadingRenderPasses::record_separate_secondary_command_buffers(std::
 	scene_command_buffer.end();
 
 	// Wait for recording
-	shadow_buffer_future.get();
+	get_job_system().wait(shadow_buffer_job);
 
 	// Recording main command buffer
 	main_command_buffer.begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
 
-	record_shadow_pass_image_memory_barrier(main_command_buffer);
+	shadow_subpass->record_atlas_write_barrier(main_command_buffer);
 
 	main_command_buffer.begin_render_pass(shadow_render_target, shadow_render_pass, shadow_framebuffer, shadow_render_pipeline->get_clear_value(), VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
-	main_command_buffer.execute_commands(shadow_command_buffer);
+	main_command_buffer.execute_commands(*shadow_command_buffer);
 	main_command_buffer.end_render_pass();
 
 	record_main_pass_image_memory_barriers(main_command_buffer);
@@ -339,36 +323,7 @@ void MultithreadingRenderPasses::record_main_pass_image_memory_barriers(vkb::Com
 		command_buffer.image_memory_barrier(views[depth_attachment_index], memory_barrier);
 	}
 
-	{
-		assert(shadowmap_attachment_index < shadow_render_targets[render_context->get_active_frame_index()]->get_views().size());
-		auto &shadowmap = shadow_render_targets[render_context->get_active_frame_index()]->get_views()[shadowmap_attachment_index];
-
-		vkb::ImageMemoryBarrier memory_barrier{};
-		memory_barrier.old_layout      = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
-		memory_barrier.new_layout      = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-		memory_barrier.src_access_mask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
-		memory_barrier.dst_access_mask = VK_ACCESS_SHADER_READ_BIT;
-		memory_barrier.src_stage_mask  = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
-		memory_barrier.dst_stage_mask  = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
-
-		command_buffer.image_memory_barrier(shadowmap, memory_barrier);
-	}
-}
-
-void MultithreadingRenderPasses::record_shadow_pass_image_memory_barrier(vkb::CommandBuffer &command_buffer)
-{
-	assert(shadowmap_attachment_index < shadow_render_targets[render_context->get_active_frame_index()]->get_views().size());
-	auto &shadowmap = shadow_render_targets[render_context->get_active_frame_index()]->get_views()[shadowmap_attachment_index];
-
-	vkb::ImageMemoryBarrier memory_barrier{};
-	memory_barrier.old_layout      = VK_IMAGE_LAYOUT_UNDEFINED;
-	memory_barrier.new_layout      = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
-	memory_barrier.src_access_mask = 0;
-	memory_barrier.dst_access_mask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
-	memory_barrier.src_stage_mask  = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
-	memory_barrier.dst_stage_mask  = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
-
-	command_buffer.image_memory_barrier(shadowmap, memory_barrier);
+	shadow_subpass->record_atlas_read_barrier(command_buffer);
 }
 
 void MultithreadingRenderPasses::record_present_image_memory_barrier(vkb::CommandBuffer &command_buffer)
@@ -388,7 +343,7 @@ void MultithreadingRenderPasses::record_present_image_memory_barrier(vkb::Comman
 
 void MultithreadingRenderPasses::draw_shadow_pass(vkb::CommandBuffer &command_buffer)
 {
-	auto &shadow_render_target = *shadow_render_targets[get_render_context().get_active_frame_index()];
+	auto &shadow_render_target = shadow_subpass->get_atlas();
 	auto &shadowmap_extent     = shadow_render_target.get_extent();
 
 	set_viewport_and_scissor(command_buffer, shadowmap_extent);
@@ -399,7 +354,7 @@ void MultithreadingRenderPasses::draw_shadow_pass(vkb::CommandBuffer &command_bu
 	}
 	else
 	{
-		record_shadow_pass_image_memory_barrier(command_buffer);
+		shadow_subpass->record_atlas_write_barrier(command_buffer);
 		shadow_render_pipeline->draw(command_buffer, shadow_render_target);
 		command_buffer.end_render_pass();
 	}
@@ -441,10 +396,10 @@ MultithreadingRenderPasses::MainSubpass::MainSubpass(vkb::RenderContext
                                                      vkb::ShaderSource                              &&fragment_source,
                                                      vkb::sg::Scene                                  &scene,
                                                      vkb::sg::Camera                                 &camera,
-                                                     vkb::sg::Camera                                 &shadowmap_camera,
-                                                     std::vector<std::unique_ptr<vkb::RenderTarget>> &shadow_render_targets) :
-    shadowmap_camera{shadowmap_camera},
-    shadow_render_targets{shadow_render_targets},
+                                                     vkb::ShadowSubpass                              &shadow_subpass,
+                                                     vkb::sg::Light                                  &shadow_light) :
+    shadow_subpass{shadow_subpass},
+    shadow_light{shadow_light},
     vkb::ForwardSubpass{render_context, std::move(vertex_source), std::move(fragment_source), scene, camera}
 {
 }
@@ -472,15 +427,22 @@ void MultithreadingRenderPasses::MainSubpass::prepare()
 void MultithreadingRenderPasses::MainSubpass::draw(vkb::CommandBuffer &command_buffer)
 {
 	ShadowUniform shadow_uniform;
-	shadow_uniform.shadowmap_projection_matrix = vkb::vulkan_style_projection(shadowmap_camera.get_projection()) * shadowmap_camera.get_view();
 
-	auto &shadow_render_target = *shadow_render_targets[get_render_context().get_active_frame_index()];
-	// Bind the shadowmap texture to the proper set nd binding in shader
+	auto shadow_views = shadow_subpass.get_shadow_views(shadow_light);
+	assert(shadow_views.size() == SHADOW_CASCADE_COUNT);
+	for (size_t i = 0; i < shadow_views.size(); ++i)
+	{
+		shadow_uniform.light_matrices[i] = shadow_views[i].light_matrix;
+		shadow_uniform.atlas_rects[i]    = shadow_views[i].atlas_rect;
+	}
+
+	auto &shadow_render_target = shadow_subpass.get_atlas();
+	// Bind the shadow atlas texture to the proper set nd binding in shader
 	assert(!shadow_render_target.get_views().empty());
 	command_buffer.bind_image(shadow_render_target.get_views()[0], *shadowmap_sampler, 0, 5, 0);
 
 	auto                 &render_frame  = get_render_context().get_active_frame();
-	vkb::BufferAllocation shadow_buffer = render_frame.allocate_buffer(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, sizeof(glm::mat4));
+	vkb::BufferAllocation shadow_buffer = render_frame.allocate_buffer(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, sizeof(ShadowUniform));
 	shadow_buffer.update(shadow_uniform);
 	// Bind the shadowmap uniform to the proper set nd binding in shader
 	command_buffer.bind_buffer(shadow_buffer.get_buffer(), shadow_buffer.get_offset(), shadow_buffer.get_size(), 0, 6, 0);
@@ -488,54 +450,6 @@ void MultithreadingRenderPasses::MainSubpass::draw(vkb::CommandBuffer &command_b
 	ForwardSubpass::draw(command_buffer);
 }
 
-MultithreadingRenderPasses::ShadowSubpass::ShadowSubpass(vkb::RenderContext &render_context,
-                                                         vkb::ShaderSource &&vertex_source,
-                                                         vkb::ShaderSource &&fragment_source,
-                                                         vkb::sg::Scene     &scene,
-                                                         vkb::sg::Camera    &camera) :
-    vkb::GeometrySubpass{render_context, std::move(vertex_source), std::move(fragment_source), scene, camera}
-{
-}
-
-void MultithreadingRenderPasses::ShadowSubpass::prepare_pipeline_state(vkb::CommandBuffer &command_buffer, VkFrontFace front_face, bool double_sided_material)
-{
-	// Enabling depth bias to get rid of self-shadowing artifacts
-	// Depth bias leterally "pushes" slightly all the primitives further away from the camera taking their slope into account
-	// It helps to avoid precision related problems while doing depth comparisons in the final pass
-	vkb::RasterizationState rasterization_state{};
-	rasterization_state.front_face        = front_face;
-	rasterization_state.depth_bias_enable = VK_TRUE;
-
-	if (double_sided_material)
-	{
-		rasterization_state.cull_mode = VK_CULL_MODE_NONE;
-	}
-
-	command_buffer.set_rasterization_state(rasterization_state);
-	command_buffer.set_depth_bias(-1.4f, 0.0f, -1.7f);
-
-	vkb::MultisampleState multisample_state{};
-	multisample_state.rasterization_samples = sample_count;
-	command_buffer.set_multisample_state(multisample_state);
-}
-
-vkb::PipelineLayout &MultithreadingRenderPasses::ShadowSubpass::prepare_pipeline_layout(vkb::CommandBuffer &command_buffer, const std::vector<vkb::ShaderModule *> &shader_modules)
-{
-	// Only vertex shader is needed in the shadow subpass
-	assert(!shader_modules.empty());
-	auto vertex_shader_module = shader_modules[0];
-
-	vertex_shader_module->set_resource_mode("GlobalUniform", vkb::ShaderResourceMode::Dynamic);
-
-	return command_buffer.get_device().get_resource_cache().request_pipeline_layout({vertex_shader_module});
-}
-
-void MultithreadingRenderPasses::ShadowSubpass::prepare_push_constants(vkb::CommandBuffer &command_buffer, vkb::sg::SubMesh &sub_mesh)
-{
-	// No push constants are used the in shadow pass
-	return;
-}
-
 std::unique_ptr<vkb::VulkanSample> create_multithreading_render_passes()
 {
 	return std::make_unique<MultithreadingRenderPasses>();
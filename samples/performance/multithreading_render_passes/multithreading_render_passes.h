@@ -17,17 +17,21 @@
 
 #pragma once
 
-#include <ctpl_stl.h>
-
 #include "core/command_buffer.h"
 #include "rendering/render_pipeline.h"
 #include "rendering/subpasses/forward_subpass.h"
+#include "rendering/subpasses/shadow_subpass.h"
 #include "scene_graph/components/camera.h"
 #include "vulkan_sample.h"
 
+// Cascades of the directional light, must match main.frag
+constexpr uint32_t SHADOW_CASCADE_COUNT = 3;
+
 struct alignas(16) ShadowUniform
 {
-	glm::mat4 shadowmap_projection_matrix;        // Projection matrix used to render shadowmap
+	glm::mat4 light_matrices[SHADOW_CASCADE_COUNT];        // Matrices used to render the cascades, from the closest to the camera
+
+	glm::vec4 atlas_rects[SHADOW_CASCADE_COUNT];        // Placement of the cascades in the shadow atlas
 };
 
 /**
@@ -55,26 +59,6 @@ class MultithreadingRenderPasses : public vkb::VulkanSample
 
 	void draw_gui() override;
 
-	/**
-     * @brief This subpass is responsible for rendering a shadowmap
-     */
-	class ShadowSubpass : public vkb::GeometrySubpass
-	{
-	  public:
-		ShadowSubpass(vkb::RenderContext &render_context,
-		              vkb::ShaderSource &&vertex_source,
-		              vkb::ShaderSource &&fragment_source,
-		              vkb::sg::Scene &    scene,
-		              vkb::sg::Camera &   camera);
-
-	  protected:
-		virtual void prepare_pipeline_state(vkb::CommandBuffer &command_buffer, VkFrontFace front_face, bool double_sided_material) override;
-
-		virtual vkb::PipelineLayout &prepare_pipeline_layout(vkb::CommandBuffer &command_buffer, const std::vector<vkb::ShaderModule *> &shader_modules) override;
-
-		virtual void prepare_push_constants(vkb::CommandBuffer &command_buffer, vkb::sg::SubMesh &sub_mesh) override;
-	};
-
 	/**
      * @brief This subpass is responsible for rendering a Scene
      *		  It implements a custom draw function which passes shadowmap and light matrix
@@ -87,8 +71,8 @@ class MultithreadingRenderPasses : public vkb::VulkanSample
 		            vkb::ShaderSource &&                             fragment_source,
 		            vkb::sg::Scene &                                 scene,
 		            vkb::sg::Camera &                                camera,
-		            vkb::sg::Camera &                                shadowmap_camera,
-		            std::vector<std::unique_ptr<vkb::RenderTarget>> &shadow_render_targets);
+		            vkb::ShadowSubpass &                             shadow_subpass,
+		            vkb::sg::Light &                                 shadow_light);
 
 		virtual void prepare() override;
 
@@ -97,16 +81,14 @@ class MultithreadingRenderPasses : public vkb::VulkanSample
 	  private:
 		std::unique_ptr<vkb::core::Sampler> shadowmap_sampler{};
 
-		vkb::sg::Camera &shadowmap_camera;
+		vkb::ShadowSubpass &shadow_subpass;
 
-		std::vector<std::unique_ptr<vkb::RenderTarget>> &shadow_render_targets;
+		vkb::sg::Light &shadow_light;
 	};
 
   private:
 	virtual void prepare_render_context() override;
 
-	std::unique_ptr<vkb::RenderTarget> create_shadow_render_target(uint32_t size);
-
 	/**
      * @return Shadow render pass which should run first
      */
@@ -117,9 +99,9 @@ class MultithreadingRenderPasses : public vkb::VulkanSample
      */
 	std::unique_ptr<vkb::RenderPipeline> create_main_renderpass();
 
-	const uint32_t SHADOWMAP_RESOLUTION{1024};
+	const uint32_t SHADOW_ATLAS_RESOLUTION{2048};
 
-	std::vector<std::unique_ptr<vkb::RenderTarget>> shadow_render_targets;
+	const uint32_t SHADOW_TILE_RESOLUTION{1024};
 
 	/**
 	 * @brief Pipeline for shadowmap rendering
@@ -134,28 +116,29 @@ class MultithreadingRenderPasses : public vkb::VulkanSample
 	/**
 	 * @brief Subpass for shadowmap rendering  
 	 */
-	ShadowSubpass *shadow_subpass{};
+	vkb::ShadowSubpass *shadow_subpass{};
 
 	/**
-	 * @brief Camera for shadowmap rendering (view from the light source)
+	 * @brief Light casting the shadows
 	 */
-	vkb::sg::Camera *shadowmap_camera{};
+	vkb::sg::Light *shadow_light{};
 
 	/**
 	 * @brief Main camera for scene rendering
 	 */
 	vkb::sg::Camera *camera{};
 
-	ctpl::thread_pool thread_pool;
-
 	uint32_t swapchain_attachment_index{0};
 
 	uint32_t depth_attachment_index{1};
 
-	uint32_t shadowmap_attachment_index{0};
-
 	int multithreading_mode{0};
 
+	/**
+	 * @brief Whether the shadow tiles are only rendered when their content changed
+	 */
+	bool shadow_caching{false};
+
 	/**
 	 * @brief Record drawing commands using the chosen strategy
      * @param main_command_buffer Already allocated command buffer for the main pass
@@ -169,8 +152,6 @@ class MultithreadingRenderPasses : public vkb::VulkanSample
 
 	void record_main_pass_image_memory_barriers(vkb::CommandBuffer &command_buffer);
 
-	void record_shadow_pass_image_memory_barrier(vkb::CommandBuffer &command_buffer);
-
 	void record_present_image_memory_barrier(vkb::CommandBuffer &command_buffer);
 
 	void draw_shadow_pass(vkb::CommandBuffer &command_buffer);
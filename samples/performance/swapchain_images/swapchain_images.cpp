@@ -17,6 +17,7 @@
 
 #include "swapchain_images.h"
 
+#include "common/logging.h"
 #include "core/device.h"
 #include "core/pipeline_layout.h"
 #include "core/shader_module.h"
@@ -33,12 +34,27 @@
 #	include "platform/android/android_platform.h"
 #endif
 
+namespace
+{
+// Deepest CPU pipelining measured, beyond triple buffering when rendering without swapchain
+constexpr int MAX_FRAMES_IN_FLIGHT = 4;
+}        // namespace
+
 SwapchainImages::SwapchainImages()
 {
 	auto &config = get_configuration();
 
 	config.insert<vkb::IntSetting>(0, swapchain_image_count, 3);
+	config.insert<vkb::IntSetting>(0, frames_in_flight, 0);
 	config.insert<vkb::IntSetting>(1, swapchain_image_count, 2);
+	config.insert<vkb::IntSetting>(1, frames_in_flight, 0);
+
+	// Triple buffering with the CPU recording 1 to MAX_FRAMES_IN_FLIGHT frames ahead of the GPU
+	for (int i = 1; i <= MAX_FRAMES_IN_FLIGHT; ++i)
+	{
+		config.insert<vkb::IntSetting>(i + 1, swapchain_image_count, 3);
+		config.insert<vkb::IntSetting>(i + 1, frames_in_flight, i);
+	}
 }
 
 bool SwapchainImages::prepare(vkb::Platform &platform)
@@ -65,12 +81,36 @@ bool SwapchainImages::prepare(vkb::Platform &platform)
 	stats->request_stats({vkb::StatIndex::frame_times});
 	gui = std::make_unique<vkb::Gui>(*this, platform.get_window(), stats.get());
 
+	frame_rate_timer.start();
+
 	return true;
 }
 
+void SwapchainImages::prepare_render_context()
+{
+	// Without swapchain, a render frame is created for each frame in flight
+	render_context->set_frames_in_flight(MAX_FRAMES_IN_FLIGHT);
+
+	VulkanSample::prepare_render_context();
+
+	render_context->set_frames_in_flight(static_cast<uint32_t>(frames_in_flight));
+}
+
 void SwapchainImages::update(float delta_time)
 {
+	if (swapchain_image_count != last_swapchain_image_count || frames_in_flight != last_frames_in_flight)
+	{
+		log_frame_rate();
+	}
+
 	// Process GUI input
+	if (frames_in_flight != last_frames_in_flight)
+	{
+		render_context->set_frames_in_flight(static_cast<uint32_t>(frames_in_flight));
+
+		last_frames_in_flight = frames_in_flight;
+	}
+
 	if (swapchain_image_count != last_swapchain_image_count)
 	{
 		get_device().wait_idle();
@@ -82,6 +122,22 @@ void SwapchainImages::update(float delta_time)
 	}
 
 	VulkanSample::update(delta_time);
+
+	elapsed_frames++;
+}
+
+void SwapchainImages::log_frame_rate()
+{
+	double elapsed_time = frame_rate_timer.elapsed();
+
+	if (elapsed_frames > 0 && elapsed_time > 0.0)
+	{
+		LOGI("{} swapchain images, {} frames in flight: {:.1f} frames per second over {} frames", last_swapchain_image_count,
+		     render_context->get_frames_in_flight(), elapsed_frames / elapsed_time, elapsed_frames);
+	}
+
+	frame_rate_timer.start();
+	elapsed_frames = 0;
 }
 
 void SwapchainImages::draw_gui()
@@ -91,9 +147,9 @@ void SwapchainImages::draw_gui()
 		    ImGui::RadioButton("Double buffering", &swapchain_image_count, 2);
 		    ImGui::SameLine();
 		    ImGui::RadioButton("Triple buffering", &swapchain_image_count, 3);
-		    ImGui::SameLine();
+		    ImGui::SliderInt("Frames in flight", &frames_in_flight, 0, MAX_FRAMES_IN_FLIGHT, frames_in_flight == 0 ? "All" : "%d");
 	    },
-	    /* lines = */ 1);
+	    /* lines = */ 2);
 }
 
 std::unique_ptr<vkb::VulkanSample> create_swapchain_images()
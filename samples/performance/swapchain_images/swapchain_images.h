@@ -20,6 +20,7 @@
 #include "common/utils.h"
 #include "rendering/render_pipeline.h"
 #include "scene_graph/components/camera.h"
+#include "timer.h"
 #include "vulkan_sample.h"
 
 /**
@@ -36,14 +37,31 @@ class SwapchainImages : public vkb::VulkanSample
 
 	virtual void update(float delta_time) override;
 
+	virtual void prepare_render_context() override;
+
   private:
 	vkb::sg::Camera *camera{nullptr};
 
 	virtual void draw_gui() override;
 
+	/**
+	 * @brief Logs the frame rate of the previous configuration
+	 */
+	void log_frame_rate();
+
 	int swapchain_image_count{3};
 
 	int last_swapchain_image_count{3};
+
+	// Frames the CPU records ahead of the GPU, zero for one per swapchain image
+	int frames_in_flight{0};
+
+	int last_frames_in_flight{0};
+
+	// Wall clock time of the current configuration, the delta time may be fixed by the benchmark mode
+	vkb::Timer frame_rate_timer;
+
+	uint32_t elapsed_frames{0};
 };
 
 std::unique_ptr<vkb::VulkanSample> create_swapchain_images();
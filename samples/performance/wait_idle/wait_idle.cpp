@@ -17,6 +17,10 @@
 
 #include "wait_idle.h"
 
+#include <algorithm>
+#include <cmath>
+
+#include "common/logging.h"
 #include "common/vk_common.h"
 #include "gltf_loader.h"
 #include "gui.h"
@@ -33,8 +37,9 @@ WaitIdle::WaitIdle()
 {
 	auto &config = get_configuration();
 
-	config.insert<vkb::IntSetting>(0, wait_idle_enabled, 0);
-	config.insert<vkb::IntSetting>(1, wait_idle_enabled, 1);
+	config.insert<vkb::IntSetting>(0, wait_mode, 0);
+	config.insert<vkb::IntSetting>(1, wait_mode, 1);
+	config.insert<vkb::IntSetting>(2, wait_mode, 2);
 }
 
 bool WaitIdle::prepare(vkb::Platform &plat)
@@ -71,13 +76,58 @@ bool WaitIdle::prepare(vkb::Platform &plat)
 void WaitIdle::prepare_render_context()
 {
 	render_context.reset();
-	render_context = std::make_unique<CustomRenderContext>(get_device(), get_surface(), platform->get_window(), wait_idle_enabled);
+	render_context = std::make_unique<CustomRenderContext>(get_device(), get_surface(), platform->get_window(), wait_mode);
 	VulkanSample::prepare_render_context();
 }
 
-WaitIdle::CustomRenderContext::CustomRenderContext(vkb::Device &device, VkSurfaceKHR surface, const vkb::Window &window, int &wait_idle_enabled) :
+void WaitIdle::update(float delta_time)
+{
+	if (wait_mode != last_wait_mode)
+	{
+		log_frame_times();
+		last_wait_mode = wait_mode;
+	}
+
+	// POI
+	//
+	// With timeline semaphores, each submission signals the next value of its queue timeline instead of a fence,
+	// and the frame waits for its last values with vkWaitSemaphores, without any fence to reset
+	auto synchronization = wait_mode == 2 ? vkb::RenderContext::FrameSynchronization::TimelineSemaphores : vkb::RenderContext::FrameSynchronization::Fences;
+	if (render_context->get_frame_synchronization() != synchronization)
+	{
+		render_context->set_frame_synchronization(synchronization);
+	}
+
+	elapsed_time += delta_time;
+	elapsed_squared_time += delta_time * delta_time;
+	elapsed_frames++;
+
+	VulkanSample::update(delta_time);
+}
+
+void WaitIdle::log_frame_times()
+{
+	if (elapsed_frames > 0)
+	{
+		const char *wait_modes[] = {"Fences", "Wait idle", "Timeline semaphores"};
+
+		// The variance shows how evenly the frames are paced, beyond their average time
+		double mean      = elapsed_time / elapsed_frames;
+		double variance  = std::max(elapsed_squared_time / elapsed_frames - mean * mean, 0.0);
+		double deviation = std::sqrt(variance);
+
+		LOGI("{}: {:.3f} ms average frame time, {:.3f} ms standard deviation over {} frames", wait_modes[last_wait_mode], mean * 1000.0,
+		     deviation * 1000.0, elapsed_frames);
+	}
+
+	elapsed_time         = 0.0;
+	elapsed_squared_time = 0.0;
+	elapsed_frames       = 0;
+}
+
+WaitIdle::CustomRenderContext::CustomRenderContext(vkb::Device &device, VkSurfaceKHR surface, const vkb::Window &window, int &wait_mode) :
     RenderContext(device, surface, window),
-    wait_idle_enabled(wait_idle_enabled)
+    wait_mode(wait_mode)
 {}
 
 void WaitIdle::CustomRenderContext::wait_frame()
@@ -88,7 +138,7 @@ void WaitIdle::CustomRenderContext::wait_frame()
 
 	vkb::RenderFrame &frame = get_active_frame();
 
-	if (wait_idle_enabled)
+	if (wait_mode == 1)
 	{
 		get_device().wait_idle();
 	}
@@ -99,16 +149,21 @@ void WaitIdle::CustomRenderContext::wait_frame()
 void WaitIdle::draw_gui()
 {
 	bool     landscape = camera->get_aspect_ratio() > 1.0f;
-	uint32_t lines     = landscape ? 1 : 2;
+	uint32_t lines     = landscape ? 1 : 3;
 
 	gui->show_options_window(
 	    /* body = */ [&]() {
-		    ImGui::RadioButton("Wait Idle", &wait_idle_enabled, 1);
+		    ImGui::RadioButton("Wait Idle", &wait_mode, 1);
+		    if (landscape)
+		    {
+			    ImGui::SameLine();
+		    }
+		    ImGui::RadioButton("Fences", &wait_mode, 0);
 		    if (landscape)
 		    {
 			    ImGui::SameLine();
 		    }
-		    ImGui::RadioButton("Fences", &wait_idle_enabled, 0);
+		    ImGui::RadioButton("Timeline semaphores", &wait_mode, 2);
 	    },
 	    /* lines = */ lines);
 }
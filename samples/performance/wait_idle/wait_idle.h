@@ -31,19 +31,22 @@ class WaitIdle : public vkb::VulkanSample
 
 	virtual bool prepare(vkb::Platform &platform) override;
 
+	virtual void update(float delta_time) override;
+
 	/**
 	 * @brief This RenderContext is responsible containing the scene's RenderFrames
 	 *		  It implements a custom wait_frame function which alternates between waiting with WaitIdle or Fences
+	 *		  or timeline semaphores
 	 */
 	class CustomRenderContext : public vkb::RenderContext
 	{
 	  public:
-		CustomRenderContext(vkb::Device &device, VkSurfaceKHR surface, const vkb::Window &window, int &wait_idle_enabled);
+		CustomRenderContext(vkb::Device &device, VkSurfaceKHR surface, const vkb::Window &window, int &wait_mode);
 
 		virtual void wait_frame() override;
 
 	  private:
-		int &wait_idle_enabled;
+		int &wait_mode;
 	};
 
 	virtual void prepare_render_context() override;
@@ -55,7 +58,22 @@ class WaitIdle : public vkb::VulkanSample
 
 	virtual void draw_gui() override;
 
-	int wait_idle_enabled{0};
+	/**
+	 * @brief Logs the mean and the standard deviation of the frame times of the previous wait mode
+	 */
+	void log_frame_times();
+
+	// 0: fences, 1: vkDeviceWaitIdle, 2: timeline semaphores
+	int wait_mode{0};
+
+	int last_wait_mode{0};
+
+	// Frame times of the current wait mode, in seconds
+	double elapsed_time{0.0};
+
+	double elapsed_squared_time{0.0};
+
+	uint32_t elapsed_frames{0};
 };
 
 std::unique_ptr<vkb::VulkanSample> create_wait_idle();
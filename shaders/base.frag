@@ -56,6 +56,10 @@ layout(set = 0, binding = 4) uniform LightsInfo
 }
 lights_info;
 
+#ifdef CLUSTERED_LIGHTING
+#include "clustered_lighting.h"
+#endif
+
 layout(constant_id = 0) const uint DIRECTIONAL_LIGHT_COUNT = 0U;
 layout(constant_id = 1) const uint POINT_LIGHT_COUNT       = 0U;
 layout(constant_id = 2) const uint SPOT_LIGHT_COUNT        = 0U;
@@ -71,6 +75,9 @@ void main(void)
 		light_contribution += apply_directional_light(lights_info.directional_lights[i], normal);
 	}
 
+#ifdef CLUSTERED_LIGHTING
+	light_contribution += apply_clustered_lights(in_pos.xyz, normal, gl_FragCoord.xy);
+#else
 	for (uint i = 0U; i < POINT_LIGHT_COUNT; ++i)
 	{
 		light_contribution += apply_point_light(lights_info.point_lights[i], in_pos.xyz, normal);
@@ -80,6 +87,7 @@ void main(void)
 	{
 		light_contribution += apply_spot_light(lights_info.spot_lights[i], in_pos.xyz, normal);
 	}
+#endif
 
 	vec4 base_color = vec4(1.0, 0.0, 0.0, 1.0);
 
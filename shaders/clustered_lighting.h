@@ -0,0 +1,81 @@
+/* Copyright (c) 2023, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Lights assigned to the clusters of the view by the ClusteredLighting of the framework,
+// requires lighting.h and the light type definitions
+
+layout(set = 1, binding = 0) uniform ClusterUniform
+{
+	mat4  view;
+	uvec4 grid_size;
+	vec4  cluster_scale;
+}
+cluster_uniform;
+
+layout(std430, set = 1, binding = 1) readonly buffer ClusteredLightBuffer
+{
+	Light clustered_lights[];
+};
+
+// Offset and count of the light indices of each cluster
+layout(std430, set = 1, binding = 2) readonly buffer ClusterBuffer
+{
+	uvec2 clusters[];
+};
+
+layout(std430, set = 1, binding = 3) readonly buffer LightIndexBuffer
+{
+	uint light_indices[];
+};
+
+uint get_cluster_index(vec3 pos, vec2 frag_coord)
+{
+	float depth = -(cluster_uniform.view * vec4(pos, 1.0)).z;
+
+	uvec3 cluster;
+	cluster.xy = min(uvec2(frag_coord * cluster_uniform.cluster_scale.xy), cluster_uniform.grid_size.xy - 1U);
+	cluster.z  = uint(clamp(log(max(depth, 1e-4)) * cluster_uniform.cluster_scale.z + cluster_uniform.cluster_scale.w,
+	                        0.0, float(cluster_uniform.grid_size.z - 1U)));
+
+	return (cluster.z * cluster_uniform.grid_size.y + cluster.y) * cluster_uniform.grid_size.x + cluster.x;
+}
+
+// Fades a light to zero at its range, so that it does not end abruptly at the clusters it was assigned to
+float get_range_attenuation(Light light, vec3 pos)
+{
+	float distance_ratio = length(light.position.xyz - pos) / light.direction.w;
+	float falloff        = clamp(1.0 - distance_ratio * distance_ratio * distance_ratio * distance_ratio, 0.0, 1.0);
+	return falloff * falloff;
+}
+
+vec3 apply_clustered_lights(vec3 pos, vec3 normal, vec2 frag_coord)
+{
+	uvec2 cluster = clusters[get_cluster_index(pos, frag_coord)];
+
+	vec3 light_contribution = vec3(0.0);
+
+	for (uint i = 0U; i < cluster.y; ++i)
+	{
+		Light light = clustered_lights[light_indices[cluster.x + i]];
+
+		vec3 contribution = light.position.w == POINT_LIGHT ? apply_point_light(light, pos, normal) : apply_spot_light(light, pos, normal);
+
+		light_contribution += contribution * get_range_attenuation(light, pos);
+	}
+
+	return light_contribution;
+}
@@ -26,17 +26,30 @@ layout(set = 0, binding = 1) uniform GlobalUniform {
     vec3 camera_position;
 } global_uniform;
 
+#ifdef INSTANCING
+// Model matrices of the instances of an instanced draw
+layout(std430, set = 0, binding = 5) readonly buffer InstanceBuffer {
+    mat4 models[];
+} instance_buffer;
+#endif
+
 layout (location = 0) out vec4 o_pos;
 layout (location = 1) out vec2 o_uv;
 layout (location = 2) out vec3 o_normal;
 
 void main(void)
 {
-    o_pos = global_uniform.model * vec4(position, 1.0);
+#ifdef INSTANCING
+    mat4 model = instance_buffer.models[gl_InstanceIndex];
+#else
+    mat4 model = global_uniform.model;
+#endif
+
+    o_pos = model * vec4(position, 1.0);
 
     o_uv = texcoord_0;
 
-    o_normal = mat3(global_uniform.model) * normal;
+    o_normal = mat3(model) * normal;
 
     gl_Position = global_uniform.view_proj * o_pos;
 }
@@ -41,6 +41,10 @@ layout(set = 0, binding = 4) uniform LightsInfo
 }
 lights_info;
 
+#ifdef CLUSTERED_LIGHTING
+#include "clustered_lighting.h"
+#endif
+
 layout(constant_id = 0) const uint DIRECTIONAL_LIGHT_COUNT = 0U;
 layout(constant_id = 1) const uint POINT_LIGHT_COUNT       = 0U;
 layout(constant_id = 2) const uint SPOT_LIGHT_COUNT        = 0U;
@@ -61,6 +65,9 @@ void main()
 	{
 		L += apply_directional_light(lights_info.directional_lights[i], normal);
 	}
+#ifdef CLUSTERED_LIGHTING
+	L += apply_clustered_lights(pos, normal, gl_FragCoord.xy);
+#else
 	for (uint i = 0U; i < POINT_LIGHT_COUNT; ++i)
 	{
 		L += apply_point_light(lights_info.point_lights[i], pos, normal);
@@ -69,6 +76,7 @@ void main()
 	{
 		L += apply_spot_light(lights_info.spot_lights[i], pos, normal);
 	}
+#endif
 	vec3 ambient_color = vec3(0.2) * albedo.xyz;
 	
 	o_color = vec4(ambient_color + L * albedo.xyz, 1.0);
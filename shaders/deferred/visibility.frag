@@ -0,0 +1,33 @@
+#version 450
+/* Copyright (c) 2023, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+layout(set = 0, binding = 1) uniform VisibilityUniform
+{
+	mat4 model;
+	mat4 view_proj;
+	uint draw_index;
+}
+visibility_uniform;
+
+// Draw index offset by one, zero meaning no triangle, and triangle index within the draw
+layout(location = 0) out uvec2 o_visibility;
+
+void main(void)
+{
+	o_visibility = uvec2(visibility_uniform.draw_index + 1U, uint(gl_PrimitiveID));
+}
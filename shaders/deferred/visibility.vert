@@ -0,0 +1,32 @@
+#version 450
+/* Copyright (c) 2023, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+layout(location = 0) in vec3 position;
+
+layout(set = 0, binding = 1) uniform VisibilityUniform
+{
+	mat4 model;
+	mat4 view_proj;
+	uint draw_index;
+}
+visibility_uniform;
+
+void main(void)
+{
+	gl_Position = visibility_uniform.view_proj * visibility_uniform.model * vec4(position, 1.0);
+}
@@ -0,0 +1,220 @@
+#version 450
+/* Copyright (c) 2023, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifdef BASE_COLOR_TEXTURES
+#extension GL_EXT_nonuniform_qualifier : require
+#endif
+
+precision highp float;
+
+// Draw index offset by one and triangle index, written by visibility.frag
+layout(input_attachment_index = 0, binding = 0) uniform usubpassInput i_visibility;
+
+layout(location = 0) in vec2 in_uv;
+layout(location = 0) out vec4 o_color;
+
+layout(set = 0, binding = 3) uniform GlobalUniform
+{
+	mat4 inv_view_proj;
+	vec2 inv_resolution;
+}
+global_uniform;
+
+#include "lighting.h"
+
+layout(set = 0, binding = 4) uniform LightsInfo
+{
+	Light directional_lights[MAX_LIGHT_COUNT];
+	Light point_lights[MAX_LIGHT_COUNT];
+	Light spot_lights[MAX_LIGHT_COUNT];
+}
+lights_info;
+
+#ifdef CLUSTERED_LIGHTING
+#include "clustered_lighting.h"
+#endif
+
+// Geometry packed by the visibility subpass, positions and normals as tightly packed vec3
+layout(std430, set = 0, binding = 5) readonly buffer PositionBuffer
+{
+	float positions[];
+};
+
+layout(std430, set = 0, binding = 6) readonly buffer NormalBuffer
+{
+	float normals[];
+};
+
+layout(std430, set = 0, binding = 7) readonly buffer TexcoordBuffer
+{
+	vec2 texcoords[];
+};
+
+layout(std430, set = 0, binding = 8) readonly buffer IndexBuffer
+{
+	uint indices[];
+};
+
+struct Draw
+{
+	mat4 model;
+	uint first_index;
+	int  vertex_offset;
+	uint material_index;
+	uint padding;
+};
+
+layout(std430, set = 0, binding = 9) readonly buffer DrawBuffer
+{
+	Draw draws[];
+};
+
+struct Material
+{
+	vec4 base_color_factor;
+	int  base_color_texture;
+};
+
+layout(std430, set = 0, binding = 10) readonly buffer MaterialBuffer
+{
+	Material materials[];
+};
+
+#ifdef BASE_COLOR_TEXTURES
+layout(set = 0, binding = 11) uniform sampler2D base_color_textures[BASE_COLOR_TEXTURE_COUNT];
+#endif
+
+layout(constant_id = 0) const uint DIRECTIONAL_LIGHT_COUNT = 0U;
+layout(constant_id = 1) const uint POINT_LIGHT_COUNT       = 0U;
+layout(constant_id = 2) const uint SPOT_LIGHT_COUNT        = 0U;
+
+vec3 load_position(uint index)
+{
+	return vec3(positions[3U * index], positions[3U * index + 1U], positions[3U * index + 2U]);
+}
+
+vec3 load_normal(uint index)
+{
+	return vec3(normals[3U * index], normals[3U * index + 1U], normals[3U * index + 2U]);
+}
+
+// View ray through a point of the screen, in world space
+void get_view_ray(vec2 uv, out vec3 origin, out vec3 direction)
+{
+	vec4 near_w = global_uniform.inv_view_proj * vec4(uv * 2.0 - 1.0, 0.0, 1.0);
+	vec4 far_w  = global_uniform.inv_view_proj * vec4(uv * 2.0 - 1.0, 1.0, 1.0);
+
+	origin    = near_w.xyz / near_w.w;
+	direction = far_w.xyz / far_w.w - origin;
+}
+
+// Barycentrics of the vertices 1 and 2 of the triangle at the intersection with the view ray through a point of the screen.
+// The ray is intersected with the plane of the triangle, so the barycentrics extrapolate past its edges.
+vec2 get_barycentrics(vec2 uv, vec3 p0, vec3 e1, vec3 e2)
+{
+	vec3 origin;
+	vec3 direction;
+	get_view_ray(uv, origin, direction);
+
+	vec3  p   = cross(direction, e2);
+	float det = dot(e1, p);
+
+	// Rays parallel to the triangle do not cover a pixel of it
+	float inv_det = abs(det) > 1e-12 ? 1.0 / det : 0.0;
+
+	vec3 t = origin - p0;
+	vec3 q = cross(t, e1);
+
+	return vec2(dot(t, p), dot(direction, q)) * inv_det;
+}
+
+void main()
+{
+	uvec2 visibility = subpassLoad(i_visibility).xy;
+
+	if (visibility.x == 0U)
+	{
+		o_color = vec4(0.0, 0.0, 0.0, 1.0);
+		return;
+	}
+
+	Draw draw = draws[visibility.x - 1U];
+
+	// Vertices of the triangle
+	uint  first = draw.first_index + 3U * visibility.y;
+	uvec3 index = uvec3(indices[first], indices[first + 1U], indices[first + 2U]) + uint(draw.vertex_offset);
+
+	vec3 p0 = (draw.model * vec4(load_position(index.x), 1.0)).xyz;
+	vec3 p1 = (draw.model * vec4(load_position(index.y), 1.0)).xyz;
+	vec3 p2 = (draw.model * vec4(load_position(index.z), 1.0)).xyz;
+
+	vec3 e1 = p1 - p0;
+	vec3 e2 = p2 - p0;
+
+	vec2 b = get_barycentrics(in_uv, p0, e1, e2);
+
+	highp vec3 pos = p0 + b.x * e1 + b.y * e2;
+
+	vec3 normal = load_normal(index.x) * (1.0 - b.x - b.y) + load_normal(index.y) * b.x + load_normal(index.z) * b.y;
+	normal      = normalize(mat3(draw.model) * normal);
+
+	// Same as the G-buffer, the texture replaces the factor
+	Material material = materials[draw.material_index];
+	vec4     albedo   = material.base_color_factor;
+
+#ifdef BASE_COLOR_TEXTURES
+	if (material.base_color_texture >= 0)
+	{
+		vec2 t0 = texcoords[index.x];
+		vec2 t1 = texcoords[index.y] - t0;
+		vec2 t2 = texcoords[index.z] - t0;
+
+		// Gradients from the barycentrics of the neighbor pixels, as the rasterizer would have derived them
+		vec2 b_x = get_barycentrics(in_uv + vec2(global_uniform.inv_resolution.x, 0.0), p0, e1, e2);
+		vec2 b_y = get_barycentrics(in_uv + vec2(0.0, global_uniform.inv_resolution.y), p0, e1, e2);
+
+		vec2 texcoord = t0 + b.x * t1 + b.y * t2;
+		vec2 ddx      = (b_x.x - b.x) * t1 + (b_x.y - b.y) * t2;
+		vec2 ddy      = (b_y.x - b.x) * t1 + (b_y.y - b.y) * t2;
+
+		albedo = textureGrad(base_color_textures[nonuniformEXT(material.base_color_texture)], texcoord, ddx, ddy);
+	}
+#endif
+
+	// Calculate lighting
+	vec3 L = vec3(0.0);
+	for (uint i = 0U; i < DIRECTIONAL_LIGHT_COUNT; ++i)
+	{
+		L += apply_directional_light(lights_info.directional_lights[i], normal);
+	}
+#ifdef CLUSTERED_LIGHTING
+	L += apply_clustered_lights(pos, normal, gl_FragCoord.xy);
+#else
+	for (uint i = 0U; i < POINT_LIGHT_COUNT; ++i)
+	{
+		L += apply_point_light(lights_info.point_lights[i], pos, normal);
+	}
+	for (uint i = 0U; i < SPOT_LIGHT_COUNT; ++i)
+	{
+		L += apply_spot_light(lights_info.spot_lights[i], pos, normal);
+	}
+#endif
+	vec3 ambient_color = vec3(0.2) * albedo.xyz;
+
+	o_color = vec4(ambient_color + L * albedo.xyz, 1.0);
+}
@@ -0,0 +1,67 @@
+#version 450
+/* Copyright (c) 2023, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+layout(location = 0) in vec3 position;
+layout(location = 1) in vec2 texcoord_0;
+layout(location = 2) in vec3 normal;
+
+layout(set = 0, binding = 1) uniform GlobalUniform
+{
+	mat4 model;
+	mat4 view_proj;
+	vec3 camera_position;
+}
+global_uniform;
+
+struct Instance
+{
+	mat4 model;
+	vec4 bounding_sphere;
+	uint command_index;
+	uint padding[3];
+};
+
+layout(std430, set = 0, binding = 5) readonly buffer InstanceBuffer
+{
+	Instance instances[];
+}
+instance_buffer;
+
+// Filled by the culling shader, each indirect command owns the range starting at its firstInstance
+layout(std430, set = 0, binding = 6) readonly buffer VisibleInstanceBuffer
+{
+	uint instances[];
+}
+visible_instance_buffer;
+
+layout(location = 0) out vec4 o_pos;
+layout(location = 1) out vec2 o_uv;
+layout(location = 2) out vec3 o_normal;
+
+void main(void)
+{
+	mat4 model = instance_buffer.instances[visible_instance_buffer.instances[gl_InstanceIndex]].model;
+
+	o_pos = model * vec4(position, 1.0);
+
+	o_uv = texcoord_0;
+
+	o_normal = mat3(model) * normal;
+
+	gl_Position = global_uniform.view_proj * o_pos;
+}
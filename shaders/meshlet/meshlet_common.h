@@ -0,0 +1,112 @@
+/* Copyright (c) 2023, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MESHLET_COMMON_H_
+#define MESHLET_COMMON_H_
+
+// Largest number of meshlets culled by a task shader workgroup, or by a culling compute workgroup
+#define MESHLET_TASK_SIZE 32
+
+struct Meshlet
+{
+	vec4 bounding_sphere;
+	vec4 normal_cone;
+	uint vertex_offset;
+	uint triangle_offset;
+	uint vertex_count;
+	uint triangle_count;
+};
+
+// A range of the meshlets of an instance, culled by one workgroup
+struct MeshletTask
+{
+	uint instance;
+	uint first_meshlet;
+	uint meshlet_count;
+	uint first_command;
+};
+
+layout(set = 0, binding = 2) uniform MeshletCullUniform
+{
+	vec4 frustum_planes[6];
+	vec4 camera_position;
+	uint first_task;
+	uint task_count;
+	uint cone_culling;
+}
+cull_uniform;
+
+layout(std430, set = 0, binding = 5) readonly buffer InstanceBuffer
+{
+	mat4 models[];
+}
+instance_buffer;
+
+layout(std430, set = 0, binding = 6) readonly buffer MeshletTaskBuffer
+{
+	MeshletTask tasks[];
+}
+task_buffer;
+
+layout(std430, set = 0, binding = 7) readonly buffer MeshletBuffer
+{
+	Meshlet meshlets[];
+}
+meshlet_buffer;
+
+/**
+ * @brief Index of the task of the current workgroup, the workgroups being laid out in rows
+ */
+uint get_task_index()
+{
+	return gl_WorkGroupID.y * gl_NumWorkGroups.x + gl_WorkGroupID.x;
+}
+
+/**
+ * @brief Tests a meshlet of an instance against the view frustum, and whether all its triangles face away from the camera
+ */
+bool is_meshlet_visible(mat4 model, Meshlet meshlet)
+{
+	vec3  center = (model * vec4(meshlet.bounding_sphere.xyz, 1.0)).xyz;
+	float scale  = max(length(model[0].xyz), max(length(model[1].xyz), length(model[2].xyz)));
+	float radius = meshlet.bounding_sphere.w * scale;
+
+	for (uint i = 0; i < 6; ++i)
+	{
+		vec4 plane = cull_uniform.frustum_planes[i];
+		if (dot(plane.xyz, center) + plane.w <= -radius)
+		{
+			return false;
+		}
+	}
+
+	// A cutoff of 1 marks meshlets which are never back-facing as a whole
+	if (cull_uniform.cone_culling != 0 && meshlet.normal_cone.w < 1.0)
+	{
+		vec3 axis      = normalize(mat3(model) * meshlet.normal_cone.xyz);
+		vec3 direction = center - cull_uniform.camera_position.xyz;
+
+		if (dot(direction, axis) >= meshlet.normal_cone.w * length(direction) + radius)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+#endif
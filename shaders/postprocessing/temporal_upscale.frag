@@ -0,0 +1,90 @@
+#version 450
+/* Copyright (c) 2023, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+precision highp float;
+
+layout(set = 0, binding = 1) uniform sampler2D color_sampler;
+layout(set = 0, binding = 2) uniform sampler2D depth_sampler;
+layout(set = 0, binding = 3) uniform sampler2D history_sampler;
+
+layout(location = 0) in vec2 in_uv;
+
+layout(location = 0) out vec4 o_color;
+
+layout(set = 0, binding = 0) uniform TemporalUpscaleUniform
+{
+	// Output NDC and depth of the current frame to clip space of the previous frame, without jitter
+	mat4 reprojection;
+
+	// xy: jitter of the current frame in NDC, zw: render extent divided by the extent of the scene images
+	vec4 jitter_scale;
+
+	// xy: render extent in pixels, z: weight of the current frame, w: 1 if the history is valid
+	vec4 render_extent;
+}
+upscale_uniform;
+
+void main(void)
+{
+	vec2  jitter      = upscale_uniform.jitter_scale.xy;
+	vec2  image_scale = upscale_uniform.jitter_scale.zw;
+	vec2  render_size = upscale_uniform.render_extent.xy;
+	ivec2 render_max  = ivec2(render_size) - 1;
+
+	// The jitter moves the scene by jitter in NDC, so the render position of this pixel moves by half of it in UV
+	vec2  render_uv    = in_uv + 0.5 * jitter;
+	ivec2 render_texel = clamp(ivec2(render_uv * render_size), ivec2(0), render_max);
+
+	// Only the top-left region of the scene images is rendered to
+	vec2 image_size = vec2(textureSize(color_sampler, 0));
+	vec2 color_uv   = clamp(render_uv * image_scale, vec2(0.5) / image_size, (render_size - 0.5) / image_size);
+	vec3 current    = texture(color_sampler, color_uv).rgb;
+
+	// Color range and closest depth of the neighbourhood, with reversed depth the closest is the largest
+	vec3  neighbourhood_min = current;
+	vec3  neighbourhood_max = current;
+	float closest_depth     = 0.0;
+	for (int y = -1; y <= 1; ++y)
+	{
+		for (int x = -1; x <= 1; ++x)
+		{
+			ivec2 texel = clamp(render_texel + ivec2(x, y), ivec2(0), render_max);
+
+			vec3 color        = texelFetch(color_sampler, texel, 0).rgb;
+			neighbourhood_min = min(neighbourhood_min, color);
+			neighbourhood_max = max(neighbourhood_max, color);
+
+			closest_depth = max(closest_depth, texelFetch(depth_sampler, texel, 0).r);
+		}
+	}
+
+	// Motion of the camera, the scene itself is static
+	vec4 previous_clip = upscale_uniform.reprojection * vec4(in_uv * 2.0 - 1.0, closest_depth, 1.0);
+	vec2 previous_uv   = previous_clip.xy / previous_clip.w * 0.5 + 0.5;
+
+	float current_weight = upscale_uniform.render_extent.z;
+	if (upscale_uniform.render_extent.w == 0.0 || any(lessThan(previous_uv, vec2(0.0))) || any(greaterThan(previous_uv, vec2(1.0))))
+	{
+		current_weight = 1.0;
+	}
+
+	// Clamping the history to the current neighbourhood rejects the history of disoccluded pixels
+	vec3 history = clamp(texture(history_sampler, previous_uv).rgb, neighbourhood_min, neighbourhood_max);
+
+	o_color = vec4(mix(history, current, current_weight), 1.0);
+}
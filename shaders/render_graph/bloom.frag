@@ -0,0 +1,41 @@
+#version 450
+/* Copyright (c) 2023, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+precision highp float;
+
+layout(set = 0, binding = 1) uniform sampler2D hdr_sampler;
+
+layout(location = 0) in vec2 in_uv;
+
+layout(location = 0) out vec4 o_color;
+
+// Brightness above which the lit scene bleeds into the bloom
+const float bloom_threshold = 1.0;
+
+void main(void)
+{
+	// Average a 4x4 texel footprint of the full resolution image with four bilinear samples
+	vec2 texel = 1.0 / vec2(textureSize(hdr_sampler, 0));
+
+	vec3 color = texture(hdr_sampler, in_uv + vec2(-texel.x, -texel.y)).rgb;
+	color += texture(hdr_sampler, in_uv + vec2(texel.x, -texel.y)).rgb;
+	color += texture(hdr_sampler, in_uv + vec2(-texel.x, texel.y)).rgb;
+	color += texture(hdr_sampler, in_uv + vec2(texel.x, texel.y)).rgb;
+
+	o_color = vec4(max(0.25 * color - vec3(bloom_threshold), vec3(0.0)), 1.0);
+}
@@ -0,0 +1,25 @@
+/* Copyright (c) 2023, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Postprocessing pixel stage adding the bloom to the HDR color
+
+STAGE_BINDING(1) uniform sampler2D bloom_sampler;
+
+vec4 process(vec4 color, ivec2 pixel, vec2 uv)
+{
+	return vec4(color.rgb + texture(bloom_sampler, uv).rgb, color.a);
+}
@@ -0,0 +1,40 @@
+/* Copyright (c) 2023, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Postprocessing pixel stage adjusting the contrast and saturation of the tone mapped color,
+// and darkening the corners of the image
+
+STAGE_BINDING(0) uniform ColorGradingUniform
+{
+	float contrast;
+	float saturation;
+	float vignette;
+}
+color_grading_uniform;
+
+vec4 process(vec4 color, ivec2 pixel, vec2 uv)
+{
+	vec3 graded = (color.rgb - 0.5) * color_grading_uniform.contrast + 0.5;
+
+	float luminance = dot(graded, vec3(0.2126, 0.7152, 0.0722));
+	graded          = mix(vec3(luminance), graded, color_grading_uniform.saturation);
+
+	vec2 offset = uv - 0.5;
+	graded *= 1.0 - color_grading_uniform.vignette * dot(offset, offset);
+
+	return vec4(clamp(graded, 0.0, 1.0), color.a);
+}
@@ -0,0 +1,32 @@
+/* Copyright (c) 2023, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Postprocessing pixel stage mapping the HDR color to the displayable range
+
+STAGE_BINDING(0) uniform TonemapUniform
+{
+	float exposure;
+}
+tonemap_uniform;
+
+vec4 process(vec4 color, ivec2 pixel, vec2 uv)
+{
+	vec3 exposed = color.rgb * tonemap_uniform.exposure;
+
+	// Reinhard tone mapping
+	return vec4(exposed / (exposed + vec3(1.0)), 1.0);
+}
@@ -63,21 +63,40 @@ layout(constant_id = 2) const uint SPOT_LIGHT_COUNT        = 0U;
 
 layout(set = 0, binding = 5) uniform sampler2DShadow shadowmap_texture;
 
+// Must match the cascade count of the sample
+#define SHADOW_CASCADE_COUNT 3
+
 layout(set = 0, binding = 6) uniform ShadowUniform
 {
-	mat4 light_matrix;
+	mat4 light_matrices[SHADOW_CASCADE_COUNT];
+	vec4 atlas_rects[SHADOW_CASCADE_COUNT];
 }
 shadow_uniform;
 
 float calculate_shadow()
 {
-    vec4 projected_coord = shadow_uniform.light_matrix * vec4(in_pos.xyz, 1.0);
+	// The first cascade covering the fragment has the highest resolution
+	for (int i = 0; i < SHADOW_CASCADE_COUNT; ++i)
+	{
+		vec4 projected_coord = shadow_uniform.light_matrices[i] * vec4(in_pos.xyz, 1.0);
+
+		projected_coord /= projected_coord.w;
 
-    projected_coord /= projected_coord.w;
+		projected_coord.xy = 0.5 * projected_coord.xy + 0.5;
 
-    projected_coord.xy = 0.5 * projected_coord.xy + 0.5;
+		if (all(greaterThanEqual(projected_coord.xy, vec2(0.0))) && all(lessThanEqual(projected_coord.xy, vec2(1.0))))
+		{
+			// Stay half a texel away from the borders, so that filtering does not read the neighbouring tiles
+			vec4 atlas_rect  = shadow_uniform.atlas_rects[i];
+			vec2 half_texel  = 0.5 / (vec2(textureSize(shadowmap_texture, 0)) * atlas_rect.zw);
+			vec2 atlas_coord = atlas_rect.xy + clamp(projected_coord.xy, half_texel, 1.0 - half_texel) * atlas_rect.zw;
+
+			return texture(shadowmap_texture, vec3(atlas_coord, projected_coord.z));
+		}
+	}
 
-    return texture(shadowmap_texture, vec3(projected_coord.xy, projected_coord.z));
+	// Outside of all the cascades
+	return 1.0;
 }
 
 void main(void)